@@ -18,6 +18,11 @@ if( NOT DEFINED USE_LIBC_SEMAPHORE )
 endif()
 add_definitions( -DUSE_LIBC_SEMAPHORE=${USE_LIBC_SEMAPHORE} )
 
+if( NOT DEFINED CMS_MAX_NODES )
+    set(CMS_MAX_NODES 64)
+endif()
+add_definitions( -DCMS_MAX_NODES=${CMS_MAX_NODES} )
+
 #-------------------------------------------------------------------------------
 # Enable c++0x / c++11
 #-------------------------------------------------------------------------------
@@ -19,6 +19,7 @@ message( STATUS "C Compiler:        " ${CMAKE_C_COMPILER} )
 message( STATUS "C++ Compiler:      " ${CMAKE_CXX_COMPILER} )
 message( STATUS "Build type:        " ${CMAKE_BUILD_TYPE} )
 message( STATUS "Plug-in version:   " ${PLUGIN_VERSION} )
+message( STATUS "CMS max nodes:     " ${CMS_MAX_NODES} )
 message( STATUS "" )
 message( STATUS "Readline support:  " ${STATUS_READLINE} )
 message( STATUS "Fuse support:      " ${STATUS_FUSE} )
@@ -80,6 +80,14 @@ if( NOT MacOSX )
   endif()
 endif()
 
+#-------------------------------------------------------------------------------
+# io_uring (we use the raw system calls so only the kernel header is needed)
+#-------------------------------------------------------------------------------
+if( Linux )
+  check_symbol_exists( IORING_FEAT_RW_CUR_POS "linux/io_uring.h" HAVE_IO_URING )
+  compiler_define_if_found( HAVE_IO_URING HAVE_IO_URING )
+endif()
+
 #-------------------------------------------------------------------------------
 # Check for libcrypt
 #-------------------------------------------------------------------------------
@@ -115,6 +115,7 @@ enum CmsReqCode            // Request Codes
      kYR_update  = 25,
      kYR_usage   = 26,
      kYR_xauth   = 27,
+     kYR_bloom   = 28,
      kYR_MaxReq            // Count of request numbers (highest + 1)
 };
 
@@ -185,6 +186,32 @@ struct CmsAvailRequest
 //     kXR_int32     diskUtil;
 };
 
+/******************************************************************************/
+/*                         b l o o m   R e q u e s t                          */
+/******************************************************************************/
+  
+// Request: bloom <gen> <offset> <bits> <hashes> <segment>
+// Respond: n/a
+//
+// A server sends its bloom filter as a sequence of segments in increasing
+// offset order. The last segment has the Last modifier set. Only sent to
+// managers that indicated kYR_bloom at login time.
+//
+struct CmsBloomData
+{      kXR_unt32     Gen;                      // Filter generation
+       kXR_unt32     Offset;                   // Byte offset of segment
+       kXR_char      lgBits;                   // log2 of filter size in bits
+       kXR_char      Hashes;                   // Number of hash functions
+       kXR_unt16     Rsvd;
+};
+
+struct CmsBloomRequest
+{      CmsRRHdr      Hdr;
+       enum          {Last = 1};               // Modifier
+       CmsBloomData  Data;
+//     kXR_char      Segment[Hdr.datalen-sizeof(CmsBloomData)];
+};
+
 /******************************************************************************/
 /*                         c h m o d   R e q u e s t                          */
 /******************************************************************************/
@@ -299,6 +326,7 @@ struct CmsLoginData
                   kYR_suspend =   0x00000100,   // Suspended login
                   kYR_nostage =   0x00000200,   // Staging unavailable
                   kYR_trying  =   0x00000400,   // Extensive login retries
+                  kYR_bloom   =   0x00000800,   // Accepts bloom filters
                   kYR_debug   =   0x80000000,
                   kYR_share   =   0x7f000000,   // Mask to isolate share
                   kYR_shift   =   24,           // Share shift position
@@ -66,6 +66,12 @@ const char *XrdBuffManager::TraceID = "BuffManager";
 namespace
 {
 static const int minBuffSz = 1 << XRD_BUSHIFT;
+
+// The number of buffers moved between a thread cache and the buckets at once
+// is half of the cache depth for the bucket. Caches for large buffers are
+// limited so that a single cache never holds more than tcMaxMem per bucket.
+//
+static const int tcMaxMem = 4*1024*1024;
 }
 
 namespace XrdGlobal
@@ -104,6 +110,16 @@ XrdBuffManager::XrdBuffManager(XrdSysError *lP, XrdOucTrace *tP, int minrst) :
    rsinprog = 0;
    minrsw   = minrst;
    memset(static_cast<void *>(bucket), 0, sizeof(bucket));
+
+// Thread caches are off unless SetCache() is called prior to Init()
+//
+   tcList   = 0;
+   tcOn     = false;
+   tcDepth  = 0;
+   tchits   = 0;
+   bkhits   = 0;
+   bkallo   = 0;
+   memset(tcMax, 0, sizeof(tcMax));
 }
 
 /******************************************************************************/
@@ -113,6 +129,19 @@ XrdBuffManager::XrdBuffManager(XrdSysError *lP, XrdOucTrace *tP, int minrst) :
 XrdBuffManager::~XrdBuffManager()
 {
    XrdBuffer *bP;
+   TCache *tcP;
+
+   if (tcOn) pthread_key_delete(tcKey);
+   while((tcP = tcList))
+        {tcList = tcP->tcNext;
+         for (int i = 0; i < XRD_BUCKETS; i++)
+             {while((bP = tcP->bnext[i]))
+                   {tcP->bnext[i] = bP->next;
+                    delete bP;
+                   }
+             }
+         delete tcP;
+        }
 
    for (int i = 0; i < XRD_BUCKETS; i++)
        {while((bP = bucket[i].bnext))
@@ -132,6 +161,23 @@ void XrdBuffManager::Init()
    pthread_t tid;
    int rc;
 
+// Enable thread caches, if so wanted. The caches themselves are allocated as
+// threads first use them. Compute the depth of each bucket's cache so that
+// big buffers are not hoarded in idle caches.
+//
+   if (tcDepth > 0)
+      {if ((rc = pthread_key_create(&tcKey, TCDone)))
+          XrdLog->Emsg("BuffManager", rc, "create thread cache key");
+          else {for (int i = 0; i < slots; i++)
+                    {tcMax[i] = tcMaxMem / (minBuffSz << i);
+                     if (tcMax[i] > tcDepth) tcMax[i] = tcDepth;
+                        else if (tcMax[i] < 2) tcMax[i] = 2;
+                    }
+                tcOn = true;
+                TRACE(MEM, "Using thread caches; depth " <<tcDepth);
+               }
+      }
+
 // Start the reshaper thread
 //
    if ((rc = XrdSysThread::Run(&tid, XrdReshaper, static_cast<void *>(this), 0,
@@ -146,6 +192,7 @@ void XrdBuffManager::Init()
 XrdBuffer *XrdBuffManager::Obtain(int sz)
 {
    XrdBuffer *bp;
+   TCache *tcP;
    char *memp;
    int mk, pk, bindex;
 
@@ -162,18 +209,38 @@ XrdBuffer *XrdBuffManager::Obtain(int sz)
    if (mk < sz) {bindex++; mk = mk << 1;}
    if (bindex >= slots) return 0;    // Should never happen!
 
+// If we have thread caches, try to obtain a buffer from this thread's cache.
+// Should it be empty, we refill it in one go from the corresponding bucket.
+//
+   if (tcOn && (tcP = ThreadCache()))
+      {tcP->tcMutex.Lock();
+       tcP->totreq++;
+       tcP->numreq[bindex]++;
+       if ((bp = tcP->bnext[bindex]))
+          {tcP->bnext[bindex] = bp->next; tcP->numbuf[bindex]--;
+           tcP->hits++;
+           tcP->tcMutex.UnLock();
+           return bp;
+          }
+       tcP->tcMutex.UnLock();
+       if ((bp = Refill(tcP, bindex))) return bp;
+      } else {
+
 // Obtain a lock on the bucket array and try to give away an existing buffer
 //
-    Reshaper.Lock();
-    totreq++;
-    bucket[bindex].numreq++;
-    if ((bp = bucket[bindex].bnext))
-       {bucket[bindex].bnext = bp->next; bucket[bindex].numbuf--;}
-    Reshaper.UnLock();
+       Reshaper.Lock();
+       totreq++;
+       bucket[bindex].numreq++;
+       if ((bp = bucket[bindex].bnext))
+          {bucket[bindex].bnext = bp->next; bucket[bindex].numbuf--;
+           bkhits++;
+          }
+       Reshaper.UnLock();
 
 // Check if we really allocated a buffer
 //
-   if (bp) return bp;
+       if (bp) return bp;
+      }
 
 // Allocate a chunk of aligned memory
 //
@@ -188,6 +255,7 @@ XrdBuffer *XrdBuffManager::Obtain(int sz)
 //
     Reshaper.Lock();
     totbuf++;
+    bkallo++;
     if ((totalo += mk) > maxalo && !rsinprog)
        {rsinprog = 1; Reshaper.Signal();}
     Reshaper.UnLock();
@@ -226,12 +294,36 @@ int XrdBuffManager::Recalc(int sz)
   
 void XrdBuffManager::Release(XrdBuffer *bp)
 {
+   TCache *tcP;
    int bindex = bp->bindex;
 
 // Check if we should release this via the big buffer object
 //
    if (bindex >= slots) {xlBuff.Release(bp); return;}
 
+// If we have thread caches, return the buffer to this thread's cache. When the
+// cache overflows, half of it is drained back to the bucket with a single lock.
+//
+   if (tcOn && (tcP = ThreadCache()))
+      {XrdBuffer *chain = 0;
+       int num = 0;
+       tcP->tcMutex.Lock();
+       bp->next = tcP->bnext[bindex];
+       tcP->bnext[bindex] = bp;
+       if (++(tcP->numbuf[bindex]) > tcMax[bindex])
+          {num = tcMax[bindex]/2;
+           for (int i = 0; i < num; i++)
+               {bp = tcP->bnext[bindex];
+                tcP->bnext[bindex] = bp->next;
+                bp->next = chain; chain = bp;
+               }
+           tcP->numbuf[bindex] -= num;
+          }
+       tcP->tcMutex.UnLock();
+       if (chain) Drain(&chain, bindex, num);
+       return;
+      }
+
 // Obtain a lock on the bucket array and reclaim the buffer
 //
     Reshaper.Lock();
@@ -266,6 +358,16 @@ while(1)
           Reshaper.Lock();
          }
 
+      // Trim the thread caches by moving their buffers and request counts to
+      // the buckets. Caches are refilled on demand so only active threads
+      // will hold on to buffers after this point.
+      //
+      for (TCache *tcP = tcList; tcP; tcP = tcP->tcNext)
+          {tcP->tcMutex.Lock();
+           Fold(tcP);
+           tcP->tcMutex.UnLock();
+          }
+
       // We have the lock so compute the request profile
       //
       if (totreq > slots)
@@ -322,6 +424,19 @@ void XrdBuffManager::Set(int maxmem, int minw)
    Reshaper.UnLock();
 }
  
+/******************************************************************************/
+/*                              S e t C a c h e                               */
+/******************************************************************************/
+  
+void XrdBuffManager::SetCache(int tcdepth)
+{
+
+// This must be called prior to Init() as the caches are enabled there. A
+// zero depth disables the thread cache layer.
+//
+   if (tcdepth >= 0) tcDepth = tcdepth;
+}
+
 /******************************************************************************/
 /*                                 S t a t s                                  */
 /******************************************************************************/
@@ -329,19 +444,179 @@ void XrdBuffManager::Set(int maxmem, int minw)
 int XrdBuffManager::Stats(char *buff, int blen, int do_sync)
 {
     static char statfmt[] = "<stats id=\"buff\"><reqs>%d</reqs>"
-                "<mem>%lld</mem><buffs>%d</buffs><adj>%d</adj>%s</stats>";
+                "<mem>%lld</mem><buffs>%d</buffs><adj>%d</adj>"
+                "<hits><tc>%lld</tc><bk>%lld</bk><new>%lld</new></hits>"
+                "%s</stats>";
     char xlStats[1024];
-    int nlen;
+    long long hits = tchits;
+    int nlen, tcreq = 0;
 
 // If only size wanted, return it
 //
-   if (!buff) return sizeof(statfmt) + 16*4 + xlBuff.Stats(0,0);
+   if (!buff) return sizeof(statfmt) + 16*7 + xlBuff.Stats(0,0);
+
+// Requests satisfied by a thread cache are folded into the global counts only
+// when the caches are trimmed, so we add the current ones. The cache list can
+// only be walked with the lock held, whatever do_sync says.
+//
+   if (tcOn)
+      {Reshaper.Lock();
+       for (TCache *tcP = tcList; tcP; tcP = tcP->tcNext)
+           {if (do_sync) tcP->tcMutex.Lock();
+            hits  += tcP->hits;
+            tcreq += tcP->totreq;
+            if (do_sync) tcP->tcMutex.UnLock();
+           }
+       if (!do_sync) Reshaper.UnLock();
+      }
 
 // Return formatted stats
 //
-   if (do_sync) Reshaper.Lock();
+   if (do_sync && !tcOn) Reshaper.Lock();
    xlBuff.Stats(xlStats, sizeof(xlStats), do_sync);
-   nlen = snprintf(buff,blen,statfmt,totreq,totalo,totbuf,totadj,xlStats);
+   nlen = snprintf(buff,blen,statfmt,totreq+tcreq,totalo,totbuf,totadj,
+                   hits, bkhits, bkallo, xlStats);
    if (do_sync) Reshaper.UnLock();
    return nlen;
 }
+
+/******************************************************************************/
+/*                       P r i v a t e   M e t h o d s                        */
+/******************************************************************************/
+/******************************************************************************/
+/*                                 D r a i n                                  */
+/******************************************************************************/
+  
+void XrdBuffManager::Drain(XrdBuffer **chain, int bindex, int num)
+{
+   XrdBuffer *bp = *chain;
+
+// Find the end of the chain and splice it into the bucket
+//
+   while(bp->next) bp = bp->next;
+   Reshaper.Lock();
+   bp->next = bucket[bindex].bnext;
+   bucket[bindex].bnext = *chain;
+   bucket[bindex].numbuf += num;
+   Reshaper.UnLock();
+   *chain = 0;
+}
+
+/******************************************************************************/
+/*                                  F o l d                                   */
+/******************************************************************************/
+
+// Caller must hold the Reshaper lock and the cache's mutex.
+  
+void XrdBuffManager::Fold(TCache *tcP)
+{
+   XrdBuffer *bp;
+
+// Move the buffers and request counts of the cache into the buckets
+//
+   for (int i = 0; i < slots; i++)
+       {bucket[i].numreq += tcP->numreq[i]; tcP->numreq[i] = 0;
+        if ((bp = tcP->bnext[i]))
+           {while(bp->next) bp = bp->next;
+            bp->next = bucket[i].bnext;
+            bucket[i].bnext = tcP->bnext[i];
+            bucket[i].numbuf += tcP->numbuf[i];
+            tcP->bnext[i] = 0; tcP->numbuf[i] = 0;
+           }
+       }
+   totreq += tcP->totreq; tcP->totreq = 0;
+}
+
+/******************************************************************************/
+/*                                R e f i l l                                 */
+/******************************************************************************/
+  
+XrdBuffer *XrdBuffManager::Refill(TCache *tcP, int bindex)
+{
+   XrdBuffer *bp, *chain = 0, *last = 0;
+   int num = 0, batch = tcMax[bindex]/2;
+
+// Grab a batch of buffers from the bucket. The first one is returned to the
+// caller and the remainder is placed in the thread cache.
+//
+   Reshaper.Lock();
+   if ((bp = bucket[bindex].bnext))
+      {bkhits++;
+       bucket[bindex].bnext = bp->next; bucket[bindex].numbuf--;
+       if ((chain = bucket[bindex].bnext))
+          {for (last = chain, num = 1; num < batch && last->next; num++)
+               last = last->next;
+           bucket[bindex].bnext = last->next;
+           bucket[bindex].numbuf -= num;
+           last->next = 0;
+          }
+      }
+   Reshaper.UnLock();
+
+// Place any excess buffers in the thread cache
+//
+   if (num)
+      {tcP->tcMutex.Lock();
+       last->next = tcP->bnext[bindex];
+       tcP->bnext[bindex] = chain;
+       tcP->numbuf[bindex] += num;
+       tcP->tcMutex.UnLock();
+      }
+   return bp;
+}
+
+/******************************************************************************/
+/*                           T h r e a d C a c h e                            */
+/******************************************************************************/
+  
+XrdBuffManager::TCache *XrdBuffManager::ThreadCache()
+{
+   TCache *tcP;
+
+// Return this thread's cache for this manager if it already has one
+//
+   if ((tcP = (TCache *)pthread_getspecific(tcKey))) return tcP;
+
+// Allocate a cache for this thread and add it to our list. Should we fail, the
+// caller simply uses the buckets.
+//
+   if (!(tcP = new TCache)) return 0;
+   tcP->tcMgr = this;
+   memset(tcP->bnext,  0, sizeof(tcP->bnext));
+   memset(tcP->numbuf, 0, sizeof(tcP->numbuf));
+   memset(tcP->numreq, 0, sizeof(tcP->numreq));
+   tcP->totreq = 0;
+   tcP->hits   = 0;
+   if (pthread_setspecific(tcKey, tcP)) {delete tcP; return 0;}
+
+   Reshaper.Lock();
+   tcP->tcNext = tcList; tcList = tcP;
+   Reshaper.UnLock();
+   return tcP;
+}
+
+/******************************************************************************/
+/*                                T C D o n e                                 */
+/******************************************************************************/
+
+// This is called when a thread that has a cache exits.
+  
+void XrdBuffManager::TCDone(void *cP)
+{
+   TCache *tcP = (TCache *)cP, *pP;
+   XrdBuffManager *mP = tcP->tcMgr;
+
+// Remove the cache from the list and fold its contents into the buckets
+//
+   mP->Reshaper.Lock();
+   if (mP->tcList == tcP) mP->tcList = tcP->tcNext;
+      else {for (pP = mP->tcList; pP && pP->tcNext != tcP; pP = pP->tcNext) {}
+            if (pP) pP->tcNext = tcP->tcNext;
+           }
+   tcP->tcMutex.Lock();
+   mP->Fold(tcP);
+   mP->tchits += tcP->hits;
+   tcP->tcMutex.UnLock();
+   mP->Reshaper.UnLock();
+   delete tcP;
+}
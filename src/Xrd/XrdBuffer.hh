@@ -89,6 +89,8 @@ void        Reshape();
 
 void        Set(int maxmem=-1, int minw=-1);
 
+void        SetCache(int tcdepth);
+
 int         Stats(char *buff, int blen, int do_sync=0);
 
             XrdBuffManager(XrdSysError *lP, XrdOucTrace *tP, int minrst=20*60);
@@ -97,6 +99,15 @@ int         Stats(char *buff, int blen, int do_sync=0);
 
 private:
 
+struct TCache;
+
+void       Drain(XrdBuffer **chain, int bindex, int num);
+void       Fold(TCache *tcP);
+XrdBuffer *Refill(TCache *tcP, int bindex);
+static
+void       TCDone(void *tcP);
+TCache    *ThreadCache();
+
 XrdOucTrace *XrdTrace;
 XrdSysError *XrdLog;
 
@@ -118,6 +129,31 @@ int       minrsw;
 int       rsinprog;
 int       totadj;
 
+// When enabled, each thread using this manager gets its own cache in front of
+// the bucket list. It is found via a thread specific key owned by the manager
+// and folded back into the buckets when the thread exits. The cache mutex is
+// only contended by the reshaper and stats. The list is protected by Reshaper.
+//
+struct TCache
+      {TCache         *tcNext;
+       XrdBuffManager *tcMgr;
+       XrdSysMutex     tcMutex;
+       XrdBuffer      *bnext[XRD_BUCKETS];
+       int             numbuf[XRD_BUCKETS];
+       int             numreq[XRD_BUCKETS];
+       int             totreq;
+       long long       hits;
+      }   *tcList;
+
+pthread_key_t tcKey;                   // Key to this thread's cache
+bool      tcOn;                        // Thread caches are in use
+int       tcDepth;                     // Max buffers per cache per bucket
+int       tcMax[XRD_BUCKETS];          // Actual depth per bucket
+long long tchits;                      // Hits of caches already folded
+
+long long bkhits;                      // Obtain() satisfied by the buckets
+long long bkallo;                      // Obtain() that needed a new buffer
+
 XrdSysCondVar      Reshaper;
 static const char *TraceID;
 };
@@ -585,6 +585,7 @@ int XrdConfig::ConfigXeq(char *var, XrdOucStream &Config, XrdSysError *eDest)
    TS_Xeq("adminpath",     xapath);
    TS_Xeq("allow",         xallow);
    TS_Xeq("homepath",      xhpath);
+   TS_Xeq("poller",        xpoll);
    TS_Xeq("port",          xport);
    TS_Xeq("protocol",      xprot);
    TS_Xeq("report",        xrep);
@@ -1202,11 +1203,17 @@ int XrdConfig::xhpath(XrdSysError *eDest, XrdOucStream &Config)
 
 /* Function: xbuf
 
-   Purpose:  To parse the directive: buffers [maxbsz <bsz>] <memsz> [<rint>]
+   Purpose:  To parse the directive: buffers [maxbsz <bsz>] [tcache <tcopt>]
+                                              <memsz> [<rint>]
 
              <bsz>      maximum size of an individualbuffer. The default is 2m.
                         Specify any value 2m < bsz <= 1g; if specified, it must
                         appear before the <memsz> and <memsz> becomes optional.
+             <tcopt>    off | <depth> the maximum number of buffers of a given
+                        size that each thread may keep in a private cache in
+                        front of the shared buffer pool. The default is off.
+                        When specified, it must appear before the <memsz> and
+                        <memsz> becomes optional.
              <memsz>    maximum amount of memory devoted to buffers
              <rint>     minimum buffer reshape interval in seconds
 
@@ -1232,6 +1239,16 @@ int XrdConfig::xbuf(XrdSysError *eDest, XrdOucStream &Config)
         if (!(val = Config.GetWord())) return 0;
        }
 
+    if (!strcmp("tcache", val))
+       {int tcdepth = 0;
+        if (!(val = Config.GetWord()))
+           {eDest->Emsg("Config", "tcache value not specified"); return 1;}
+        if (strcmp("off", val)
+        &&  XrdOuca2x::a2i(*eDest,"tcache depth",val,&tcdepth,2,1024)) return 1;
+        BuffPool.SetCache(tcdepth);
+        if (!(val = Config.GetWord())) return 0;
+       }
+
     if (XrdOuca2x::a2sz(*eDest,"buffer limit value",val,&blim,
                        (long long)1024*1024)) return 1;
 
@@ -1416,6 +1433,37 @@ int XrdConfig::xnkap(XrdSysError *eDest, char *val)
    return 0;
 }
   
+/******************************************************************************/
+/*                                 x p o l l                                  */
+/******************************************************************************/
+
+/* Function: xpoll
+
+   Purpose:  To parse the directive: poller {edge | oneshot}
+
+             edge      Keep links in the poll set using edge triggered events.
+                       A link is only re-armed when an event occurred while its
+                       request was being processed. This avoids a system call
+                       per request. Supported on Linux only.
+             oneshot   Re-arm each link after each request (the default).
+
+   Output: 0 upon success or !0 upon failure.
+*/
+
+int XrdConfig::xpoll(XrdSysError *eDest, XrdOucStream &Config)
+{
+    char *val;
+
+    if (!(val = Config.GetWord()))
+       {eDest->Emsg("Config", "poller mode not specified"); return 1;}
+
+         if (!strcmp(val, "edge"))    XrdPoll::setEdge(true);
+    else if (!strcmp(val, "oneshot")) XrdPoll::setEdge(false);
+    else {eDest->Emsg("Config", "invalid poller mode -", val); return 1;}
+
+    return 0;
+}
+
 /******************************************************************************/
 /*                                 x p o r t                                  */
 /******************************************************************************/
@@ -1671,6 +1719,7 @@ int XrdConfig::xrep(XrdSysError *eDest, XrdOucStream &Config)
 
    Purpose:  To parse directive: sched [mint <mint>] [maxt <maxt>] [avlt <at>]
                                        [idle <idle>] [stksz <qnt>] [core <cv>]
+                                       [steal {off | on | <nq>}]
 
              <mint>   is the minimum number of threads that we need. Once
                       this number of threads is created, it does not decrease.
@@ -1687,6 +1736,10 @@ int XrdConfig::xrep(XrdSysError *eDest, XrdOucStream &Config)
              <idle>   The time (in time spec) between checks for underused
                       threads. Those found will be terminated. Default is 780.
              <qnt>    The thread stack size in bytes or K, M, or G.
+             steal    Gives each worker thread a home queue from which it takes
+                      work and, when empty, steals work from other queues.
+                      Specify on to use one queue per cpu or <nq> for a
+                      specific number of queues (1 to 64). The default is off.
 
    Output: 0 upon success or 1 upon failure.
 */
@@ -1696,7 +1749,7 @@ int XrdConfig::xsched(XrdSysError *eDest, XrdOucStream &Config)
     char *val;
     long long lpp;
     int  i, ppp = 0;
-    int  V_mint = -1, V_maxt = -1, V_idle = -1, V_avlt = -1;
+    int  V_mint = -1, V_maxt = -1, V_idle = -1, V_avlt = -1, V_steal = -2;
     struct schedopts {const char *opname; int minv; int *oploc;
                       const char *opmsg;} scopts[] =
        {
@@ -1705,7 +1758,8 @@ int XrdConfig::xsched(XrdSysError *eDest, XrdOucStream &Config)
         {"maxt",       1, &V_maxt, "sched maxt"},
         {"avlt",       1, &V_avlt, "sched avlt"},
         {"core",       1,       0, "sched core"},
-        {"idle",       0, &V_idle, "sched idle"}
+        {"idle",       0, &V_idle, "sched idle"},
+        {"steal",      1,       0, "sched steal"}
        };
     int numopts = sizeof(scopts)/sizeof(struct schedopts);
 
@@ -1732,6 +1786,14 @@ int XrdConfig::xsched(XrdSysError *eDest, XrdOucStream &Config)
                                   return 1;
                                  }
                            }
+                   else if (!strcmp(scopts[i].opname, "steal"))
+                           {     if (!strcmp("off", val)) V_steal = -1;
+                            else if (!strcmp("on",  val)) V_steal =  0;
+                            else if (XrdOuca2x::a2i(*eDest, scopts[i].opmsg,
+                                     val, &V_steal, scopts[i].minv, 64))
+                                    return 1;
+                            break;
+                           }
                    else if (*scopts[i].opname == 's')
                            {if (XrdOuca2x::a2sz(*eDest, scopts[i].opmsg, val,
                                                 &lpp, scopts[i].minv)) return 1;
@@ -1764,6 +1826,7 @@ int XrdConfig::xsched(XrdSysError *eDest, XrdOucStream &Config)
 // Establish scheduler options
 //
    Sched.setParms(V_mint, V_maxt, V_avlt, V_idle);
+   if (V_steal > -2) Sched.setSteal(V_steal);
    return 0;
 }
 
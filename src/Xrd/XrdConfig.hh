@@ -77,6 +77,7 @@ int   xbuf(XrdSysError *edest, XrdOucStream &Config);
 int   xnet(XrdSysError *edest, XrdOucStream &Config);
 int   xnkap(XrdSysError *edest, char *val);
 int   xlog(XrdSysError *edest, XrdOucStream &Config);
+int   xpoll(XrdSysError *edest, XrdOucStream &Config);
 int   xport(XrdSysError *edest, XrdOucStream &Config);
 int   xprot(XrdSysError *edest, XrdOucStream &Config);
 int   xrep(XrdSysError *edest, XrdOucStream &Config);
@@ -157,6 +157,7 @@ XrdLink::XrdLink() : XrdJob("connection"), IOSemaphore(0, "link i/o")
 {
   Etext = 0;
   HostName = 0;
+  coalBuff = 0;
   Reset();
 }
 
@@ -165,6 +166,9 @@ void XrdLink::Reset()
   FD    = -1;
   if (Etext)    {free(Etext); Etext = 0;}
   if (HostName) {free(HostName); HostName = 0;}
+  if (coalBuff) {free(coalBuff); coalBuff = 0;}
+  coalBsz  = coalMax = coalLen = 0;
+  coalOn   = false;
   Uname[sizeof(Uname)-1] = '@';
   Uname[sizeof(Uname)-2] = '?';
   Lname[0] = '?';
@@ -341,6 +345,12 @@ int XrdLink::Close(int defer)
 // commits suicide.
 // Note that we can hold the opMutex while we also get the wrMutex.
 //
+   if (coalBuff)
+      {wrMutex.Lock();
+       coalFlush();
+       free(coalBuff); coalBuff = 0; coalOn = false;
+       wrMutex.UnLock();
+      }
    if (defer)
       {if (!sendQ) Shutdown(false);
           else {TRACEI(DEBUG, "Shutdown FD only via SendQ");
@@ -422,6 +432,114 @@ int XrdLink::Close(int defer)
    return rc;
 }
 
+/******************************************************************************/
+/* private                       c o a l B e g                                */
+/******************************************************************************/
+
+// Called by the thread servicing the link. Only messages sent by this thread
+// are held back; all others are sent immediately.
+//
+void XrdLink::coalBeg()
+{
+   wrMutex.Lock();
+   coalTID = pthread_self();
+   coalOn  = true;
+   wrMutex.UnLock();
+}
+
+/******************************************************************************/
+/* private                       c o a l E n d                                */
+/******************************************************************************/
+
+void XrdLink::coalEnd()
+{
+   wrMutex.Lock();
+   coalOn = false;
+   if (coalLen) coalFlush();
+   wrMutex.UnLock();
+}
+
+/******************************************************************************/
+/* private                     c o a l F l u s h                              */
+/******************************************************************************/
+
+// Called with wrMutex locked.
+
+int XrdLink::coalFlush()
+{
+   struct iovec iov = {coalBuff, static_cast<size_t>(coalLen)};
+   int n = coalLen;
+
+   coalLen = 0;
+   return (n ? sendIOV(&iov, 1, n) : 0);
+}
+
+/******************************************************************************/
+/* private                      c o a l S e n d                               */
+/******************************************************************************/
+
+// Called with wrMutex locked.
+
+int XrdLink::coalSend(const struct iovec *iov, int iocnt, int bytes)
+{
+   static const int maxIOV = 16;
+   struct iovec ioV[maxIOV];
+   int i, retc;
+
+// If this is a small message from the servicing thread and it fits, copy it
+// into the buffer. We only hold back messages while the link is serviced.
+//
+   if (coalOn && bytes <= coalMax && pthread_equal(coalTID, pthread_self())
+   &&  bytes <= coalBsz - coalLen)
+      {char *bP = coalBuff + coalLen;
+       for (i = 0; i < iocnt; i++)
+           {memcpy(bP, iov[i].iov_base, iov[i].iov_len);
+            bP += iov[i].iov_len;
+           }
+       coalLen += bytes;
+       return bytes;
+      }
+
+// Send whatever is being held back followed by this message. If possible, we
+// do this in a single system call. Large messages always go out immediately.
+//
+   if (coalLen)
+      {if (iocnt < maxIOV)
+          {ioV[0].iov_base = coalBuff;
+           ioV[0].iov_len  = coalLen;
+           memcpy(&ioV[1], iov, iocnt*sizeof(struct iovec));
+           retc = sendIOV(ioV, iocnt+1, coalLen+bytes);
+           coalLen = 0;
+           return (retc < 0 ? retc : bytes);
+          }
+       if (coalFlush() < 0) return -1;
+      }
+   return sendIOV(iov, iocnt, bytes);
+}
+
+/******************************************************************************/
+/* private                      c o a l W a i t                               */
+/******************************************************************************/
+
+// Called before waiting for input. Held back messages are sent unless more
+// input is already waiting, in which case they will be sent with responses
+// to the pending requests.
+//
+void XrdLink::coalWait()
+{
+   struct pollfd polltab = {FD, POLLIN|POLLRDNORM, 0};
+   int retc;
+
+   wrMutex.Lock();
+   if (coalLen)
+      {if (coalOn)
+          {do {retc = poll(&polltab, 1, 0);} while(retc < 0 && errno == EINTR);
+          } else retc = 0;
+       if (retc != 1) coalFlush();
+      }
+   wrMutex.UnLock();
+}
+
 /******************************************************************************/
 /*                                  D o I t                                   */
 /******************************************************************************/
@@ -438,15 +556,18 @@ void XrdLink::DoIt()
 // > 0 -> Slow link, stop getting requests  and enable the link
 //
    if (Protocol)
-      do {rc = Protocol->Process(this);} while (!rc && XrdSched->canStick());
-      else {XrdLog->Emsg("Link", "Dispatch on closed link", ID);
-            return;
-           }
+      {if (coalBuff) coalBeg();
+       do {rc = Protocol->Process(this);} while (!rc && XrdSched->canStick());
+       if (coalBuff) coalEnd();
+      } else {XrdLog->Emsg("Link", "Dispatch on closed link", ID);
+              return;
+             }
 
 // Either re-enable the link and cycle back waiting for a new request, leave
 // disabled, or terminate the connection.
 //
-   if (rc >= 0) {if (Poller && !Poller->Enable(this)) Close();}
+   if (rc >= 0)
+      {if (Poller && !Poller->Resume(this)) Close();}
       else if (rc != -EINPROGRESS) Close();
 }
   
@@ -562,6 +683,7 @@ int XrdLink::Peek(char *Buff, int Blen, int timeout)
 // Wait until we can actually read something
 //
    isIdle = 0;
+   if (coalBuff) coalWait();
    do {retc = poll(&polltab, 1, timeout);} while(retc < 0 && errno == EINTR);
    if (retc != 1)
       {if (retc == 0) return 0;
@@ -601,6 +723,7 @@ int XrdLink::Recv(char *Buff, int Blen)
 //
    if (LockReads) rdMutex.Lock();
    isIdle = 0;
+   if (coalBuff) coalWait();
    do {rlen = read(FD, Buff, Blen);} while(rlen < 0 && errno == EINTR);
    if (rlen > 0) AtomicAdd(BytesIn, rlen);
    if (LockReads) rdMutex.UnLock();
@@ -626,6 +749,7 @@ int XrdLink::Recv(char *Buff, int Blen, int timeout)
 // Wait up to timeout milliseconds for data to arrive
 //
    isIdle = 0;
+   if (coalBuff) coalWait();
    while(Blen > 0)
         {do {retc = poll(&polltab,1,timeout);} while(retc < 0 && errno == EINTR);
          if (retc != 1)
@@ -677,6 +801,7 @@ int XrdLink::RecvAll(char *Buff, int Blen, int timeout)
 // Check if timeout specified. Notice that the timeout is the max we will
 // for some data. We will wait forever for all the data. Yeah, it's weird.
 //
+   if (coalBuff) coalWait();
    if (timeout >= 0)
       {do {retc = poll(&polltab,1,timeout);} while(retc < 0 && errno == EINTR);
        if (retc != 1)
@@ -719,6 +844,15 @@ int XrdLink::Send(const char *Buff, int Blen)
    isIdle = 0;
    AtomicAdd(BytesOut, Blen);
 
+// If we are coalescing output, let that handle the message
+//
+   if (coalBuff)
+      {struct iovec iov = {(void *)Buff, static_cast<size_t>(Blen)};
+       retc = coalSend(&iov, 1, Blen);
+       wrMutex.UnLock();
+       return retc;
+      }
+
 // Do non-blocking writes if we are setup to do so.
 //
    if (sendQ)
@@ -749,9 +883,7 @@ int XrdLink::Send(const char *Buff, int Blen)
   
 int XrdLink::Send(const struct iovec *iov, int iocnt, int bytes)
 {
-   ssize_t bytesleft, n, retc = 0;
-   const char *Buff;
-   int i;
+   int i, retc;
 
 // Add up bytes if they were not given to us
 //
@@ -763,44 +895,15 @@ int XrdLink::Send(const struct iovec *iov, int iocnt, int bytes)
    isIdle = 0;
    AtomicAdd(BytesOut, bytes);
 
-// Do non-blocking writes if we are setup to do so.
+// Send the data, coalescing it with other messages if we are doing so
 //
-   if (sendQ)
-      {retc = sendQ->Send(iov, iocnt, bytes);
-       wrMutex.UnLock();
-       return retc;
-      }
-
-// Write the data out. On some version of Unix (e.g., Linux) a writev() may
-// end at any time without writing all the bytes when directed to a socket.
-// So, we attempt to resume the writev() using a combination of write() and
-// a writev() continuation. This approach slowly converts a writev() to a
-// series of writes if need be. We must do this inline because we must hold
-// the lock until all the bytes are written or an error occurs.
-//
-   bytesleft = static_cast<ssize_t>(bytes);
-   while(bytesleft)
-        {do {retc = writev(FD, iov, iocnt);} while(retc < 0 && errno == EINTR);
-         if (retc >= bytesleft || retc < 0) break;
-         bytesleft -= retc;
-         while(retc >= (n = static_cast<ssize_t>(iov->iov_len)))
-              {retc -= n; iov++; iocnt--;}
-         Buff = (const char *)iov->iov_base + retc; n -= retc; iov++; iocnt--;
-         while(n) {if ((retc = write(FD, Buff, n)) < 0)
-                      {if (errno == EINTR) continue;
-                          else break;
-                      }
-                   n -= retc; Buff += retc;
-                  }
-         if (retc < 0 || iocnt < 1) break;
-        }
+   if (coalBuff) retc = coalSend(iov, iocnt, bytes);
+      else       retc = sendIOV(iov, iocnt, bytes);
 
 // All done
 //
    wrMutex.UnLock();
-   if (retc >= 0) return bytes;
-   XrdLog->Emsg("Link", errno, "send to", ID);
-   return -1;
+   return retc;
 }
  
 /******************************************************************************/
@@ -809,9 +912,14 @@ int XrdLink::Send(const sfVec *sfP, int sfN)
 #if !defined(HAVE_SENDFILE) || defined(__APPLE__)
    return -1;
 #else
-// Make sure we have valid vector count
+// Make sure we have valid vector count. Only Solaris needs a fixed size vector,
+// elsewhere the count is bounded by what a readv response can hold.
 //
+#ifdef __solaris__
    if (sfN < 1 || sfN > XrdOucSFVec::sfMax)
+#else
+   if (sfN < 1 || sfN > XrdOucSFVec::sfMaxRV)
+#endif
       {XrdLog->Emsg("Link", EINVAL, "send file to", ID);
        return -1;
       }
@@ -844,6 +952,11 @@ int XrdLink::Send(const sfVec *sfP, int sfN)
 //
    wrMutex.Lock();
    isIdle = 0;
+   if (coalLen && (coalFlush() < 0 || (sendQ && sendQ->Backlog())))
+      {wrMutex.UnLock();
+       XrdLog->Emsg("Link", EWOULDBLOCK, "send file to", ID);
+       return -1;
+      }
 do{retc = sendfilev(FD, vecSFP, sfN, &xframt);
 
 // Check if all went well and return if so (usual case)
@@ -897,8 +1010,15 @@ do{retc = sendfilev(FD, vecSFP, sfN, &xframt);
        uncork = 0; sfOK = 0;
       }
 
-// Send the header first
+// Send any held back messages, they will go out with the header as we are
+// corked. They go through the send queue when the link has one, in which case
+// the file data must not overtake anything still queued. Then send the header.
 //
+   if (coalLen && (coalFlush() < 0 || (sendQ && sendQ->Backlog())))
+      {wrMutex.UnLock();
+       XrdLog->Emsg("Link", EWOULDBLOCK, "send file to", ID);
+       return -1;
+      }
    for (i = 0; i < sfN; sfP++, i++)
        {if (sfP->fdnum < 0) retc = sendData(sfP->buffer, sfP->sendsz);
            else {myOffset = sfP->offset; bytesleft = sfP->sendsz;
@@ -958,6 +1078,79 @@ int XrdLink::sendData(const char *Buff, int Blen)
    return retc;
 }
 
+/******************************************************************************/
+/* private                       s e n d I O V                                */
+/******************************************************************************/
+
+// Called with wrMutex locked.
+  
+int XrdLink::sendIOV(const struct iovec *iov, int iocnt, int bytes)
+{
+   ssize_t bytesleft, n, retc = 0;
+   const char *Buff;
+
+// Do non-blocking writes if we are setup to do so.
+//
+   if (sendQ) return sendQ->Send(iov, iocnt, bytes);
+
+// Write the data out. On some version of Unix (e.g., Linux) a writev() may
+// end at any time without writing all the bytes when directed to a socket.
+// So, we attempt to resume the writev() using a combination of write() and
+// a writev() continuation. This approach slowly converts a writev() to a
+// series of writes if need be. We must do this inline because we must hold
+// the lock until all the bytes are written or an error occurs.
+//
+   bytesleft = static_cast<ssize_t>(bytes);
+   while(bytesleft)
+        {do {retc = writev(FD, iov, iocnt);} while(retc < 0 && errno == EINTR);
+         if (retc >= bytesleft || retc < 0) break;
+         bytesleft -= retc;
+         while(retc >= (n = static_cast<ssize_t>(iov->iov_len)))
+              {retc -= n; iov++; iocnt--;}
+         Buff = (const char *)iov->iov_base + retc; n -= retc; iov++; iocnt--;
+         while(n) {if ((retc = write(FD, Buff, n)) < 0)
+                      {if (errno == EINTR) continue;
+                          else break;
+                      }
+                   n -= retc; Buff += retc;
+                  }
+         if (retc < 0 || iocnt < 1) break;
+        }
+
+// All done
+//
+   if (retc >= 0) return bytes;
+   XrdLog->Emsg("Link", errno, "send to", ID);
+   return -1;
+}
+
+/******************************************************************************/
+/*                           s e t C o a l e s c e                            */
+/******************************************************************************/
+
+bool XrdLink::setCoalesce(int bsz, int maxmsg)
+{
+   char *newBuff = 0;
+
+// Allocate a new buffer, if need be
+//
+   if (bsz > 0 && !(newBuff = (char *)malloc(bsz))) return false;
+
+// Send anything being held back and swap buffers. As we are called by the
+// thread servicing the link, coalescing starts right away.
+//
+   wrMutex.Lock();
+   if (coalBuff) {coalFlush(); free(coalBuff);}
+   coalBuff = newBuff;
+   coalBsz  = bsz;
+   coalMax  = (maxmsg > 0 && maxmsg < bsz ? maxmsg : bsz);
+   coalLen  = 0;
+   coalTID  = pthread_self();
+   coalOn   = (coalBuff != 0);
+   wrMutex.UnLock();
+   return true;
+}
+
 /******************************************************************************/
 /*                              s e t E t e x t                               */
 /******************************************************************************/
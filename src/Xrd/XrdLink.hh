@@ -218,6 +218,14 @@ int           Send(const sfVec *sdP, int sdn); // Iff sfOK > 0
 
 void          Serialize();                              // ASYNC Mode
 
+// Hold back small messages sent while the link is being serviced and send
+// them together with a single system call when the protocol waits for input
+// (or the link is re-enabled). Messages larger than maxmsg are not held back.
+// A bsz of zero turns off coalescing. Returns false if memory is exhausted.
+// This must be called by the thread servicing the link (e.g. in Process()).
+//
+bool          setCoalesce(int bsz, int maxmsg=0);
+
 int           setEtext(const char *text);
 
 void          setID(const char *userid, int procid);
@@ -256,6 +264,12 @@ private:
 
 void   Reset();
 int    sendData(const char *Buff, int Blen);
+int    sendIOV(const struct iovec *iov, int iocnt, int bytes);
+void   coalBeg();
+void   coalEnd();
+int    coalFlush();
+int    coalSend(const struct iovec *iov, int iocnt, int bytes);
+void   coalWait();
 
 static XrdSysError  *XrdLog;
 static XrdOucTrace  *XrdTrace;
@@ -327,9 +341,15 @@ char                LockReads;
 char                KeepFD;
 char                isEnabled;
 char                isIdle;
-char                inQ;    // Only used by PollPoll.icc
+char                inQ;    // PollPoll.icc: queued; PollE.icc: edge pending
 char                isBridged;
 char                KillCnt;        // Protected by opMutex!
+bool                coalOn;         // Protected by wrMutex
+char               *coalBuff;       // Protected by wrMutex
+int                 coalBsz;
+int                 coalMax;
+int                 coalLen;        // Protected by wrMutex
+pthread_t           coalTID;        // Protected by wrMutex
 static const char   KillMax =   60;
 static const char   KillMsk = 0x7f;
 static const char   KillXwt = 0x80;
@@ -31,6 +31,7 @@
 #include <stdio.h>
 #include <stdlib.h>
   
+#include "XrdSys/XrdSysAtomics.hh"
 #include "XrdSys/XrdSysError.hh"
 #include "XrdSys/XrdSysFD.hh"
 #include "XrdSys/XrdSysPlatform.hh"
@@ -86,6 +87,8 @@ int           Stats(char *buff, int blen, int do_sync=0) {return 0;}
        XrdSysError  *XrdPoll::XrdLog   = 0;
        XrdScheduler *XrdPoll::XrdSched = 0;
 
+       bool          XrdPoll::edgeMode = false;
+
 /******************************************************************************/
 /*              T h r e a d   S t a r t u p   I n t e r f a c e               */
 /******************************************************************************/
@@ -117,6 +120,7 @@ XrdPoll::XrdPoll()
 
    TID=0;
    numAttached=numEnabled=numEvents=numInterrupts=0;
+   numWakeups=numDispatch=numSyscalls=0;
 
    if (XrdSysFD_Pipe(fildes) == 0)
       {CmdFD = fildes[1];
@@ -330,13 +334,15 @@ int XrdPoll::Setup(int numfd)
 int XrdPoll::Stats(char *buff, int blen, int do_sync)
 {
    static const char statfmt[] = "<stats id=\"poll\"><att>%d</att>"
-   "<en>%d</en><ev>%d</ev><int>%d</int></stats>";
+   "<en>%d</en><ev>%d</ev><int>%d</int><wk>%d</wk><disp>%d</disp>"
+   "<sc>%d</sc><evpw>%.2f</evpw><scpr>%.2f</scpr></stats>";
    int i, numatt = 0, numen = 0, numev = 0, numint = 0;
+   int numwk = 0, numdisp = 0, numsc = 0;
    XrdPoll *pp;
 
 // Return number of bytes if so wanted
 //
-   if (!buff) return (sizeof(statfmt)+(4*16))*XRD_NUMPOLLERS;
+   if (!buff) return (sizeof(statfmt)+(9*16))*XRD_NUMPOLLERS;
 
 // Get statistics. While we wish we could honor do_sync, doing so would be
 // costly and hardly worth it. So, we do not include code such as:
@@ -348,11 +354,19 @@ int XrdPoll::Stats(char *buff, int blen, int do_sync)
         numen  += pp->numEnabled;
         numev  += pp->numEvents;
         numint += pp->numInterrupts;
+        numwk  += pp->numWakeups;
+        numdisp+= AtomicGet(pp->numDispatch);
+        numsc  += AtomicGet(pp->numSyscalls);
        }
 
-// Format and return
+// Format and return. We also report the number of events per wakeup and the
+// number of system calls per dispatched request as these are the measures
+// of how efficiently we are polling.
 //
-   return snprintf(buff, blen, statfmt, numatt, numen, numev, numint);
+   return snprintf(buff, blen, statfmt, numatt, numen, numev, numint,
+                   numwk, numdisp, numsc,
+                   (numwk   ? static_cast<double>(numev)/numwk   : 0.0),
+                   (numdisp ? static_cast<double>(numsc)/numdisp : 0.0));
 }
   
 /******************************************************************************/
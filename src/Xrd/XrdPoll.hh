@@ -69,10 +69,23 @@ static  int   Finish(XrdLink *lp, const char *etxt=0); //Implementation supplied
 static  void  Init(XrdSysError *eP, XrdOucTrace *tP, XrdScheduler *sP)
                   {XrdLog = eP; XrdTrace = tP; XrdSched = sP;}
 
+// Resume() is called to enable a link once the protocol returns. The caller
+// sets drained only when it knows that all of the data that was available on
+// the link has been read (i.e., a read returned EAGAIN). Otherwise, pollers
+// using edge triggered events check for unread data before relying on the
+// next edge.
+//
+virtual int   Resume(XrdLink *lp, bool drained=false) {return Enable(lp);}
+
 // Poll2Text() converts bits in an revents item to text
 //
 static  char *Poll2Text(short events); // Implementation supplied
 
+// setEdge() is called at config time to request edge triggered polling. It
+//           is ignored by implementations that do not support it.
+//
+static  void  setEdge(bool onoff) {edgeMode = onoff;}
+
 // Setup() is called at config time to perform poller configuration
 //
 static  int   Setup(int numfd);        // Implementation supplied
@@ -103,6 +116,7 @@ static     const char   *TraceID;                  // For tracing
 static     XrdOucTrace  *XrdTrace;
 static     XrdSysError  *XrdLog;
 static     XrdScheduler *XrdSched;
+static     bool          edgeMode;                 // Use edge triggering
 
 // Gets the next request on the poll pipe. This is common to all implentations.
 //
@@ -143,6 +157,9 @@ int           PipeBlen;
            int         numEnabled;     // Count of Enable() calls
            int         numEvents;      // Count of poll fd's dispatched
            int         numInterrupts;  // Number of interrupts (e.g., signals)
+           int         numWakeups;     // Number of times poller woke up
+           int         numDispatch;    // Number of links scheduled (atomic)
+           int         numSyscalls;    // Number of poll system calls (atomic)
 
 private:
 
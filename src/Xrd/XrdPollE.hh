@@ -45,6 +45,8 @@ public:
 
        int   Enable(XrdLink *lp);
 
+       int   Resume(XrdLink *lp, bool drained=false);
+
        void Start(XrdSysSemaphore *syncp, int &rc);
 
             XrdPollE(struct epoll_event *ptab, int numfd, int pfd)
@@ -57,6 +59,7 @@ protected:
 const  char *x2Text(unsigned int evf, char *buff);
 
 private:
+int  reArm(XrdLink *lp);
 void remFD(XrdLink *lp, unsigned int events);
 
 #ifdef EPOLLONESHOT
@@ -67,6 +70,13 @@ void remFD(XrdLink *lp, unsigned int events);
    static const int ePollEvents = EPOLLIN  | EPOLLHUP | EPOLLPRI | EPOLLERR |
                                   EPOLLRDHUP | ePollOneShot;
 
+// In edge triggered mode links stay in the poll set. Events that occur while
+// a link is disabled are recorded (lp->inQ) and acted upon when it is enabled.
+//
+   static const int ePollEdge   = EPOLLIN  | EPOLLHUP | EPOLLPRI | EPOLLERR |
+                                  EPOLLRDHUP | EPOLLET;
+
+XrdSysMutex         EdgeMutex;   // Serializes edge state with Resume()
 struct epoll_event *PollTab;
        int          PollDfd;
        int          PollMax;
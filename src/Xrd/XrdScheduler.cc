@@ -29,8 +29,10 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <sched.h>
 #include <signal.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/resource.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -41,6 +43,7 @@
 
 #include "Xrd/XrdJob.hh"
 #include "Xrd/XrdScheduler.hh"
+#include "XrdSys/XrdSysAtomics.hh"
 #include "XrdSys/XrdSysError.hh"
 
 #define XRD_TRACE XrdTrace->
@@ -52,6 +55,16 @@
 
        const char   *XrdScheduler::TraceID = "Sched";
 
+// Each worker thread, when work stealing is enabled, has a home queue. The
+// value is 1-origin with zero indicating the thread is not a worker.
+//
+namespace
+{
+static __thread int wsqHome = 0;
+
+static const int    wsqMax  = 64;
+}
+
 /******************************************************************************/
 /*                         L o c a l   C l a s s e s                          */
 /******************************************************************************/
@@ -65,6 +78,21 @@ class XrdSchedulerPID
                         {next = prev; pid = newpid;}
      ~XrdSchedulerPID() {}
      };
+
+// A work stealing queue. The depth is read without the lock to quickly skip
+// empty queues. Each queue is padded to avoid sharing cache lines.
+//
+struct XrdScheduler::WSQueue
+      {XrdSysMutex   qMutex;
+       XrdJob       *First;
+       XrdJob       *Last;
+       volatile int  Depth;
+       int           MaxDepth;
+       char          Pad[64];
+
+                     WSQueue() : First(0), Last(0), Depth(0), MaxDepth(0) {}
+                    ~WSQueue() {}
+      };
   
 /******************************************************************************/
 /*            E x t e r n a l   T h r e a d   I n t e r f a c e s             */
@@ -114,8 +142,15 @@ XrdScheduler::XrdScheduler(XrdSysError *eP, XrdOucTrace *tP,
     num_TDestroy=  0;
     num_Layoffs =  0;
     num_Limited =  0;
+    num_Steals  =  0;
     firstPID    =  0;
     WorkFirst = WorkLast = TimerQueue = 0;
+    wsqTab      =  0;
+    wsqNum      = -1;
+    wsqSpin     = 32;
+    wsqParked   =  0;
+    wsqNext     =  0;
+    wsqAssign   =  0;
 
 // Make sure we are using the maximum number of threads allowed (Linux only)
 //
@@ -218,7 +253,8 @@ void XrdScheduler::DoIt()
           {if (num_kill > 1) num_kill = num_kill/2;
            SchedMutex.Lock();
            num_Layoffs = num_kill;
-           while(num_kill--) WorkAvail.Post();
+           if (wsqTab) wsqWake(num_kill);
+              else while(num_kill--) WorkAvail.Post();
            SchedMutex.UnLock();
           }
       }
@@ -323,6 +359,10 @@ void XrdScheduler::Run()
    int waiting;
    XrdJob *jp;
 
+// If we are using per-worker queues, use the work stealing loop instead
+//
+   if (wsqTab) {wsqRun(); return;}
+
 // Wait for work then do it (an endless task for a worker thread)
 //
    do {do {DispatchMutex.Lock();          idl_Workers++;DispatchMutex.UnLock();
@@ -364,6 +404,10 @@ void XrdScheduler::Run()
   
 void XrdScheduler::Schedule(XrdJob *jp)
 {
+// If we are using per-worker queues, add it to the appropriate one
+//
+   if (wsqTab) {wsqAdd(1, jp, jp); return;}
+
 // Lock down our data area
 //
    SchedMutex.Lock();
@@ -396,6 +440,10 @@ void XrdScheduler::Schedule(XrdJob *jp)
 void XrdScheduler::Schedule(int numjobs, XrdJob *jfirst, XrdJob *jlast)
 {
 
+// If we are using per-worker queues, add the list to the appropriate one
+//
+   if (wsqTab) {wsqAdd(numjobs, jfirst, jlast); return;}
+
 // Lock down our data area
 //
    SchedMutex.Lock();
@@ -505,6 +553,28 @@ void XrdScheduler::setParms(int minw, int maxw, int avlw, int maxi, int once)
    TRACE(SCHED,"Set stk_Workers=" <<stk_Workers <<" max_Workidl=" <<max_Workidl);
 }
 
+/******************************************************************************/
+/*                              s e t S t e a l                               */
+/******************************************************************************/
+
+void XrdScheduler::setSteal(int nq, int spin)
+{
+#ifdef HAVE_ATOMICS
+// Establish the number of queues (this is only effective prior to Start())
+//
+   if (nq == 0)
+      {long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+       nq = (ncpu > 0 ? static_cast<int>(ncpu) : 1);
+      }
+   wsqNum = (nq > wsqMax ? wsqMax : nq);
+   if (spin >= 0) wsqSpin = spin;
+#else
+   if (nq >= 0)
+      XrdLog->Say("Config warning: work stealing requires atomics; "
+                  "scheduler is using a single queue.");
+#endif
+}
+
 /******************************************************************************/
 /*                                 S t a r t                                  */
 /******************************************************************************/
@@ -514,6 +584,13 @@ void XrdScheduler::Start() // Serialized one time call!
     int retc, numw;
     pthread_t tid;
 
+// Allocate the per-worker queues if we will be using them
+//
+   if (wsqNum > 0)
+      {wsqTab = new WSQueue[wsqNum];
+       TRACE(SCHED, "Using " <<wsqNum <<" work stealing queues");
+      }
+
 // Start a time based scheduler
 //
    if ((retc = XrdSysThread::Run(&tid, XrdStartTSched, (void *)this,
@@ -541,16 +618,19 @@ void XrdScheduler::Start() // Serialized one time call!
 int XrdScheduler::Stats(char *buff, int blen, int do_sync)
 {
     int cnt_Jobs, cnt_JobsinQ, xam_QLength, cnt_Workers, cnt_idl;
-    int cnt_TCreate, cnt_TDestroy, cnt_Limited;
+    int cnt_TCreate, cnt_TDestroy, cnt_Limited, i, n;
     static char statfmt[] = "<stats id=\"sched\"><jobs>%d</jobs>"
                 "<inq>%d</inq><maxinq>%d</maxinq>"
                 "<threads>%d</threads><idle>%d</idle>"
                 "<tcr>%d</tcr><tde>%d</tde>"
-                "<tlimr>%d</tlimr></stats>";
+                "<tlimr>%d</tlimr>";
+    static char wsqfmt[]  = "<wsq><n>%d</n><steals>%d</steals><qd>";
 
 // If only length wanted, do so
 //
-   if (!buff) return sizeof(statfmt) + 16*8;
+   if (!buff) return sizeof(statfmt) + 16*8 + sizeof("</stats>")
+                   + (wsqTab ? sizeof(wsqfmt) + 16*2 + sizeof("</qd></wsq>")
+                             + 12*wsqNum : 0);
 
 // Get values protected by the Dispatch lock (avoid lock if no sync needed)
 //
@@ -570,11 +650,25 @@ int XrdScheduler::Stats(char *buff, int blen, int do_sync)
    cnt_Limited = num_Limited;
    if (do_sync) SchedMutex.UnLock();
 
-// Format the stats and return them
+// Format the stats
+//
+   n = snprintf(buff, blen, statfmt, cnt_Jobs, cnt_JobsinQ, xam_QLength,
+                cnt_Workers, cnt_idl, cnt_TCreate, cnt_TDestroy,
+                cnt_Limited);
+
+// Add the per-worker queue depths, if we are using them
 //
-   return snprintf(buff, blen, statfmt, cnt_Jobs, cnt_JobsinQ, xam_QLength,
-                   cnt_Workers, cnt_idl, cnt_TCreate, cnt_TDestroy,
-                   cnt_Limited);
+   if (wsqTab && n < blen)
+      {n += snprintf(buff+n, blen-n, wsqfmt, wsqNum, num_Steals);
+       for (i = 0; i < wsqNum && n < blen; i++)
+           n += snprintf(buff+n, blen-n, (i ? ",%d" : "%d"), wsqTab[i].Depth);
+       if (n < blen) n += snprintf(buff+n, blen-n, "</qd></wsq>");
+      }
+
+// Add the trailer and return
+//
+   if (n < blen) n += snprintf(buff+n, blen-n, "</stats>");
+   return (n < blen ? n : blen-1);
 }
 
 /******************************************************************************/
@@ -648,6 +742,182 @@ void XrdScheduler::hireWorker(int dotrace)
       } else if (dotrace) TRACE(SCHED, "Now have " <<num_Workers <<" workers" );
 }
  
+/******************************************************************************/
+/*                                w s q A d d                                 */
+/******************************************************************************/
+
+// Work stealing is only enabled when atomics are available (see setSteal()).
+// Otherwise, these methods are never called and are simply stubs.
+//
+#ifdef HAVE_ATOMICS
+// A worker adds jobs to its own queue; other threads distribute them across
+// the queues in a round-robin fashion. Idle workers are only woken if some
+// are actually waiting, which avoids thundering herds.
+//
+void XrdScheduler::wsqAdd(int num, XrdJob *jfirst, XrdJob *jlast)
+{
+   int inq, qn = (wsqHome ? wsqHome-1 : AtomicInc(wsqNext) % wsqNum);
+   WSQueue &wq = wsqTab[qn];
+
+// Place the jobs on the queue
+//
+   jlast->NextJob = 0;
+   wq.qMutex.Lock();
+   if (wq.First) wq.Last->NextJob = jfirst;
+      else       wq.First = jfirst;
+   wq.Last = jlast;
+   wq.Depth += num;
+   if (wq.Depth > wq.MaxDepth) wq.MaxDepth = wq.Depth;
+   wq.qMutex.UnLock();
+
+// Calculate statistics
+//
+   AtomicAdd(num_Jobs, num);
+   inq = AtomicAdd(num_JobsinQ, num) + num;
+   if (inq > max_QLength) max_QLength = inq;
+
+// Wake up as many waiting workers as needed
+//
+   wsqWake(num);
+}
+
+/******************************************************************************/
+/*                                w s q G e t                                 */
+/******************************************************************************/
+
+// Take the first job from our home queue. If there is none, steal the first
+// job from another queue. Jobs are always taken in FIFO order so that no
+// client is starved by later arrivals.
+//
+XrdJob *XrdScheduler::wsqGet(int home)
+{
+   XrdJob *jp;
+   int i, qn = home;
+
+   for (i = 0; i < wsqNum; i++, qn = (qn+1 < wsqNum ? qn+1 : 0))
+       {WSQueue &wq = wsqTab[qn];
+        if (!wq.Depth) continue;
+        wq.qMutex.Lock();
+        if ((jp = wq.First))
+           {if (!(wq.First = jp->NextJob)) wq.Last = 0;
+            wq.Depth--;
+            wq.qMutex.UnLock();
+            AtomicDec(num_JobsinQ);
+            if (qn != home) AtomicInc(num_Steals);
+            return jp;
+           }
+        wq.qMutex.UnLock();
+       }
+   return 0;
+}
+
+/******************************************************************************/
+/*                             w s q L a y o f f                              */
+/******************************************************************************/
+
+// Called by a worker that was woken but found no work. Returns true if the
+// worker should terminate.
+//
+bool XrdScheduler::wsqLayoff()
+{
+   bool bye = false;
+
+   SchedMutex.Lock();
+   if (num_Layoffs > 0)
+      {num_Layoffs--;
+       if (AtomicGet(idl_Workers) > 1)
+          {AtomicDec(idl_Workers);
+           num_TDestroy++; num_Workers--;
+           TRACE(SCHED, "terminating thread; workers=" <<num_Workers);
+           bye = true;
+          }
+      }
+   SchedMutex.UnLock();
+   return bye;
+}
+
+/******************************************************************************/
+/*                                w s q R u n                                 */
+/******************************************************************************/
+  
+void XrdScheduler::wsqRun()
+{
+   XrdJob *jp;
+   int i, home;
+
+// Assign this worker a home queue
+//
+   home = AtomicInc(wsqAssign) % wsqNum;
+   wsqHome = home+1;
+
+// Find work, spinning a bit before waiting, then do it (an endless task)
+//
+   do {AtomicInc(idl_Workers);
+       do {if ((jp = wsqGet(home))) break;
+           for (i = 0; i < wsqSpin; i++)
+               {sched_yield();
+                if ((jp = wsqGet(home))) break;
+               }
+           if (jp) break;
+
+        // Indicate we are about to wait and look one last time. If we find
+        // work, retract the wait unless a wakeup was already sent our way.
+        //
+           AtomicInc(wsqParked);
+           if ((jp = wsqGet(home)))
+              {if (!wsqUnpark()) WorkAvail.Wait();
+               break;
+              }
+           WorkAvail.Wait();
+           if (!(jp = wsqGet(home)) && wsqLayoff()) return;
+          } while(!jp);
+
+    // Check if we should hire a new worker (we always want 1 idle thread)
+    // before running this job.
+    //
+       if (AtomicDec(idl_Workers) <= 1) hireWorker();
+       if (TRACING(TRACE_SCHED) && *(jp->Comment) != '.')
+          {TRACE(SCHED, "running " <<jp->Comment <<" inq=" <<num_JobsinQ);}
+       jp->DoIt();
+      } while(1);
+}
+
+/******************************************************************************/
+/*                             w s q U n p a r k                              */
+/******************************************************************************/
+
+// Retract a pending wait. False is returned if a wakeup has already been
+// issued which the caller must consume.
+//
+bool XrdScheduler::wsqUnpark()
+{
+   int n;
+
+   while((n = AtomicGet(wsqParked)) > 0)
+        if (AtomicCAS(wsqParked, n, n-1)) return true;
+   return false;
+}
+
+/******************************************************************************/
+/*                               w s q W a k e                                */
+/******************************************************************************/
+
+void XrdScheduler::wsqWake(int num)
+{
+   int n;
+
+   while(num > 0 && (n = AtomicGet(wsqParked)) > 0)
+        if (AtomicCAS(wsqParked, n, n-1)) {WorkAvail.Post(); num--;}
+}
+#else
+void    XrdScheduler::wsqAdd(int, XrdJob *, XrdJob *) {}
+XrdJob *XrdScheduler::wsqGet(int) {return 0;}
+bool    XrdScheduler::wsqLayoff() {return true;}
+void    XrdScheduler::wsqRun() {}
+bool    XrdScheduler::wsqUnpark() {return true;}
+void    XrdScheduler::wsqWake(int) {}
+#endif
+
 /******************************************************************************/
 /*                             t r a c e E x i t                              */
 /******************************************************************************/
@@ -66,6 +66,13 @@ void          Schedule(XrdJob *jp, time_t atime);
 
 void          setParms(int minw, int maxw, int avlt, int maxi, int once=0);
 
+// Use per-worker queues with work stealing; must be called prior to Start().
+// When nq is zero, the number of queues is the number of cpus (max 64).
+// A negative value disables the mode. Idle workers look for work spin times
+// before waiting.
+//
+void          setSteal(int nq, int spin=-1);
+
 void          Start();
 
 int           Stats(char *buff, int blen, int do_sync=0);
@@ -79,6 +86,7 @@ int        num_TDestroy;// Number of threads destroyed
 int        num_Jobs;    // Number of jobs scheduled
 int        max_QLength; // Longest queue length we had
 int        num_Limited; // Number of times max was reached
+int        num_Steals;  // Number of jobs taken from another worker's queue
 
 // Constructor and destructor
 //
@@ -114,6 +122,21 @@ XrdSysMutex            TimerMutex; // Protects scheduler area
 XrdSchedulerPID       *firstPID;
 XrdSysMutex            ReaperMutex;
 
+struct WSQueue;
+WSQueue               *wsqTab;     // Steal: Per-worker queues (0 -> not used)
+int                    wsqNum;     // Steal: Number of queues
+int                    wsqSpin;    // Steal: Spins before an idle worker waits
+int                    wsqParked;  // Steal: Workers waiting on WorkAvail
+unsigned int           wsqNext;    // Steal: Queue for next external job
+unsigned int           wsqAssign;  // Steal: Queue for next worker thread
+
+void    wsqAdd(int num, XrdJob *jfirst, XrdJob *jlast);
+XrdJob *wsqGet(int home);
+bool    wsqLayoff();
+void    wsqRun();
+bool    wsqUnpark();
+void    wsqWake(int num);
+
 void hireWorker(int dotrace=1);
 void Monitor();
 void traceExit(pid_t pid, int status);
@@ -31,6 +31,19 @@ if( NOT XRDCL_ONLY )
     pthread
     ${ZLIB_LIBRARY} )
 
+  #-----------------------------------------------------------------------------
+  # xrdcksbench (checksum kernel benchmark, not installed)
+  #-----------------------------------------------------------------------------
+  add_executable(
+    xrdcksbench
+    XrdApps/XrdCksBench.cc )
+
+  target_link_libraries(
+    xrdcksbench
+    XrdUtils
+    pthread
+    ${ZLIB_LIBRARY} )
+
   #-----------------------------------------------------------------------------
   # cconfig
   #-----------------------------------------------------------------------------
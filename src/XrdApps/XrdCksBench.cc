@@ -0,0 +1,228 @@
+/******************************************************************************/
+/*                                                                            */
+/*                       X r d C k s B e n c h . c c                          */
+/*                                                                            */
+/* (c) 2019 by the Board of Trustees of the Leland Stanford, Jr., University  */
+/*                            All Rights Reserved                             */
+/*   Produced by Andrew Hanushevsky for Stanford University under contract    */
+/*              DE-AC02-76-SFO0515 with the Department of Energy              */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+// This program compares the checksum kernels in XrdCksAccel against each other
+// and against zlib over a range of buffer sizes. Each kernel must produce the
+// same result as the scalar one (the original implementation); otherwise the
+// program exits with a non-zero status.
+//
+// Usage: xrdcksbench [-m <mbytes>] [<bsz> [<bsz> [...]]]
+//
+// <mbytes> is the amount of data to run through each kernel for each buffer
+// size (default 256) and <bsz> a buffer size (suffix k, m, or g allowed).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <zlib.h>
+
+#include "XrdCks/XrdCksAccel.hh"
+#include "XrdOuc/XrdOucCRC.hh"
+
+/******************************************************************************/
+/*                         L o c a l   S t a t i c s                          */
+/******************************************************************************/
+
+namespace
+{
+const long long defSizes[] = {64, 511, 4096, 65536, 1000003, 67108864, 0};
+
+long long mbTotal = 256;
+
+bool      allOK   = true;
+
+double Now()
+{
+   struct timeval tv;
+   gettimeofday(&tv, 0);
+   return tv.tv_sec + tv.tv_usec/1000000.0;
+}
+
+void Report(const char *ktype, const char *kname, long long bsz,
+            long long bytes, double secs, unsigned int rslt, unsigned int ref)
+{
+   double mbs = (secs > 0 ? bytes/secs/1048576.0 : 0.0);
+
+   printf("%-7s %-8s %10lld %10.1f MB/s %08x%s\n", ktype, kname, bsz, mbs,
+          rslt, (rslt == ref ? "" : " MISMATCH!"));
+   if (rslt != ref) allOK = false;
+}
+
+long long Size(const char *val)
+{
+   char *eP;
+   long long sz = strtoll(val, &eP, 10);
+
+   switch(*eP)
+         {case 'k': case 'K': sz <<= 10; eP++; break;
+          case 'm': case 'M': sz <<= 20; eP++; break;
+          case 'g': case 'G': sz <<= 30; eP++; break;
+          default: break;
+         }
+   if (*eP || sz <= 0 || sz > 0x7fffffff)
+      {fprintf(stderr, "xrdcksbench: invalid buffer size - %s\n", val);
+       exit(2);
+      }
+   return sz;
+}
+
+void Usage()
+{
+   fprintf(stderr,"Usage: xrdcksbench [-m <mbytes>] [<bsz> [<bsz> [...]]]\n");
+   exit(2);
+}
+}
+
+/******************************************************************************/
+/*                                 A d l e r                                  */
+/******************************************************************************/
+
+void Adler(const char *buff, long long bsz, int reps)
+{
+   const char **kList = XrdCksAccel::Adler32List();
+   XrdCksAccel::Adler32_t kFunc;
+   unsigned int s1, s2, ref = 0;
+   double tBeg;
+   int i;
+
+// Run each kernel that this cpu supports (the first is the reference)
+//
+   for (int k = 0; kList[k]; k++)
+       {if (!(kFunc = XrdCksAccel::Adler32Impl(kList[k]))) continue;
+        tBeg = Now();
+        for (i = 0; i < reps; i++)
+            {s1 = 1; s2 = 0;
+             kFunc(s1, s2, (const unsigned char *)buff, (int)bsz);
+            }
+        if (!k) ref = (s2 << 16) | s1;
+        Report("adler32", kList[k], bsz, bsz*reps, Now()-tBeg,
+               (s2 << 16) | s1, ref);
+       }
+
+// Now do the same for zlib
+//
+   uLong zsum = 0;
+   tBeg = Now();
+   for (i = 0; i < reps; i++)
+       zsum = adler32(adler32(0L, Z_NULL, 0), (const Bytef *)buff, bsz);
+   Report("adler32", "zlib", bsz, bsz*reps, Now()-tBeg, zsum, ref);
+}
+
+/******************************************************************************/
+/*                                 C r c 3 2                                  */
+/******************************************************************************/
+
+void Crc32(const char *buff, long long bsz, int reps)
+{
+   const char **kList = XrdCksAccel::Crc32List();
+   XrdCksAccel::Crc32_t kFunc;
+   unsigned int crc = 0, ref = 0;
+   double tBeg;
+   int i;
+
+// Run each kernel that this cpu supports (the first is the reference)
+//
+   for (int k = 0; kList[k]; k++)
+       {if (!(kFunc = XrdCksAccel::Crc32Impl(kList[k]))) continue;
+        tBeg = Now();
+        for (i = 0; i < reps; i++)
+            crc = kFunc(0, (const unsigned char *)buff, (int)bsz);
+        if (!k) ref = crc;
+        Report("crc32", kList[k], bsz, bsz*reps, Now()-tBeg, crc, ref);
+       }
+
+// The reflected crc32 (XrdOucCRC) is checked against zlib
+//
+   uLong zcrc = 0;
+   tBeg = Now();
+   for (i = 0; i < reps; i++)
+       zcrc = crc32(crc32(0L, Z_NULL, 0), (const Bytef *)buff, bsz);
+   Report("crc32r", "zlib", bsz, bsz*reps, Now()-tBeg, zcrc, zcrc);
+
+   tBeg = Now();
+   for (i = 0; i < reps; i++)
+       crc = XrdOucCRC::CRC32((const unsigned char *)buff, (int)bsz);
+   Report("crc32r", "slice8", bsz, bsz*reps, Now()-tBeg, crc, zcrc);
+}
+
+/******************************************************************************/
+/*                                  m a i n                                   */
+/******************************************************************************/
+
+int main(int argc, char *argv[])
+{
+   long long bsz, sizes[64];
+   char *buff;
+   int c, i, n = 0, reps;
+
+// Process the options
+//
+   while ((c = getopt(argc, argv, "m:")) != -1)
+         {switch(c)
+                {case 'm': mbTotal = atoll(optarg);
+                           if (mbTotal <= 0) Usage();
+                           break;
+                 default:  Usage();
+                }
+         }
+
+// Get the buffer sizes
+//
+   if (optind >= argc)
+      {for (i = 0; defSizes[i]; i++) sizes[n++] = defSizes[i];}
+      else while(optind < argc && n < (int)(sizeof(sizes)/sizeof(sizes[0])))
+                 sizes[n++] = Size(argv[optind++]);
+
+// Run through each size using data that is not too regular. The buffer is
+// offset by one byte to exercise unaligned access.
+//
+   for (i = 0; i < n; i++)
+       {bsz = sizes[i];
+        if (!(buff = (char *)malloc(bsz+1)))
+           {fprintf(stderr, "xrdcksbench: unable to allocate buffer\n");
+            return 3;
+           }
+        srandom(bsz);
+        for (long long j = 0; j <= bsz; j++) buff[j] = (char)random();
+        reps = (int)((mbTotal*1048576LL)/bsz);
+        if (reps < 1) reps = 1;
+        Adler(buff+1, bsz, reps);
+        Crc32(buff+1, bsz, reps);
+        free(buff);
+        printf("\n");
+       }
+
+// All done
+//
+   if (!allOK) printf("xrdcksbench: some kernels produced wrong results!\n");
+   return (allOK ? 0 : 1);
+}
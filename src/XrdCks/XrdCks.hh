@@ -218,6 +218,31 @@ int        Ver(  const char *Pfn, XrdCksData &Cks) = 0;
 //------------------------------------------------------------------------------
 virtual   ~XrdCks() {}
 
+//------------------------------------------------------------------------------
+//! Calculate several checksums for a physical file. Implementations should
+//! do this in a single pass over the file. The default simply calls Calc()
+//! for each checksum. This is the last virtual method so that plugins built
+//! against prior versions of this class keep a compatible vtable.
+//!
+//! @param  Pfn       The physical name of the file to be checksumed.
+//! @param  Cks       Array of csNum checksum objects. For input, each specifies
+//!                   a checksum algorithm. For output, each holds the value.
+//! @param  csNum     The number of elements in the Cks array.
+//! @param  doSet     When true, the new values must replace existing values
+//!                   in the Pfn's extended file attributes.
+//!
+//! @return Success:  zero with each Cks structure holding the checksum value.
+//!         Failure: -errno (see significant error numbers below).
+//------------------------------------------------------------------------------
+virtual
+int        Calc( const char *Pfn, XrdCksData *Cks, int csNum, int doSet=1)
+{
+  int rc;
+  for (int i = 0; i < csNum; i++)
+      if ((rc = Calc(Pfn, Cks[i], doSet))) return rc;
+  return 0;
+}
+
 /*! Significant errno values:
 
    -EDOM       The supplied checksum length is invalid for the checksum name.
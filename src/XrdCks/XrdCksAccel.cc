@@ -0,0 +1,537 @@
+/******************************************************************************/
+/*                                                                            */
+/*                       X r d C k s A c c e l . c c                          */
+/*                                                                            */
+/* (c) 2019 by the Board of Trustees of the Leland Stanford, Jr., University  */
+/*                            All Rights Reserved                             */
+/*   Produced by Andrew Hanushevsky for Stanford University under contract    */
+/*              DE-AC02-76-SFO0515 with the Department of Energy              */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <pthread.h>
+#include <string.h>
+
+#include "XrdCks/XrdCksAccel.hh"
+
+// The vector kernels are compiled using function level target attributes so
+// that the rest of the code need not be compiled for a particular cpu. This
+// requires gcc 4.9 or later (or clang).
+//
+#if defined(__x86_64__) && (defined(__clang__) || (defined(__GNUC__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define XRDCKS_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+/******************************************************************************/
+/*                        S t a t i c   M e m b e r s                         */
+/******************************************************************************/
+
+XrdCksAccel::Adler32_t XrdCksAccel::adler32Fn = XrdCksAccel::adler32Init;
+XrdCksAccel::Crc32_t   XrdCksAccel::crc32Fn   = XrdCksAccel::crc32Init;
+
+/******************************************************************************/
+/*                         L o c a l   S t a t i c s                          */
+/******************************************************************************/
+
+namespace
+{
+const unsigned int AdlerBase = 0xFFF1;
+const          int AdlerNMax = 5552;
+
+/* NMAX is the largest n such that 255n(n+1)/2 + (n+1)(BASE-1) <= 2^32-1 */
+
+const unsigned long long Crc32Poly = 0x104C11DB7ULL;
+
+unsigned int       crcTab[8][256];  // crcTab[0] is the classic byte table
+unsigned long long crcK128;         // x**128 mod P
+unsigned long long crcK192;         // x**192 mod P
+unsigned long long crcK512;         // x**512 mod P
+unsigned long long crcK576;         // x**576 mod P
+
+pthread_once_t     onceSetup = PTHREAD_ONCE_INIT;
+
+const char        *adlerName = "scalar";
+const char        *crcName   = "scalar";
+
+#ifdef XRDCKS_X86
+bool               hasSSSE3  = false;
+bool               hasAVX2   = false;
+bool               hasPCLMUL = false;
+#endif
+}
+
+/******************************************************************************/
+/*                        a d l e r 3 2 _ s c a l a r                         */
+/******************************************************************************/
+
+/* The following implementation of adler32 was derived from zlib and is
+                   * Copyright (C) 1995-1998 Mark Adler
+   Below are the zlib license terms for this implementation.
+*/
+  
+/* zlib.h -- interface of the 'zlib' general purpose compression library
+  version 1.1.4, March 11th, 2002
+
+  Copyright (C) 1995-2002 Jean-loup Gailly and Mark Adler
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+
+  Jean-loup Gailly        Mark Adler
+  jloup@gzip.org          madler@alumni.caltech.edu
+
+
+  The data format used by the zlib library is described by RFCs (Request for
+  Comments) 1950 to 1952 in the files ftp://ds.internic.net/rfc/rfc1950.txt
+  (zlib format), rfc1951.txt (deflate format) and rfc1952.txt (gzip format).
+*/
+
+#define DO1(buf)  {unSum1 += *buf++; unSum2 += unSum1;}
+#define DO2(buf)  DO1(buf); DO1(buf);
+#define DO4(buf)  DO2(buf); DO2(buf);
+#define DO8(buf)  DO4(buf); DO4(buf);
+#define DO16(buf) DO8(buf); DO8(buf);
+
+namespace
+{
+void adler32_scalar(unsigned int &sum1, unsigned int &sum2,
+                    const unsigned char *buff, int BLen)
+{
+   unsigned int unSum1 = sum1, unSum2 = sum2;
+   int k;
+
+   while(BLen > 0)
+        {k = (BLen < AdlerNMax ? BLen : AdlerNMax);
+         BLen -= k;
+         while(k >= 16) {DO16(buff); k -= 16;}
+         if (k != 0) do {DO1(buff);} while (--k);
+         unSum1 %= AdlerBase; unSum2 %= AdlerBase;
+        }
+   sum1 = unSum1; sum2 = unSum2;
+}
+}
+
+/******************************************************************************/
+/*                         a d l e r 3 2 _ s s s e 3                          */
+/******************************************************************************/
+
+// The vector versions process 32 byte blocks. The sum of the bytes in a block
+// is accumulated via sad and the position weighted sum via maddubs. The sum1
+// value prior to each block is accumulated in "ps" and added to sum2 (times
+// the block size) at the end of each run of at most NMAX bytes.
+//
+#ifdef XRDCKS_X86
+namespace
+{
+__attribute__((target("ssse3")))
+void adler32_ssse3(unsigned int &sum1, unsigned int &sum2,
+                   const unsigned char *buff, int blen)
+{
+   const int    blkSz = 32;
+   const __m128i tap1 = _mm_setr_epi8(32,31,30,29,28,27,26,25,
+                                      24,23,22,21,20,19,18,17);
+   const __m128i tap2 = _mm_setr_epi8(16,15,14,13,12,11,10, 9,
+                                       8, 7, 6, 5, 4, 3, 2, 1);
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i ones = _mm_set1_epi16(1);
+   unsigned int s1 = sum1, s2 = sum2;
+   int n, blocks = blen / blkSz;
+
+   blen -= blocks * blkSz;
+   while(blocks)
+        {n = AdlerNMax / blkSz;
+         if (n > blocks) n = blocks;
+         blocks -= n;
+
+         __m128i v_ps = _mm_set_epi32(0, 0, 0, s1 * n);
+         __m128i v_s2 = _mm_set_epi32(0, 0, 0, s2);
+         __m128i v_s1 = zero;
+
+         do {const __m128i b1 = _mm_loadu_si128((const __m128i *)buff);
+             const __m128i b2 = _mm_loadu_si128((const __m128i *)(buff+16));
+             v_ps = _mm_add_epi32(v_ps, v_s1);
+             v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(b1, zero));
+             v_s2 = _mm_add_epi32(v_s2,
+                    _mm_madd_epi16(_mm_maddubs_epi16(b1, tap1), ones));
+             v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(b2, zero));
+             v_s2 = _mm_add_epi32(v_s2,
+                    _mm_madd_epi16(_mm_maddubs_epi16(b2, tap2), ones));
+             buff += blkSz;
+            } while(--n);
+
+         v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+
+         v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, 0xb1));
+         v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, 0x4e));
+         v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, 0xb1));
+         v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, 0x4e));
+         s1 += _mm_cvtsi128_si32(v_s1);
+         s2  = _mm_cvtsi128_si32(v_s2);
+         s1 %= AdlerBase; s2 %= AdlerBase;
+        }
+
+   sum1 = s1; sum2 = s2;
+   if (blen) adler32_scalar(sum1, sum2, buff, blen);
+}
+
+/******************************************************************************/
+/*                          a d l e r 3 2 _ a v x 2                           */
+/******************************************************************************/
+
+__attribute__((target("avx2")))
+void adler32_avx2(unsigned int &sum1, unsigned int &sum2,
+                  const unsigned char *buff, int blen)
+{
+   const int    blkSz = 32;
+   const __m256i tap  = _mm256_setr_epi8(32,31,30,29,28,27,26,25,
+                                         24,23,22,21,20,19,18,17,
+                                         16,15,14,13,12,11,10, 9,
+                                          8, 7, 6, 5, 4, 3, 2, 1);
+   const __m256i zero = _mm256_setzero_si256();
+   const __m256i ones = _mm256_set1_epi16(1);
+   unsigned int s1 = sum1, s2 = sum2;
+   int n, blocks = blen / blkSz;
+
+   blen -= blocks * blkSz;
+   while(blocks)
+        {n = AdlerNMax / blkSz;
+         if (n > blocks) n = blocks;
+         blocks -= n;
+
+         __m256i v_ps = _mm256_set_epi32(0, 0, 0, 0, 0, 0, 0, s1 * n);
+         __m256i v_s2 = _mm256_set_epi32(0, 0, 0, 0, 0, 0, 0, s2);
+         __m256i v_s1 = zero;
+
+         do {const __m256i b = _mm256_loadu_si256((const __m256i *)buff);
+             v_ps = _mm256_add_epi32(v_ps, v_s1);
+             v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(b, zero));
+             v_s2 = _mm256_add_epi32(v_s2,
+                    _mm256_madd_epi16(_mm256_maddubs_epi16(b, tap), ones));
+             buff += blkSz;
+            } while(--n);
+
+         v_s2 = _mm256_add_epi32(v_s2, _mm256_slli_epi32(v_ps, 5));
+
+         __m128i h1 = _mm_add_epi32(_mm256_castsi256_si128(v_s1),
+                                    _mm256_extracti128_si256(v_s1, 1));
+         __m128i h2 = _mm_add_epi32(_mm256_castsi256_si128(v_s2),
+                                    _mm256_extracti128_si256(v_s2, 1));
+         h1 = _mm_add_epi32(h1, _mm_shuffle_epi32(h1, 0xb1));
+         h1 = _mm_add_epi32(h1, _mm_shuffle_epi32(h1, 0x4e));
+         h2 = _mm_add_epi32(h2, _mm_shuffle_epi32(h2, 0xb1));
+         h2 = _mm_add_epi32(h2, _mm_shuffle_epi32(h2, 0x4e));
+         s1 += _mm_cvtsi128_si32(h1);
+         s2  = _mm_cvtsi128_si32(h2);
+         s1 %= AdlerBase; s2 %= AdlerBase;
+        }
+
+   sum1 = s1; sum2 = s2;
+   if (blen) adler32_scalar(sum1, sum2, buff, blen);
+}
+}
+#endif
+
+/******************************************************************************/
+/*                          c r c 3 2 _ s c a l a r                           */
+/******************************************************************************/
+
+// This is the classic non-reflected table driven method documented by Ross
+// Williams (see XrdCksCalccrc32.cc).
+//
+namespace
+{
+unsigned int crc32_scalar(unsigned int crc, const unsigned char *p, int blen)
+{
+   while(blen-- > 0) crc = (crc << 8) ^ crcTab[0][(crc >> 24) ^ *p++];
+   return crc;
+}
+
+/******************************************************************************/
+/*                          c r c 3 2 _ s l i c e 8                           */
+/******************************************************************************/
+
+// Eight bytes are processed per iteration using eight tables where table k
+// gives the crc contribution of a byte followed by k zero bytes.
+//
+unsigned int crc32_slice8(unsigned int crc, const unsigned char *p, int blen)
+{
+   unsigned int one, two;
+
+   while(blen >= 8)
+        {one = crc ^ ((unsigned int)p[0] << 24 | (unsigned int)p[1] << 16
+                    | (unsigned int)p[2] <<  8 | (unsigned int)p[3]);
+         two =       ((unsigned int)p[4] << 24 | (unsigned int)p[5] << 16
+                    | (unsigned int)p[6] <<  8 | (unsigned int)p[7]);
+         crc = crcTab[7][one >> 24]         ^ crcTab[6][(one >> 16) & 0xff]
+             ^ crcTab[5][(one >> 8) & 0xff] ^ crcTab[4][ one        & 0xff]
+             ^ crcTab[3][two >> 24]         ^ crcTab[2][(two >> 16) & 0xff]
+             ^ crcTab[1][(two >> 8) & 0xff] ^ crcTab[0][ two        & 0xff];
+         p += 8; blen -= 8;
+        }
+   return crc32_scalar(crc, p, blen);
+}
+}
+
+/******************************************************************************/
+/*                          c r c 3 2 _ p c l m u l                           */
+/******************************************************************************/
+
+// Data is viewed as a polynomial with the first bit being the most significant
+// (hence the byte swap on load). Four 128 bit accumulators are folded forward
+// 512 bits at a time using carry-less multiplication by x**576 and x**512 mod
+// P, which preserves the value of the polynomial mod P. The accumulators are
+// then folded into one which, being congruent to the data consumed, is simply
+// run through the table method followed by any remaining bytes.
+//
+#ifdef XRDCKS_X86
+namespace
+{
+__attribute__((target("pclmul,ssse3")))
+inline __m128i crc32_fold(__m128i acc, __m128i k, __m128i data)
+{
+   return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(acc, k, 0x11),
+                                      _mm_clmulepi64_si128(acc, k, 0x00)),
+                        data);
+}
+
+__attribute__((target("pclmul,ssse3")))
+unsigned int crc32_pclmul(unsigned int crc, const unsigned char *p, int blen)
+{
+   const __m128i bswap = _mm_setr_epi8(15,14,13,12,11,10, 9, 8,
+                                        7, 6, 5, 4, 3, 2, 1, 0);
+   const __m128i k4 = _mm_set_epi64x(crcK576, crcK512);
+   const __m128i k1 = _mm_set_epi64x(crcK192, crcK128);
+   __m128i a0, a1, a2, a3;
+   unsigned char rbuf[16];
+
+// Short buffers are not worth the setup
+//
+   if (blen < 128) return crc32_slice8(crc, p, blen);
+
+// Load the first 64 bytes and inject the initial crc into the first block
+//
+#define LOADBE(x) _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(x)), bswap)
+
+   a0 = _mm_xor_si128(LOADBE(p), _mm_set_epi32(crc, 0, 0, 0));
+   a1 = LOADBE(p+16); a2 = LOADBE(p+32); a3 = LOADBE(p+48);
+   p += 64; blen -= 64;
+
+// Fold 64 bytes at a time
+//
+   while(blen >= 64)
+        {a0 = crc32_fold(a0, k4, LOADBE(p));
+         a1 = crc32_fold(a1, k4, LOADBE(p+16));
+         a2 = crc32_fold(a2, k4, LOADBE(p+32));
+         a3 = crc32_fold(a3, k4, LOADBE(p+48));
+         p += 64; blen -= 64;
+        }
+
+// Fold the accumulators into one and then any remaining full blocks
+//
+   a0 = crc32_fold(a0, k1, a1);
+   a0 = crc32_fold(a0, k1, a2);
+   a0 = crc32_fold(a0, k1, a3);
+   while(blen >= 16)
+        {a0 = crc32_fold(a0, k1, LOADBE(p));
+         p += 16; blen -= 16;
+        }
+#undef LOADBE
+
+// The accumulator is now equivalent to a 16 byte message with a zero crc
+//
+   _mm_storeu_si128((__m128i *)rbuf, _mm_shuffle_epi8(a0, bswap));
+   crc = crc32_slice8(0, rbuf, sizeof(rbuf));
+   return crc32_slice8(crc, p, blen);
+}
+}
+#endif
+
+/******************************************************************************/
+/*                           A d l e r 3 2 I m p l                            */
+/******************************************************************************/
+
+XrdCksAccel::Adler32_t XrdCksAccel::Adler32Impl(const char *name,
+                                                const char **impl)
+{
+   pthread_once(&onceSetup, Setup);
+
+   if (!name) {if (impl) *impl = adlerName; return adler32Fn;}
+   if (impl) *impl = name;
+
+   if (!strcmp(name, "scalar")) return adler32_scalar;
+#ifdef XRDCKS_X86
+   if (!strcmp(name, "ssse3"))  return (hasSSSE3 ? adler32_ssse3 : 0);
+   if (!strcmp(name, "avx2"))   return (hasAVX2  ? adler32_avx2  : 0);
+#endif
+   return 0;
+}
+
+/******************************************************************************/
+/*                           A d l e r 3 2 L i s t                            */
+/******************************************************************************/
+
+const char **XrdCksAccel::Adler32List()
+{
+   static const char *aList[] = {"scalar", "ssse3", "avx2", 0};
+
+   return aList;
+}
+
+/******************************************************************************/
+/*                             C r c 3 2 I m p l                              */
+/******************************************************************************/
+
+XrdCksAccel::Crc32_t XrdCksAccel::Crc32Impl(const char *name, const char **impl)
+{
+   pthread_once(&onceSetup, Setup);
+
+   if (!name) {if (impl) *impl = crcName; return crc32Fn;}
+   if (impl) *impl = name;
+
+   if (!strcmp(name, "scalar")) return crc32_scalar;
+   if (!strcmp(name, "slice8")) return crc32_slice8;
+#ifdef XRDCKS_X86
+   if (!strcmp(name, "pclmul")) return (hasPCLMUL ? crc32_pclmul : 0);
+#endif
+   return 0;
+}
+
+/******************************************************************************/
+/*                             C r c 3 2 L i s t                              */
+/******************************************************************************/
+
+const char **XrdCksAccel::Crc32List()
+{
+   static const char *cList[] = {"scalar", "slice8", "pclmul", 0};
+
+   return cList;
+}
+
+/******************************************************************************/
+/*                       P r i v a t e   M e t h o d s                        */
+/******************************************************************************/
+/******************************************************************************/
+/*                           a d l e r 3 2 I n i t                            */
+/******************************************************************************/
+
+// Initial kernels that select the real one upon first use
+//
+void XrdCksAccel::adler32Init(unsigned int &sum1, unsigned int &sum2,
+                              const unsigned char *buff, int blen)
+{
+   pthread_once(&onceSetup, Setup);
+   adler32Fn(sum1, sum2, buff, blen);
+}
+
+/******************************************************************************/
+/*                             c r c 3 2 I n i t                              */
+/******************************************************************************/
+
+unsigned int XrdCksAccel::crc32Init(unsigned int crc,
+                                    const unsigned char *buff, int blen)
+{
+   pthread_once(&onceSetup, Setup);
+   return crc32Fn(crc, buff, blen);
+}
+
+/******************************************************************************/
+/*                                 S e t u p                                  */
+/******************************************************************************/
+
+namespace
+{
+unsigned long long XnModP(int n)
+{
+   unsigned long long r = 1;
+
+   while(n--) {r <<= 1; if (r & 0x100000000ULL) r ^= Crc32Poly;}
+   return r;
+}
+}
+
+void XrdCksAccel::Setup()
+{
+   unsigned int c;
+   int i, k;
+
+// Generate the crc tables
+//
+   for (i = 0; i < 256; i++)
+       {c = (unsigned int)i << 24;
+        for (k = 0; k < 8; k++)
+            c = (c & 0x80000000 ? (c << 1) ^ (unsigned int)Crc32Poly : c << 1);
+        crcTab[0][i] = c;
+       }
+   for (i = 0; i < 256; i++)
+       for (k = 1; k < 8; k++)
+           crcTab[k][i] = (crcTab[k-1][i] << 8)
+                        ^ crcTab[0][crcTab[k-1][i] >> 24];
+
+   crcK128 = XnModP(128); crcK192 = XnModP(192);
+   crcK512 = XnModP(512); crcK576 = XnModP(576);
+
+// Determine what the cpu supports. AVX2 requires that the OS save the ymm
+// registers as well.
+//
+#ifdef XRDCKS_X86
+   unsigned int eax, ebx, ecx, edx;
+
+   if (__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+      {hasSSSE3  = (ecx & bit_SSSE3) != 0;
+       hasPCLMUL = hasSSSE3 && (ecx & bit_PCLMUL) != 0;
+       if ((ecx & bit_OSXSAVE) && (ecx & bit_AVX) && __get_cpuid_max(0, 0) >= 7)
+          {unsigned int xlo, xhi;
+           __asm__ __volatile__ ("xgetbv" : "=a"(xlo), "=d"(xhi) : "c"(0));
+           if ((xlo & 6) == 6)
+              {__cpuid_count(7, 0, eax, ebx, ecx, edx);
+               hasAVX2 = (ebx & bit_AVX2) != 0;
+              }
+          }
+      }
+
+   if (hasAVX2)        {adler32Fn = adler32_avx2;  adlerName = "avx2";}
+      else if (hasSSSE3) {adler32Fn = adler32_ssse3; adlerName = "ssse3";}
+      else               {adler32Fn = adler32_scalar;}
+
+   if (hasPCLMUL) {crc32Fn = crc32_pclmul; crcName = "pclmul";}
+      else        {crc32Fn = crc32_slice8; crcName = "slice8";}
+#else
+   adler32Fn = adler32_scalar;
+   crc32Fn   = crc32_slice8; crcName = "slice8";
+#endif
+}
@@ -0,0 +1,98 @@
+#ifndef __XRDCKSACCEL_HH__
+#define __XRDCKSACCEL_HH__
+/******************************************************************************/
+/*                                                                            */
+/*                       X r d C k s A c c e l . h h                          */
+/*                                                                            */
+/* (c) 2019 by the Board of Trustees of the Leland Stanford, Jr., University  */
+/*                            All Rights Reserved                             */
+/*   Produced by Andrew Hanushevsky for Stanford University under contract    */
+/*              DE-AC02-76-SFO0515 with the Department of Energy              */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+/******************************************************************************/
+/*                           X r d C k s A c c e l                            */
+/******************************************************************************/
+
+// This class provides the computational kernels for the adler32 and crc32
+// checksums. Several implementations exist for each and the fastest one that
+// the cpu supports is selected the first time a kernel is used. All of them
+// produce identical results.
+//
+// Adler32 kernels: scalar, ssse3, avx2
+// Crc32   kernels: scalar (byte table), slice8, pclmul
+//
+// The crc32 here is the non-reflected POSIX 1003.2 (cksum) crc used by the
+// XrdCksCalccrc32 class, not the reflected zlib crc32.
+//
+class XrdCksAccel
+{
+public:
+
+// Update the adler32 running sums (each must be < 65521) with the data.
+//
+typedef void         (*Adler32_t)(unsigned int &sum1, unsigned int &sum2,
+                                  const unsigned char *buff, int blen);
+
+// Update the running (non-reflected) crc32 register and return the new value.
+//
+typedef unsigned int (*Crc32_t)(unsigned int crc,
+                                const unsigned char *buff, int blen);
+
+static void         Adler32(unsigned int &sum1, unsigned int &sum2,
+                            const char *buff, int blen)
+                           {adler32Fn(sum1, sum2,
+                                      (const unsigned char *)buff, blen);
+                           }
+
+static unsigned int Crc32(unsigned int crc, const char *buff, int blen)
+                         {return crc32Fn(crc, (const unsigned char *)buff, blen);}
+
+// Return the named implementation or nil if it is unknown or not supported
+// by this cpu. Passing a nil name returns the one selected for general use.
+// The name of the chosen implementation is returned in impl, when supplied.
+//
+static Adler32_t    Adler32Impl(const char *name, const char **impl=0);
+
+static Crc32_t      Crc32Impl  (const char *name, const char **impl=0);
+
+// Return the list of implementation names, the first being the fallback.
+//
+static const char **Adler32List();
+
+static const char **Crc32List();
+
+                    XrdCksAccel() {}
+                   ~XrdCksAccel() {}
+
+private:
+
+static void         Setup();
+static void         adler32Init(unsigned int &, unsigned int &,
+                                const unsigned char *, int);
+static unsigned int crc32Init(unsigned int, const unsigned char *, int);
+
+static Adler32_t    adler32Fn;
+static Crc32_t      crc32Fn;
+};
+#endif
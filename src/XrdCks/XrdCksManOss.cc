@@ -51,7 +51,6 @@
 namespace
 {
 XrdOss      *ossP = 0;
-int          rdSz = 67108864;
 }
 
 /******************************************************************************/
@@ -84,10 +83,8 @@ const char *Pfn2Lfn(const char *Lfn)
   
 XrdCksManOss::XrdCksManOss(XrdOss *ossX, XrdSysError *erP, int iosz,
                            XrdVersionInfo &vInfo, bool autoload)
-             : XrdCksManager(erP, rdSz, vInfo, autoload)
-             {if (rdSz <= 65536) rdSz = 67108864;
-                 else rdSz = ((rdSz/65536) + (rdSz%65536 != 0)) * 65536;
-              eDest = erP;
+             : XrdCksManager(erP, iosz, vInfo, autoload)
+             {eDest = erP;
               ossP  = ossX;
              }
 
@@ -111,20 +108,43 @@ int XrdCksManOss::Calc(const char *Lfn, XrdCksData &Cks, int doSet)
 
 /******************************************************************************/
   
-int XrdCksManOss::Calc(const char *Pfn, time_t &MTime, XrdCksCalc *csP)
+int XrdCksManOss::Calc(const char *Lfn, XrdCksData *Cks, int csNum, int doSet)
 {
-   class inFile
+   int rc;
+   LfnPfn Xfn(Lfn, rc);
+
+// If lfn conversion failed, bail out
+//
+   if (rc) return rc;
+
+// Return the result
+//
+   return XrdCksManager::Calc(Xfn.Pfn, Cks, csNum, doSet);
+}
+
+/******************************************************************************/
+  
+int XrdCksManOss::Calc(const char *Pfn, time_t &MTime,
+                       XrdCksCalc **csP, int csNum)
+{
+   class inFile : public XrdCksManager::ioSource
         {public:
          XrdOssDF *fP;
+         ssize_t   Read(char *buff, size_t blen, off_t offs)
+                       {ssize_t rc, rlen = 0;
+                        while(rlen < (ssize_t)blen)
+                             {rc = fP->Read(buff+rlen, offs+rlen, blen-rlen);
+                              if (rc <= 0) return (rc < 0 ? rc : rlen);
+                              rlen += rc;
+                             }
+                        return rlen;
+                       }
              inFile() {fP = ossP->newFile("ckscalc");}
             ~inFile() {if (fP) delete fP;}
         } In;
    XrdOucEnv openEnv;
    const char *Lfn = Pfn2Lfn(Pfn);
    struct stat Stat;
-   char  *buffP;
-   off_t  Offset=0, fileSize;
-   size_t ioSize, calcSize;
    int    rc;
 
 // Open the input file
@@ -135,31 +155,11 @@ int XrdCksManOss::Calc(const char *Pfn, time_t &MTime, XrdCksCalc *csP)
 //
    if ((rc = In.fP->Fstat(&Stat))) return (rc > 0 ? -rc : rc);
    if (!(Stat.st_mode & S_IFREG)) return -EPERM;
-   calcSize = fileSize = Stat.st_size;
    MTime = Stat.st_mtime;
 
-// Compute read size and allocate a buffer
-//
-   ioSize = (fileSize < (off_t)rdSz ? fileSize : rdSz); rc = 0;
-   buffP  = (char *)malloc(ioSize);
-   if (!buffP) return -ENOMEM;
-
-// We now compute checksum 64MB at a time using mmap I/O
-//
-   while(calcSize)
-        {if ((rc= In.fP->Read(buffP, Offset, ioSize)) < 0) break;
-         csP->Update(buffP, ioSize);
-         calcSize -= ioSize; Offset += ioSize;
-         if (calcSize < (size_t)ioSize) ioSize = calcSize;
-        }
-
-// Issue error message if we have an error
-//
-   if (rc < 0) eDest->Emsg("Cks", rc, "read", Pfn);
-
-// Return
+// Compute the checksums, reading ahead as needed
 //
-   return (rc < 0 ? rc : 0);
+   return Stream(In, Stat.st_size, csP, csNum, Pfn);
 }
 
 /******************************************************************************/
@@ -45,6 +45,9 @@ class XrdCksManOss : public XrdCksManager
 public:
 virtual int         Calc(const char *Lfn, XrdCksData &Cks, int doSet=1);
 
+virtual int         Calc(const char *Lfn, XrdCksData *Cks, int csNum,
+                         int doSet=1);
+
 virtual int         Del( const char *Lfn, XrdCksData &Cks);
 
 virtual int         Get( const char *Lfn, XrdCksData &Cks);
@@ -61,11 +64,8 @@ virtual int         Ver( const char *Lfn, XrdCksData &Cks);
 virtual            ~XrdCksManOss() {}
 
 protected:
-virtual int         Calc(const char *Lfn, time_t &MTime, XrdCksCalc *CksObj);
+virtual int         Calc(const char *Lfn, time_t &MTime, XrdCksCalc **CksObj,
+                         int csNum);
 virtual int         ModTime(const char *Pfn, time_t &MTime);
-
-private:
-
-int buffSZ;
 };
 #endif
@@ -30,11 +30,11 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <stdio.h>
 #include <unistd.h>
-#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
   
@@ -54,6 +54,112 @@
 #include "XrdSys/XrdSysPlugin.hh"
 #include "XrdSys/XrdSysPthread.hh"
 
+/******************************************************************************/
+/*                         L o c a l   C l a s s e s                          */
+/******************************************************************************/
+
+// The RdAhead class reads the file into two buffers using a helper thread so
+// that reading the next segment overlaps the calculation on the current one.
+//
+namespace
+{
+class RdAhead
+{
+public:
+
+static void *Start(void *carg) {((RdAhead *)carg)->Reader(); return 0;}
+
+// Return the next filled buffer or nil upon error (rc holds -errno)
+//
+char        *Next(ssize_t &rc)
+                 {Slot[bNext].Full.Wait();
+                  rc = Slot[bNext].Blen;
+                  return (rc > 0 ? Slot[bNext].Buff : 0);
+                 }
+
+// Indicate the buffer obtained via Next() is no longer needed
+//
+void         Done() {Slot[bNext].Free.Post(); bNext ^= 1;}
+
+// Stop the reader thread and wait for it to end
+//
+void         Stop() {doStop = true; Slot[0].Free.Post(); Slot[1].Free.Post();
+                     XrdSysThread::Join(tid, 0);
+                    }
+
+pthread_t    tid;
+
+             RdAhead(XrdCksManager::ioSource &src, char *b0, char *b1,
+                     size_t bsz, off_t fsz)
+                    : Src(src), bSize(bsz), fSize(fsz), bNext(0), doStop(false)
+                    {Slot[0].Buff = b0; Slot[1].Buff = b1;}
+            ~RdAhead() {}
+
+private:
+
+void         Reader();
+
+struct rdSlot
+      {XrdSysSemaphore Free;
+       XrdSysSemaphore Full;
+       char           *Buff;
+       ssize_t         Blen;
+                       rdSlot() : Free(1), Full(0), Buff(0), Blen(0) {}
+      }     Slot[2];
+
+XrdCksManager::ioSource &Src;
+size_t          bSize;
+off_t           fSize;
+int             bNext;
+volatile bool   doStop;
+};
+
+/******************************************************************************/
+
+void RdAhead::Reader()
+{
+   off_t Offset = 0;
+   int   bNum = 0;
+
+// Fill alternate buffers until we reach the end of file, encounter an error,
+// or are asked to stop.
+//
+   while(Offset < fSize)
+        {Slot[bNum].Free.Wait();
+         if (doStop) break;
+         size_t ioSize = (fSize - Offset < (off_t)bSize ? fSize-Offset : bSize);
+         ssize_t rc = Src.Read(Slot[bNum].Buff, ioSize, Offset);
+         Slot[bNum].Blen = (rc < 0 || rc == (ssize_t)ioSize ? rc : -EIO);
+         Slot[bNum].Full.Post();
+         if (rc != (ssize_t)ioSize) break;
+         Offset += ioSize; bNum ^= 1;
+        }
+}
+
+/******************************************************************************/
+
+class FdSource : public XrdCksManager::ioSource
+{
+public:
+
+ssize_t Read(char *buff, size_t blen, off_t offs)
+            {ssize_t rc, rlen = 0;
+             while(rlen < (ssize_t)blen)
+                  {do {rc = pread(FD, buff+rlen, blen-rlen, offs+rlen);}
+                      while(rc < 0 && errno == EINTR);
+                   if (rc <= 0) return (rc < 0 ? -errno : rlen);
+                   rlen += rc;
+                  }
+             return rlen;
+            }
+
+int     FD;
+
+        FdSource() : FD(-1) {}
+       ~FdSource() {if (FD >= 0) close(FD);}
+};
+}
+
 /******************************************************************************/
 /*                           C o n s t r u c t o r                            */
 /******************************************************************************/
@@ -75,9 +181,10 @@ XrdCksManager::XrdCksManager(XrdSysError *erP, int rdsz, XrdVersionInfo &vInfo,
    strcpy(csTab[2].Name, "md5");
    csLast = 2;
 
-// Compute the i/o size
+// Compute the i/o size. Since reads are double buffered, the default is
+// smaller than the original 64MB memory mapped segment.
 //
-   if (rdsz <= 65536) segSize = 67108864;
+   if (rdsz <= 65536) segSize = 8388608;
       else segSize = ((rdsz/65536) + (rdsz%65536 != 0)) * 65536;
 }
 
@@ -104,9 +211,9 @@ XrdCksManager::~XrdCksManager()
 int XrdCksManager::Calc(const char *Pfn, XrdCksData &Cks, int doSet)
 {
    XrdCksCalc *csP;
-   csInfo *csIP = &csTab[0];
-   time_t MTime;
-   int rc;
+   csInfo     *csIP = &csTab[0];
+   time_t      MTime;
+   int         rc;
 
 // Determine which checksum to get
 //
@@ -114,9 +221,6 @@ int XrdCksManager::Calc(const char *Pfn, XrdCksData &Cks, int doSet)
    if (!(*Cks.Name)) Cks.Set(csIP->Name);
       else if (!(csIP = Find(Cks.Name))) return -ENOTSUP;
 
-// If we need not set the checksum then see if we can get it from the
-// extended attributes.
-
 // Obtain a new checksum object
 //
    if (!(csP = csIP->Obj->New())) return -ENOMEM;
@@ -134,7 +238,59 @@ int XrdCksManager::Calc(const char *Pfn, XrdCksData &Cks, int doSet)
            memcpy(&xCS.Attr.Cks, &Cks, sizeof(xCS.Attr.Cks));
            if ((rc = xCS.Set(Pfn))) return -rc;
           }
-      }
+      } else csP->Recycle();
+
+// All done
+//
+   return rc;
+}
+
+/******************************************************************************/
+  
+int XrdCksManager::Calc(const char *Pfn, XrdCksData *Cks, int csNum, int doSet)
+{
+   XrdCksCalc *csP[csMax];
+   csInfo     *csIP[csMax];
+   time_t MTime;
+   int i, rc;
+
+// Determine which checksums to get
+//
+   if (csLast < 0) return -ENOTSUP;
+   if (csNum <= 0 || csNum > csMax) return -EINVAL;
+   for (i = 0; i < csNum; i++)
+       {if (!(*Cks[i].Name)) Cks[i].Set((csIP[i] = &csTab[0])->Name);
+           else if (!(csIP[i] = Find(Cks[i].Name))) return -ENOTSUP;
+       }
+
+// Obtain a new checksum object for each one
+//
+   for (i = 0; i < csNum; i++)
+       if (!(csP[i] = csIP[i]->Obj->New()))
+          {while(i--) csP[i]->Recycle();
+           return -ENOMEM;
+          }
+
+// Calculate all of the checksums using a single pass over the file
+//
+   rc = Calc(Pfn, MTime, csP, csNum);
+
+// Return the results and possibly set them
+//
+   for (i = 0; i < csNum; i++)
+       {if (!rc)
+           {memcpy(Cks[i].Value, csP[i]->Final(), csIP[i]->Len);
+            Cks[i].fmTime = static_cast<long long>(MTime);
+            Cks[i].csTime = static_cast<int>(time(0) - MTime);
+            Cks[i].Length = csIP[i]->Len;
+            if (doSet)
+               {XrdOucXAttr<XrdCksXAttr> xCS;
+                memcpy(&xCS.Attr.Cks, &Cks[i], sizeof(xCS.Attr.Cks));
+                if ((rc = xCS.Set(Pfn))) rc = -rc;
+               }
+           }
+        csP[i]->Recycle();
+       }
 
 // All done
 //
@@ -145,17 +301,16 @@ int XrdCksManager::Calc(const char *Pfn, XrdCksData &Cks, int doSet)
   
 int XrdCksManager::Calc(const char *Pfn, time_t &MTime, XrdCksCalc *csP)
 {
-   class ioFD
-        {public:
-         int FD;
-             ioFD() : FD(-1) {}
-            ~ioFD() {if (FD >= 0) close(FD);}
-        } In;
+   return Calc(Pfn, MTime, &csP, 1);
+}
+
+/******************************************************************************/
+
+int XrdCksManager::Calc(const char *Pfn, time_t &MTime,
+                        XrdCksCalc **csP, int csNum)
+{
+   FdSource In;
    struct stat Stat;
-   char *inBuff;
-   off_t  Offset=0, fileSize;
-   size_t ioSize, calcSize;
-   int rc;
 
 // Open the input file
 //
@@ -165,32 +320,17 @@ int XrdCksManager::Calc(const char *Pfn, time_t &MTime, XrdCksCalc *csP)
 //
    if (fstat(In.FD, &Stat)) return -errno;
    if (!(Stat.st_mode & S_IFREG)) return -EPERM;
-   calcSize = fileSize = Stat.st_size;
    MTime = Stat.st_mtime;
 
-// We now compute checksum 64MB at a time using mmap I/O
+// Tell the kernel we will be reading the file sequentially
 //
-   ioSize = (fileSize < (off_t)segSize ? fileSize : segSize); rc = 0;
-   while(calcSize)
-        {if ((inBuff = (char *)mmap(0, ioSize, PROT_READ, 
-#if defined(__FreeBSD__)
-                       MAP_RESERVED0040|MAP_PRIVATE, In.FD, Offset)) == MAP_FAILED)
-#else
-                       MAP_NORESERVE|MAP_PRIVATE, In.FD, Offset)) == MAP_FAILED)
+#if defined(__linux__)
+   posix_fadvise(In.FD, 0, 0, POSIX_FADV_SEQUENTIAL);
 #endif
-            {rc = errno; eDest->Emsg("Cks", rc, "memory map", Pfn); break;}
-         madvise(inBuff, ioSize, MADV_SEQUENTIAL);
-         csP->Update(inBuff, ioSize);
-         calcSize -= ioSize; Offset += ioSize;
-         if (munmap(inBuff, ioSize) < 0)
-            {rc = errno; eDest->Emsg("Cks",rc,"unmap memory for",Pfn); break;}
-         if (calcSize < (size_t)segSize) ioSize = calcSize;
-        }
 
-// Return if we failed
+// Compute the checksums
 //
-   if (calcSize) return (rc ? -rc : -EIO);
-   return 0;
+   return Stream(In, Stat.st_size, csP, csNum, Pfn);
 }
 
 /******************************************************************************/
@@ -604,6 +744,70 @@ int XrdCksManager::Set(const char *Pfn, XrdCksData &Cks, int myTime)
    return xCS.Set(Pfn);
 }
 
+/******************************************************************************/
+/*                                S t r e a m                                 */
+/******************************************************************************/
+
+int XrdCksManager::Stream(ioSource &Src, off_t fSize, XrdCksCalc **csP,
+                          int csNum, const char *Pfn)
+{
+   char   *buff, *bP[2] = {0, 0};
+   off_t   Offset = 0;
+   ssize_t rc = 0;
+   size_t  ioSize;
+   int     i, nBuff;
+
+// Handle the trivial case
+//
+   if (fSize <= 0) return 0;
+
+// Allocate page aligned buffers, two if we will need to read ahead
+//
+   ioSize = (fSize < (off_t)segSize ? fSize : segSize);
+   nBuff  = (fSize > (off_t)segSize ? 2 : 1);
+   for (i = 0; i < nBuff; i++)
+       if (posix_memalign((void **)&bP[i], sysconf(_SC_PAGESIZE), ioSize))
+          {if (bP[0]) free(bP[0]);
+           return -ENOMEM;
+          }
+
+// When the file spans several segments, a helper thread reads the next one
+// while we do the calculation on the current one. Should we not be able to
+// start the thread, we simply do everything inline.
+//
+   if (nBuff > 1)
+      {RdAhead rdA(Src, bP[0], bP[1], ioSize, fSize);
+       if (!XrdSysThread::Run(&rdA.tid, RdAhead::Start, (void *)&rdA,
+                              XRDSYSTHREAD_HOLD, "cks read ahead"))
+          {while(Offset < fSize && (buff = rdA.Next(rc)))
+                {for (i = 0; i < csNum; i++) csP[i]->Update(buff, rc);
+                 Offset += rc;
+                 rdA.Done();
+                }
+           rdA.Stop();
+          }
+      }
+
+// Read whatever remains inline (this is everything unless we read ahead)
+//
+   while(Offset < fSize && rc >= 0)
+        {size_t rdSize = (fSize-Offset < (off_t)ioSize ? fSize-Offset : ioSize);
+         if ((rc = Src.Read(bP[0], rdSize, Offset)) != (ssize_t)rdSize)
+            {if (rc >= 0) rc = -EIO;
+             break;
+            }
+         for (i = 0; i < csNum; i++) csP[i]->Update(bP[0], rc);
+         Offset += rc;
+        }
+
+// Free the buffers and issue error message if we have an error
+//
+   free(bP[0]);
+   if (bP[1]) free(bP[1]);
+   if (rc < 0) {eDest->Emsg("Cks", -rc, "read", Pfn); return rc;}
+   return 0;
+}
+
 /******************************************************************************/
 /*                                   V e r                                    */
 /******************************************************************************/
@@ -634,7 +838,7 @@ int XrdCksManager::Ver(const char *Pfn, XrdCksData &Cks)
    ||  strcmp(xCS.Attr.Cks.Name, csIP->Name)
    ||  xCS.Attr.Cks.Length != csIP->Len)
       {strcpy(xCS.Attr.Cks.Name, Cks.Name);
-       if ((rc = Calc(Pfn, xCS.Attr.Cks, 1)) < 0) return rc;
+       if ((rc = XrdCksManager::Calc(Pfn, xCS.Attr.Cks, 1)) < 0) return rc;
       }
 
 // Compare the checksums
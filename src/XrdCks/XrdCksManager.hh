@@ -50,6 +50,9 @@ class XrdCksManager : public XrdCks
 public:
 virtual int         Calc( const char *Pfn, XrdCksData &Cks, int doSet=1);
 
+virtual int         Calc( const char *Pfn, XrdCksData *Cks, int csNum,
+                          int doSet=1);
+
 virtual int         Config(const char *Token, char *Line);
 
 virtual int         Del(  const char *Pfn, XrdCksData &Cks);
@@ -70,6 +73,16 @@ virtual int         Set(  const char *Pfn, XrdCksData &Cks, int myTime=0);
 
 virtual int         Ver(  const char *Pfn, XrdCksData &Cks);
 
+// The data source used by Stream() to read a file.
+//
+class ioSource
+{
+public:
+virtual ssize_t     Read(char *buff, size_t blen, off_t offs) = 0;
+                    ioSource() {}
+virtual            ~ioSource() {}
+};
+
                     XrdCksManager(XrdSysError *erP, int iosz,
                                   XrdVersionInfo &vInfo, bool autoload=false);
 virtual            ~XrdCksManager();
@@ -79,15 +92,32 @@ protected:
 /* Calc()     returns 0 if the checksum was successfully calculated using the
               supplied CksObj and places the file's modification time in MTime.
               Otherwise, it returns -errno. The default implementation uses
-              open(), fstat(), mmap(), and unmap() to calculate the results.
+              the array version below with a single object.
 */
 virtual int         Calc(const char *Pfn, time_t &MTime, XrdCksCalc *CksObj);
 
+/* Stream()   feeds fSize bytes from Src to each of the csNum CksObj objects.
+              Files larger than the i/o size are read ahead using a helper
+              thread and two buffers. It returns 0 or -errno upon failure.
+*/
+int                 Stream(ioSource &Src, off_t fSize, XrdCksCalc **CksObj,
+                           int csNum, const char *Pfn);
+
 /* ModTime()  returns 0 and places file's modification time in MTime. Otherwise,
               it return -errno. The default implementation uses stat().
 */
 virtual int         ModTime(const char *Pfn, time_t &MTime);
 
+/* Calc()     is the same as the first Calc() except that csNum checksums are
+              calculated using a single pass over the file. The default
+              implementation uses open(), fstat(), and pread() via Stream().
+              It is only used for the array version of the public Calc() and
+              is declared last so that existing virtual methods keep their
+              place in the vtable.
+*/
+virtual int         Calc(const char *Pfn, time_t &MTime, XrdCksCalc **CksObj,
+                         int csNum);
+
 private:
 
 struct csInfo
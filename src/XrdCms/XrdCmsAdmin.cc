@@ -44,6 +44,7 @@
 #include "XrdCms/XrdCmsManager.hh"
 #include "XrdCms/XrdCmsPrepare.hh"
 #include "XrdCms/XrdCmsState.hh"
+#include "XrdCms/XrdCmsSummary.hh"
 #include "XrdCms/XrdCmsTrace.hh"
 #include "XrdNet/XrdNetSocket.hh"
 #include "XrdOuc/XrdOuca2x.hh"
@@ -801,6 +802,10 @@ void XrdCmsAdmin::do_RmDud(int isPfn)
           } else tp = apath;
       }
 
+// Add online files to our bloom filter, if we are sending one
+//
+   if (Config.BloomInt && (Mods & CmsHaveRequest::Online)) Summary.Added(tp);
+
 // Check if we are relaying remove events and, if so, vector through that.
 //
    if (areFunc) AddEvent(tp, kYR_have, Mods);
@@ -0,0 +1,188 @@
+#ifndef XRDCMSBITSET__H
+#define XRDCMSBITSET__H
+/******************************************************************************/
+/*                                                                            */
+/*                       X r d C m s B i t S e t . h h                        */
+/*                                                                            */
+/* (c) 2019 by the Board of Trustees of the Leland Stanford, Jr., University  */
+/*                            All Rights Reserved                             */
+/*   Produced by Andrew Hanushevsky for Stanford University under contract    */
+/*              DE-AC02-76-SFO0515 with the Department of Energy              */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <ostream>
+
+/******************************************************************************/
+/*                   C l a s s   X r d C m s B i t S e t                      */
+/******************************************************************************/
+  
+// The XrdCmsBitSet object is a fixed size bit vector that behaves like an
+// unsigned integer of N bits. It is used for node masks (SMask_t) so that a
+// cell may have more than 64 nodes. The bits are kept in an array of 64-bit
+// words and every operation is a simple loop over that array which compilers
+// unroll or vectorize; with N == 64 it is as cheap as an unsigned long long.
+// Construction from a signed integer is sign extended, so SMask_t(~0) has all bits set.
+//
+template<int N>
+class XrdCmsBitSet
+{
+public:
+
+static const int nWords = (N + 63) / 64;
+
+// Count() returns the number of bits that are set
+//
+inline int           Count() const
+                          {int n = 0;
+                           for (int i = 0; i < nWords; i++)
+                               n += __builtin_popcountll(Bits[i]);
+                           return n;
+                          }
+
+// First() returns the number of the lowest bit that is set or -1 if none
+//
+inline int           First() const
+                          {for (int i = 0; i < nWords; i++)
+                               if (Bits[i]) return i*64 + __builtin_ctzll(Bits[i]);
+                           return -1;
+                          }
+
+// Low() returns the low order 64 bits (e.g. for display)
+//
+inline unsigned long long Low() const {return Bits[0];}
+
+// Set() and Test() set or test a single bit
+//
+inline void          Set(int bit)
+                        {Bits[bit >> 6] |= 1ULL << (bit & 63);}
+
+inline bool          Test(int bit) const
+                         {return (Bits[bit >> 6] & (1ULL << (bit & 63))) != 0;}
+
+// Operators that make this look like an unsigned integer
+//
+explicit operator    bool() const
+                          {unsigned long long v = 0;
+                           for (int i = 0; i < nWords; i++) v |= Bits[i];
+                           return v != 0;
+                          }
+
+inline bool          operator!() const {return !static_cast<bool>(*this);}
+
+inline XrdCmsBitSet  operator~() const
+                          {XrdCmsBitSet r;
+                           for (int i = 0; i < nWords; i++) r.Bits[i] = ~Bits[i];
+                           return r;
+                          }
+
+inline XrdCmsBitSet &operator&=(const XrdCmsBitSet &rhs)
+                          {for (int i = 0; i < nWords; i++) Bits[i] &= rhs.Bits[i];
+                           return *this;
+                          }
+
+inline XrdCmsBitSet &operator|=(const XrdCmsBitSet &rhs)
+                          {for (int i = 0; i < nWords; i++) Bits[i] |= rhs.Bits[i];
+                           return *this;
+                          }
+
+inline XrdCmsBitSet &operator^=(const XrdCmsBitSet &rhs)
+                          {for (int i = 0; i < nWords; i++) Bits[i] ^= rhs.Bits[i];
+                           return *this;
+                          }
+
+inline XrdCmsBitSet  operator<<(int n) const
+                          {XrdCmsBitSet r(0);
+                           int w = n >> 6, b = n & 63;
+                           for (int i = nWords-1; i >= w; i--)
+                               {r.Bits[i] = Bits[i-w] << b;
+                                if (b && i-w > 0) r.Bits[i] |= Bits[i-w-1] >> (64-b);
+                               }
+                           return r;
+                          }
+
+inline XrdCmsBitSet  operator>>(int n) const
+                          {XrdCmsBitSet r(0);
+                           int w = n >> 6, b = n & 63;
+                           for (int i = 0; i < nWords-w; i++)
+                               {r.Bits[i] = Bits[i+w] >> b;
+                                if (b && i+w+1 < nWords) r.Bits[i] |= Bits[i+w+1] << (64-b);
+                               }
+                           return r;
+                          }
+
+inline bool          operator==(const XrdCmsBitSet &rhs) const
+                          {unsigned long long v = 0;
+                           for (int i = 0; i < nWords; i++) v |= Bits[i] ^ rhs.Bits[i];
+                           return v == 0;
+                          }
+
+inline bool          operator!=(const XrdCmsBitSet &rhs) const
+                          {return !(*this == rhs);}
+
+friend XrdCmsBitSet  operator&(XrdCmsBitSet lhs, const XrdCmsBitSet &rhs)
+                          {return lhs &= rhs;}
+
+friend XrdCmsBitSet  operator|(XrdCmsBitSet lhs, const XrdCmsBitSet &rhs)
+                          {return lhs |= rhs;}
+
+friend XrdCmsBitSet  operator^(XrdCmsBitSet lhs, const XrdCmsBitSet &rhs)
+                          {return lhs ^= rhs;}
+
+// Masks are always displayed in hex, high order word first
+//
+friend std::ostream &operator<<(std::ostream &os, const XrdCmsBitSet &m)
+                          {char buff[20];
+                           int i = nWords-1;
+                           while(i > 0 && !m.Bits[i]) i--;
+                           snprintf(buff, sizeof(buff), "%llx", m.Bits[i]);
+                           os <<buff;
+                           while(i-- > 0)
+                                {snprintf(buff, sizeof(buff), "%016llx", m.Bits[i]);
+                                 os <<buff;
+                                }
+                           return os;
+                          }
+
+                     XrdCmsBitSet() = default;  // Uninitialized, like an integer
+
+                     XrdCmsBitSet(int v)
+                          {Bits[0] = static_cast<unsigned long long>(v);
+                           for (int i = 1; i < nWords; i++) Bits[i] = (v < 0 ? ~0ULL : 0);
+                          }
+
+                     XrdCmsBitSet(long long v)
+                          {Bits[0] = static_cast<unsigned long long>(v);
+                           for (int i = 1; i < nWords; i++) Bits[i] = (v < 0 ? ~0ULL : 0);
+                          }
+
+                     XrdCmsBitSet(unsigned long long v)
+                          {Bits[0] = v;
+                           for (int i = 1; i < nWords; i++) Bits[i] = 0;
+                          }
+
+private:
+
+unsigned long long   Bits[nWords];
+};
+#endif
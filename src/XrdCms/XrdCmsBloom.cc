@@ -0,0 +1,110 @@
+/******************************************************************************/
+/*                                                                            */
+/*                        X r d C m s B l o o m . c c                         */
+/*                                                                            */
+/* (c) 2019 by the Board of Trustees of the Leland Stanford, Jr., University  */
+/*                            All Rights Reserved                             */
+/*   Produced by Andrew Hanushevsky for Stanford University under contract    */
+/*              DE-AC02-76-SFO0515 with the Department of Energy              */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "XrdCms/XrdCmsBloom.hh"
+
+/******************************************************************************/
+/*                           C o n s t r u c t o r                            */
+/******************************************************************************/
+
+XrdCmsBloom::XrdCmsBloom(int lgb, int hashes)
+{
+        if (lgb < minBits) lgb = minBits;
+   else if (lgb > maxBits) lgb = maxBits;
+
+   lgSize  = lgb;
+   bitMask = static_cast<unsigned int>((1ULL << lgb) - 1);
+   numHash = (hashes < 1 ? 1 : hashes);
+   bitVec  = (unsigned char *)calloc(Size(), 1);
+}
+
+/******************************************************************************/
+/*                            D e s t r u c t o r                             */
+/******************************************************************************/
+
+XrdCmsBloom::~XrdCmsBloom()
+{
+   if (bitVec) free(bitVec);
+}
+
+/******************************************************************************/
+/*                                  F o l d                                   */
+/******************************************************************************/
+
+void XrdCmsBloom::Fold(int lgb)
+{
+   unsigned char *newVec;
+   int i, oldSize = Size(), newSize;
+
+// Make sure we are actually getting smaller
+//
+   if (lgb < minBits) lgb = minBits;
+   if (!bitVec || lgb >= lgSize) return;
+   newSize = 1 << (lgb - 3);
+
+// Fold each piece into the first one and trim the vector
+//
+   for (i = newSize; i < oldSize; i++) bitVec[i & (newSize-1)] |= bitVec[i];
+   if ((newVec = (unsigned char *)realloc(bitVec, newSize))) bitVec = newVec;
+   bitMask = (1U << lgb) - 1;
+   lgSize  = lgb;
+}
+
+/******************************************************************************/
+/*                                  H a s h                                   */
+/******************************************************************************/
+
+unsigned long long XrdCmsBloom::Hash(const char *path, int plen)
+{
+   unsigned long long hv = 0xcbf29ce484222325ULL;
+   int i;
+
+// Ignore a trailing slash
+//
+   while(plen > 1 && path[plen-1] == '/') plen--;
+
+// Compute the 64-bit FNV-1a hash of the name skipping repeated slashes
+//
+   for (i = 0; i < plen && path[i]; i++)
+       {if (path[i] == '/' && i && path[i-1] == '/') continue;
+        hv ^= static_cast<unsigned char>(path[i]);
+        hv *= 0x100000001b3ULL;
+       }
+
+// Mix the bits so that the low and high words are both usable
+//
+   hv ^= hv >> 33; hv *= 0xff51afd7ed558ccdULL;
+   hv ^= hv >> 33; hv *= 0xc4ceb9fe1a85ec53ULL;
+   hv ^= hv >> 33;
+   return hv;
+}
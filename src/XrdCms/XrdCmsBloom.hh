@@ -0,0 +1,105 @@
+#ifndef __XRDCMSBLOOM_H__
+#define __XRDCMSBLOOM_H__
+/******************************************************************************/
+/*                                                                            */
+/*                        X r d C m s B l o o m . h h                         */
+/*                                                                            */
+/* (c) 2019 by the Board of Trustees of the Leland Stanford, Jr., University  */
+/*                            All Rights Reserved                             */
+/*   Produced by Andrew Hanushevsky for Stanford University under contract    */
+/*              DE-AC02-76-SFO0515 with the Department of Energy              */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+/******************************************************************************/
+/*                     C l a s s   X r d C m s B l o o m                      */
+/******************************************************************************/
+
+// The XrdCmsBloom object is a bloom filter of file names. Servers build one
+// for all of their exported files and send it to their managers who use it to
+// decide which servers need to be asked about a file not in the cache. Bit i
+// of the filter is bit (i & 7) of byte (i >> 3) so that the filter can be sent
+// as is. A filter of 2**n bits can be folded into one of 2**m bits (m < n) by
+// or'ing together its 2**(n-m) pieces; each name remains present. A filter
+// whose vector could not be allocated is not Valid() and may have any name.
+//
+class XrdCmsBloom
+{
+public:
+
+static const int minBits = 13;   // log2 of smallest filter size (1K)
+static const int maxBits = 30;   // log2 of largest  filter size (128M)
+
+// Add() adds a file name given its Hash() value
+//
+inline void      Add(unsigned long long hv)
+                    {unsigned int h1 = hv, h2 = (hv >> 32) | 1;
+                     if (!bitVec) return;
+                     for (int i = 0; i < numHash; i++, h1 += h2)
+                         bitVec[(h1 & bitMask) >> 3] |= 1 << (h1 & 7);
+                    }
+
+// Data() returns the filter itself, Size() its length in bytes
+//
+inline unsigned char *Data() {return bitVec;}
+
+inline int       Size() {return static_cast<int>((bitMask >> 3) + 1);}
+
+// Fold() reduces the filter to 2**lgb bits
+//
+       void      Fold(int lgb);
+
+// Has() returns true if the name with the Hash() value may be in the filter
+//
+inline bool      Has(unsigned long long hv) const
+                    {unsigned int h1 = hv, h2 = (hv >> 32) | 1;
+                     if (!bitVec) return true;
+                     for (int i = 0; i < numHash; i++, h1 += h2)
+                         if (!(bitVec[(h1 & bitMask) >> 3] & (1 << (h1 & 7))))
+                            return false;
+                     return true;
+                    }
+
+// Hash() returns the value to be used for a file name. Repeated slashes and
+// a trailing slash are ignored so that equivalent names hash the same.
+//
+static unsigned long long Hash(const char *path, int plen);
+
+inline int       Hashes() {return numHash;}
+
+inline int       lgBits() {return lgSize;}
+
+// Valid() returns true if the filter vector was allocated
+//
+inline bool      Valid() const {return bitVec != 0;}
+
+                 XrdCmsBloom(int lgb, int hashes);
+                ~XrdCmsBloom();
+
+private:
+
+unsigned char   *bitVec;
+unsigned int     bitMask;
+int              numHash;
+int              lgSize;
+};
+#endif
@@ -61,15 +61,16 @@ class XrdCmsCacheJob : XrdJob
 {
 public:
 
-void   DoIt() {Cache.Recycle(myList); delete this;}
+void   DoIt() {Cache.Recycle(myShard, myList); delete this;}
 
-       XrdCmsCacheJob(XrdCmsKeyItem *List)
-                     : XrdJob("cache scrubber"), myList(List) {}
+       XrdCmsCacheJob(XrdCmsCache::Shard *sP, XrdCmsKeyItem *List)
+                     : XrdJob("cache scrubber"), myShard(sP), myList(List) {}
       ~XrdCmsCacheJob() {}
 
 private:
 
-XrdCmsKeyItem *myList;
+XrdCmsCache::Shard *myShard;
+XrdCmsKeyItem      *myList;
 };
 
 /******************************************************************************/
@@ -116,18 +117,19 @@ void *XrdCmsStartTickTock(void *carg)
   
 int XrdCmsCache::AddFile(XrdCmsSelect &Sel, SMask_t mask)
 {
+   Shard &sP = getShard(Sel.Path);
    XrdCmsKeyItem *iP;
    SMask_t xmask;
    int isrw = (Sel.Opts & XrdCmsSelect::Write), isnew = 0;
 
 // Serialize processing
 //
-   myMutex.Lock();
+   sP.myMutex.Lock();
 
 // Check for fast path processing
 //
    if (  !(iP = Sel.Path.TODRef) || !(iP->Key.Equiv(Sel.Path)))
-      if ((iP = Sel.Path.TODRef = CTable.Find(Sel.Path)))
+      if ((iP = Sel.Path.TODRef = sP.CTable.Find(Sel.Path)))
          Sel.Path.Ref = iP->Key.Ref;
 
 // Add/Modify the entry
@@ -137,8 +139,8 @@ int XrdCmsCache::AddFile(XrdCmsSelect &Sel, SMask_t mask)
           {iP->Loc.deadline = QDelay + time(0);
            iP->Loc.lifeline = nilTMO + iP->Loc.deadline;
            iP->Loc.hfvec = 0; iP->Loc.pfvec = 0; iP->Loc.qfvec = 0;
-           iP->Loc.TOD_B = BClock;
-           iP->Key.TOD = Tock;
+           iP->Loc.TOD_B = sP.BClock;
+           iP->Key.TOD = sP.Tock;
           } else {
            xmask = iP->Loc.pfvec;
            if (Sel.Opts & XrdCmsSelect::Pending) iP->Loc.pfvec |= mask;
@@ -155,11 +157,11 @@ int XrdCmsCache::AddFile(XrdCmsSelect &Sel, SMask_t mask)
                      }
           }
       } else if (!(Sel.Opts & XrdCmsSelect::Advisory))
-                {Sel.Path.TOD = Tock;
-                 if ((iP = CTable.Add(Sel.Path)))
+                {Sel.Path.TOD = sP.Tock;
+                 if ((iP = sP.CTable.Add(Sel.Path)))
                     {iP->Loc.pfvec    = (Sel.Opts&XrdCmsSelect::Pending?mask:0);
                      iP->Loc.hfvec    = mask;
-                     iP->Loc.TOD_B    = BClock;
+                     iP->Loc.TOD_B    = sP.BClock;
                      iP->Loc.qfvec    = 0;
                      iP->Loc.deadline = QDelay + time(0);
                      iP->Loc.lifeline = nilTMO + iP->Loc.deadline;
@@ -170,10 +172,76 @@ int XrdCmsCache::AddFile(XrdCmsSelect &Sel, SMask_t mask)
 
 // All done
 //
-   myMutex.UnLock();
+   sP.myMutex.UnLock();
    return isnew;
 }
   
+/******************************************************************************/
+/* Public                        B l m F i l e                                */
+/******************************************************************************/
+
+// This method is called when a file is not in the cache. It uses the bloom
+// filters sent by the nodes to decide which of them may have the file and
+// adds a new entry for it. Nodes that did not send a filter must be queried.
+
+// No filters:     FALSE is returned and nothing is done.
+// Entry exists:   FALSE is returned as someone else added it in the interim.
+// Read  request:  Sel.Vec.hf holds the nodes that may have the file and the
+//                 client may be sent there without waiting. These are not
+//                 recorded in the cache as only a query response confirms it.
+//                 Sel.Vec.bf holds these nodes plus those without a filter.
+//                 -1 is returned if any need to be queried and 1 otherwise.
+// Write request:  Sel.Vec.hf is zero and Sel.Vec.bf holds the nodes to query.
+//                 1 is returned so that the caller waits for the responses.
+  
+int XrdCmsCache::BlmFile(XrdCmsSelect &Sel, SMask_t mask)
+{
+   XrdCmsKeyItem *iP;
+   SMask_t maybe(0), query;
+   unsigned long long hv;
+   int i;
+
+// Check for the most common case of not having any bloom filters
+//
+   if (!bloomVec) return 0;
+
+// Find out which nodes may have the file. These and the nodes without a
+// filter are the only ones that need to be asked about it.
+//
+   hv = XrdCmsBloom::Hash(Sel.Path.Val, Sel.Path.Len);
+   bloomLock.ReadLock();
+   for (i = 0; i < STMax; i++)
+       if (bloomTab[i] && mask.Test(i) && bloomTab[i]->Has(hv)) maybe.Set(i);
+   query = maybe | (mask & ~bloomVec);
+   bloomLock.UnLock();
+
+// Add the entry to the cache with no location information. The deadline is
+// only set if some node needs to be queried.
+//
+   Shard &sP = getShard(Sel.Path);
+   sP.myMutex.Lock();
+   if (sP.CTable.Find(Sel.Path)) {sP.myMutex.UnLock(); return 0;}
+   Sel.Path.TOD = sP.Tock;
+   if (!(iP = sP.CTable.Add(Sel.Path))) {sP.myMutex.UnLock(); return 0;}
+   iP->Loc.hfvec    = 0;
+   iP->Loc.pfvec    = 0;
+   iP->Loc.qfvec    = 0;
+   iP->Loc.TOD_B    = sP.BClock;
+   iP->Loc.deadline = (query ? QDelay + time(0) : 0);
+   iP->Loc.lifeline = nilTMO + (query ? iP->Loc.deadline : time(0));
+   Sel.Path.Ref     = iP->Key.Ref;
+   Sel.Path.TODRef  = iP;
+   sP.myMutex.UnLock();
+
+// Return the selection vectors
+//
+   Sel.Vec.pf = 0;
+   Sel.Vec.bf = query;
+   if (Sel.Opts & XrdCmsSelect::Write) {Sel.Vec.hf = 0; return 1;}
+   Sel.Vec.hf = maybe & ~Sel.nmask;
+   return (query ? -1 : 1);
+}
+
 /******************************************************************************/
 /* Public                        D e l F i l e                                */
 /******************************************************************************/
@@ -190,29 +258,30 @@ int XrdCmsCache::AddFile(XrdCmsSelect &Sel, SMask_t mask)
   
 int XrdCmsCache::DelFile(XrdCmsSelect &Sel, SMask_t mask)
 {
+   Shard &sP = getShard(Sel.Path);
    XrdCmsKeyItem *iP;
    int gone4good;
 
 // Lock the hash table
 //
-   myMutex.Lock();
+   sP.myMutex.Lock();
 
 // Look up the entry and remove server
 //
-   if ((iP = CTable.Find(Sel.Path)))
+   if ((iP = sP.CTable.Find(Sel.Path)))
       {iP->Loc.hfvec &= ~mask;
        iP->Loc.pfvec &= ~mask;
        if ((gone4good = (iP->Loc.hfvec == 0)))
           {if (nilTMO) iP->Loc.lifeline = nilTMO + time(0);
            if (!(Sel.Opts & XrdCmsSelect::Advisory)
-           &&  XrdCmsKeyItem::Unload(iP) && !CTable.Recycle(iP))
+           &&  sP.CTable.Unload(iP) && !sP.CTable.Recycle(iP))
               Say.Emsg("DelFile", "Delete failed for", iP->Key.Val);
           }
       } else gone4good = 0;
 
 // All done
 //
-   myMutex.UnLock();
+   sP.myMutex.UnLock();
    return gone4good;
 }
   
@@ -231,19 +300,20 @@ int XrdCmsCache::DelFile(XrdCmsSelect &Sel, SMask_t mask)
   
 int  XrdCmsCache::GetFile(XrdCmsSelect &Sel, SMask_t mask)
 {
+   Shard &sP = getShard(Sel.Path);
    XrdCmsKeyItem *iP;
    SMask_t bVec;
    int retc;
 
 // Lock the hash table
 //
-   myMutex.Lock();
+   sP.myMutex.Lock();
 
 // Look up the entry and return location information
 //
-   if ((iP = CTable.Find(Sel.Path)))
-      {if ((bVec = (iP->Loc.TOD_B < BClock 
-                 ? getBVec(iP->Key.TOD, iP->Loc.TOD_B) & mask : 0)))
+   if ((iP = sP.CTable.Find(Sel.Path)))
+      {if ((bVec = (iP->Loc.TOD_B < sP.BClock
+                 ? getBVec(sP, iP->Key.TOD, iP->Loc.TOD_B) & mask : 0)))
           {iP->Loc.hfvec &= ~bVec; 
            iP->Loc.pfvec &= ~bVec;
            iP->Loc.qfvec &= ~mask;
@@ -258,15 +328,15 @@ int  XrdCmsCache::GetFile(XrdCmsSelect &Sel, SMask_t mask)
        if (nilTMO && retc == 1 && iP->Loc.hfvec == 0
        &&  iP->Loc.lifeline <= time(0)) retc = 0;
 
-       Sel.Vec.hf      = okVec & iP->Loc.hfvec;
-       Sel.Vec.pf      = okVec & iP->Loc.pfvec;
-       Sel.Vec.bf      = okVec & (bVec | iP->Loc.qfvec); iP->Loc.qfvec = 0;
+       Sel.Vec.hf      = sP.okVec & iP->Loc.hfvec;
+       Sel.Vec.pf      = sP.okVec & iP->Loc.pfvec;
+       Sel.Vec.bf      = sP.okVec & (bVec | iP->Loc.qfvec); iP->Loc.qfvec = 0;
        Sel.Path.Ref    = iP->Key.Ref;
       } else retc = 0;
 
 // All done
 //
-   myMutex.UnLock();
+   sP.myMutex.UnLock();
    Sel.Path.TODRef = iP;
    return retc;
 }
@@ -278,11 +348,12 @@ int  XrdCmsCache::GetFile(XrdCmsSelect &Sel, SMask_t mask)
 int XrdCmsCache::UnkFile(XrdCmsSelect &Sel, SMask_t mask)
 {
    EPNAME("UnkFile");
+   Shard &sP = getShard(Sel.Path);
    XrdCmsKeyItem *iP;
 
 // Make sure we have the proper information. If so, lock the hash table
 //
-   myMutex.Lock();
+   sP.myMutex.Lock();
 
 // Look up the entry and if valid update the unqueried vector. Note that
 // this method may only be called after GetFile() or AddFile() for a new entry
@@ -294,7 +365,7 @@ int XrdCmsCache::UnkFile(XrdCmsSelect &Sel, SMask_t mask)
 
 // Return result
 //
-   myMutex.UnLock();
+   sP.myMutex.UnLock();
    DEBUG("rc=" <<(iP ? 1 : 0) <<" path=" <<Sel.Path.Val);
    return (iP ? 1 : 0);
 }
@@ -313,7 +384,8 @@ int XrdCmsCache::WT4File(XrdCmsSelect &Sel, SMask_t mask)
 // Make sure we have the proper information. If so, lock the hash table
 //
    if (!Sel.InfoP) return DLTime;
-   myMutex.Lock();
+   Shard &sP = getShard(Sel.Path);
+   sP.myMutex.Lock();
 
 // Look up the entry and if valid add it to the callback queue. Note that
 // this method may only be called after GetFile() or AddFile() for a new entry
@@ -328,7 +400,7 @@ int XrdCmsCache::WT4File(XrdCmsSelect &Sel, SMask_t mask)
 
 // Return result
 //
-   myMutex.UnLock();
+   sP.myMutex.UnLock();
    DEBUG("rc=" <<retc <<" path=" <<Sel.Path.Val);
    return retc;
 }
@@ -336,6 +408,42 @@ int XrdCmsCache::WT4File(XrdCmsSelect &Sel, SMask_t mask)
 /******************************************************************************/
 /*         P u b l i c   A d m i n i s t r a t i v e   C l a s s e s          */
 /******************************************************************************/
+/******************************************************************************/
+/* public                          B l o o m                                  */
+/******************************************************************************/
+
+void XrdCmsCache::Bloom(int SNum, XrdCmsBloom *bP)
+{
+   SMask_t smask(1);
+
+// A filter that could not be allocated is the same as not having one
+//
+   if (bP && !bP->Valid()) {delete bP; bP = 0;}
+
+// Replace the node's filter and note whether it now has one
+//
+   smask = smask << SNum;
+   bloomLock.WriteLock();
+   if (bloomTab[SNum]) delete bloomTab[SNum];
+   bloomTab[SNum] = bP;
+   if (bP) bloomVec |= smask;
+      else bloomVec &= ~smask;
+   bloomLock.UnLock();
+}
+
+/******************************************************************************/
+
+void XrdCmsCache::Bloom(int SNum, const char *path, int plen)
+{
+   unsigned long long hv = XrdCmsBloom::Hash(path, plen);
+
+// Add the file to the node's filter, if it has one
+//
+   bloomLock.WriteLock();
+   if (bloomTab[SNum]) bloomTab[SNum]->Add(hv);
+   bloomLock.UnLock();
+}
+
 /******************************************************************************/
 /* public                         B o u n c e                                 */
 /******************************************************************************/
@@ -343,13 +451,17 @@ int XrdCmsCache::WT4File(XrdCmsSelect &Sel, SMask_t mask)
 void XrdCmsCache::Bounce(SMask_t smask, int SNum)
 {
 
-// Simply indicate that this server bounced
-//
-   myMutex.Lock();
-   Bounced[SNum] = ++BClock;
-   okVec |= smask;
-   if (SNum > vecHi) vecHi = SNum;
-   myMutex.UnLock();
+// Simply indicate that this server bounced. Each shard keeps its own bounce
+// state, so we update them one at a time and never hold more than one lock.
+//
+   for (int i = 0; i < numShards; i++)
+       {Shard &sP = Shards[i];
+        sP.myMutex.Lock();
+        sP.Bounced[SNum] = ++sP.BClock;
+        sP.okVec |= smask;
+        if (SNum > sP.vecHi) sP.vecHi = SNum;
+        sP.myMutex.UnLock();
+       }
 }
 
 /******************************************************************************/
@@ -364,13 +476,20 @@ void XrdCmsCache::Drop(SMask_t smask, int SNum, int xHi)
 //
    Paths.Remove(smask);
 
-// Remove the node from the list of valid nodes
+// Discard any bloom filter the node sent us
+//
+   Bloom(SNum, 0);
+
+// Remove the node from the list of valid nodes in each shard
 //
-   myMutex.Lock();
-   Bounced[SNum] = 0;
-   okVec &= nmask;
-   vecHi = xHi;
-   myMutex.UnLock();
+   for (int i = 0; i < numShards; i++)
+       {Shard &sP = Shards[i];
+        sP.myMutex.Lock();
+        sP.Bounced[SNum] = 0;
+        sP.okVec &= nmask;
+        sP.vecHi = xHi;
+        sP.myMutex.UnLock();
+       }
 }
 
 /******************************************************************************/
@@ -379,7 +498,6 @@ void XrdCmsCache::Drop(SMask_t smask, int SNum, int xHi)
   
 int XrdCmsCache::Init(int fxHold, int fxDelay, int fxQuery, int seFS, int nxHold)
 {
-   XrdCmsKeyItem *iP;
    pthread_t tid;
 
 // Indicate whether we are a shared-everything setup as this changes how we
@@ -411,9 +529,7 @@ int XrdCmsCache::Init(int fxHold, int fxDelay, int fxQuery, int seFS, int nxHold
 
 // Get the first reserve of cache items
 //
-   iP = XrdCmsKeyItem::Alloc(0);
-   XrdCmsKeyItem::Unload((unsigned int)0);
-   iP->Recycle();
+   XrdCmsKeyItem::Replenish();
 
 // All done
 //
@@ -427,16 +543,21 @@ int XrdCmsCache::Init(int fxHold, int fxDelay, int fxQuery, int seFS, int nxHold
 void *XrdCmsCache::TickTock()
 {
    XrdCmsKeyItem *iP;
+   int i;
 
-// Simply adjust the clock and trim old entries
+// Simply adjust the clock and trim old entries. Each shard is done in turn
+// so that lookups in the other shards proceed while one is being trimmed.
 //
    do {XrdSysTimer::Snooze(Tick);
-       myMutex.Lock();
-       Tock = (Tock+1) & XrdCmsKeyItem::TickMask;
-       Bhistory[Tock].Start = Bhistory[Tock].End = 0;
-       iP = XrdCmsKeyItem::Unload(Tock);
-       myMutex.UnLock();
-       if (iP) Sched->Schedule((XrdJob *)new XrdCmsCacheJob(iP));
+       for (i = 0; i < numShards; i++)
+           {Shard &sP = Shards[i];
+            sP.myMutex.Lock();
+            sP.Tock = (sP.Tock+1) & XrdCmsKeyItem::TickMask;
+            sP.Bhistory[sP.Tock].Start = sP.Bhistory[sP.Tock].End = 0;
+            iP = sP.CTable.Unload(sP.Tock);
+            sP.myMutex.UnLock();
+            if (iP) Sched->Schedule((XrdJob *)new XrdCmsCacheJob(&sP, iP));
+           }
       } while(1);
 
 // Keep compiler happy
@@ -502,7 +623,9 @@ void XrdCmsCache::Dispatch(XrdCmsSelect &Sel, XrdCmsKeyItem *iP,
 /*                               g e t B V e c                                */
 /******************************************************************************/
   
-SMask_t XrdCmsCache::getBVec(unsigned int TODa, unsigned int &TODb)
+// Must be called with the shard lock held.
+//
+SMask_t XrdCmsCache::getBVec(Shard &sP, unsigned int TODa, unsigned int &TODb)
 {
    EPNAME("getBVec");
    SMask_t BVec(0);
@@ -510,20 +633,20 @@ SMask_t XrdCmsCache::getBVec(unsigned int TODa, unsigned int &TODb)
 
 // See if we can use a previously calculated bVec
 //
-   if (Bhistory[TODa].End == BClock && Bhistory[TODa].Start <= TODb)
-      {Bhits++; TODb = BClock; return Bhistory[TODa].Vec;}
+   if (sP.Bhistory[TODa].End == sP.BClock && sP.Bhistory[TODa].Start <= TODb)
+      {sP.Bhits++; TODb = sP.BClock; return sP.Bhistory[TODa].Vec;}
 
 // Calculate the new vector
 //
-   for (i = 0; i <= vecHi; i++)
-       if (TODb < Bounced[i]) BVec |= 1ULL << i;
+   for (i = 0; i <= sP.vecHi; i++)
+       if (TODb < sP.Bounced[i]) BVec.Set(i);
 
-   Bhistory[TODa].Vec   = BVec;
-   Bhistory[TODa].Start = TODb;
-   Bhistory[TODa].End   = BClock;
-   TODb                 = BClock;
-   Bmiss++;
-   if (!(Bmiss & 0xff)) DEBUG("hits=" <<Bhits <<" miss=" <<Bmiss);
+   sP.Bhistory[TODa].Vec   = BVec;
+   sP.Bhistory[TODa].Start = TODb;
+   sP.Bhistory[TODa].End   = sP.BClock;
+   TODb                    = sP.BClock;
+   sP.Bmiss++;
+   if (!(sP.Bmiss & 0xff)) DEBUG("hits=" <<sP.Bhits <<" miss=" <<sP.Bmiss);
    return BVec;
 }
 
@@ -531,7 +654,7 @@ SMask_t XrdCmsCache::getBVec(unsigned int TODa, unsigned int &TODb)
 /*                               R e c y c l e                                */
 /******************************************************************************/
   
-void XrdCmsCache::Recycle(XrdCmsKeyItem *theList)
+void XrdCmsCache::Recycle(Shard *sP, XrdCmsKeyItem *theList)
 {
    XrdCmsKeyItem *iP;
    char msgBuff[100];
@@ -543,24 +666,18 @@ void XrdCmsCache::Recycle(XrdCmsKeyItem *theList)
         {theList = iP->Key.TODRef;
          if (iP->Loc.roPend) RRQ.Del(iP->Loc.roPend, iP);
          if (iP->Loc.rwPend) RRQ.Del(iP->Loc.rwPend, iP);
-         myMutex.Lock(); CTable.Recycle(iP); myMutex.UnLock();
+         sP->myMutex.Lock(); sP->CTable.Recycle(iP); sP->myMutex.UnLock();
          numRecycled++;
         }
 
-// See if we have enough items in reserve
+// See if we have enough items in reserve (the free list serializes itself)
 //
-   myMutex.Lock();
    XrdCmsKeyItem::Stats(numHave, numFree, numNull);
    if (numFree < XrdCmsKeyItem::minFree)
-      {myMutex.UnLock();
-       if (!(numNull /= 4)) numNull = 1;
+      {if (!(numNull /= 4)) numNull = 1;
        numHave += XrdCmsKeyItem::minAlloc * numNull;
-       while(numNull--)
-            {myMutex.Lock();
-             numFree = XrdCmsKeyItem::Replenish();
-             myMutex.UnLock();
-            }
-      } else myMutex.UnLock();
+       while(numNull--) numFree = XrdCmsKeyItem::Replenish();
+      }
 
 // Log the stats
 //
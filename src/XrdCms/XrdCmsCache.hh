@@ -34,6 +34,7 @@
   
 #include "Xrd/XrdJob.hh"
 #include "Xrd/XrdScheduler.hh"
+#include "XrdCms/XrdCmsBloom.hh"
 #include "XrdCms/XrdCmsKey.hh"
 #include "XrdCms/XrdCmsNash.hh"
 #include "XrdCms/XrdCmsPList.hh"
@@ -53,6 +54,13 @@ XrdCmsPList_Anchor Paths;
 //
 int         AddFile(XrdCmsSelect &Sel, SMask_t mask);
 
+// BlmFile() adds a new entry using the bloom filters sent by the nodes in mask
+//           to tell which nodes may have the file. It returns 0 if no node
+//           sent a filter. Otherwise, the return value is as for GetFile()
+//           with Sel.Vec.bf holding the nodes that still need to be queried.
+//
+int         BlmFile(XrdCmsSelect &Sel, SMask_t mask);
+
 // DelFile() returns true if this is the last deletion, false otherwise
 //
 int         DelFile(XrdCmsSelect &Sel, SMask_t mask);
@@ -70,6 +78,12 @@ int         UnkFile(XrdCmsSelect &Sel, SMask_t mask);
 //
 int         WT4File(XrdCmsSelect &Sel, SMask_t mask);
 
+// Bloom() replaces a node's bloom filter (bP may be nil) or adds a file to it
+//
+void        Bloom(int SNum, XrdCmsBloom *bP);
+
+void        Bloom(int SNum, const char *path, int plen);
+
 void        Bounce(SMask_t smask, int SNum);
 
 void        Drop(SMask_t mask, int SNum, int xHi);
@@ -80,22 +94,23 @@ void       *TickTock();
 
 static const int min_nxTime = 60;
 
-            XrdCmsCache() : okVec(0), Tick(8*60*60), Tock(0), BClock(0), 
-                            nilTMO(0),
-                            DLTime(5), QDelay(5), Bhits(0), Bmiss(0), vecHi(-1),
-                            isDFS(0)
-                          {memset(Bounced,  0, sizeof(Bounced));
-                           memset(Bhistory, 0, sizeof(Bhistory));
-                          }
+            XrdCmsCache() : Tick(8*60*60), nilTMO(0),
+                            DLTime(5), QDelay(5), isDFS(0), bloomVec(0)
+                          {memset(bloomTab, 0, sizeof(bloomTab));}
            ~XrdCmsCache() {}   // Never gets deleted
 
 private:
 
-void          Add2Q(XrdCmsRRQInfo *Info, XrdCmsKeyItem *cp, int selOpts);
-void          Dispatch(XrdCmsSelect &Sel, XrdCmsKeyItem *cinfo,
-                       short roQ, short rwQ);
-SMask_t       getBVec(unsigned int todA, unsigned int &todB);
-void          Recycle(XrdCmsKeyItem *theList);
+// The cache is split into independently locked shards selected by the high
+// order bits of the key hash. Each shard has its own hash table, tock lists,
+// and copy of the bounce state so that a lookup only needs the shard lock.
+//
+static const int   shardBits = 4;
+static const int   numShards = 1 << shardBits;
+
+class Shard
+{
+public:
 
 struct  {SMask_t      Vec;
          unsigned int Start;
@@ -106,16 +121,40 @@ XrdSysMutex   myMutex;
 XrdCmsNash    CTable;
 unsigned int  Bounced[STMax];
 SMask_t       okVec;
-unsigned int  Tick;
 unsigned int  Tock;
 unsigned int  BClock;
-         int  nilTMO;
-         int  DLTime;
-         int  QDelay;
          int  Bhits;
          int  Bmiss;
          int  vecHi;
+
+              Shard() : CTable(2584, 4181), okVec(0), Tock(0), BClock(0),
+                        Bhits(0), Bmiss(0), vecHi(-1)
+                      {memset(Bounced,  0, sizeof(Bounced));
+                       memset(Bhistory, 0, sizeof(Bhistory));
+                      }
+             ~Shard() {}
+};
+
+void          Add2Q(XrdCmsRRQInfo *Info, XrdCmsKeyItem *cp, int selOpts);
+void          Dispatch(XrdCmsSelect &Sel, XrdCmsKeyItem *cinfo,
+                       short roQ, short rwQ);
+SMask_t       getBVec(Shard &sP, unsigned int todA, unsigned int &todB);
+Shard        &getShard(XrdCmsKey &Key)
+                      {if (!Key.Hash) Key.setHash();
+                       return Shards[Key.Hash >> (32 - shardBits)];
+                      }
+void          Recycle(Shard *sP, XrdCmsKeyItem *theList);
+
+Shard         Shards[numShards];
+unsigned int  Tick;
+         int  nilTMO;
+         int  DLTime;
+         int  QDelay;
          int  isDFS;
+
+XrdSysRWLock  bloomLock;
+XrdCmsBloom  *bloomTab[STMax];
+SMask_t       bloomVec;       // Nodes that sent a bloom filter
 };
 
 namespace XrdCms
@@ -56,6 +56,7 @@
 #include "XrdCms/XrdCmsTrace.hh"
 #include "XrdCms/XrdCmsTypes.hh"
 
+#include "XrdOuc/XrdOucCRC.hh"
 #include "XrdOuc/XrdOucPup.hh"
 
 #include "XrdSys/XrdSysPlatform.hh"
@@ -70,6 +71,24 @@ using namespace XrdCms;
 
        XrdCmsCluster   XrdCms::Cluster;
 
+/******************************************************************************/
+/*                         L o c a l   M e t h o d s                          */
+/******************************************************************************/
+
+namespace
+{
+// Spread the bits of a hash value (the CRC32 used for path keys and node
+// names does not spread similar names well enough for the hash ring).
+//
+inline unsigned int Mix(unsigned int h)
+{
+   h ^= h >> 16; h *= 0x85ebca6bU;
+   h ^= h >> 13; h *= 0xc2b2ae35U;
+   h ^= h >> 16;
+   return h;
+}
+}
+
 /******************************************************************************/
 /*                      L o c a l   S t r u c t u r e s                       */
 /******************************************************************************/
@@ -122,6 +141,12 @@ XrdCmsCluster::XrdCmsCluster()
      resetMask = 0;
      peerHost  = 0;
      peerMask  = ~peerHost;
+     curSnap   = new NodeSnap(0);
+     snapStale = 1;
+     snapSeq   = 0;
+     hashRing  = 0;
+     ringNum   = 0;
+     ringStale = true;
 }
   
 /******************************************************************************/
@@ -229,6 +254,7 @@ XrdCmsNode *XrdCmsCluster::Add(XrdLink *lp, int port, int Status, int sport,
 //
    if (!aSet && (Status & CMS_isSuper)) setAltMan(Slot, lp, sport);
    if (Slot > STHi) STHi = Slot;
+   Stale(); setSnap(); ringStale = true;
    nP->isBound   = 1;
    nP->isConn    = 1;
    nP->isNoStage = 0 != (Status & CMS_noStage);
@@ -316,7 +342,7 @@ XrdCmsNode *XrdCmsCluster::AddAlt(XrdCmsClustID *cidP, XrdLink *lp,
    if ((pP = NodeTab[slot]) && !(pP->isBound))
       {setAltMan(nP->NodeID, nP->Link, sport);
        Say.Emsg("AddAlt", nP->Ident, "replacing dropped", pP->Ident);
-       NodeTab[slot] = nP;
+       NodeTab[slot] = nP; ringStale = true;
        pP->DropJob = new XrdCmsDrop(pP); // Schedule deletion
       }
 
@@ -365,6 +391,7 @@ void XrdCmsCluster::BlackList(XrdOucTList *blP)
                 Say.Emsg("Manager", nP->Name(), "removed from blacklist.");
                }
             nP->n2gLock(STMutex);
+            Stale();
            }
        }
    STMutex.UnLock();
@@ -544,7 +571,7 @@ XrdCmsSelected *XrdCmsCluster::List(SMask_t mask, CmsLSOpts opts, bool &oksel)
    oksel = false;
    STMutex.Lock();
    for (i = 0; i <= STHi; i++)
-        if ((nP=NodeTab[i]) && (nP->NodeMask & mask))
+        if ((nP=NodeTab[i]) && mask.Test(i))
            {oksel = true;
             if (retDest)
                {     if (nP->netIF.HasDest(ifType)) ifGet = ifType;
@@ -744,6 +771,28 @@ void *XrdCmsCluster::MonRefs()
    return (void *)0;
 }
 
+/******************************************************************************/
+/*                               M o n S n a p                                */
+/******************************************************************************/
+
+void *XrdCmsCluster::MonSnap()
+{
+   static const int snapWait = 250; // Milliseconds between checks
+   int isStale;
+
+// Periodically publish a new node snapshot if node information has changed.
+// This keeps load and space reports from forcing a rebuild on the selection
+// path as they arrive far more often than their effect on selection matters.
+//
+   do {XrdSysTimer::Wait(snapWait);
+       AtomicBeg(SnapMutex);
+       isStale = AtomicGet(snapStale);
+       AtomicEnd(SnapMutex);
+       if (isStale) {STMutex.Lock(); setSnap(); STMutex.UnLock();}
+      } while(1);
+   return (void *)0;
+}
+
 /******************************************************************************/
 /*                                R e m o v e                                 */
 /******************************************************************************/
@@ -815,6 +864,7 @@ void XrdCmsCluster::Remove(const char *reason, XrdCmsNode *theNode, int immed)
 // Mark node as being offline and remove any drop job from it
 //
    theNode->isOffline = 1; // STMutex is held here
+   Stale(); setSnap();
 
 // If the node is connected we simply close the connection. This will cause
 // the connection handler to re-initiate the node removal. This condition
@@ -857,7 +907,7 @@ void XrdCmsCluster::Remove(const char *reason, XrdCmsNode *theNode, int immed)
    if (theNode->isMan && theNode->cidP && !(theNode->cidP->IsSingle())
    && (altNode = theNode->cidP->RemNode(theNode)))
       {if (altNode->isBound) NodeCnt++;
-       NodeTab[NodeID] = altNode;
+       NodeTab[NodeID] = altNode; ringStale = true;
        if (Config.asManager())
           CmsState.Update(XrdCmsState::Counts,
                           altNode->isBad & XrdCmsNode::isSuspend ? 0 :  1,
@@ -972,7 +1022,8 @@ int XrdCmsCluster::Select(XrdCmsSelect &Sel)
       }
 
 // If either a refresh is wanted or we didn't find the file, re-prime the cache
-// which will force the client to wait. Otherwise, compute the primary and
+// which will force the client to wait unless the nodes' bloom filters let us
+// add the file (see BlmFile()). Otherwise, compute the primary and
 // secondary selections. If there are none, the client may have to wait if we
 // have servers that we can query regarding the file. Note that for files being
 // opened in write mode, only one writable copy may exist unless this is a
@@ -980,7 +1031,8 @@ int XrdCmsCluster::Select(XrdCmsSelect &Sel)
 // or a replica request, in which case we select a new target server.
 //
    if (!(Sel.Opts & XrdCmsSelect::Refresh)
-   &&   (retc = Cache.GetFile(Sel, pinfo.rovec)))
+   &&  ((retc = Cache.GetFile(Sel, pinfo.rovec))
+   ||   (retc = Cache.BlmFile(Sel, pinfo.rovec))))
       {if (isRW)
           {     if (retc<0) return Config.LUPDelay;
               else if (Sel.Opts & XrdCmsSelect::Replica)
@@ -1074,11 +1126,9 @@ int XrdCmsCluster::Select(XrdCmsSelect &Sel)
 int XrdCmsCluster::Select(SMask_t pmask, int &port, char *hbuff, int &hlen,
                           int isrw, int isMulti, int ifWant)
 {
-   static const SMask_t smLow(255);
    XrdCmsSelector selR;
    XrdCmsNode *nP = 0;
-   SMask_t tmask;
-   int Snum = 0;
+   int Snum;
    XrdNetIF::ifType nType = static_cast<XrdNetIF::ifType>(ifWant);
 
 // If there is nothing to select from, return failure
@@ -1097,10 +1147,13 @@ int XrdCmsCluster::Select(SMask_t pmask, int &port, char *hbuff, int &hlen,
 // may have more than one server indicated. So, we need to do a full select.
 // This is forced when isMulti is true, indicating a choice may exist. Note
 // that the node, if any, is returned unlocked but we have the global mutex.
+// With two choice selection we first try the node snapshot (see SelbyP2C).
 //
    if (isMulti || baseFS.isDFS())
-      {STMutex.Lock();
-       nP = (Config.sched_RR ? SelbyRef(pmask,selR) : SelbyLoad(pmask,selR));
+      {if (Config.sched_Pick == 1) nP = SelbyP2C(pmask, selR, false);
+          else STMutex.Lock();
+       if (!nP)
+          nP = (Config.sched_RR ? SelbyRef(pmask,selR) : SelbyLoad(pmask,selR));
        if (nP) hlen = nP->netIF.GetName(hbuff, port, nType) + 1;
           else hlen = 0;
        STMutex.UnLock();
@@ -1110,9 +1163,7 @@ int XrdCmsCluster::Select(SMask_t pmask, int &port, char *hbuff, int &hlen,
 // In shared-nothing systems the incomming mask will only have a single node.
 // Compute the a single node number that is contained in the mask.
 //
-   do {if (!(tmask = pmask & smLow)) Snum += 8;
-         else {while((tmask = tmask>>1)) Snum++; break;}
-      } while((pmask = pmask >> 8));
+   Snum = pmask.First();
 
 // See if the node passes muster
 //
@@ -1420,6 +1471,7 @@ int XrdCmsCluster::Drop(int sent, int sinst, XrdCmsDrop *djp)
 //
    NodeTab[sent] = 0;
    nP->isOffline = 1; // STMutex is locked
+   Stale(); setSnap(); ringStale = true;
    nP->DropTime  = 0;
    nP->DropJob   = 0;
    nP->isBound   = 0;
@@ -1462,36 +1514,33 @@ int XrdCmsCluster::Drop(int sent, int sinst, XrdCmsDrop *djp)
    return 0;
 }
 
+/******************************************************************************/
+/*                               g e t S n a p                                */
+/******************************************************************************/
+
+// Return a reference to the last published node snapshot. The caller need not
+// hold the STMutex and must call putSnap() when done with the snapshot.
+  
+XrdCmsCluster::NodeSnap *XrdCmsCluster::getSnap()
+{
+   NodeSnap *snP;
+
+// Get a reference to the current snapshot
+//
+   SnapMutex.Lock();
+   snP = curSnap;
+   snP->Refs++;
+   SnapMutex.UnLock();
+   return snP;
+}
+
 /******************************************************************************/
 /*                              M u l t i p l e                               */
 /******************************************************************************/
 
 int XrdCmsCluster::Multiple(SMask_t mVec)
 {
-   static const unsigned long long Left32  = 0xffffffff00000000LL;
-   static const unsigned long long Right32 = 0x00000000ffffffffLL;
-   static const unsigned long long Left16  = 0x00000000ffff0000LL;
-   static const unsigned long long Right16 = 0x000000000000ffffLL;
-   static const unsigned long long Left08  = 0x000000000000ff00LL;
-   static const unsigned long long Right08 = 0x00000000000000ffLL;
-   static const unsigned long long Left04  = 0x00000000000000f0LL;
-   static const unsigned long long Right04 = 0x000000000000000fLL;
-//                                0 1 2 3 4 5 6 7 8 9 A B C D E F
-   static const int isMult[16] = {0,0,0,1,0,1,1,1,0,1,1,1,1,1,1,1};
-
-   if (mVec & Left32) {if (mVec & Right32) return 1;
-                          else mVec = mVec >> 32LL;
-                      }
-   if (mVec & Left16) {if (mVec & Right16) return 1;
-                          else mVec = mVec >> 16LL;
-                      }
-   if (mVec & Left08) {if (mVec & Right08) return 1;
-                          else mVec = mVec >>  8LL;
-                      }
-   if (mVec & Left04) {if (mVec & Right04) return 1;
-                          else mVec = mVec >>  4LL;
-                      }
-   return isMult[mVec];
+   return mVec.Count() > 1;
 }
   
 /******************************************************************************/
@@ -1500,19 +1549,26 @@ int XrdCmsCluster::Multiple(SMask_t mVec)
   
 bool XrdCmsCluster::maxBits(SMask_t mVec, int mbits)
 {
-   int count = 0;
 
-// Count bits. This is the fastest way assuming few bits are set
+// Count bits, the mask may be many words long so we do them all at once
 //
-   while(mVec)
-        {mVec &= (mVec - 1);
-         count++;
-         if (count >= mbits) return true;
-        }
+   return mVec.Count() >= mbits;
+}
 
-// Indicate we have not reached the maximum bits set
+/******************************************************************************/
+/*                               p u t S n a p                                */
+/******************************************************************************/
+  
+void XrdCmsCluster::putSnap(NodeSnap *snP)
+{
+   bool doDel;
+
+// Drop the reference and delete the snapshot when no longer in use
 //
-   return false;
+   SnapMutex.Lock();
+   doDel = !(--snP->Refs);
+   SnapMutex.UnLock();
+   if (doDel) delete snP;
 }
 
 /******************************************************************************/
@@ -1563,13 +1619,24 @@ int XrdCmsCluster::SelNode(XrdCmsSelect &Sel, SMask_t pmask, SMask_t amask)
       else selR.needSpace = (Sel.Opts & XrdCmsSelect::Write
                           ?  XrdCmsNode::allowsRW : 0);
 
+// With two choice selection first try to pick a primary node from the node
+// snapshot. This returns with the global mutex held, whatever the outcome.
+// With hash selection first try the node the path maps to on the hash ring.
+//
+   if (Config.sched_Pick && !selR.selPack && !(Sel.Opts & XrdCmsSelect::UseRef))
+      {if (Config.sched_Pick == 1) nP = SelbyP2C(pmask, selR, true);
+          else {if (!Sel.Path.Hash) Sel.Path.setHash();
+                STMutex.Lock();
+                nP = SelbyHash(pmask & peerMask, Sel.Path.Hash, selR);
+               }
+      } else STMutex.Lock();
+
 // Scan for a primary and alternate node (alternates do staging). At this
 // point we omit all peer nodes as they are our last resort. Note that Selbyxxx
 // returns the node unlocked but we have he global mutex so that is OK.
 //
-   STMutex.Lock();
    mask = pmask & peerMask;
-   while(pass--)
+   while(!nP && pass--)
         {if (mask)
             {nP = (Config.sched_RR || (Sel.Opts & XrdCmsSelect::UseRef)
                 ?  SelbyRef(mask,selR) : SelbyLoad(mask,selR));
@@ -1693,7 +1760,7 @@ XrdCmsNode *XrdCmsCluster::SelbyCost(SMask_t mask, XrdCmsSelector &selR)
 //
    selR.Reset(); SelTcnt++;
    for (int i = 0; i <= STHi; i++)
-       if ((np = NodeTab[i]) && (np->NodeMask & mask))
+       if ((np = NodeTab[i]) && mask.Test(i))
           {if (!(selR.needNet &  np->hasNet))    {selR.xNoNet= true; continue;}
            selR.nPick++;
            if (np->isOffline)                    {selR.xOff  = true; continue;}
@@ -1721,6 +1788,72 @@ XrdCmsNode *XrdCmsCluster::SelbyCost(SMask_t mask, XrdCmsSelector &selR)
    return sp;
 }
   
+/******************************************************************************/
+/*                             S e l b y H a s h                              */
+/******************************************************************************/
+
+// Hash selection maps the path's hash onto a ring of the nodes and uses the
+// first eligible node at or after that point so that a file is sent to the
+// same node as long as it is eligible; adding or dropping a node only moves
+// the paths that map to it. To bound the load, a node that has been selected
+// P_spill percent more often than the average eligible node is passed over.
+
+// Caller must have the STMutex locked. The returned node, if any, is unlocked.
+// A nil return means that a full scan is needed, as for SelbyP2C().
+
+XrdCmsNode *XrdCmsCluster::SelbyHash(SMask_t mask, unsigned int hVal,
+                                     XrdCmsSelector &selR)
+{
+    XrdCmsNode *np, *sp = 0;
+    SMask_t okVec(0);
+    long long refMax, refTot = 0;
+    int i, j, lo, hi, n = 0;
+    bool reqSS = (selR.needSpace & XrdCmsNode::allowsSS) != 0;
+
+// Rebuild the ring if the set of nodes changed
+//
+   if (ringStale) setRing();
+   if (!ringNum) return 0;
+
+// Find the eligible nodes and the number of times they have been selected
+//
+   for (i = 0; i <= STHi; i++)
+       if ((np = NodeTab[i]) && mask.Test(i))
+          {if (!(selR.needNet & np->hasNet) || np->isOffline || np->isBad
+           ||  (!Config.sched_RR && np->myLoad > Config.MaxLoad)) continue;
+           if (selR.needSpace && (np->DiskFree < np->DiskMinF
+                                  || (reqSS && np->isNoStage))) continue;
+           okVec.Set(i); n++;
+           refTot += (selR.needSpace ? np->RefW : np->RefR);
+          }
+   if (!n) return 0;
+   refMax = ((refTot + 1) * (100 + Config.P_spill) + 100LL*n - 1) / (100LL*n);
+
+// Find the first point at or after the path's hash and walk the ring from
+// there. The least selected node is always below the bound so we will find
+// a node.
+//
+   hVal = Mix(hVal); lo = 0; hi = ringNum;
+   while(lo < hi)
+        {j = (lo + hi) / 2;
+         if (hashRing[j].Hash < hVal) lo = j + 1;
+            else hi = j;
+        }
+   for (j = 0; j < ringNum; j++)
+       {i = hashRing[(lo + j) % ringNum].Slot;
+        if (!okVec.Test(i)) continue;
+        np = NodeTab[i];
+        if ((selR.needSpace ? np->RefW : np->RefR) < refMax) {sp = np; break;}
+       }
+
+// Count the selection
+//
+   if (!sp) return 0;
+   selR.Reset(); selR.nPick = n; SelTcnt++;
+   RefCount(sp, n > 1, selR.needSpace);
+   return sp;
+}
+  
 /******************************************************************************/
 /*                             S e l b y L o a d                              */
 /******************************************************************************/
@@ -1736,7 +1869,7 @@ XrdCmsNode *XrdCmsCluster::SelbyLoad(SMask_t mask, XrdCmsSelector &selR)
 //
    selR.Reset(); SelTcnt++;
    for (int i = 0; i <= STHi; i++)
-       if ((np = NodeTab[i]) && (np->NodeMask & mask))
+       if ((np = NodeTab[i]) && mask.Test(i))
           {if (!(selR.needNet & np->hasNet))      {selR.xNoNet= true; continue;}
            selR.nPick++;
            if (np->isOffline)                     {selR.xOff  = true; continue;}
@@ -1773,6 +1906,108 @@ XrdCmsNode *XrdCmsCluster::SelbyLoad(SMask_t mask, XrdCmsSelector &selR)
    return sp;
 }
 
+/******************************************************************************/
+/*                              S e l b y P 2 C                               */
+/******************************************************************************/
+
+// Two choice selection picks two eligible nodes at random and uses the one
+// with the lower load (or mass when space is needed). Unlike a scan for the
+// least loaded node, concurrent selections do not all land on the same node
+// between load reports. The candidates come from the node snapshot so that
+// the STMutex is only needed to compare the two picked nodes, not to scan.
+
+// Caller must not have the STMutex locked; it is always locked upon return.
+// The returned node, if any, is unlocked. A nil return means that a full scan
+// is needed, which also establishes the reason for not selecting a node.
+
+XrdCmsNode *XrdCmsCluster::SelbyP2C(SMask_t mask, XrdCmsSelector &selR,
+                                    bool noPeer)
+{
+    NodeSnap *snP = getSnap();
+    NodeSnap::Entry Pick[2];
+    XrdCmsNode *np, *sp = 0;
+    unsigned long long rVal;
+    int cand[2], i, j, k, n = 0, nPick = 0;
+    bool reqSS = (selR.needSpace & XrdCmsNode::allowsSS) != 0;
+
+// Count the eligible nodes in the snapshot
+//
+   if (noPeer) mask &= snP->peerMask;
+   for (i = 0; i < snP->Num; i++)
+       if (SelP2COk(snP->Node[i], mask, selR, reqSS)) n++;
+
+// Pick two distinct candidates at random by their ordinal and then find them
+//
+   if (n)
+      {AtomicBeg(SnapMutex);
+       AtomicFAdd(rVal, snapSeq, 1);
+       AtomicEnd(SnapMutex);
+       rVal = (rVal + 1) * 0x9e3779b97f4a7c15ULL;
+       rVal = (rVal ^ (rVal >> 31)) * 0xbf58476d1ce4e5b9ULL;
+       rVal ^= rVal >> 29;
+       cand[nPick++] = i = rVal % n;
+       if (n > 1)
+          {j = (rVal >> 32) % (n-1);
+           cand[nPick++] = (j < i ? j : j+1);
+          }
+       for (i = k = 0; i < snP->Num; i++)
+           if (SelP2COk(snP->Node[i], mask, selR, reqSS))
+              {for (j = 0; j < nPick; j++)
+                   if (cand[j] == k) Pick[j] = snP->Node[i];
+               k++;
+              }
+      }
+   putSnap(snP);
+
+// Make sure each picked node is still the same and still eligible and use
+// the better one based on its current load and reference counts. If neither
+// is usable a full scan will sort things out.
+//
+   STMutex.Lock();
+   for (i = 0; i < nPick; i++)
+       {np = NodeTab[Pick[i].Slot];
+        if (!np || np != Pick[i].nodeP || np->Instance != Pick[i].Inst
+        ||  !(selR.needNet & np->hasNet) || np->isOffline || np->isBad
+        ||  (!Config.sched_RR && np->myLoad > Config.MaxLoad)
+        ||  (noPeer && peerHost.Test(Pick[i].Slot))
+        ||  (selR.needSpace && (np->DiskFree < np->DiskMinF
+                                || (reqSS && np->isNoStage)))) continue;
+        if (!sp) sp = np;
+           else if (selR.needSpace)
+                   {if (abs(sp->myMass - np->myMass) <= Config.P_fuzz)
+                       {if (sp->RefW > (np->RefW+Config.DiskLinger))    sp=np;}
+                       else if (sp->myMass > np->myMass)                sp=np;
+                   } else {
+                    if (abs(sp->myLoad - np->myLoad) <= Config.P_fuzz)
+                       {if (sp->RefR > np->RefR)                        sp=np;}
+                       else if (sp->myLoad > np->myLoad)                sp=np;
+                   }
+       }
+
+// Count the selection
+//
+   if (!sp) return 0;
+   selR.Reset(); selR.nPick = n; SelTcnt++;
+   RefCount(sp, n > 1, selR.needSpace);
+   return sp;
+}
+
+/******************************************************************************/
+/*                              S e l P 2 C O k                               */
+/******************************************************************************/
+
+// Return true if the snapshot entry is eligible for two choice selection.
+  
+bool XrdCmsCluster::SelP2COk(NodeSnap::Entry &eP, SMask_t &mask,
+                             XrdCmsSelector &selR, bool reqSS)
+{
+   if (!mask.Test(eP.Slot) || !(selR.needNet & eP.hasNet)
+   ||  eP.isOffline || eP.isBad
+   ||  (!Config.sched_RR && eP.Load > Config.MaxLoad)) return false;
+   return !selR.needSpace || (eP.DiskFree >= eP.DiskMinF
+                              && !(reqSS && eP.isNoStage));
+}
+
 /******************************************************************************/
 /*                              S e l b y R e f                               */
 /******************************************************************************/
@@ -1788,7 +2023,7 @@ XrdCmsNode *XrdCmsCluster::SelbyRef(SMask_t mask, XrdCmsSelector &selR)
 //
    selR.Reset(); SelTcnt++;
    for (int i = 0; i <= STHi; i++)
-       if ((np = NodeTab[i]) && (np->NodeMask & mask))
+       if ((np = NodeTab[i]) && mask.Test(i))
           {if (!(selR.needNet & np->hasNet))    {selR.xNoNet= true; continue;}
            selR.nPick++;
            if (np->isOffline)                   {selR.xOff  = true; continue;}
@@ -1946,6 +2181,110 @@ void XrdCmsCluster::setAltMan(int snum, XrdLink *lp, int port)
    if (ap >= AltMend) {AltMend = ap + AltSize; AltMent = snum;}
 }
 
+/******************************************************************************/
+/*                               s e t R i n g                                */
+/******************************************************************************/
+
+// Caller must have the STMutex locked.
+  
+void XrdCmsCluster::setRing()
+{
+   XrdCmsNode *np;
+   char buff[512];
+   unsigned int nHash;
+   int i, j, n = 0;
+
+// Allocate the ring for the largest number of nodes we can have
+//
+   ringStale = false;
+   if (!hashRing
+   &&  !(hashRing = (RingPoint *)malloc(sizeof(RingPoint) * STMax * ringVN)))
+      {ringNum = 0; return;}
+
+// Place each node on the ring based on its name and port so that a node has
+// the same points no matter which slot it gets or how often it reconnects.
+//
+   for (i = 0; i <= STHi; i++)
+       if ((np = NodeTab[i]))
+          {j = snprintf(buff, sizeof(buff), "%s:%d", np->Name(),
+                                                     np->netIF.Port());
+           nHash = XrdOucCRC::CRC32((const unsigned char *)buff, j);
+           for (j = 0; j < ringVN; j++, n++)
+               {hashRing[n].Hash = Mix(nHash + j * 0x9e3779b9U);
+                hashRing[n].Slot = i;
+               }
+          }
+
+// Sort the points by hash value
+//
+   qsort(hashRing, n, sizeof(RingPoint), RingCmp);
+   ringNum = n;
+}
+
+/******************************************************************************/
+
+int XrdCmsCluster::RingCmp(const void *a, const void *b)
+{
+   unsigned int aHash = ((const RingPoint *)a)->Hash;
+   unsigned int bHash = ((const RingPoint *)b)->Hash;
+
+   if (aHash == bHash) return ((const RingPoint *)a)->Slot
+                            - ((const RingPoint *)b)->Slot;
+   return (aHash < bHash ? -1 : 1);
+}
+
+/******************************************************************************/
+/*                               s e t S n a p                                */
+/******************************************************************************/
+
+// Caller must have the STMutex locked.
+  
+void XrdCmsCluster::setSnap()
+{
+   NodeSnap *snP, *oldP;
+   XrdCmsNode *np;
+   int isStale;
+
+// The snapshot is only used for two choice selection
+//
+   if (Config.sched_Pick != 1) return;
+
+// Check if another thread already rebuilt the snapshot. Otherwise, clear the
+// indicator before copying so that changes made during the copy are caught.
+//
+   AtomicBeg(SnapMutex);
+   AtomicFZAP(isStale, snapStale);
+   AtomicEnd(SnapMutex);
+   if (!isStale) return;
+
+// Copy the selection information of each node
+//
+   snP = new NodeSnap(STHi+1);
+   snP->peerMask = peerMask;
+   for (int i = 0; i <= STHi; i++)
+       if ((np = NodeTab[i]))
+          {NodeSnap::Entry &eP = snP->Node[snP->Num++];
+           eP.nodeP     = np;
+           eP.Slot      = i;
+           eP.Inst      = np->Instance;
+           eP.Load      = np->myLoad;
+           eP.DiskFree  = np->DiskFree;
+           eP.DiskMinF  = np->DiskMinF;
+           eP.hasNet    = np->hasNet;
+           eP.isBad     = np->isBad;
+           eP.isOffline = np->isOffline;
+           eP.isNoStage = np->isNoStage;
+          }
+
+// Publish the new snapshot and drop our reference to the old one
+//
+   SnapMutex.Lock();
+   oldP = curSnap;
+   curSnap = snP;
+   SnapMutex.UnLock();
+   putSnap(oldP);
+}
+
 /******************************************************************************/
 /*                           U n r e a c h a b l e                            */
 /******************************************************************************/
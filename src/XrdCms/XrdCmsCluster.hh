@@ -38,6 +38,7 @@
 #include "XrdCms/XrdCmsTypes.hh"
 #include "XrdOuc/XrdOucTList.hh"
 #include "XrdOuc/XrdOucEnum.hh"
+#include "XrdSys/XrdSysAtomics.hh"
 #include "XrdSys/XrdSysPthread.hh"
 
 class XrdLink;
@@ -168,6 +169,10 @@ void           *MonPerf();
 //
 void           *MonRefs();
 
+// Always run as a separate thread to publish the node snapshot (two choice)
+//
+void           *MonSnap();
+
 // Return total number of redirect references (sloppy as we don't lock it)
 //
 long long       Refs() {return SelWcnt+SelWtot+SelRcnt+SelRtot;}
@@ -202,6 +207,14 @@ void            SLock(bool dolock)
 //
 void            Space(XrdCms::SpaceData &sData, SMask_t smask);
 
+// Called when node selection information changes (load, space, or status) so
+// that the node snapshot is rebuilt when it is next published by MonSnap().
+//
+inline void     Stale() {AtomicBeg(SnapMutex);
+                         AtomicInc(snapStale);
+                         AtomicEnd(SnapMutex);
+                        }
+
 // Called to return statistics
 //
 int             Stats(char *bfr, int bln); // Server
@@ -211,6 +224,38 @@ int             Statt(char *bfr, int bln); // Manager
 virtual        ~XrdCmsCluster() {} // This object should never be deleted
 
 private:
+
+// The node snapshot is an immutable copy of the node selection information.
+// It is rebuilt under the STMutex when it is stale, either periodically by
+// MonSnap() or right away when a node is added or dropped, and is used to
+// select a node without holding the STMutex. Snapshots are reference counted as an
+// older one may still be in use when a new one is published. Only as many
+// entries as there are slots in use (i.e. up to STHi) are allocated.
+//
+class NodeSnap
+{
+public:
+struct Entry
+      {XrdCmsNode *nodeP;       // Only compared against NodeTab, never used!
+       int         Slot;
+       int         Inst;
+       int         Load;
+       int         DiskFree;
+       int         DiskMinF;
+       char        hasNet;
+       char        isBad;
+       char        isOffline;
+       char        isNoStage;
+      }          *Node;
+int               Num;
+int               Refs;
+SMask_t           peerMask;
+
+                  NodeSnap(int maxNum) : Node(maxNum > 0 ? new Entry[maxNum]:0),
+                                         Num(0), Refs(1), peerMask(0) {}
+                 ~NodeSnap() {if (Node) delete [] Node;}
+};
+
 XrdCmsNode *AddAlt(XrdCmsClustID *cidP, XrdLink *lp, int port, int Status,
                    int sport, const char *theNID, const char *theIF);
 XrdCmsNode *calcDelay(XrdCmsSelector &selR);
@@ -222,12 +267,20 @@ enum        {eExists, eDups, eROfs, eNoRep, eNoSel, eNoEnt}; // Passed to SelFai
 int         SelFail(XrdCmsSelect &Sel, int rc);
 int         SelNode(XrdCmsSelect &Sel, SMask_t  pmask, SMask_t  amask);
 XrdCmsNode *SelbyCost(SMask_t, XrdCmsSelector &selR);
+XrdCmsNode *SelbyHash(SMask_t, unsigned int hVal, XrdCmsSelector &selR);
 XrdCmsNode *SelbyLoad(SMask_t, XrdCmsSelector &selR);
+XrdCmsNode *SelbyP2C (SMask_t, XrdCmsSelector &selR, bool noPeer);
+bool        SelP2COk(NodeSnap::Entry &eP, SMask_t &mask,
+                     XrdCmsSelector &selR, bool reqSS);
 XrdCmsNode *SelbyRef (SMask_t, XrdCmsSelector &selR);
 int         SelDFS(XrdCmsSelect &Sel, SMask_t amask,
                    SMask_t &pmask, SMask_t &smask, int isRW);
 void        sendAList(XrdLink *lp);
 void        setAltMan(int snum, XrdLink *lp, int port);
+NodeSnap   *getSnap();
+void        putSnap(NodeSnap *snP);
+void        setRing();
+void        setSnap();
 int         Unreachable(XrdCmsSelect &Sel, bool none);
 int         Unuseable(XrdCmsSelect &Sel);
 
@@ -239,6 +292,23 @@ XrdSysMutex   XXMutex;          // Protects cluster summary state variables
 XrdSysMutex   STMutex;          // Protects all node information  variables
 XrdCmsNode   *NodeTab[STMax];   // Current  set of nodes
 
+XrdSysMutex   SnapMutex;        // Protects curSnap and snapshot ref counts
+NodeSnap     *curSnap;          // Current  node snapshot
+int           snapStale;        // Snapshot must be rebuilt when not zero
+unsigned int  snapSeq;          // Sequence for random selection
+
+// The hash ring used for consistent hash selection holds ringVN points for
+// each node, derived from its name and port, sorted by hash value. It is
+// protected by the STMutex and rebuilt when a node is added or dropped.
+//
+struct RingPoint {unsigned int Hash; int Slot;};
+static const int ringVN = 100;
+static int    RingCmp(const void *a, const void *b);
+
+RingPoint    *hashRing;         // Points on the ring
+int           ringNum;          // Number of points on the ring
+bool          ringStale;        // Ring must be rebuilt when true
+
 int           STHi;             // NodeTab high watermark
 int           doReset;          // Must send reset event to Managers[resetMask]
 long long     SelWcnt;          // Curr  number of r/w selections (successful)
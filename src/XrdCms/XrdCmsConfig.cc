@@ -50,6 +50,7 @@
 #include "XrdCms/XrdCmsAdmin.hh"
 #include "XrdCms/XrdCmsBaseFS.hh"
 #include "XrdCms/XrdCmsBlackList.hh"
+#include "XrdCms/XrdCmsBloom.hh"
 #include "XrdCms/XrdCmsCache.hh"
 #include "XrdCms/XrdCmsCluster.hh"
 #include "XrdCms/XrdCmsConfig.hh"
@@ -64,6 +65,7 @@
 #include "XrdCms/XrdCmsSecurity.hh"
 #include "XrdCms/XrdCmsSelect.hh"
 #include "XrdCms/XrdCmsState.hh"
+#include "XrdCms/XrdCmsSummary.hh"
 #include "XrdCms/XrdCmsSupervisor.hh"
 #include "XrdCms/XrdCmsTrace.hh"
 #include "XrdCms/XrdCmsUtils.hh"
@@ -135,8 +137,12 @@ void *XrdCmsStartMonPerf(void *carg) { return Cluster.MonPerf(); }
 
 void *XrdCmsStartMonRefs(void *carg) { return Cluster.MonRefs(); }
 
+void *XrdCmsStartMonSnap(void *carg) { return Cluster.MonSnap(); }
+
 void *XrdCmsStartMonStat(void *carg) { return CmsState.Monitor(); }
 
+void *XrdCmsStartSummary(void *carg) { return Summary.Start(); }
+
 void *XrdCmsStartAdmin(void *carg)
       {return XrdCms::Admin.Start((XrdNetSocket *)carg);
       }
@@ -500,6 +506,7 @@ int XrdCmsConfig::ConfigXeq(char *var, XrdOucStream &CFile, XrdSysError *eDest)
    TS_Xeq("allow",         xallow);  // Manager, non-dynamic
    TS_Xeq("altds",         xaltds);  // Server,  non-dynamic
    TS_Xeq("blacklist",     xblk);    // Manager, non-dynamic
+   TS_Xeq("bloom",         xbloom);  // Server,  non-dynamic
    TS_Xeq("cidtag",        xcid);    // Any,     non-dynamic
    TS_Xeq("defaults",      xdefs);   // Server,  non-dynamic
    TS_Xeq("dfs",           xdfs);    // Any,     non-dynamic
@@ -598,6 +605,16 @@ void XrdCmsConfig::DoIt()
 //
    if (isManager || isServer || isPeer) XrdCmsManager::Start(ManList);
 
+// Start the bloom filter builder if we are a plain server that wants one. A
+// staging server can't say which files it can get so it never sends one.
+//
+   if (BloomInt && isServer && !isManager && ManList)
+      {if (DiskSS) Say.Emsg("Config", "Bloom filters disabled; server stages files.");
+          else if (XrdSysThread::Run(&tid, XrdCmsStartSummary, (void *)0,
+                                     0, "Bloom filter builder"))
+                  Say.Emsg("cmsd", errno, "start bloom filter builder");
+      }
+
 // Start state monitoring thread
 //
    if (XrdSysThread::Run(&tid, XrdCmsStartMonStat, (void *)0,
@@ -680,6 +697,7 @@ void XrdCmsConfig::ConfigDefaults(void)
    P_load   = 0;
    P_mem    = 0;
    P_pag    = 0;
+   P_spill  = 25;
    AskPerf  = 10;         // Every 10 pings
    AskPing  = 60;         // Every  1 minute
    PingTick = 0;
@@ -687,6 +705,8 @@ void XrdCmsConfig::ConfigDefaults(void)
    DoHnTry  = 1;
    MaxDelay = -1;
    LogPerf  = 10;         // Every 10 usage requests
+   BloomInt = 0;          // No bloom filters
+   BloomMax = 24;         // 2MB maximum filter
    DiskMin  = 10240;      // 10GB*1024 (Min partition space) in MB
    DiskHWM  = 11264;      // 11GB*1024 (High Water Mark SUO) in MB
    DiskMinP = 2;
@@ -698,6 +718,7 @@ void XrdCmsConfig::ConfigDefaults(void)
    myPaths  = (char *)""; // Default is 'r /'
    ConfigFN = 0;
    sched_RR = sched_Pack = sched_Level = 0; sched_Force = 1;
+   sched_Pick = 0;
    isManager= 0;
    isMeta   = 0;
    isPeer   = 0;
@@ -1085,6 +1106,8 @@ int XrdCmsConfig::setupManager()
       {Say.Say("Config round robin scheduling in effect.");
        sched_Level = 0;
       }
+   if (sched_Pick == 1) Say.Say("Config two choice server selection in effect.");
+   if (sched_Pick == 2) Say.Say("Config consistent hash server selection in effect.");
 
 // Create statistical monitoring thread
 //
@@ -1105,6 +1128,16 @@ int XrdCmsConfig::setupManager()
           }
       }
 
+// Create node snapshot publishing thread for two choice selection
+//
+   if (sched_Pick == 1)
+      {if ((rc = XrdSysThread::Run(&tid, XrdCmsStartMonSnap, (void *)0,
+                                   0, "Snapshot monitor")))
+          {Say.Emsg("Config", rc, "create snapshot monitor thread");
+           return 1;
+          }
+      }
+
 // Initialize the fast redirect queue
 //
    RRQ.Init(LUPHold, LUPDelay);
@@ -1446,6 +1479,69 @@ int XrdCmsConfig::xblk(XrdSysError *eDest, XrdOucStream &CFile, bool iswl)
    return 0;
 }
   
+/******************************************************************************/
+/*                                x b l o o m                                 */
+/******************************************************************************/
+
+/* Function: xbloom
+
+   Purpose:  To parse the directive: bloom {off | [int <sec>] [maxsz <size>]}
+
+             off       do not send bloom filters (the default).
+             int       seconds between rebuilds of the filter (default 1 hour).
+             maxsz     the largest filter to send, rounded down to a power of
+                       two. The default is 2m. Servers with more than about
+                       maxsz*0.8 files will see more false hits.
+
+             Files created other than via the data server are not seen by
+             the manager until the next rebuild or a refresh is requested.
+
+   Type: Server only, non-dynamic.
+
+   Output: 0 upon success or !0 upon failure. Ignored by manager.
+*/
+
+int XrdCmsConfig::xbloom(XrdSysError *eDest, XrdOucStream &CFile)
+{
+    long long bsz = 1LL << (BloomMax-3);
+    int  ival = 60*60;
+    char *val;
+
+    if (!isServer) return CFile.noEcho();
+
+    if (!(val = CFile.GetWord()))
+       {eDest->Emsg("Config", "bloom options not specified"); return 1;}
+
+    if (!strcmp("off", val)) {BloomInt = 0; return 0;}
+
+    do {     if (!strcmp("int", val))
+                {if (!(val = CFile.GetWord()))
+                    {eDest->Emsg("Config", "bloom int value not specified");
+                     return 1;
+                    }
+                 if (XrdOuca2x::a2tm(*eDest,"bloom int",val,&ival,60)) return 1;
+                }
+        else if (!strcmp("maxsz", val))
+                {if (!(val = CFile.GetWord()))
+                    {eDest->Emsg("Config", "bloom maxsz value not specified");
+                     return 1;
+                    }
+                 if (XrdOuca2x::a2sz(*eDest, "bloom maxsz", val, &bsz,
+                                     1LL << (XrdCmsBloom::minBits-3),
+                                     1LL << (XrdCmsBloom::maxBits-3))) return 1;
+                }
+        else eDest->Say("Config warning: ignoring invalid bloom option '",val,"'.");
+       } while((val = CFile.GetWord()));
+
+// Convert the size to the number of bits in the filter
+//
+    BloomMax = XrdCmsBloom::minBits;
+    while(BloomMax < XrdCmsBloom::maxBits && (2LL << (BloomMax-3)) <= bsz)
+         BloomMax++;
+    BloomInt = ival;
+    return 0;
+}
+  
 /******************************************************************************/
 /*                                  x c i d                                   */
 /******************************************************************************/
@@ -2657,6 +2753,8 @@ int XrdCmsConfig::xrole(XrdSysError *eDest, XrdOucStream &CFile)
                                        [fuzz <p>] [maxload <p>] [refreset <sec>]
                                        [maxretries <n>[@<host>:<port>]]
                                        [nomultisrc[@<host>:<port>]]
+                                       [pick {best | p2c | hash}]
+                                       [spill <p>]
                 [affinity [default] {none | weak | strong | strict}]
 
              <p>      is the percentage to include in the load as a value
@@ -2667,7 +2765,13 @@ int XrdCmsConfig::xrole(XrdSysError *eDest, XrdOucStream &CFile)
                       between reference counter resets. gshr is the percentage
                       share of requests that should be redirected here via the 
                       metamanager (i.e. global share). The gsdflt is the
-                      default to be used by the metamanager.
+                      default to be used by the metamanager. pick selects
+                      how a server is chosen: best scans for the least loaded
+                      one, p2c picks the better of two random eligible ones,
+                      hash maps the path onto a ring of the servers so that a
+                      file is usually sent to the same one (for caches). spill
+                      is how far above the average number of selections a
+                      server may be before hash moves on to the next server.
 
    Type: Any, dynamic.
 
@@ -2690,6 +2794,7 @@ int XrdCmsConfig::xsched(XrdSysError *eDest, XrdOucStream &CFile)
         {"mem",      100, &P_mem},
         {"pag",      100, &P_pag},
         {"space",    100, &P_dsk},
+        {"spill",   1000, &P_spill},
         {"maxload",  100, &MaxLoad},
         {"refreset", -1,  &RefReset},
         {"affinity", -2,  0},
@@ -2787,6 +2892,20 @@ int XrdCmsConfig::xschedx(char *val, XrdSysError *eDest, XrdOucStream &CFile)
        return 0;
       }
 
+// Check for pick
+//
+   if (!strcmp(val, "pick"))
+      {if (!(val = CFile.GetWord()))
+          {eDest->Emsg("Config", "sched ", "pick argument not specified.");
+           return -1;
+          }
+            if (!strcmp(val, "best")) sched_Pick = 0;
+       else if (!strcmp(val, "p2c"))  sched_Pick = 1;
+       else if (!strcmp(val, "hash")) sched_Pick = 2;
+       else {eDest->Emsg("Config", "Invalid sched pick -", val); return -1;}
+       return 0;
+      }
+
 // Check for unqualified nomultisrc
 //
    if (!strcmp(val, "nomultisrc"))
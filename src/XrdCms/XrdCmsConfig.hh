@@ -90,6 +90,8 @@ int         AskPerf;      // Seconds between perf queries
 int         AskPing;      // Number of ping requests per AskPerf window
 int         PingTick;     // Ping clock value
 int         LogPerf;      // AskPerf intervals before logging perf
+int         BloomInt;     // Seconds between bloom filter rebuilds (0 -> off)
+int         BloomMax;     // log2 of the largest bloom filter in bits
 
 int         PortTCP;      // TCP Port to  listen on
 int         PortSUP;      // TCP Port to  listen on (supervisor)
@@ -104,6 +106,7 @@ int         P_io;         // % I/O Capacity in load factor
 int         P_load;       // % MSC Capacity in load factor
 int         P_mem;        // % MEM Capacity in load factor
 int         P_pag;        // % PAG Capacity in load factor
+int         P_spill;      // % Selections over average before hash spills
 
 char        DoMWChk;      // When true (default) perform multiple write check
 char        DoHnTry;      // When true (default) use hostnames for try redirs
@@ -124,6 +127,8 @@ char        sched_RR;     // 1 -> Simply do round robin scheduling
 char        sched_Pack;   // 1 -> Pick oldest node (>1 same but wait for resps)
 char        sched_Level;  // 1 -> Use load-based level for "pack" selection
 char        sched_Force;  // 1 -> Client cannot select mode
+char        sched_Pick;   // 1 -> Pick the better of two random nodes
+                          // 2 -> Pick by path on a consistent hash ring
 int         doWait;       // 1 -> Wait for a data end-point
 
 int         adsPort;      // Alternate server port
@@ -215,6 +220,7 @@ int  xallow(XrdSysError *edest, XrdOucStream &CFile);
 int  xaltds(XrdSysError *edest, XrdOucStream &CFile);
 int  Fsysadd(XrdSysError *edest, int chk, char *fn);
 int  xblk(XrdSysError *edest, XrdOucStream &CFile, bool iswl=false);
+int  xbloom(XrdSysError *edest, XrdOucStream &CFile);
 int  xcid(XrdSysError *edest, XrdOucStream &CFile);
 int  xdelay(XrdSysError *edest, XrdOucStream &CFile);
 int  xdefs(XrdSysError *edest, XrdOucStream &CFile);
@@ -257,7 +257,8 @@ void XrdCmsManager::Inform(const char *What, const char *Data, int Dlen)
 
 /******************************************************************************/
   
-void XrdCmsManager::Inform(const char *What, struct iovec *vP, int vN, int vT)
+void XrdCmsManager::Inform(const char *What, struct iovec *vP, int vN, int vT,
+                           bool onlyBloom)
 {
    EPNAME("Inform");
    int i;
@@ -267,10 +268,11 @@ void XrdCmsManager::Inform(const char *What, struct iovec *vP, int vN, int vT)
 //
    MTMutex.Lock();
 
-// Run through the table looking for managers to send messages to
+// Run through the table looking for managers to send messages to. Bloom
+// filters are only sent to managers that said they will accept them.
 //
    for (i = 0; i <= MTHi; i++)
-       {if ((nP=MastTab[i]) && !nP->isOffline)
+       {if ((nP=MastTab[i]) && !nP->isOffline && (!onlyBloom || nP->isBloom))
            {nP->Lock(true);
             MTMutex.UnLock();
             DEBUG(nP->Name() <<" " <<What);
@@ -69,7 +69,8 @@ void        Delete(XrdCmsNode *nodeP);
 void        Finished(const char *manP, int mPort);
 
 static void Inform(const char *What, const char *Data, int Dlen);
-static void Inform(const char *What, struct iovec *vP, int vN, int vT=0);
+static void Inform(const char *What, struct iovec *vP, int vN, int vT=0,
+                   bool onlyBloom=false);
 static void Inform(XrdCms::CmsReqCode rCode, int rMod, const char *Arg=0, int Alen=0);
 static void Inform(XrdCms::CmsRRHdr &Hdr, const char *Arg=0, int Alen=0);
 
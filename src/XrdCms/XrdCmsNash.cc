@@ -45,6 +45,7 @@ XrdCmsNash::XrdCmsNash(int psize, int csize)
      nashtable     = (XrdCmsKeyItem **)
                      malloc( (size_t)(csize*sizeof(XrdCmsKeyItem *)) );
      memset((void *)nashtable, 0, (size_t)(csize*sizeof(XrdCmsKeyItem *)));
+     memset((void *)TockTable, 0, sizeof(TockTable));
 }
 
 /******************************************************************************/
@@ -58,7 +59,7 @@ XrdCmsKeyItem *XrdCmsNash::Add(XrdCmsKey &Key)
 
 // Allocate the entry
 //
-   if (!(hip = XrdCmsKeyItem::Alloc(Key.TOD))) return (XrdCmsKeyItem *)0;
+   if (!(hip = XrdCmsKeyItem::Alloc(Key.TOD, TockTable))) return (XrdCmsKeyItem *)0;
 
 // Check if we should expand the table
 //
@@ -42,6 +42,7 @@
 #include "XProtocol/YProtocol.hh"
 
 #include "XrdCms/XrdCmsBaseFS.hh"
+#include "XrdCms/XrdCmsBloom.hh"
 #include "XrdCms/XrdCmsCache.hh"
 #include "XrdCms/XrdCmsCluster.hh"
 #include "XrdCms/XrdCmsClustID.hh"
@@ -145,6 +146,10 @@ XrdCmsNode::XrdCmsNode(XrdLink *lnkp, const char *theIF, const char *nid,
     ConfigID =  0;
     TZValid  = 0;
     TimeZone = 0;
+    isBloom  = 0;
+    bloomNew = 0;
+    bloomGen = 0;
+    bloomOff = 0;
     subsPort = 0;
     myVersion= kYR_Version;
 
@@ -176,6 +181,7 @@ XrdCmsNode::~XrdCmsNode()
    if (Ident) free(Ident);
    if (myNID) free(myNID);
    if (myName)free(myName);
+   if (bloomNew) delete bloomNew;
 }
 
 /******************************************************************************/
@@ -342,6 +348,7 @@ const char *XrdCmsNode::do_Avail(XrdCmsRRData &Arg)
 //
    DiskFree = Arg.dskFree;
    DiskUtil = static_cast<int>(Arg.dskUtil);
+   Cluster.Stale();
 
 // Do some debugging
 //
@@ -349,6 +356,77 @@ const char *XrdCmsNode::do_Avail(XrdCmsRRData &Arg)
    return 0;
 }
 
+/******************************************************************************/
+/*                              d o _ B l o o m                               */
+/******************************************************************************/
+  
+// Servers send their bloom filter in segments and the filter is only given to
+// the cache once all of them have arrived. A segment out of sequence discards
+// whatever was received; the server will send a complete filter later on. Like
+// all responses, a bad one is simply noted and ignored.
+//
+const char *XrdCmsNode::do_Bloom(XrdCmsRRData &Arg)
+{
+   EPNAME("do_Bloom")
+   CmsBloomData *bdP = (CmsBloomData *)Arg.Buff;
+   unsigned int gen;
+   int lgb, off, slen;
+
+// Make sure we have a segment and we can use it
+//
+   if (!Config.asManager() || Arg.Dlen < (int)sizeof(CmsBloomData))
+      {Say.Emsg("do_Bloom", "Invalid bloom segment from", Ident);
+       return 0;
+      }
+   gen  = ntohl(bdP->Gen);
+   off  = static_cast<int>(ntohl(bdP->Offset));
+   lgb  = static_cast<int>(bdP->lgBits);
+   slen = Arg.Dlen - sizeof(CmsBloomData);
+   if (lgb < XrdCmsBloom::minBits || lgb > XrdCmsBloom::maxBits)
+      {Say.Emsg("do_Bloom", "Invalid bloom filter size from", Ident);
+       return 0;
+      }
+
+// The first segment starts a new filter. Any other must be the one we expect.
+//
+   if (!off)
+      {if (bloomNew) delete bloomNew;
+       bloomNew = new XrdCmsBloom(lgb, bdP->Hashes);
+       if (!bloomNew->Valid())
+          {Say.Emsg("do_Bloom", "Insufficient memory for bloom filter from",
+                    Ident);
+           delete bloomNew; bloomNew = 0;
+           return 0;
+          }
+       bloomGen = gen; bloomOff = 0;
+      } else if (!bloomNew || gen != bloomGen || off != bloomOff)
+                {DEBUGR("discarding bloom gen " <<gen <<" offset " <<off);
+                 if (bloomNew) {delete bloomNew; bloomNew = 0;}
+                 return 0;
+                }
+
+// Copy in the segment
+//
+   if (slen > bloomNew->Size() - off)
+      {Say.Emsg("do_Bloom", "Invalid bloom segment length from", Ident);
+       delete bloomNew; bloomNew = 0;
+       return 0;
+      }
+   memcpy(bloomNew->Data()+off, Arg.Buff+sizeof(CmsBloomData), slen);
+   bloomOff = off + slen;
+
+// If this is the last segment, give the cache the filter if it's complete
+//
+   if (Arg.Request.modifier & CmsBloomRequest::Last)
+      {if (bloomOff == bloomNew->Size())
+          {DEBUGR("bloom gen " <<gen <<' ' <<bloomOff <<" bytes");
+           Cache.Bloom(NodeID, bloomNew);
+          } else delete bloomNew;
+       bloomNew = 0;
+      }
+   return 0;
+}
+
 /******************************************************************************/
 /*                              d o _ C h m o d                               */
 /******************************************************************************/
@@ -485,7 +563,9 @@ const char *XrdCmsNode::do_Have(XrdCmsRRData &Arg)
             if (baseFS.isDFS())
                {Sel.Vec.hf = pinfo.rovec; Sel.Vec.wf = pinfo.rwvec;
                 isnew       = Cache.AddFile(Sel, allNodes);
-               } else isnew = Cache.AddFile(Sel, NodeMask);
+               } else {isnew = Cache.AddFile(Sel, NodeMask);
+                       Cache.Bloom(NodeID, Arg.Path, Arg.PathLen-1);
+                      }
            }
 
 // Return if we have no managers or we already informed the managers
@@ -527,6 +607,7 @@ const char *XrdCmsNode::do_Load(XrdCmsRRData &Arg)
    myMass = Meter.calcLoad(myLoad, pdsk);
    DiskFree = Arg.dskFree;
    DiskUtil = pdsk;
+   Cluster.Stale();
 
 // Do some debugging
 //
@@ -1680,7 +1761,8 @@ const char *XrdCmsNode::do_Status(XrdCmsRRData &Arg)
 // Now see if we need to change anything
 //
    if (add2Activ || add2Stage)
-       {CmsState.Update(XrdCmsState::Counts, add2Activ, add2Stage);
+       {Cluster.Stale();
+        CmsState.Update(XrdCmsState::Counts, add2Activ, add2Stage);
         Say.Emsg("Node", Name(), srvMsg, stgMsg);
        }
 
@@ -44,6 +44,7 @@
 
 class XrdCmsBaseFR;
 class XrdCmsBaseFS;
+class XrdCmsBloom;
 class XrdCmsClustID;
 class XrdCmsDrop;
 class XrdCmsManager;
@@ -74,6 +75,7 @@ public:
        char   RoleID;       //5 The converted XrdCmsRole::RoleID
        char   TimeZone;     //6 Time zone in +UTC-
        char   TZValid;      //7 Time zone has been set
+       char   isBloom;      //0 Set when manager accepts bloom filters
 
 static const char isBlisted  = 0x01; // in isBad -> Node is black listed
 static const char isDisabled = 0x02; // in isBad -> Node is disable (internal)
@@ -91,6 +93,7 @@ unsigned int    DiskTotal;    // Total disk space in GB
 unsigned int    ConfigID;     // Configuration identifier
 
 const  char  *do_Avail(XrdCmsRRData &Arg);
+const  char  *do_Bloom(XrdCmsRRData &Arg);
 const  char  *do_Chmod(XrdCmsRRData &Arg);
 const  char  *do_Disc(XrdCmsRRData &Arg);
 const  char  *do_Gone(XrdCmsRRData &Arg);
@@ -135,7 +138,7 @@ inline int    Inst() {return Instance;}
 
        bool   inDomain() {return netIF.InDomain(&netID);}
 
-inline int    isNode(SMask_t smask) {return (smask & NodeMask) != 0;}
+inline int    isNode(const SMask_t &smask) {return NodeID >= 0 && smask.Test(NodeID);}
 
 inline int    isNode(const XrdNetAddr *addr) // Only for avoid processing!
                     {return netID.Same(addr);}
@@ -276,6 +279,10 @@ char               Shrip;        // Share of requests to skip
 char               Rsvd[2];
 int                Shrin;        // Share intervals used
 
+XrdCmsBloom       *bloomNew;     // Bloom filter being received
+unsigned int       bloomGen;     // Its generation
+int                bloomOff;     // Offset of the next expected segment
+
 // The following fields are used to keep the supervisor's free space value
 //
 static XrdSysMutex mlMutex;
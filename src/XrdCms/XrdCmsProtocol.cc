@@ -60,6 +60,7 @@
 #include "XrdCms/XrdCmsRouting.hh"
 #include "XrdCms/XrdCmsRTable.hh"
 #include "XrdCms/XrdCmsState.hh"
+#include "XrdCms/XrdCmsSummary.hh"
 #include "XrdCms/XrdCmsTrace.hh"
 
 #include "XrdOuc/XrdOucCRC.hh"
@@ -396,6 +397,8 @@ void XrdCmsProtocol::Pander(const char *manager, int mport)
                    Say.Emsg("Protocol", "Logged into", sname, Link->Name());
                    if (Data.SID)
                       Manager->Verify(Link, (const char *)Data.SID, sname);
+                   if (Data.Mode & CmsLoginData::kYR_bloom)
+                      {myNode->isBloom = 1; Summary.Resend();}
                    Reason = Dispatch(isUp, TimeOut, 2);
                    rc = 0;
                    loginData.fSpace= Meter.FreeSpace(fsUtil);
@@ -474,6 +477,7 @@ int XrdCmsProtocol::Process(XrdLink *lp)
        myNode->UnLock();
        if ((Reason = Dispatch(myWay, tOut, 2))) lp->setEtext(Reason);
        Cluster.SLock(true); myNode->isOffline = 1; Cluster.SLock(false);
+       Cluster.Stale();
       }
 
 // Serialize all activity on the link before we proceed. This makes sure that
@@ -584,6 +588,7 @@ XrdCmsRouting *XrdCmsProtocol::Admit()
    if (CmsState.Suspended)      {Data.Mode |= CmsLoginData::kYR_suspend;
                                  wasSuspended = 1;
                                 }
+   if (Config.asManager())       Data.Mode |= CmsLoginData::kYR_bloom;
    Data.HoldTime = Config.LUPHold;
 
 // Do the login and get the data
@@ -728,6 +733,7 @@ XrdCmsRouting *XrdCmsProtocol::Admit()
    Cluster.ResetRef(servset);
    if (Config.asManager()) {Manager->Reset(); myNode->SyncSpace();}
    myNode->isBad &= ~XrdCmsNode::isDisabled;
+   Cluster.Stale();
 
 // At this point we can switch to nonblocking sendq for this node
 //
@@ -0,0 +1,306 @@
+/******************************************************************************/
+/*                                                                            */
+/*                      X r d C m s S u m m a r y . c c                       */
+/*                                                                            */
+/* (c) 2019 by the Board of Trustees of the Leland Stanford, Jr., University  */
+/*                            All Rights Reserved                             */
+/*   Produced by Andrew Hanushevsky for Stanford University under contract    */
+/*              DE-AC02-76-SFO0515 with the Department of Energy              */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "XProtocol/YProtocol.hh"
+
+#include "XrdCms/XrdCmsBloom.hh"
+#include "XrdCms/XrdCmsConfig.hh"
+#include "XrdCms/XrdCmsManager.hh"
+#include "XrdCms/XrdCmsPList.hh"
+#include "XrdCms/XrdCmsSummary.hh"
+#include "XrdCms/XrdCmsTrace.hh"
+#include "XrdCms/XrdCmsTypes.hh"
+
+#include "XrdOss/XrdOss.hh"
+#include "XrdOuc/XrdOucEnv.hh"
+#include "XrdOuc/XrdOucTList.hh"
+
+using namespace XrdCms;
+
+/******************************************************************************/
+/*                               G l o b a l s                                */
+/******************************************************************************/
+
+XrdCmsSummary XrdCms::Summary;
+
+/******************************************************************************/
+/*                         L o c a l   M e t h o d s                          */
+/******************************************************************************/
+
+namespace
+{
+// Since we walk each exported tree, an export that lies within another one
+// need not be walked as it will be covered when the outer one is walked.
+//
+bool Nested(const char *path)
+{
+   XrdCmsPList *pP = Config.PathList.First();
+   int plen;
+
+   while(pP)
+        {plen = strlen(pP->Path());
+         if (strcmp(pP->Path(), path) && !strncmp(pP->Path(), path, plen)
+         &&  (pP->Path()[plen-1] == '/' || path[plen] == '/')) return true;
+         pP = pP->Next();
+        }
+   return false;
+}
+}
+
+/******************************************************************************/
+/* Public                          A d d e d                                  */
+/******************************************************************************/
+  
+void XrdCmsSummary::Added(const char *path)
+{
+   unsigned long long hv = XrdCmsBloom::Hash(path, strlen(path));
+
+// Add the file to the filter we last sent (the manager adds it to its copy
+// when it gets our have) and to the one being built, if any.
+//
+   bloomMutex.Lock();
+   if (curBloom) curBloom->Add(hv);
+   if (newBloom) newBloom->Add(hv);
+   bloomMutex.UnLock();
+}
+
+/******************************************************************************/
+/* Public                         R e s e n d                                 */
+/******************************************************************************/
+  
+void XrdCmsSummary::Resend()
+{
+   sumCond.Lock();
+   reSend = true;
+   sumCond.Signal();
+   sumCond.UnLock();
+}
+
+/******************************************************************************/
+/* Public                          S t a r t                                  */
+/******************************************************************************/
+  
+void *XrdCmsSummary::Start()
+{
+   time_t tNext;
+   int    wTime;
+
+// Periodically rebuild the filter and send it to our managers. In between,
+// send the current filter whenever a new manager needs it.
+//
+do{Build();
+   tNext = time(0) + Config.BloomInt;
+   Send();
+   sumCond.Lock();
+   while((wTime = static_cast<int>(tNext - time(0))) > 0)
+        {if (!reSend) sumCond.Wait(wTime);
+         if (reSend)
+            {reSend = false;
+             sumCond.UnLock();
+             Send();
+             sumCond.Lock();
+            }
+        }
+   reSend = false;
+   sumCond.UnLock();
+  } while(1);
+
+// We never get here
+//
+   return (void *)0;
+}
+
+/******************************************************************************/
+/* Private                         B u i l d                                  */
+/******************************************************************************/
+  
+int XrdCmsSummary::Build()
+{
+   EPNAME("Build");
+   XrdCmsPList *pP;
+   XrdOucTList *dirList = 0, *dP;
+   int lgb, numFiles = 0;
+
+// Allocate the largest filter we allow as we don't know how many files we have
+//
+   bloomMutex.Lock();
+   newBloom = new XrdCmsBloom(Config.BloomMax, numHash);
+   if (!newBloom->Valid())
+      {delete newBloom; newBloom = 0;
+       bloomMutex.UnLock();
+       Say.Emsg("Summary", ENOMEM, "allocate bloom filter");
+       return 0;
+      }
+   bloomMutex.UnLock();
+
+// Walk each exported tree, the default being the whole namespace
+//
+   if (!(pP = Config.PathList.First())) dirList = new XrdOucTList("/");
+      else while(pP)
+                {if (!Nested(pP->Path()))
+                    dirList = new XrdOucTList(pP->Path(), 0, dirList);
+                 pP = pP->Next();
+                }
+
+   while((dP = dirList))
+        {dirList = dP->next;
+         Scan(dP->text, dirList, numFiles);
+         delete dP;
+        }
+
+// Fold the filter down to what we actually need and make it the current one
+//
+   lgb = XrdCmsBloom::minBits;
+   while(lgb < Config.BloomMax && (1LL << lgb) < (long long)numFiles*bpFile)
+        lgb++;
+   bloomMutex.Lock();
+   newBloom->Fold(lgb);
+   if (curBloom) delete curBloom;
+   curBloom = newBloom; newBloom = 0;
+   bloomGen++;
+   bloomMutex.UnLock();
+
+// All done
+//
+   DEBUG("gen " <<bloomGen <<' ' <<numFiles <<" files in " <<(1 << (lgb-3))
+                <<" bytes");
+   return numFiles;
+}
+
+/******************************************************************************/
+/* Private                          S c a n                                   */
+/******************************************************************************/
+  
+void XrdCmsSummary::Scan(const char *path, XrdOucTList *&dirList,
+                         int &numFiles)
+{
+   static const int maxDepth = 64;
+   XrdOucEnv    myEnv;
+   XrdOssDF    *dirP = Config.ossFS->newDir("cmsd");
+   struct stat  Stat;
+   char         pBuff[XrdCmsMAX_PATH_LEN+1], dName[256];
+   int          pLen, rc, dLen, Depth = 0;
+   bool         autoStat;
+
+// Open the directory and see if we can get stat information as we read it
+//
+   if ((rc = dirP->Opendir(path, myEnv)))
+      {if (rc != -ENOENT) Say.Emsg("Summary", -rc, "open directory", path);
+       delete dirP;
+       return;
+      }
+   autoStat = (dirP->StatRet(&Stat) == 0);
+
+// Prepare to construct the full path to each entry
+//
+   pLen = strlen(path);
+   if (pLen >= (int)sizeof(pBuff)-1) {dirP->Close(); delete dirP; return;}
+   strcpy(pBuff, path);
+   if (pBuff[pLen-1] != '/') pBuff[pLen++] = '/';
+   for (int i = 0; i < pLen; i++) if (pBuff[i] == '/') Depth++;
+
+// Add each file to the filter and each directory to the list to be scanned
+//
+   while(!(rc = dirP->Readdir(dName, sizeof(dName))) && *dName)
+        {if (*dName == '.' && (!dName[1] || (dName[1] == '.' && !dName[2])))
+            continue;
+         if ((dLen = strlen(dName)) + pLen >= (int)sizeof(pBuff)) continue;
+         strcpy(pBuff+pLen, dName);
+         if (!autoStat && Config.ossFS->Stat(pBuff, &Stat, XRDOSS_resonly))
+            continue;
+         if (S_ISREG(Stat.st_mode))
+            {unsigned long long hv = XrdCmsBloom::Hash(pBuff, pLen+dLen);
+             bloomMutex.Lock();
+             newBloom->Add(hv);
+             bloomMutex.UnLock();
+             numFiles++;
+            } else if (S_ISDIR(Stat.st_mode) && Depth < maxDepth)
+                      dirList = new XrdOucTList(pBuff, 0, dirList);
+        }
+
+// All done
+//
+   if (rc) Say.Emsg("Summary", -rc, "read directory", path);
+   dirP->Close();
+   delete dirP;
+}
+
+/******************************************************************************/
+/* Private                          S e n d                                   */
+/******************************************************************************/
+  
+void XrdCmsSummary::Send()
+{
+   CmsRRHdr     Hdr = {0, kYR_bloom, 0, 0};
+   CmsBloomData Data;
+   char         segBuff[segSize];
+   struct iovec ioV[3] = {{(char *)&Hdr,  sizeof(Hdr)},
+                          {(char *)&Data, sizeof(Data)},
+                          {segBuff,       0}};
+   int bSize, sLen;
+
+// Describe the current filter. Only this thread replaces it.
+//
+   bloomMutex.Lock();
+   if (!curBloom) {bloomMutex.UnLock(); return;}
+   Data.Gen    = htonl(bloomGen);
+   Data.lgBits = static_cast<kXR_char>(curBloom->lgBits());
+   Data.Hashes = static_cast<kXR_char>(curBloom->Hashes());
+   Data.Rsvd   = 0;
+   bSize       = curBloom->Size();
+   bloomMutex.UnLock();
+
+// Send the filter in segments. Files may be added while we do this so we copy
+// each segment under the lock. The manager takes the filter upon the last one.
+//
+   for (int bOff = 0; bOff < bSize; bOff += sLen)
+       {sLen = (bSize - bOff > segSize ? segSize : bSize - bOff);
+        bloomMutex.Lock();
+        memcpy(segBuff, curBloom->Data()+bOff, sLen);
+        bloomMutex.UnLock();
+        Hdr.modifier = kYR_raw
+                     | (bOff+sLen < bSize ? 0 : int(CmsBloomRequest::Last));
+        Hdr.datalen  = htons(static_cast<kXR_unt16>(sizeof(Data)+sLen));
+        Data.Offset  = htonl(static_cast<kXR_unt32>(bOff));
+        ioV[2].iov_len = sLen;
+        XrdCmsManager::Inform("bloom", ioV, 3, sizeof(Hdr)+sizeof(Data)+sLen,
+                              true);
+       }
+}
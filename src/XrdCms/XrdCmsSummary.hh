@@ -0,0 +1,89 @@
+#ifndef __XRDCMSSUMMARY_H__
+#define __XRDCMSSUMMARY_H__
+/******************************************************************************/
+/*                                                                            */
+/*                      X r d C m s S u m m a r y . h h                       */
+/*                                                                            */
+/* (c) 2019 by the Board of Trustees of the Leland Stanford, Jr., University  */
+/*                            All Rights Reserved                             */
+/*   Produced by Andrew Hanushevsky for Stanford University under contract    */
+/*              DE-AC02-76-SFO0515 with the Department of Energy              */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include "XrdSys/XrdSysPthread.hh"
+
+class XrdCmsBloom;
+class XrdOucTList;
+
+/******************************************************************************/
+/*                   C l a s s   X r d C m s S u m m a r y                    */
+/******************************************************************************/
+
+// The XrdCmsSummary object periodically builds a bloom filter of all of the
+// files this server exports and sends it to each manager that accepts one
+// (see cms.bloom). Files added in the interim are added to the filter as they
+// are reported. Files that are removed remain in the filter until it is next
+// rebuilt; the manager's location cache covers them in the meantime.
+//
+class XrdCmsSummary
+{
+public:
+
+// Added() adds a newly created file to the filter
+//
+void   Added(const char *path);
+
+// Resend() causes the filter to be sent to all managers again. It is called
+//          when a manager that accepts bloom filters logs in.
+//
+void   Resend();
+
+void  *Start();
+
+       XrdCmsSummary() : sumCond(0, "sumCond"), curBloom(0), newBloom(0),
+                         bloomGen(0), reSend(false) {}
+      ~XrdCmsSummary() {}   // Never gets deleted
+
+private:
+
+static const int segSize = 8192;   // Bytes of filter sent per request
+static const int bpFile  = 10;     // Filter bits per file (~1% false hits)
+static const int numHash = 4;      // Number of hash functions
+
+int    Build();
+void   Scan(const char *path, XrdOucTList *&dirList, int &numFiles);
+void   Send();
+
+XrdSysCondVar  sumCond;
+XrdSysMutex    bloomMutex;
+XrdCmsBloom   *curBloom;           // Filter last sent
+XrdCmsBloom   *newBloom;           // Filter being built
+unsigned int   bloomGen;
+bool           reSend;
+};
+
+namespace XrdCms
+{
+extern    XrdCmsSummary Summary;
+}
+#endif
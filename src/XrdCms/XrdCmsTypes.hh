@@ -30,13 +30,20 @@
 /* specific prior written permission of the institution or contributor.       */
 /******************************************************************************/
   
-typedef unsigned long long SMask_t;
+#include "XrdCms/XrdCmsBitSet.hh"
 
-#define FULLMASK 0xFFFFFFFFFFFFFFFFULL
-
-// The following defines our cell size (maximum subscribers)
+// The following defines our cell size (maximum subscribers). It is set at
+// build time (cmake -DCMS_MAX_NODES=<n>) and is rounded up to a multiple of 64.
 //
-#define STMax 64
+#ifndef CMS_MAX_NODES
+#define CMS_MAX_NODES 64
+#endif
+
+#define STMax (((CMS_MAX_NODES) + 63) / 64 * 64)
+
+typedef XrdCmsBitSet<STMax> SMask_t;
+
+#define FULLMASK SMask_t(~0)
 
 // The following defines the maximum number of redirectors. It is one greater
 // than the actual maximum as the zeroth is never used.
@@ -31,6 +31,7 @@ add_executable(
   Xrd/XrdMain.cc
   XrdCms/XrdCmsAdmin.cc           XrdCms/XrdCmsAdmin.hh
   XrdCms/XrdCmsBaseFS.cc          XrdCms/XrdCmsBaseFS.hh
+  XrdCms/XrdCmsBloom.cc           XrdCms/XrdCmsBloom.hh
   XrdCms/XrdCmsCache.cc           XrdCms/XrdCmsCache.hh
   XrdCms/XrdCmsCluster.cc         XrdCms/XrdCmsCluster.hh
   XrdCms/XrdCmsClustID.cc         XrdCms/XrdCmsClustID.hh
@@ -51,6 +52,7 @@ add_executable(
   XrdCms/XrdCmsRRQ.cc             XrdCms/XrdCmsRRQ.hh
                                   XrdCms/XrdCmsSelect.hh
   XrdCms/XrdCmsState.cc           XrdCms/XrdCmsState.hh
+  XrdCms/XrdCmsSummary.cc         XrdCms/XrdCmsSummary.hh
   XrdCms/XrdCmsSupervisor.cc      XrdCms/XrdCmsSupervisor.hh
                                   XrdCms/XrdCmsTrace.hh )
 target_link_libraries(
@@ -19,9 +19,13 @@ add_library(
   XrdFileCache/XrdFileCache.cc              XrdFileCache/XrdFileCache.hh
   XrdFileCache/XrdFileCacheConfiguration.cc
   XrdFileCache/XrdFileCachePurge.cc
+  XrdFileCache/XrdFileCachePurgeIndex.cc    XrdFileCache/XrdFileCachePurgeIndex.hh
   XrdFileCache/XrdFileCacheCommand.cc
+  XrdFileCache/XrdFileCachePrestage.cc      XrdFileCache/XrdFileCachePrestage.hh
   XrdFileCache/XrdFileCacheFile.cc          XrdFileCache/XrdFileCacheFile.hh
+  XrdFileCache/XrdFileCacheHotTier.cc       XrdFileCache/XrdFileCacheHotTier.hh
   XrdFileCache/XrdFileCacheVRead.cc
+  XrdFileCache/XrdFileCacheBlockIndex.hh
   XrdFileCache/XrdFileCacheStats.hh
   XrdFileCache/XrdFileCacheInfo.cc          XrdFileCache/XrdFileCacheInfo.hh
   XrdFileCache/XrdFileCacheIO.cc            XrdFileCache/XrdFileCacheIO.hh
@@ -17,6 +17,9 @@
 //----------------------------------------------------------------------------------
 
 #include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <sstream>
 #include <algorithm>
 #include <sys/statvfs.h>
@@ -49,10 +52,9 @@ void *PurgeThread(void* cache_void)
    return NULL;
 }
 
-void *ProcessWriteTaskThread(void* c)
+void *ProcessWriteTaskThread(void* wq_idx)
 {
-   Cache *cache = static_cast<Cache*>(c);
-   cache->ProcessWriteTasks();
+   Cache::GetInstance().ProcessWriteTasks((int)(long) wq_idx);
    return NULL;
 }
 
@@ -83,12 +85,6 @@ XrdOucCache2 *XrdOucGetCache2(XrdSysLogger *logger,
    }
    err.Say("------ Proxy file cache initialization completed.");
 
-   for (int wti = 0; wti < factory.RefConfiguration().m_wqueue_threads; ++wti)
-   {
-      pthread_t tid1;
-      XrdSysThread::Run(&tid1, ProcessWriteTaskThread, (void*)(&factory), 0, "XrdFileCache WriteTasks ");
-   }
-
    if (factory.RefConfiguration().m_prefetch_max_blocks > 0)
    {
       pthread_t tid2;
@@ -165,8 +161,12 @@ Cache::Cache(XrdSysLogger *logger) :
    m_trace(new XrdSysTrace("XrdFileCache", logger)),
    m_traceID("Manager"),
    m_prefetch_condVar(0),
+   m_prefetch_seq(0),
    m_RAMblocks_used(0),
+   m_RAMblocks_total(0),
    m_isClient(false),
+   m_writeQ_cnt(0),
+   m_writes_between_purges(0),
    m_in_purge(false),
    m_active_cond(0)
 {
@@ -227,18 +227,54 @@ int Cache::isAttached()
 }
 
 
+int Cache::GetWriteQueueIdx(dev_t dev)
+{
+   XrdSysMutexHelper lock(&m_writeQ_mutex);
+
+   for (int i = 0; i < m_writeQ_cnt; ++i)
+   {
+      if (m_writeQ[i]->dev == dev) return i;
+   }
+
+   // Should there be more devices than queues, they share the last one.
+   if (m_writeQ_cnt == s_maxWriteQ)
+   {
+      return s_maxWriteQ - 1;
+   }
+
+   int idx = m_writeQ_cnt;
+   m_writeQ[idx] = new WriteQ(dev);
+
+   for (int wti = 0; wti < m_configuration.m_wqueue_threads; ++wti)
+   {
+      pthread_t tid;
+      XrdSysThread::Run(&tid, ProcessWriteTaskThread, (void*)(long) idx, 0, "XrdFileCache WriteTasks ");
+   }
+   m_writeQ_cnt = idx + 1;
+
+   char dev_str[32]; snprintf(dev_str, sizeof(dev_str), "0x%llx", (unsigned long long) dev);
+   TRACE(Info, "Cache::GetWriteQueueIdx() created write queue " << idx << " for device " << dev_str <<
+         " with " << m_configuration.m_wqueue_threads << " threads");
+
+   return idx;
+}
+
+
 void Cache::AddWriteTask(Block* b, bool fromRead)
 {
    TRACE(Dump, "Cache::AddWriteTask() bOff=%ld " <<  b->m_offset);
 
-   m_writeQ.condVar.Lock();
+   WriteQ &wq = *m_writeQ[b->m_file->GetWriteQueueIdx()];
+
+   wq.condVar.Lock();
    if (fromRead)
-      m_writeQ.queue.push_back(b);
+      wq.queue.push_back(b);
    else
-      m_writeQ.queue.push_front(b);
-   m_writeQ.size++;
-   m_writeQ.condVar.Signal();
-   m_writeQ.condVar.UnLock();
+      wq.queue.push_front(b);
+   wq.size++;
+   if (wq.size > wq.size_max) wq.size_max = wq.size;
+   wq.condVar.Signal();
+   wq.condVar.UnLock();
 }
 
 
@@ -246,86 +282,246 @@ void Cache::RemoveWriteQEntriesFor(File *iFile)
 {
    std::list<Block*> removed_blocks;
 
-   m_writeQ.condVar.Lock();
-   std::list<Block*>::iterator i = m_writeQ.queue.begin();
-   while (i != m_writeQ.queue.end())
+   WriteQ &wq = *m_writeQ[iFile->GetWriteQueueIdx()];
+
+   wq.condVar.Lock();
+   std::list<Block*>::iterator i = wq.queue.begin();
+   while (i != wq.queue.end())
    {
       if ((*i)->m_file == iFile)
       {
          TRACE(Dump, "Cache::Remove entries for " <<  (void*)(*i) << " path " <<  iFile->lPath());
          std::list<Block*>::iterator j = i++;
          removed_blocks.push_back(*j);
-         m_writeQ.queue.erase(j);
-         --m_writeQ.size;
+         wq.queue.erase(j);
+         --wq.size;
       }
       else
       {
          ++i;
       }
    }
-   m_writeQ.condVar.UnLock();
+   wq.condVar.UnLock();
 
    iFile->BlocksRemovedFromWriteQ(removed_blocks);
 }
 
 
-void Cache::ProcessWriteTasks()
+namespace
 {
+bool BlockWriteOrder(const Block *a, const Block *b)
+{
+   return a->m_file < b->m_file || (a->m_file == b->m_file && a->m_offset < b->m_offset);
+}
+}
+
+void Cache::ProcessWriteTasks(int wq_idx)
+{
+   WriteQ &wq = *m_writeQ[wq_idx];
+
    std::vector<Block*> blks_to_write(m_configuration.m_wqueue_blocks);
 
    while (true)
    {
-      m_writeQ.condVar.Lock();
-      while (m_writeQ.size == 0)
+      wq.condVar.Lock();
+      while (wq.size == 0)
       {
-         m_writeQ.condVar.Wait();
+         wq.condVar.Wait();
       }
 
-      // MT -- optimize to pop several blocks if they are available (or swap the list).
-      // This makes sense especially for smallish block sizes.
-
-      int n_pushed = std::min(m_writeQ.size, m_configuration.m_wqueue_blocks);
+      int n_pushed = std::min(wq.size, m_configuration.m_wqueue_blocks);
 
+      long long n_bytes = 0;
       for (int bi = 0; bi < n_pushed; ++bi)
       {
-         Block* block = m_writeQ.queue.front();
-         m_writeQ.queue.pop_front();
-         m_writeQ.writes_between_purges += block->get_size();
+         Block* block = wq.queue.front();
+         wq.queue.pop_front();
+         n_bytes += block->get_size();
 
          blks_to_write[bi] = block;
 
          TRACE(Dump, "Cache::ProcessWriteTasks for block " <<  (void*)(block) << " path " << block->m_file->lPath());
       }
-      m_writeQ.size -= n_pushed;
+      wq.size -= n_pushed;
 
-      m_writeQ.condVar.UnLock();
+      wq.condVar.UnLock();
 
-      for (int bi = 0; bi < n_pushed; ++bi)
+      // Blocks of the same file that follow each other are written in one go.
+      std::sort(blks_to_write.begin(), blks_to_write.begin() + n_pushed, BlockWriteOrder);
+
+      int n_writes = 0;
+      for (int bi = 0; bi < n_pushed; )
+      {
+         int be = bi + 1;
+         while (be < n_pushed && blks_to_write[be]->m_file == blks_to_write[bi]->m_file &&
+                blks_to_write[be]->m_offset == blks_to_write[be - 1]->m_offset + blks_to_write[be - 1]->get_size())
+         {
+            ++be;
+         }
+
+         blks_to_write[bi]->m_file->WriteBlocksToDisk(&blks_to_write[bi], be - bi);
+
+         ++n_writes;
+         bi = be;
+      }
+
+      {
+         XrdSysMutexHelper lock(&m_writeQ_mutex);
+
+         m_writes_between_purges += n_bytes;
+         wq.n_blocks             += n_pushed;
+         wq.n_writes             += n_writes;
+      }
+
+      // A congested queue may have drained enough to allow prefetching.
+      WakePrefetch();
+   }
+}
+
+
+bool Cache::IsWriteQueueCongested(int wq_idx)
+{
+   int n_queues, size;
+   {
+      XrdSysMutexHelper lock(&m_writeQ_mutex);
+      n_queues = m_writeQ_cnt;
+   }
+   {
+      XrdSysCondVarHelper lock(&m_writeQ[wq_idx]->condVar);
+      size = m_writeQ[wq_idx]->size;
+   }
+
+   // Each queue may hold up to its share of half of the RAM blocks.
+   int limit = std::max(m_configuration.m_NRamBuffers / (2 * n_queues), m_configuration.m_wqueue_blocks);
+
+   return size > limit;
+}
+
+
+void Cache::report_write_queues()
+{
+   XrdSysMutexHelper lock(&m_writeQ_mutex);
+
+   for (int i = 0; i < m_writeQ_cnt; ++i)
+   {
+      WriteQ &wq = *m_writeQ[i];
+      int size, size_max;
       {
-         Block* block = blks_to_write[bi];
+         XrdSysCondVarHelper wq_lock(&wq.condVar);
 
-         block->m_file->WriteBlockToDisk(block);
+         size        = wq.size;
+         size_max    = wq.size_max;
+         wq.size_max = size;
       }
+
+      char buff[256];
+      snprintf(buff, sizeof(buff), "write queue %d device 0x%llx depth %d, max depth %d, blocks written %lld in %lld writes",
+               i, (unsigned long long) wq.dev, size, size_max, wq.n_blocks, wq.n_writes);
+      TRACE(Info, "Cache::Purge() " << buff);
+
+      wq.n_blocks = wq.n_writes = 0;
    }
 }
 
 
-bool Cache::RequestRAMBlock()
+char* Cache::RequestRAMBlock(bool force)
 {
    XrdSysMutexHelper lock(&m_RAMblock_mutex);
-   if ( m_RAMblocks_used < Cache::GetInstance().RefConfiguration().m_NRamBuffers )
+   if ( m_RAMblocks_used >= m_configuration.m_NRamBuffers && m_hot_tier.IsEnabled() )
+   {
+      // Blocks kept in the hot tier give way to blocks being read or prefetched.
+      char *buf = m_hot_tier.Reclaim();
+      if (buf) return buf;
+   }
+   if ( m_RAMblocks_used < m_configuration.m_NRamBuffers || force )
    {
+      if (m_RAMblock_pool.empty() && ! refill_ram_pool())
+      {
+         return 0;
+      }
       m_RAMblocks_used++;
-      return true;
+      char *buf = m_RAMblock_pool.back();
+      m_RAMblock_pool.pop_back();
+      return buf;
    }
-   return false;
+   return 0;
 }
 
 
-void Cache::RAMBlockReleased()
+void Cache::RAMBlockReleased(char *buf)
 {
-   XrdSysMutexHelper lock(&m_RAMblock_mutex);
-   m_RAMblocks_used--;
+   {
+      XrdSysMutexHelper lock(&m_RAMblock_mutex);
+      m_RAMblocks_used--;
+      m_RAMblock_pool.push_back(buf);
+   }
+   WakePrefetch();
+}
+
+
+void Cache::InvalidateHotTier(const std::string &f_name)
+{
+   if ( ! m_hot_tier.IsEnabled()) return;
+
+   std::vector<char*> bufs;
+   m_hot_tier.Invalidate(f_name, bufs);
+   for (std::vector<char*>::iterator i = bufs.begin(); i != bufs.end(); ++i)
+   {
+      RAMBlockReleased(*i);
+   }
+}
+
+
+bool Cache::refill_ram_pool()
+{
+   // Called under m_RAMblock_mutex.
+   //
+   // Block buffers are carved out of slabs of at least 2 MB so that they can
+   // be backed by hugepages. Slabs are never returned to the system; the pool
+   // grows only up to the peak number of blocks in use, which is bounded by
+   // pfc.ram (plus a few prefetch blocks).
+
+   const long long bs      = m_configuration.m_bufferSize;
+   const long long hp_size = 2 * 1024 * 1024;
+   const int       n_bufs  = std::max(1LL, hp_size / bs);
+
+   size_t  slab_size = n_bufs * bs;
+   void   *slab      = 0;
+
+   if (m_configuration.m_hugepages)
+   {
+      slab_size = (slab_size + hp_size - 1) / hp_size * hp_size;
+#ifdef MAP_HUGETLB
+      slab = mmap(0, slab_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (slab == MAP_FAILED) slab = 0;
+#endif
+      // Fall back to transparent hugepages if none are reserved.
+      if ( ! slab && posix_memalign(&slab, hp_size, slab_size) == 0)
+      {
+#ifdef MADV_HUGEPAGE
+         madvise(slab, slab_size, MADV_HUGEPAGE);
+#endif
+      }
+   }
+   else
+   {
+      if (posix_memalign(&slab, sysconf(_SC_PAGESIZE), slab_size) != 0) slab = 0;
+   }
+
+   if ( ! slab)
+   {
+      TRACE(Error, "Cache::refill_ram_pool failed to allocate " << slab_size << " bytes for RAM blocks");
+      return false;
+   }
+
+   for (int i = n_bufs - 1; i >= 0; --i)
+   {
+      m_RAMblock_pool.push_back((char*) slab + i * bs);
+   }
+   m_RAMblocks_total += n_bufs;
+
+   TRACE(Debug, "Cache::refill_ram_pool allocated " << n_bufs << " RAM blocks, total " << m_RAMblocks_total);
+   return true;
 }
 
 
@@ -407,6 +603,12 @@ File* Cache::GetFile(const std::string& path, IO* io, long long off, long long f
       m_active_cond.Broadcast();
    }
 
+   // Register the file, or its new access time, with the purge index.
+   if (file)
+   {
+      m_purge_index.Update(path + Info::m_infoExtension, file->GetNDownloadedBytes(), time(0), file->GetAccessCnt());
+   }
+
    return file;
 }
 
@@ -455,16 +657,18 @@ class CommandExecutor : public XrdJob
 {
 private:
    std::string m_command_url;
+   std::string m_origin;
 
 public:
-   CommandExecutor(const std::string& command, const char *desc = "") :
+   CommandExecutor(const std::string& command, const std::string& origin, const char *desc = "") :
       XrdJob(desc),
-      m_command_url(command)
+      m_command_url(command),
+      m_origin(origin)
    {}
 
    void DoIt()
    {
-      Cache::GetInstance().ExecuteCommandUrl(m_command_url);
+      Cache::GetInstance().ExecuteCommandUrl(m_command_url, m_origin);
       delete this;
    }
 };
@@ -560,6 +764,9 @@ void Cache::dec_ref_cnt(File* f, bool high_debug)
       }
    }
 
+   std::string info_path;
+   long long   n_bytes   = 0;
+   int         n_access  = 0;
    {
      XrdSysCondVarHelper lock(&m_active_cond);
 
@@ -567,11 +774,21 @@ void Cache::dec_ref_cnt(File* f, bool high_debug)
      TRACE_INT(tlvl, "Cache::dec_ref_cnt " << f->GetLocalPath() << ", cnt after sync_check and dec_ref_cnt = " << cnt);
      if (cnt == 0)
      {
+        info_path = f->GetLocalPath() + Info::m_infoExtension;
+        n_bytes   = f->GetNDownloadedBytes();
+        n_access  = f->GetAccessCnt();
+
         ActiveMap_i it = m_active.find(f->GetLocalPath());
         m_active.erase(it);
         delete f;
      }
    }
+
+   // Record detach time in purge index.
+   if ( ! info_path.empty())
+   {
+      m_purge_index.Update(info_path, n_bytes, time(0), n_access);
+   }
 }
 
 bool Cache::IsFileActiveOrPurgeProtected(const std::string& path)
@@ -598,6 +815,7 @@ void Cache::RegisterPrefetchFile(File* file)
 
    m_prefetch_condVar.Lock();
    m_prefetchList.push_back(file);
+   ++m_prefetch_seq;
    m_prefetch_condVar.Signal();
    m_prefetch_condVar.UnLock();
 }
@@ -625,7 +843,7 @@ void Cache::DeRegisterPrefetchFile(File* file)
 }
 
 
-File* Cache::GetNextFileToPrefetch()
+File* Cache::GetNextFileToPrefetch(float ram_pressure)
 {
    m_prefetch_condVar.Lock();
    while (m_prefetchList.empty())
@@ -633,36 +851,96 @@ File* Cache::GetNextFileToPrefetch()
       m_prefetch_condVar.Wait();
    }
 
-   //  std::sort(m_prefetchList.begin(), m_prefetchList.end(), myobject);
+   // Take the file with the highest prefetch priority, i.e., its prefetch
+   // score times the number of IOs streaming through it. As RAM fills up,
+   // files whose prefetched blocks are often left unread are passed over;
+   // newly opened files keep a full score until they have warmed up.
+   // The chosen file goes to the back of the list so that equals take turns.
 
-   size_t l = m_prefetchList.size();
-   int idx = rand() % l;
-   File* f = m_prefetchList[idx];
+   size_t l    = m_prefetchList.size();
+   size_t best = l;
+   float  best_prio = 0;
+   for (size_t i = 0; i < l; ++i)
+   {
+      File *f = m_prefetchList[i];
+      if (f->GetPrefetchScore() < ram_pressure) continue;
+
+      // Do not add to the backlog of a slow disk.
+      if (IsWriteQueueCongested(f->GetWriteQueueIdx())) continue;
+
+      float prio = f->GetPrefetchPriority();
+      if (best == l || prio > best_prio)
+      {
+         best      = i;
+         best_prio = prio;
+      }
+   }
+
+   File* f = 0;
+   if (best < l)
+   {
+      f = m_prefetchList[best];
+      m_prefetchList.erase(m_prefetchList.begin() + best);
+      m_prefetchList.push_back(f);
+   }
 
    m_prefetch_condVar.UnLock();
    return f;
 }
 
 
+void Cache::WakePrefetch()
+{
+   // Can be called with other locks held.
+
+   if ( ! m_prefetch_enabled)
+   {
+      return;
+   }
+
+   m_prefetch_condVar.Lock();
+   ++m_prefetch_seq;
+   m_prefetch_condVar.Signal();
+   m_prefetch_condVar.UnLock();
+}
+
+
 void Cache::Prefetch()
 {
    const int limitRAM = int( Cache::GetInstance().RefConfiguration().m_NRamBuffers * 0.7 );
 
    while (true)
    {
+      // Note the wake-up count first so that nothing that happens while
+      // looking for a file to prefetch goes unnoticed.
+      m_prefetch_condVar.Lock();
+      int seq = m_prefetch_seq;
+      m_prefetch_condVar.UnLock();
+
+      // Blocks in the hot tier are reclaimed on demand and do not hold back prefetching.
       m_RAMblock_mutex.Lock();
-      bool doPrefetch = (m_RAMblocks_used < limitRAM);
+      int  used       = m_RAMblocks_used - m_hot_tier.GetNBlocks();
       m_RAMblock_mutex.UnLock();
+      bool doPrefetch = (used < limitRAM);
 
       if (doPrefetch)
       {
-         File* f = GetNextFileToPrefetch();
-         f->Prefetch();
+         File* f = GetNextFileToPrefetch(float(used) / limitRAM);
+         if (f)
+         {
+            f->Prefetch();
+            continue;
+         }
       }
-      else
+
+      // Nothing can be prefetched now. Wait until RAM is released, a write
+      // queue drains or a file is registered.
+      m_prefetch_condVar.Lock();
+      while (seq == m_prefetch_seq)
       {
-         XrdSysTimer::Wait(5);
+         m_prefetch_condVar.Wait();
       }
+      m_prefetch_condVar.UnLock();
    }
 }
 
@@ -800,7 +1078,10 @@ int Cache::Prepare(const char *curl, int oflags, mode_t mode)
    {
       // Schedule a job to process command request.
       {
-         CommandExecutor *ce = new CommandExecutor(f_name, "CommandExecutor");
+         std::ostringstream origin;
+         origin << url.GetProtocol() << "://" << url.GetHostName() << ":" << url.GetPort() << "/";
+
+         CommandExecutor *ce = new CommandExecutor(f_name, origin.str(), "CommandExecutor");
          if (schedP) {
             schedP->Schedule(ce);
          } else {
@@ -950,6 +1231,9 @@ int Cache::UnlinkCommon(const std::string& f_name, bool fail_if_open)
 
    TRACE(Debug, "Cache::UnlinkCommon " << f_name << ", f_ret=" << f_ret << ", i_ret=" << i_ret);
 
+   m_purge_index.Remove(i_name);
+   InvalidateHotTier(f_name);
+
    {
       XrdSysCondVarHelper lock(&m_active_cond);
 
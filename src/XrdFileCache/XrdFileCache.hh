@@ -17,6 +17,7 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
 //----------------------------------------------------------------------------------
+#include <sys/types.h>
 #include <string>
 #include <list>
 #include <set>
@@ -29,6 +30,9 @@
 #include "XrdCl/XrdClDefaultEnv.hh"
 #include "XrdFileCacheFile.hh"
 #include "XrdFileCacheDecision.hh"
+#include "XrdFileCacheHotTier.hh"
+#include "XrdFileCachePrestage.hh"
+#include "XrdFileCachePurgeIndex.hh"
 
 class XrdOucStream;
 class XrdSysError;
@@ -52,6 +56,7 @@ struct Configuration
 {
    Configuration() :
       m_hdfsmode(false),
+      m_hugepages(false),
       m_allow_xrdpfc_command(false),
       m_data_space("public"),
       m_meta_space("public"),
@@ -70,6 +75,10 @@ struct Configuration
       m_wqueue_blocks(16),
       m_wqueue_threads(4),
       m_prefetch_max_blocks(10),
+      m_hotTierBlocks(0),
+      m_mergeReadMax(8*1024*1024),
+      m_prestageFiles(4),
+      m_prestageRate(0),
       m_hdfsbsize(128*1024*1024),
       m_flushCnt(2000)
    {}
@@ -81,6 +90,7 @@ struct Configuration
    void calculate_fractional_usages(long long du, long long fu, double &frac_du, double &frac_fu);
 
    bool m_hdfsmode;                     //!< flag for enabling block-level operation
+   bool m_hugepages;                    //!< flag for backing RAM blocks with hugepages
    bool m_allow_xrdpfc_command;         //!< flag for enabling access to /xrdpfc-command/ functionality.
 
    std::string m_username;              //!< username passed to oss plugin
@@ -96,6 +106,7 @@ struct Configuration
    int       m_purgeInterval;           //!< sleep interval between cache purges
    int       m_purgeColdFilesAge;       //!< purge files older than this age
    int       m_purgeColdFilesPeriod;    //!< peform cold file purge every this many purge cycles
+   std::string m_purgeIndexPath;        //!< local path of purge index log, empty for in-memory index
 
    long long m_bufferSize;              //!< prefetch buffer size, default 1MB
    long long m_RamAbsAvailable;         //!< available from configuration
@@ -103,6 +114,11 @@ struct Configuration
    int       m_wqueue_blocks;           //!< maximum number of blocks written per write-queue loop
    int       m_wqueue_threads;          //!< number of threads writing blocks to disk
    int       m_prefetch_max_blocks;     //!< maximum number of blocks to prefetch per file
+   int       m_hotTierBlocks;           //!< maximum number of RAM blocks in the hot tier, 0 disables it
+   long long m_mergeReadMax;            //!< maximum size of a merged remote read of several blocks, 0 disables merging
+   int       m_prestageFiles;           //!< number of files downloaded concurrently by prestage
+   long long m_prestageRate;            //!< prestage read rate limit in bytes per second, 0 for none
+   std::string m_prestageListDir;       //!< local directory with prestage file lists, empty disables them
 
    long long m_hdfsbsize;               //!< used with m_hdfsmode, default 128MB
    long long m_flushCnt;                //!< nuber of unsynced blcoks on disk before flush is called
@@ -116,6 +132,7 @@ struct TmpConfiguration
    std::string m_fileUsageNominal;
    std::string m_fileUsageMax;
    std::string m_flushRaw;
+   std::string m_hotTierRaw;
 
    TmpConfiguration() :
       m_diskUsageLWM("0.90"), m_diskUsageHWM("0.95"),
@@ -216,7 +233,13 @@ public:
    int  UnlinkUnlessOpen(const std::string& f_name);
 
    //---------------------------------------------------------------------
-   //! Add downloaded block in write queue.
+   //! Get index of write queue for the device holding a data file. A queue,
+   //! with its own writer threads, is created for each new device.
+   //---------------------------------------------------------------------
+   int  GetWriteQueueIdx(dev_t dev);
+
+   //---------------------------------------------------------------------
+   //! Add downloaded block in write queue of its file.
    //---------------------------------------------------------------------
    void AddWriteTask(Block* b, bool from_read);
 
@@ -227,18 +250,54 @@ public:
    void RemoveWriteQEntriesFor(File *f);
 
    //---------------------------------------------------------------------
-   //! Separate task which writes blocks from ram to disk.
+   //! Separate task which writes blocks from ram to disk, one or more per
+   //! write queue.
+   //---------------------------------------------------------------------
+   void ProcessWriteTasks(int wq_idx);
+
+   //---------------------------------------------------------------------
+   //! True if the write queue has more blocks than its share of RAM.
+   //! Prefetching for files on its device is then held back.
+   //---------------------------------------------------------------------
+   bool IsWriteQueueCongested(int wq_idx);
+
+   //---------------------------------------------------------------------
+   //! \brief Get a page-aligned block buffer from the RAM block pool.
+   //! The buffer is not zeroed. Returns 0 if the RAM limit is reached,
+   //! unless force is set, or if no memory could be allocated.
    //---------------------------------------------------------------------
-   void ProcessWriteTasks();
+   char* RequestRAMBlock(bool force = false);
 
-   bool RequestRAMBlock();
+   //---------------------------------------------------------------------
+   //! Return a buffer obtained with RequestRAMBlock() to the pool.
+   //---------------------------------------------------------------------
+   void RAMBlockReleased(char *buf);
 
-   void RAMBlockReleased();
+   //---------------------------------------------------------------------
+   //! In-memory tier of recently read disk blocks.
+   //---------------------------------------------------------------------
+   HotTier& RefHotTier() { return m_hot_tier; }
+
+   //---------------------------------------------------------------------
+   //! Drop blocks of a data file from the hot tier and return their
+   //! buffers to the RAM block pool.
+   //---------------------------------------------------------------------
+   void InvalidateHotTier(const std::string &f_name);
 
    void RegisterPrefetchFile(File*);
    void DeRegisterPrefetchFile(File*);
 
-   File* GetNextFileToPrefetch();
+   //---------------------------------------------------------------------
+   //! Pick the file to prefetch a block for next. Returns 0 if no file is
+   //! worth prefetching for at the given RAM pressure (used / allowed).
+   //---------------------------------------------------------------------
+   File* GetNextFileToPrefetch(float ram_pressure);
+
+   //---------------------------------------------------------------------
+   //! Wake the prefetch thread after something that may let it prefetch
+   //! again (RAM block released, write queue drained, file registered).
+   //---------------------------------------------------------------------
+   void WakePrefetch();
 
    void Prefetch();
 
@@ -257,7 +316,11 @@ public:
    XrdSysError* GetLog()   { return &m_log;  }
    XrdSysTrace* GetTrace() { return m_trace; }
 
-   void ExecuteCommandUrl(const std::string& command_url);
+   //---------------------------------------------------------------------
+   //! Execute an /xrdpfc_command/. Origin is the URL prefix of the server
+   //! the command was sent to, used by prestage.
+   //---------------------------------------------------------------------
+   void ExecuteCommandUrl(const std::string& command_url, const std::string& origin);
 
 private:
    bool ConfigParameters(std::string, XrdOucStream&, TmpConfiguration &tmpc);
@@ -269,6 +332,8 @@ private:
 
    int  UnlinkCommon(const std::string& f_name, bool fail_if_open);
 
+   bool refill_ram_pool();
+
    static Cache        *m_factory;      //!< this object
    static XrdScheduler *schedP;
 
@@ -287,22 +352,37 @@ private:
 
    XrdSysCondVar m_prefetch_condVar;        //!< lock for vector of prefetching files
    bool          m_prefetch_enabled;        //!< set to true when prefetching is enabled
-
-   XrdSysMutex m_RAMblock_mutex;            //!< lock for allcoation of RAM blocks
-   int         m_RAMblocks_used;
+   int           m_prefetch_seq;            //!< bumped by WakePrefetch(), under m_prefetch_condVar
+
+   XrdSysMutex        m_RAMblock_mutex;     //!< lock for allcoation of RAM blocks
+   int                m_RAMblocks_used;
+   int                m_RAMblocks_total;    //!< number of block buffers allocated
+   std::vector<char*> m_RAMblock_pool;      //!< free block buffers
+   HotTier            m_hot_tier;           //!< recently read disk blocks, uses buffers from the pool
+   Prestager          m_prestager;          //!< bulk downloads requested with the prestage command
    bool        m_isClient;                  //!< True if running as client
 
    struct WriteQ
    {
-      WriteQ() : condVar(0), writes_between_purges(0), size(0) {}
+      WriteQ(dev_t d) : condVar(0), dev(d), size(0), size_max(0), n_blocks(0), n_writes(0) {}
 
       XrdSysCondVar     condVar;      //!< write list condVar
       std::list<Block*> queue;        //!< container
-      long long         writes_between_purges; //!< upper bound on amount of bytes written between two purge passes
+      dev_t             dev;          //!< device holding the data files
       int               size;         //!< current size of write queue
+      int               size_max;     //!< maximum size since last report
+      long long         n_blocks;     //!< blocks written since last report
+      long long         n_writes;     //!< write calls since last report
    };
 
-   WriteQ m_writeQ;
+   static const int s_maxWriteQ = 32;
+
+   WriteQ       *m_writeQ[s_maxWriteQ];    //!< write queues, one per device
+   int           m_writeQ_cnt;
+   XrdSysMutex   m_writeQ_mutex;           //!< lock for creation of write queues and write stats
+   long long     m_writes_between_purges;  //!< upper bound on amount of bytes written between two purge passes
+
+   void report_write_queues();
 
    // active map, purge delay set
    typedef std::map<std::string, File*> ActiveMap_t;
@@ -313,6 +393,7 @@ private:
    FNameSet_t    m_purge_delay_set;
    bool          m_in_purge;
    XrdSysCondVar m_active_cond;
+   PurgeIndex    m_purge_index;         //!< files ordered by access time, consulted by Purge()
 
    void inc_ref_cnt(File*, bool lock, bool high_debug);
    void dec_ref_cnt(File*, bool high_debug);
@@ -0,0 +1,120 @@
+#ifndef __XRDFILECACHE_BLOCK_INDEX_HH__
+#define __XRDFILECACHE_BLOCK_INDEX_HH__
+//----------------------------------------------------------------------------------
+// Copyright (c) 2019 by Board of Trustees of the Leland Stanford, Jr., University
+// Author: Alja Mrak-Tadel, Matevz Tadel, Brian Bockelman
+//----------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//----------------------------------------------------------------------------------
+
+#include <stddef.h>
+
+#include <vector>
+
+namespace XrdFileCache
+{
+class Block;
+
+//----------------------------------------------------------------------------
+//! Index of blocks in RAM or being downloaded, keyed by block index.
+//!
+//! An open-addressed hash table with linear probing kept in one array, so a
+//! lookup usually touches a single cache line. Removal shifts following
+//! entries back instead of leaving tombstones. Not thread safe.
+//----------------------------------------------------------------------------
+class BlockIndex
+{
+public:
+   BlockIndex() : m_slots(16), m_size(0) {}
+
+   //! Block with given index or 0.
+   Block* Find(int idx) const
+   {
+      for (size_t i = home(idx); m_slots[i].block; i = next(i))
+      {
+         if (m_slots[i].idx == idx) return m_slots[i].block;
+      }
+      return 0;
+   }
+
+   //! Add a block, the index must not be present.
+   void Insert(int idx, Block *b)
+   {
+      if (4 * (m_size + 1) > 3 * (int) m_slots.size()) grow();
+
+      size_t i = home(idx);
+      while (m_slots[i].block) i = next(i);
+
+      m_slots[i].idx   = idx;
+      m_slots[i].block = b;
+      ++m_size;
+   }
+
+   //! Remove a block. Returns false if the index was not present.
+   bool Erase(int idx)
+   {
+      size_t i = home(idx);
+      while (m_slots[i].block && m_slots[i].idx != idx) i = next(i);
+
+      if ( ! m_slots[i].block) return false;
+
+      // Move back entries that would not be found past the emptied slot.
+      for (size_t j = next(i); m_slots[j].block; j = next(j))
+      {
+         size_t h = home(m_slots[j].idx);
+         bool   stays = (i <= j) ? (i < h && h <= j) : (i < h || h <= j);
+         if ( ! stays)
+         {
+            m_slots[i] = m_slots[j];
+            i = j;
+         }
+      }
+      m_slots[i].block = 0;
+      --m_size;
+      return true;
+   }
+
+   int  Size()  const { return m_size; }
+   bool Empty() const { return m_size == 0; }
+
+private:
+   struct Slot
+   {
+      int    idx;
+      Block *block;   //!< 0 for an empty slot
+
+      Slot() : idx(0), block(0) {}
+   };
+
+   size_t home(int idx) const { return ((unsigned int) idx * 2654435761u) & (m_slots.size() - 1); }
+   size_t next(size_t i) const { return (i + 1) & (m_slots.size() - 1); }
+
+   void grow()
+   {
+      std::vector<Slot> old;
+      old.swap(m_slots);
+      m_slots.resize(2 * old.size());
+      m_size = 0;
+      for (std::vector<Slot>::iterator i = old.begin(); i != old.end(); ++i)
+      {
+         if (i->block) Insert(i->idx, i->block);
+      }
+   }
+
+   std::vector<Slot> m_slots;   //!< size is a power of two
+   int               m_size;
+};
+}
+
+#endif
@@ -30,11 +30,14 @@
 #include "XrdSys/XrdSysFallocate.hh"
 
 #include <algorithm>
+#include <cctype>
 #include <cstring>
 #include <iostream>
 #include <fcntl.h>
 #include <vector>
+#include <sys/stat.h>
 #include <sys/time.h>
+#include <unistd.h>
 
 using namespace XrdFileCache;
 
@@ -45,7 +48,7 @@ const int MAX_ACCESSES = 20;
 const long long ONE_MB = 1024ll * 1024;
 const long long ONE_GB = 1024ll * 1024 * 1024;
 
-void Cache::ExecuteCommandUrl(const std::string& command_url)
+void Cache::ExecuteCommandUrl(const std::string& command_url, const std::string& origin)
 {
    static const char *top_epfx = "ExecuteCommandUrl ";
 
@@ -277,11 +280,14 @@ void Cache::ExecuteCommandUrl(const std::string& command_url)
          myInfo.SetFileSize(file_size);
          myInfo.SetAllBitsSynced();
 
+         time_t last_detach = time_now;
          for (int i = 0; i < at_count; ++i)
          {
             time_t att_time = access_time[i] >= 0 ? access_time[i] : time_now + access_time[i];
 
             myInfo.WriteIOStatSingle(file_size, att_time, att_time + access_duration[i]);
+
+            if (i == 0 || att_time + access_duration[i] > last_detach) last_detach = att_time + access_duration[i];
          }
 
          myInfo.Write(myInfoFile);
@@ -292,10 +298,12 @@ void Cache::ExecuteCommandUrl(const std::string& command_url)
          TRACE(Info, err_prefix << "Created file '" << file_path << "', size=" << (file_size>>20) << "MB.");
 
          {
-            XrdSysCondVarHelper lock(&m_writeQ.condVar);
+            XrdSysMutexHelper lock(&m_writeQ_mutex);
 
-            m_writeQ.writes_between_purges += file_size;
+            m_writes_between_purges += file_size;
          }
+
+         m_purge_index.Update(cinfo_path, myInfo.GetNDownloadedBytes(), last_detach, at_count);
       }
    }
 
@@ -357,6 +365,155 @@ void Cache::ExecuteCommandUrl(const std::string& command_url)
       TRACE(Info, err_prefix << "returned with status " << ret);
    }
 
+   //================================================================
+   // rescan_purge_index
+   //================================================================
+
+   else if (token == "rescan_purge_index")
+   {
+      static const char* err_prefix = "ExecuteCommandUrl: /xrdpfc_command/rescan_purge_index: ";
+
+      m_purge_index.Invalidate();
+
+      TRACE(Info, err_prefix << "purge index will be rebuilt by a full scan on next purge cycle.");
+   }
+
+   //================================================================
+   // prestage
+   //================================================================
+
+   else if (token == "prestage")
+   {
+      static const char* err_prefix = "ExecuteCommandUrl: /xrdpfc_command/prestage: ";
+      static const char* usage =
+         "Usage: prestage/ [-h] [-l]/<path>\n"
+         "  Downloads the whole file into the cache unless it is already complete.\n"
+         "  With -l, <path> names a file in the directory set with pfc.prestage listdir\n"
+         "  that lists the files to download, one per line. Empty lines and lines\n"
+         "  starting with # are skipped.\n"
+         "Notes:\n"
+         "  . If no options are needed one should still leave a space between / separators, ie., '/ /'\n"
+         "  . Concurrency and rate of downloads are set with pfc.prestage.\n";
+
+      token = cp.get_token();
+
+      TRACE(Debug, err_prefix << "Entered with argument string '" << token <<"'.");
+
+      std::vector<char*> argv;
+      SplitParser ap(token, " ");
+      int argc = ap.fill_argv(argv);
+
+      bool        is_list = false;
+      XrdOucArgs  Spec(&m_log, err_prefix, "hl",
+                       "help",         1, "h",
+                       "list",         1, "l",
+                       (const char *) 0);
+
+      Spec.Set(argc, &argv[0]);
+      char theOpt;
+
+      while ((theOpt = Spec.getopt()) != (char) -1)
+      {
+         switch (theOpt)
+         {
+            case 'h': {
+               m_log.Say(err_prefix, " -- printing help, no action will be taken\n", usage);
+               return;
+            }
+            case 'l': {
+               is_list = true;
+               break;
+            }
+            default: {
+               TRACE(Error, err_prefix << "Unhandled command argument.");
+               return;
+            }
+         }
+      }
+      if (Spec.getarg())
+      {
+         TRACE(Error, err_prefix << "Options must take up all the arguments.");
+         return;
+      }
+
+      std::string              path(cp.get_reminder());
+      std::vector<std::string> files;
+
+      if (path.find_first_not_of('/') == std::string::npos)
+      {
+         TRACE(Error, err_prefix << "no path given.");
+         return;
+      }
+
+      if (is_list)
+      {
+         // Only plain files directly in the configured directory may be read.
+         const std::string &dir  = m_configuration.m_prestageListDir;
+         std::string        name = path.substr(path.find_first_not_of('/'));
+         if (dir.empty())
+         {
+            TRACE(Error, err_prefix << "file lists are not enabled, see pfc.prestage listdir.");
+            return;
+         }
+         if (name.find('/') != std::string::npos || name == "." || name == "..")
+         {
+            TRACE(Error, err_prefix << "file list " << path << " must be a file name in " << dir << ".");
+            return;
+         }
+
+         std::string lpath = dir + "/" + name;
+         int         fd    = open(lpath.c_str(), O_RDONLY | O_NOFOLLOW);
+         if (fd < 0)
+         {
+            TRACE(Error, err_prefix << "can not open file list " << lpath << ", " << ERRNO_AND_ERRSTR(errno));
+            return;
+         }
+
+         struct stat st;
+         FILE       *fp = 0;
+         if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) fp = fdopen(fd, "r");
+         if ( ! fp)
+         {
+            TRACE(Error, err_prefix << "file list " << lpath << " is not a regular file.");
+            close(fd);
+            return;
+         }
+
+         char    *line = 0;
+         size_t   line_size = 0;
+         ssize_t  len;
+         while ((len = getline(&line, &line_size, fp)) > 0)
+         {
+            while (len > 0 && isspace(line[len - 1])) line[--len] = 0;
+
+            char *p = line;
+            while (isspace(*p)) ++p;
+            if (*p == 0 || *p == '#') continue;
+
+            files.push_back(*p == '/' ? p : std::string("/") + p);
+         }
+         free(line);
+         fclose(fp);
+      }
+      else
+      {
+         files.push_back(path);
+      }
+
+      TRACE(Info, err_prefix << "queueing " << files.size() << " files.");
+
+      m_prestager.Add(origin, files);
+   }
+
+   //================================================================
+   // prestage_status
+   //================================================================
+
+   else if (token == "prestage_status")
+   {
+      m_prestager.Report();
+   }
+
    //================================================================
    // unknown command
    //================================================================
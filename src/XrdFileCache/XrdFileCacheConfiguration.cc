@@ -310,6 +310,25 @@ bool Cache::Config(const char *config_filename, const char *parameters)
       m_log.Say("Config info: ", buff);
    }
    m_configuration.m_NRamBuffers = static_cast<int>(m_configuration.m_RamAbsAvailable / m_configuration.m_bufferSize);
+   m_RAMblock_pool.reserve(m_configuration.m_NRamBuffers);
+
+   // The hot tier is given in bytes or as a fraction of pfc.ram, at most half of it.
+   if ( ! tmpc.m_hotTierRaw.empty())
+   {
+      long long hot;
+      if ( ! cfg2bytes(tmpc.m_hotTierRaw, hot, m_configuration.m_RamAbsAvailable, "hottier"))
+      {
+         return false;
+      }
+      if (hot > m_configuration.m_RamAbsAvailable / 2)
+      {
+         m_log.Emsg("Config", "Error: pfc.hottier should be at most half of pfc.ram, given", tmpc.m_hotTierRaw.c_str());
+         return false;
+      }
+      m_configuration.m_hotTierBlocks = static_cast<int>(hot / m_configuration.m_bufferSize);
+   }
+   m_hot_tier.Init(m_configuration.m_hotTierBlocks, m_trace);
+   m_prestager.Init(m_configuration.m_prestageFiles, m_configuration.m_prestageRate, m_trace);
    
 
    // Set tracing to debug if this is set in environment
@@ -324,8 +343,10 @@ bool Cache::Config(const char *config_filename, const char *parameters)
       loff = snprintf(buff, sizeof(buff), "Config effective %s pfc configuration:\n"
                       "       pfc.blocksize %lld\n"
                       "       pfc.prefetch %d\n"
-                      "       pfc.ram %.fg\n"
+                      "       pfc.ram %.fg%s\n"
                       "       pfc.writequeue %d %d\n"
+                      "       pfc.mergereads %lld\n"
+                      "       pfc.prestage files %d rate %lld%s%s\n"
                       "       # Total available disk: %lld\n"
                       "       pfc.diskusage %lld %lld files %lld %lld %lld purgeinterval %d purgecoldfiles %d\n"
                       "       pfc.spaces %s %s\n"
@@ -334,8 +355,12 @@ bool Cache::Config(const char *config_filename, const char *parameters)
                       config_filename,
                       m_configuration.m_bufferSize,
                       m_configuration.m_prefetch_max_blocks,
-                      rg,
+                      rg, m_configuration.m_hugepages ? " hugepages" : "",
                       m_configuration.m_wqueue_blocks, m_configuration.m_wqueue_threads,
+                      m_configuration.m_mergeReadMax,
+                      m_configuration.m_prestageFiles, m_configuration.m_prestageRate,
+                      m_configuration.m_prestageListDir.empty() ? "" : " listdir ",
+                      m_configuration.m_prestageListDir.c_str(),
                       sP.Total,
                       m_configuration.m_diskUsageLWM, m_configuration.m_diskUsageHWM,
                       m_configuration.m_fileUsageBaseline, m_configuration.m_fileUsageNominal, m_configuration.m_fileUsageMax,
@@ -366,7 +391,27 @@ bool Cache::Config(const char *config_filename, const char *parameters)
          loff += snprintf(buff + loff, sizeof(buff) - loff, "%s", unameBuff);
       }
 
+      if (m_configuration.m_hotTierBlocks > 0)
+      {
+         loff += snprintf(buff + loff, sizeof(buff) - loff, "\n       pfc.hottier %lld",
+                          m_configuration.m_hotTierBlocks * m_configuration.m_bufferSize);
+      }
+
+      if ( ! m_configuration.m_purgeIndexPath.empty())
+      {
+         loff += snprintf(buff + loff, sizeof(buff) - loff, "\n       pfc.purgeindex %s", m_configuration.m_purgeIndexPath.c_str());
+      }
+
       m_log.Say(buff);
+
+      if (m_purge_index.Init(m_configuration.m_purgeIndexPath.c_str(), m_trace))
+      {
+         m_log.Say("Config info: purge index loaded from ", m_configuration.m_purgeIndexPath.c_str());
+      }
+      else
+      {
+         m_log.Say("Config info: purge index will be built by a full scan of the cache.");
+      }
    }
 
    m_log.Say("------ File Caching Proxy interface initialization ", retval ? "completed" : "failed");
@@ -491,6 +536,20 @@ bool Cache::ConfigParameters(std::string part, XrdOucStream& config, TmpConfigur
       {
          return false;
       }
+
+      const char *p = cwg.GetWord();
+      if (cwg.HasLast())
+      {
+         if (strcmp(p, "hugepages") == 0)
+         {
+            m_configuration.m_hugepages = true;
+         }
+         else
+         {
+            m_log.Emsg("Config", "Error: pfc.ram unknown option", p);
+            return false;
+         }
+      }
    }
    else if ( part == "writequeue")
    {
@@ -503,6 +562,59 @@ bool Cache::ConfigParameters(std::string part, XrdOucStream& config, TmpConfigur
          return false;
       }
    }
+   else if ( part == "hottier" )
+   {
+      tmpc.m_hotTierRaw = cwg.GetWord();
+      if ( ! cwg.HasLast())
+      {
+         m_log.Emsg("Config", "Error: pfc.hottier requires a size or a fraction of pfc.ram.");
+         return false;
+      }
+   }
+   else if ( part == "mergereads" )
+   {
+      if (XrdOuca2x::a2sz(m_log, "Error getting pfc.mergereads size", cwg.GetWord(), &m_configuration.m_mergeReadMax, 0, 256 * 1024 * 1024))
+      {
+         return false;
+      }
+   }
+   else if ( part == "prestage" )
+   {
+      const char *p = 0;
+      while ((p = cwg.GetWord()) && cwg.HasLast())
+      {
+         if (strcmp(p, "files") == 0)
+         {
+            if (XrdOuca2x::a2i(m_log, "Error getting pfc.prestage files", cwg.GetWord(), &m_configuration.m_prestageFiles, 1, 256))
+            {
+               return false;
+            }
+         }
+         else if (strcmp(p, "rate") == 0)
+         {
+            if (XrdOuca2x::a2sz(m_log, "Error getting pfc.prestage rate", cwg.GetWord(), &m_configuration.m_prestageRate, 0, 1024ll * 1024 * 1024 * 1024))
+            {
+               return false;
+            }
+         }
+         else if (strcmp(p, "listdir") == 0)
+         {
+            std::string dir = cwg.GetWord();
+            if ( ! cwg.HasLast() || dir[0] != '/')
+            {
+               m_log.Emsg("Config", "Error: pfc.prestage listdir requires an absolute path.");
+               return false;
+            }
+            while (dir.size() > 1 && dir[dir.size() - 1] == '/') dir.erase(dir.size() - 1);
+            m_configuration.m_prestageListDir = dir;
+         }
+         else
+         {
+            m_log.Emsg("Config", "Error: pfc.prestage unknown option", p);
+            return false;
+         }
+      }
+   }
    else if ( part == "spaces" )
    {
       m_configuration.m_data_space = cwg.GetWord();
@@ -513,6 +625,15 @@ bool Cache::ConfigParameters(std::string part, XrdOucStream& config, TmpConfigur
          return false;
       }
    }
+   else if ( part == "purgeindex" )
+   {
+      m_configuration.m_purgeIndexPath = cwg.GetWord();
+      if ( ! cwg.HasLast() || m_configuration.m_purgeIndexPath[0] != '/')
+      {
+         m_log.Emsg("Config", "Error: pfc.purgeindex requires an absolute path.");
+         return false;
+      }
+   }
    else if ( part == "hdfsmode" || part == "filefragmentmode" )
    {
       if (part == "filefragmentmode")
@@ -24,6 +24,9 @@
 #include <sstream>
 #include <fcntl.h>
 #include <assert.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <algorithm>
 #include "XrdCl/XrdClLog.hh"
 #include "XrdCl/XrdClConstants.hh"
 #include "XrdCl/XrdClFile.hh"
@@ -54,10 +57,12 @@ File::File(const std::string& path, long long iOffset, long long iFileSize) :
    m_ref_cnt(0),
    m_is_open(false),
    m_in_shutdown(false),
+   m_fast_read(0),
    m_output(0),
    m_infoFile(0),
    m_cfi(Cache::GetInstance().GetTrace(), Cache::GetInstance().RefConfiguration().m_prefetch_max_blocks > 0),
    m_filename(path),
+   m_writeQ_idx(0),
    m_offset(iOffset),
    m_fileSize(iFileSize),
    m_current_io(m_io_map.end()),
@@ -69,6 +74,7 @@ File::File(const std::string& path, long long iOffset, long long iFileSize) :
    m_prefetchReadCnt(0),
    m_prefetchHitCnt(0),
    m_prefetchScore(1),
+   m_prefetchPriority(0),
    m_detachTimeIsLogged(false)
 {
 }
@@ -91,7 +97,10 @@ File::~File()
       m_output = NULL;
    }
 
-   TRACEF(Debug, "File::~File() ended, prefetch score = " <<  m_prefetchScore);
+   m_stats.m_PrefetchWaste += m_prefetchUnread.size();
+
+   TRACEF(Debug, "File::~File() ended, prefetch score = " <<  m_prefetchScore <<
+          ", prefetch hit = " << m_stats.m_PrefetchHit << ", waste = " << m_stats.m_PrefetchWaste);
 }
 
 //------------------------------------------------------------------------------
@@ -126,6 +135,7 @@ void File::initiate_emergency_shutdown()
       XrdSysCondVarHelper _lck(m_downloadCond);
 
       m_in_shutdown = true;
+      update_fast_read();
 
       if (m_prefetchState != kStopped && m_prefetchState != kComplete)
       {
@@ -185,7 +195,7 @@ bool File::ioActive(IO *io)
                 ", ios_in_detach "           << m_ios_in_detach);
          TRACEF(Info,
                 "\tio_map.size() "           << m_io_map.size() <<
-                ", block_map.size() "        << m_block_map.size() << ", file");
+                ", block_map.size() "        << m_block_map.Size() << ", file");
 
          // It can happen that POSIX calls ioActive again after File already replied
          // false for a given IO.
@@ -194,7 +204,7 @@ bool File::ioActive(IO *io)
          mi->second.m_allow_prefetching = false;
 
          // Check if any IO is still available for prfetching. If not, stop it.
-         if (m_prefetchState == kOn || m_prefetchState == kHold)
+         if (m_prefetchState == kOn || m_prefetchState == kHold || m_prefetchState == kPaused)
          {
             if ( ! select_current_io_or_disable_prefetching(false) )
             {
@@ -211,7 +221,7 @@ bool File::ioActive(IO *io)
 
          if (m_io_map.size() - m_ios_in_detach == 1)
          {
-            io_active_result = ! m_block_map.empty();
+            io_active_result = ! m_block_map.Empty();
          }
          else
          {
@@ -280,8 +290,9 @@ void File::AddIO(IO *io)
    if (mi == m_io_map.end())
    {
       m_io_map.insert(std::make_pair(io, IODetails()));
+      update_prefetch_priority();
 
-      if (m_prefetchState == kStopped)
+      if (m_prefetchState == kStopped || m_prefetchState == kPaused)
       {
          m_prefetchState = kOn;
          cache()->RegisterPrefetchFile(this);
@@ -297,6 +308,25 @@ void File::AddIO(IO *io)
 
 //------------------------------------------------------------------------------
 
+void File::StopPrefetchingOnIO(IO *io)
+{
+   XrdSysCondVarHelper _lck(m_downloadCond);
+
+   IoMap_i mi = m_io_map.find(io);
+
+   if (mi != m_io_map.end())
+   {
+      mi->second.m_allow_prefetching = false;
+
+      if (m_prefetchState == kOn || m_prefetchState == kHold || m_prefetchState == kPaused)
+      {
+         select_current_io_or_disable_prefetching(false);
+      }
+   }
+}
+
+//------------------------------------------------------------------------------
+
 void File::RemoveIO(IO *io)
 {
    // Called from Cache::ReleaseFile.
@@ -316,6 +346,7 @@ void File::RemoveIO(IO *io)
 
       m_io_map.erase(mi);
       --m_ios_in_detach;
+      update_prefetch_priority();
 
       if (m_io_map.empty() && m_prefetchState != kStopped && m_prefetchState != kComplete)
       {
@@ -381,6 +412,10 @@ bool File::Open()
       return false;
    }
 
+   // Writes are queued per device so that a slow disk does not hold up others.
+   struct stat out_stat;
+   m_writeQ_idx = cache()->GetWriteQueueIdx(m_output->Fstat(&out_stat) == XrdOssOK ? out_stat.st_dev : 0);
+
    // Create the info file.
    myEnv.Put("oss.asize", "64k"); // TODO: Calculate? Get it from configuration? Do not know length of access lists ...
    myEnv.Put("oss.cgroup", conf.m_meta_space.c_str());
@@ -429,12 +464,16 @@ bool File::Open()
       m_infoFile->Fsync();
       int ss = (m_fileSize - 1)/m_cfi.GetBufferSize() + 1;
       TRACEF(Debug, "Creating new file info, data size = " <<  m_fileSize << " num blocks = "  << ss);
+
+      // Blocks kept from a previous instance of this file are no longer valid.
+      cache()->InvalidateHotTier(m_filename);
    }
 
    m_cfi.WriteIOStatAttach();
    m_downloadCond.Lock();
    m_is_open = true;
    m_prefetchState = (m_cfi.IsComplete()) ? kComplete : kStopped; // Will engage in AddIO().
+   update_fast_read();
    m_downloadCond.UnLock();
 
    return true;
@@ -478,13 +517,16 @@ bool File::overlap(int blk,            // block to query
 
 //------------------------------------------------------------------------------
 
-Block* File::PrepareBlockRequest(int i, IO *io, bool prefetch)
+Block* File::PrepareBlockRequest(int i, IO *io, bool prefetch, char *user_buf, bool force_ram)
 {
    // Must be called w/ block_map locked.
    // Checks on size etc should be done before.
    //
    // Reference count is 0 so increase it in calling function if you want to
    // catch the block while still in memory.
+   //
+   // If user_buf is given the block is downloaded directly into it. The
+   // caller must then keep the buffer valid until the block is released.
 
    const long long BS   = m_cfi.GetBufferSize();
    const int last_block = m_cfi.GetSizeInBits() - 1;
@@ -492,18 +534,29 @@ Block* File::PrepareBlockRequest(int i, IO *io, bool prefetch)
    long long off     = i * BS;
    long long this_bs = (i == last_block) ? m_fileSize - off : BS;
 
-   // 1. Should blocks be reused to avoid recreation? There is block pool in Xrd
-   // 2, Memalign to page size
-   Block *b = new (std::nothrow) Block(this, io, off, this_bs, prefetch);
+   // Otherwise the buffer comes from the cache's pool of page-aligned RAM
+   // blocks. Prefetch has already checked RAM usage so it is allowed to
+   // exceed it, unless force_ram is cleared.
+   char *buf = user_buf ? user_buf : cache()->RequestRAMBlock(prefetch && force_ram);
+   if ( ! buf)
+   {
+      return 0;
+   }
 
-   if (b)
+   Block *b = new (std::nothrow) Block(this, io, buf, off, this_bs, prefetch, user_buf != 0);
+
+   if ( ! b)
    {
-      m_block_map[i] = b;
+      if ( ! user_buf) cache()->RAMBlockReleased(buf);
+   }
+   else
+   {
+      m_block_map.Insert(i, b);
 
       // Actual Read request is issued in ProcessBlockRequests().
       TRACEF(Dump, "File::PrepareBlockRequest() " <<  i << " prefetch " <<  prefetch << " address " << (void*) b);
 
-      if (m_prefetchState == kOn && (int) m_block_map.size() >= Cache::GetInstance().RefConfiguration().m_prefetch_max_blocks)
+      if (m_prefetchState == kOn && m_block_map.Size() >= Cache::GetInstance().RefConfiguration().m_prefetch_max_blocks)
       {
          m_prefetchState = kHold;
          cache()->DeRegisterPrefetchFile(this);
@@ -521,15 +574,75 @@ void File::ProcessBlockRequest(Block *b, bool prefetch)
   b->get_io()->GetInput()->Read(*oucCB, b->get_buff(), b->get_offset(), b->get_size());
 }
 
+namespace
+{
+// Blocks are split into readv chunks of at most this size to stay below
+// the maximum readv element size of xrootd servers.
+const int MaxReadVChunk  = 512 * 1024;
+const int MaxReadVChunks = 1024;
+
+bool BlockIoOffsetLess(const Block *a, const Block *b)
+{
+   if (a->m_io != b->m_io) return a->m_io < b->m_io;
+   return a->m_offset < b->m_offset;
+}
+}
+
 void File::ProcessBlockRequests(BlockList_t& blks, bool prefetch)
 {
    // This *must not* be called with block_map locked.
+   //
+   // Blocks requested through the same IO are fetched with a single remote
+   // vector read, in order of offset, of up to pfc.mergereads bytes. Each
+   // block still gets its own response once the vector read completes.
+
+   const long long merge_max = Cache::GetInstance().RefConfiguration().m_mergeReadMax;
+
+   std::vector<Block*> sorted(blks.begin(), blks.end());
+   if (sorted.size() > 1 && merge_max > 0)
+   {
+      std::sort(sorted.begin(), sorted.end(), BlockIoOffsetLess);
+   }
 
-   for (BlockList_i bi = blks.begin(); bi != blks.end(); ++bi)
+   size_t i = 0;
+   while (i < sorted.size())
    {
-      Block *b = *bi;
-      BlockResponseHandler* oucCB = new BlockResponseHandler(b, prefetch);
-      b->get_io()->GetInput()->Read(*oucCB, b->get_buff(), b->get_offset(), b->get_size());
+      // Find the run of blocks that can be merged with sorted[i].
+      size_t    j     = i + 1;
+      long long bytes = sorted[i]->get_size();
+      int       n_ch  = (sorted[i]->get_size() - 1) / MaxReadVChunk + 1;
+      while (j < sorted.size() && sorted[j]->get_io() == sorted[i]->get_io())
+      {
+         int nc = (sorted[j]->get_size() - 1) / MaxReadVChunk + 1;
+         if (bytes + sorted[j]->get_size() > merge_max || n_ch + nc > MaxReadVChunks) break;
+         bytes += sorted[j]->get_size();
+         n_ch  += nc;
+         ++j;
+      }
+
+      if (j - i == 1)
+      {
+         ProcessBlockRequest(sorted[i], prefetch);
+      }
+      else
+      {
+         MultiBlockResponseHandler *oucCB = new MultiBlockResponseHandler(prefetch);
+         oucCB->m_blocks.assign(sorted.begin() + i, sorted.begin() + j);
+         oucCB->m_iovec.reserve(n_ch);
+         for (size_t k = i; k < j; ++k)
+         {
+            Block *b = sorted[k];
+            for (int pos = 0; pos < b->get_size(); pos += MaxReadVChunk)
+            {
+               int sz = std::min(MaxReadVChunk, b->get_size() - pos);
+               oucCB->m_iovec.push_back(XrdOucIOVec2(b->get_buff(pos), b->get_offset() + pos, sz));
+            }
+         }
+         TRACEF(Dump, "File::ProcessBlockRequests merged " << j - i << " blocks, " << bytes << " bytes, into one vector read");
+         sorted[i]->get_io()->GetInput()->ReadV(*oucCB, &oucCB->m_iovec[0], oucCB->m_iovec.size());
+      }
+
+      i = j;
    }
 }
 
@@ -565,7 +678,8 @@ int File::RequestBlocksDirect(IO *io, DirectResponseHandler *handler, IntList_t&
 //------------------------------------------------------------------------------
 
 int File::ReadBlocksFromDisk(std::list<int>& blocks,
-                             char* req_buf, long long req_off, long long req_size)
+                             char* req_buf, long long req_off, long long req_size,
+                             Stats &stats)
 {
    TRACEF(Dump, "File::ReadBlocksFromDisk " <<  blocks.size());
    const long long BS = m_cfi.GetBufferSize();
@@ -583,6 +697,28 @@ int File::ReadBlocksFromDisk(std::list<int>& blocks,
 
       overlap(*ii, BS, req_off, req_size, off, blk_off, size);
 
+      // Served from the hot tier or loaded into it with a full-block read.
+      HotTier::Entry *e;
+      char           *hot_buf;
+      int             hot_size;
+      if ((e = hot_tier_get(*ii)) != 0)
+      {
+         memcpy(req_buf + off, e->buf + blk_off, size);
+         hot_tier_release(e);
+         TRACEF(Dump, "File::ReadBlocksFromDisk block idx = " <<  *ii << " size= " << size << " from hot tier");
+         stats.m_BytesRam += size;
+         total += size;
+         continue;
+      }
+      if ((hot_buf = hot_tier_load(*ii, hot_size)) != 0)
+      {
+         memcpy(req_buf + off, hot_buf + blk_off, size);
+         hot_tier_insert(*ii, hot_buf, hot_size);
+         stats.m_BytesDisk += size;
+         total += size;
+         continue;
+      }
+
       long long rs = m_output->Read(req_buf + off, *ii * BS + blk_off -m_offset, size);
       TRACEF(Dump, "File::ReadBlocksFromDisk block idx = " <<  *ii << " size= " << size);
 
@@ -598,6 +734,7 @@ int File::ReadBlocksFromDisk(std::list<int>& blocks,
          return -EIO;
       }
 
+      stats.m_BytesDisk += rs;
       total += rs;
    }
 
@@ -606,6 +743,55 @@ int File::ReadBlocksFromDisk(std::list<int>& blocks,
 
 //------------------------------------------------------------------------------
 
+HotTier::Entry* File::hot_tier_get(int idx)
+{
+   HotTier &ht = cache()->RefHotTier();
+
+   return ht.IsEnabled() ? ht.Get(m_filename, idx) : 0;
+}
+
+void File::hot_tier_release(HotTier::Entry *e)
+{
+   char *buf = cache()->RefHotTier().Release(e);
+   if (buf) cache()->RAMBlockReleased(buf);
+}
+
+char* File::hot_tier_load(int idx, int &size)
+{
+   // Reads the whole block into a RAM buffer if the hot tier admits it.
+   // Returns 0 if it was not admitted or could not be read; the caller then
+   // reads the requested part directly.
+
+   HotTier &ht = cache()->RefHotTier();
+
+   if ( ! ht.IsEnabled() || ! ht.Admit(m_filename, idx)) return 0;
+
+   char *buf = cache()->RequestRAMBlock();
+   if ( ! buf) return 0;
+
+   const long long BS       = m_cfi.GetBufferSize();
+   const long long disk_off = idx * BS - m_offset;
+
+   size = (int) std::min(BS, m_fileSize - disk_off);
+
+   if (m_output->Read(buf, disk_off, size) != size)
+   {
+      cache()->RAMBlockReleased(buf);
+      return 0;
+   }
+
+   TRACEF(Dump, "File::hot_tier_load block idx = " <<  idx << " size= " << size);
+   return buf;
+}
+
+void File::hot_tier_insert(int idx, char *buf, int size)
+{
+   char *ret = cache()->RefHotTier().Insert(m_filename, idx, buf, size);
+   if (ret) cache()->RAMBlockReleased(ret);
+}
+
+//------------------------------------------------------------------------------
+
 int File::Read(IO *io, char* iUserBuff, long long iUserOff, int iUserSize)
 {
    const long long BS = m_cfi.GetBufferSize();
@@ -620,6 +806,20 @@ int File::Read(IO *io, char* iUserBuff, long long iUserOff, int iUserSize)
    BlockList_t blks_to_request, blks_to_process, blks_processed;
    IntList_t   blks_on_disk,    blks_direct;
 
+   std::vector<Block*> blks_user;  // downloaded into iUserBuff, to be copied out from there
+
+   // A file complete on disk is read without taking the file lock.
+   if (AtomicGet(m_fast_read))
+   {
+      for (int block_idx = idx_first; block_idx <= idx_last; ++block_idx)
+      {
+         blks_on_disk.push_back(block_idx);
+      }
+      int rc = ReadBlocksFromDisk(blks_on_disk, iUserBuff, iUserOff, iUserSize, loc_stats);
+      m_stats.AddStats(loc_stats);
+      return rc;
+   }
+
    // lock
    // loop over reqired blocks:
    //   - if on disk, ok;
@@ -643,17 +843,20 @@ int File::Read(IO *io, char* iUserBuff, long long iUserOff, int iUserSize)
       return -ENOENT;
    }
 
+   record_access(io, idx_first, idx_last, false);
+   loc_stats.m_PrefetchHit += count_prefetch_hits(idx_first, idx_last);
+
    for (int block_idx = idx_first; block_idx <= idx_last; ++block_idx)
    {
       TRACEF(Dump, "File::Read() idx " << block_idx);
-      BlockMap_i bi = m_block_map.find(block_idx);
+      Block *bi = m_block_map.Find(block_idx);
 
       // In RAM or incoming?
-      if (bi != m_block_map.end())
+      if (bi)
       {
-         inc_ref_count(bi->second);
-         TRACEF(Dump, "File::Read() " << (void*) iUserBuff << "inc_ref_count for existing block " << bi->second << " idx = " <<  block_idx);
-         blks_to_process.push_front(bi->second);
+         inc_ref_count(bi);
+         TRACEF(Dump, "File::Read() " << (void*) iUserBuff << "inc_ref_count for existing block " << bi << " idx = " <<  block_idx);
+         blks_to_process.push_front(bi);
       }
       // On disk?
       else if (m_cfi.TestBitWritten(offsetIdx(block_idx)))
@@ -664,14 +867,22 @@ int File::Read(IO *io, char* iUserBuff, long long iUserOff, int iUserSize)
       // Then we have to get it ...
       else
       {
+         // A block fully covered by the user buffer is downloaded straight
+         // into it, saving the copy from a RAM block.
+         long long user_off, off_in_block, size;
+         overlap(block_idx, BS, iUserOff, iUserSize, user_off, off_in_block, size);
+         bool  whole    = off_in_block == 0 && (size == BS || block_idx * BS + size == m_fileSize);
+         char *user_buf = whole ? iUserBuff + user_off : 0;
+
          // Is there room for one more RAM Block?
          Block *b;
-         if (cache()->RequestRAMBlock() && (b = PrepareBlockRequest(block_idx, io, false)) != 0)
+         if ((b = PrepareBlockRequest(block_idx, io, false, user_buf)) != 0)
          {
-            TRACEF(Dump, "File::Read() inc_ref_count new " <<  (void*)iUserBuff << " idx = " << block_idx);
+            TRACEF(Dump, "File::Read() inc_ref_count new " <<  (void*)iUserBuff << " idx = " << block_idx << " user_buff " << whole);
             inc_ref_count(b);
             blks_to_process.push_back(b);
             blks_to_request.push_back(b);
+            if (whole) blks_user.push_back(b);
          }
          // Nope ... read this directly without caching.
          else
@@ -706,12 +917,11 @@ int File::Read(IO *io, char* iUserBuff, long long iUserOff, int iUserSize)
    // Second, read blocks from disk.
    if ( ! blks_on_disk.empty() && bytes_read >= 0)
    {
-      int rc = ReadBlocksFromDisk(blks_on_disk, iUserBuff, iUserOff, iUserSize);
+      int rc = ReadBlocksFromDisk(blks_on_disk, iUserBuff, iUserOff, iUserSize, loc_stats);
       TRACEF(Dump, "File::Read() " << (void*)iUserBuff <<" from disk finished size = " << rc);
       if (rc >= 0)
       {
          bytes_read += rc;
-         loc_stats.m_BytesDisk += rc;
       }
       else
       {
@@ -726,6 +936,25 @@ int File::Read(IO *io, char* iUserBuff, long long iUserOff, int iUserSize)
    {
       BlockList_t finished;
       BlockList_t to_reissue;
+
+      // Downloaded blocks are picked up without the file lock. It is only
+      // needed to handle failed blocks or to wait for more to arrive.
+      BlockList_i bi = blks_to_process.begin();
+      while (bi != blks_to_process.end())
+      {
+         if ((*bi)->is_ok())
+         {
+            finished.push_back(*bi);
+            BlockList_i bj = bi++;
+            blks_to_process.erase(bj);
+         }
+         else
+         {
+            ++bi;
+         }
+      }
+
+      if (finished.empty())
       {
          XrdSysCondVarHelper _lck(m_downloadCond);
 
@@ -764,7 +993,11 @@ int File::Read(IO *io, char* iUserBuff, long long iUserOff, int iUserSize)
       ProcessBlockRequests(to_reissue, false);
       to_reissue.clear();
 
-      BlockList_i bi = finished.begin();
+      // Blocks that live in the buffer of another Read() are let go of as
+      // soon as they have been copied, as that Read() waits for them.
+      BlockList_t foreign;
+
+      bi = finished.begin();
       while (bi != finished.end())
       {
          if ((*bi)->is_ok())
@@ -776,7 +1009,10 @@ int File::Read(IO *io, char* iUserBuff, long long iUserOff, int iUserSize)
             overlap((*bi)->m_offset/BS, BS, iUserOff, iUserSize, user_off, off_in_block, size_to_copy);
 
             TRACEF(Dump, "File::Read() ub=" << (void*)iUserBuff  << " from finished block " << (*bi)->m_offset/BS << " size " << size_to_copy);
-            memcpy(&iUserBuff[user_off], &((*bi)->m_buff[off_in_block]), size_to_copy);
+            if ((*bi)->m_buff != &iUserBuff[user_off])
+            {
+               memcpy(&iUserBuff[user_off], &((*bi)->m_buff[off_in_block]), size_to_copy);
+            }
             bytes_read += size_to_copy;
             loc_stats.m_BytesRam += size_to_copy;
             if ((*bi)->m_prefetch)
@@ -792,11 +1028,80 @@ int File::Read(IO *io, char* iUserBuff, long long iUserOff, int iUserSize)
                       " finished with error " << -error_cond << " " << strerror(-error_cond));
             }
          }
-         ++bi;
+         if ((*bi)->m_user_buff && std::find(blks_user.begin(), blks_user.end(), *bi) == blks_user.end())
+         {
+            foreign.push_back(*bi);
+            BlockList_i bj = bi++;
+            finished.erase(bj);
+         }
+         else
+         {
+            ++bi;
+         }
       }
 
       std::copy(finished.begin(), finished.end(), std::back_inserter(blks_processed));
       finished.clear();
+
+      if ( ! foreign.empty())
+      {
+         XrdSysCondVarHelper _lck(m_downloadCond);
+
+         for (BlockList_i fi = foreign.begin(); fi != foreign.end(); ++fi)
+         {
+            dec_ref_count(*fi);
+         }
+      }
+   }
+
+   // Blocks that were downloaded into the user buffer are copied into pool
+   // blocks and queued for writing, so the read does not wait for the disk.
+   // Without a free pool block or with a congested write queue they are not
+   // cached. Other readers only hold on to them while copying, so the wait
+   // is short.
+   if ( ! blks_user.empty())
+   {
+      const bool congested = cache()->IsWriteQueueCongested(m_writeQ_idx);
+
+      std::vector<char*> copies(blks_user.size(), (char*) 0);
+      for (size_t i = 0; i < blks_user.size(); ++i)
+      {
+         if (congested || ! blks_user[i]->is_ok()) continue;
+
+         if ((copies[i] = cache()->RequestRAMBlock()) != 0)
+         {
+            memcpy(copies[i], blks_user[i]->get_buff(), blks_user[i]->get_size());
+         }
+      }
+
+      XrdSysCondVarHelper _lck(m_downloadCond);
+
+      for (size_t i = 0; i < blks_user.size(); ++i)
+      {
+         Block *b = blks_user[i];
+         while (b->m_refcnt > 1 || ! b->is_finished())
+         {
+            m_downloadCond.Wait();
+         }
+
+         // Nobody else is using the block now, so it can be switched to the
+         // copy. Readers that find it later use the copy too.
+         if (copies[i] && ! m_in_shutdown)
+         {
+            b->m_buff      = copies[i];
+            b->m_user_buff = false;
+            inc_ref_count(b);
+            cache()->AddWriteTask(b, true);
+         }
+         else if (copies[i])
+         {
+            cache()->RAMBlockReleased(copies[i]);
+         }
+
+         blks_processed.remove(b);
+         blks_to_process.remove(b);
+         dec_ref_count(b);
+      }
    }
 
    // Fourth, make sure all direct requests have arrived.
@@ -851,7 +1156,8 @@ int File::Read(IO *io, char* iUserBuff, long long iUserOff, int iUserSize)
          if (m_cfi.TestBitPrefetch(offsetIdx(*d)))
             m_prefetchHitCnt++;
       }
-      m_prefetchScore = float(m_prefetchHitCnt)/m_prefetchReadCnt;
+      update_prefetch_score();
+      update_prefetch_priority();
    }
 
    m_stats.AddStats(loc_stats);
@@ -881,6 +1187,65 @@ void File::WriteBlockToDisk(Block* b)
          TRACEF(Error, "File::WriteToDisk() incomplete block write ret=" << retval << " (should be " << size << ")");
       }
 
+      block_written(b, false);
+
+      return;
+   }
+
+   block_written(b, true);
+}
+
+//------------------------------------------------------------------------------
+
+void File::WriteBlocksToDisk(Block** blks, int n)
+{
+   // Blocks are adjacent and in order. When the oss exposes a file descriptor
+   // they are written with a single pwritev(), otherwise one by one.
+
+   int fd = (n > 1 && n <= IOV_MAX) ? m_output->getFD() : -1;
+
+   if (fd < 0)
+   {
+      for (int i = 0; i < n; ++i) WriteBlockToDisk(blks[i]);
+      return;
+   }
+
+   std::vector<struct iovec> iov(n);
+   long long offset = blks[0]->m_offset - m_offset;
+   long long size   = 0;
+   for (int i = 0; i < n; ++i)
+   {
+      long long blk_off  = blks[i]->m_offset - m_offset;
+      long long blk_size = (blk_off + m_cfi.GetBufferSize()) > m_fileSize ? (m_fileSize - blk_off) : m_cfi.GetBufferSize();
+
+      iov[i].iov_base = blks[i]->m_buff;
+      iov[i].iov_len  = blk_size;
+      size += blk_size;
+   }
+
+   ssize_t retval;
+   do { retval = pwritev(fd, &iov[0], n, offset); } while (retval < 0 && errno == EINTR);
+
+   if (retval < size)
+   {
+      // Retry block by block to get proper error reporting for each of them.
+      TRACEF(Warning, "File::WriteBlocksToDisk() vector write of " << n << " blocks returned " << retval <<
+             " (should be " << size << "), writing blocks one by one");
+      for (int i = 0; i < n; ++i) WriteBlockToDisk(blks[i]);
+      return;
+   }
+
+   TRACEF(Dump, "File::WriteBlocksToDisk() wrote " << n << " blocks at offset " << offset << " size=" << size);
+
+   for (int i = 0; i < n; ++i) block_written(blks[i], true);
+}
+
+//------------------------------------------------------------------------------
+
+void File::block_written(Block* b, bool ok)
+{
+   if ( ! ok)
+   {
       XrdSysCondVarHelper _lck(m_downloadCond);
 
       dec_ref_count(b);
@@ -891,7 +1256,7 @@ void File::WriteBlockToDisk(Block* b)
    const int blk_idx =  (b->m_offset - m_offset) / m_cfi.GetBufferSize();
 
    // Set written bit.
-   TRACEF(Dump, "File::WriteToDisk() success set bit for block " <<  b->m_offset << " size=" <<  size);
+   TRACEF(Dump, "File::WriteToDisk() success set bit for block " <<  b->m_offset);
 
    bool schedule_sync = false;
    {
@@ -902,6 +1267,8 @@ void File::WriteBlockToDisk(Block* b)
       if (b->m_prefetch)
          m_cfi.SetBitPrefetch(blk_idx);
 
+      update_fast_read();
+
       dec_ref_count(b);
 
       // Set synced bit or stash block index if in actual sync.
@@ -1007,6 +1374,11 @@ void File::dec_ref_count(Block* b)
    {
       free_block(b);
    }
+   // The Read() owning a user buffer block waits for other readers to let go.
+   else if (b->m_user_buff && b->m_refcnt == 1)
+   {
+      m_downloadCond.Broadcast();
+   }
 }
 
 void File::free_block(Block* b)
@@ -1014,19 +1386,18 @@ void File::free_block(Block* b)
    // Method always called under lock.
    int i = b->m_offset / BufferSize();
    TRACEF(Dump, "File::free_block block " << b << "  idx =  " <<  i);
-   size_t ret = m_block_map.erase(i);
-   if (ret != 1)
+   if ( ! m_block_map.Erase(i))
    {
       // assert might be a better option than a warning
       TRACEF(Error, "File::free_block did not erase " <<  i  << " from map");
    }
    else
    {
+      if ( ! b->m_user_buff) cache()->RAMBlockReleased(b->m_buff);
       delete b;
-      cache()->RAMBlockReleased();
    }
 
-   if (m_prefetchState == kHold && (int) m_block_map.size() < Cache::GetInstance().RefConfiguration().m_prefetch_max_blocks)
+   if (m_prefetchState == kHold && m_block_map.Size() < Cache::GetInstance().RefConfiguration().m_prefetch_max_blocks)
    {
       m_prefetchState = kOn;
       cache()->RegisterPrefetchFile(this);
@@ -1081,16 +1452,14 @@ bool File::select_current_io_or_disable_prefetching(bool skip_current)
 
 //------------------------------------------------------------------------------
 
-void File::ProcessBlockResponse(BlockResponseHandler* brh, int res)
+void File::ProcessBlockResponse(Block *b, bool for_prefetch, int res)
 {
    XrdSysCondVarHelper _lck(m_downloadCond);
 
-   Block *b = brh->m_block;
-
    TRACEF(Dump, "File::ProcessBlockResponse " << (void*)b << "  " << b->m_offset/BufferSize());
 
    // Deregister block from IO's prefetch count, if needed.
-   if (brh->m_for_prefetch)
+   if (for_prefetch)
    {
       IoMap_i mi = m_io_map.find(b->get_io());
       if (mi != m_io_map.end())
@@ -1104,7 +1473,7 @@ void File::ProcessBlockResponse(BlockResponseHandler* brh, int res)
             mi->second.m_allow_prefetching = false;
 
             // Check if any IO is still available for prfetching. If not, stop it.
-            if (m_prefetchState == kOn || m_prefetchState == kHold)
+            if (m_prefetchState == kOn || m_prefetchState == kHold || m_prefetchState == kPaused)
             {
                if ( ! select_current_io_or_disable_prefetching(false) )
                {
@@ -1128,9 +1497,10 @@ void File::ProcessBlockResponse(BlockResponseHandler* brh, int res)
    if (res >= 0)
    {
       b->set_downloaded();
-      // Increase ref-count for the writer.
+      // Increase ref-count for the writer. Blocks in a user buffer are
+      // queued by the Read() that owns the buffer.
       TRACEF(Dump, "File::ProcessBlockResponse inc_ref_count " <<  (int)(b->m_offset/BufferSize()));
-      if ( ! m_in_shutdown)
+      if ( ! m_in_shutdown && ! b->m_user_buff)
       {
          inc_ref_count(b);
          cache()->AddWriteTask(b, true);
@@ -1170,9 +1540,10 @@ int File::offsetIdx(int iIdx)
 
 void File::Prefetch()
 {
-   // Check that block is not on disk and not in RAM.
-   // TODO: Could prefetch several blocks at once!
-   //       blks_max could be an argument
+   // Prefetch one block along the access pattern of one of the IOs, taking
+   // them in turn. See select_prefetch_block() for how the block is chosen.
+   // When no IO has a block to prefetch, prefetching is paused until a read
+   // reveals a pattern worth following again.
 
    BlockList_t blks;
 
@@ -1191,32 +1562,71 @@ void File::Prefetch()
          return;
       }
 
-      // Select block(s) to fetch.
-      for (int f = 0; f < m_cfi.GetSizeInBits(); ++f)
+      // Select block to fetch.
+      bool    complete = false;
+      IoMap_i mi       = m_current_io;
+      for (int i = 0; i < (int) m_io_map.size(); ++i, ++mi)
       {
-         if ( ! m_cfi.TestBitWritten(f))
+         if (mi == m_io_map.end()) mi = m_io_map.begin();
+
+         if ( ! mi->second.m_allow_prefetching) continue;
+
+         int f_act = select_prefetch_block(mi->second, complete);
+         if (f_act < 0)
          {
-            int f_act = f + m_offset / m_cfi.GetBufferSize();
+            if (complete) break;
+            continue;
+         }
 
-            BlockMap_i bi = m_block_map.find(f_act);
-            if (bi == m_block_map.end())
-            {
-               TRACEF(Dump, "File::Prefetch take block " << f_act);
-               cache()->RequestRAMBlock();
-               blks.push_back( PrepareBlockRequest(f_act, m_current_io->first, true) );
-               m_prefetchReadCnt++;
-               m_prefetchScore = float(m_prefetchHitCnt)/m_prefetchReadCnt;
-               break;
-            }
+         TRACEF(Dump, "File::Prefetch take block " << f_act);
+         Block *b = PrepareBlockRequest(f_act, mi->first, true);
+         if ( ! b)
+         {
+            TRACEF(Error, "File::Prefetch failed to allocate block " << f_act);
+            return;
+         }
+         m_current_io = mi;
+         blks.push_back(b);
+         m_prefetchUnread.insert(f_act);
+         m_prefetchReadCnt++;
+
+         // Take the following blocks along the same access pattern too, as
+         // long as they are adjacent and RAM is available without exceeding
+         // the pool limit, so they are fetched in one request.
+         const int n_merge = Cache::GetInstance().RefConfiguration().m_mergeReadMax / BufferSize();
+         bool      dummy;
+         while (m_prefetchState == kOn && (int) blks.size() < n_merge)
+         {
+            int f_next = select_prefetch_block(mi->second, dummy);
+            if (f_next != f_act + 1) break;
+
+            Block *nb = PrepareBlockRequest(f_next, mi->first, true, 0, false);
+            if ( ! nb) break;
+
+            TRACEF(Dump, "File::Prefetch take adjacent block " << f_next);
+            blks.push_back(nb);
+            m_prefetchUnread.insert(f_next);
+            m_prefetchReadCnt++;
+            f_act = f_next;
          }
+
+         update_prefetch_score();
+         update_prefetch_priority();
+         break;
       }
 
-      if (blks.empty())
+      if (blks.empty() && complete)
       {
          TRACEF(Debug, "File::Prefetch file is complete, stopping prefetch.");
          m_prefetchState = kComplete;
          cache()->DeRegisterPrefetchFile(this);
       }
+      else if (blks.empty())
+      {
+         TRACEF(Debug, "File::Prefetch nothing to prefetch along current access patterns, pausing prefetch.");
+         m_prefetchState = kPaused;
+         cache()->DeRegisterPrefetchFile(this);
+      }
       else
       {
          m_current_io->second.m_active_prefetches += (int) blks.size();
@@ -1237,6 +1647,183 @@ float File::GetPrefetchScore() const
    return m_prefetchScore;
 }
 
+//------------------------------------------------------------------------------
+
+void File::record_access(IO *io, int blk_first, int blk_last, bool sparse)
+{
+   // Method always called under lock.
+   //
+   // Classify the reads of an IO. A read that starts in the block where the
+   // previous one ended, or in the next one, is sequential. A read that starts
+   // the same distance past the previous one as the time before is strided.
+   // Anything else, including a sparse vector read, counts toward random.
+
+   IoMap_i mi = m_io_map.find(io);
+   if (mi == m_io_map.end()) return;
+
+   IODetails &iod = mi->second;
+
+   if (sparse)
+   {
+      iod.m_stride_cnt = 0;
+      ++iod.m_random_cnt;
+   }
+   else if (iod.m_last_block >= 0)
+   {
+      const int delta = blk_first - iod.m_last_block;
+
+      if (delta == 0 || delta == 1)
+      {
+         if (iod.m_stride != 1) iod.m_stride_cnt = 0;
+         iod.m_stride = 1;
+         ++iod.m_stride_cnt;
+         iod.m_random_cnt = 0;
+      }
+      else if (delta == iod.m_stride)
+      {
+         ++iod.m_stride_cnt;
+         iod.m_random_cnt = 0;
+      }
+      else
+      {
+         iod.m_stride     = delta;
+         iod.m_stride_cnt = 1;
+         ++iod.m_random_cnt;
+      }
+   }
+   iod.m_last_block = blk_last;
+   iod.m_width      = blk_last - blk_first + 1;
+
+   update_prefetch_priority();
+
+   // Resume paused prefetching if this IO is worth prefetching for.
+   if (m_prefetchState == kPaused && iod.m_allow_prefetching && ! iod.is_random())
+   {
+      m_prefetchState = kOn;
+      cache()->RegisterPrefetchFile(this);
+   }
+}
+
+//------------------------------------------------------------------------------
+
+int File::count_prefetch_hits(int blk_first, int blk_last)
+{
+   // Method always called under lock.
+
+   int n = 0;
+   if (m_prefetchUnread.empty()) return n;
+
+   for (int i = blk_first; i <= blk_last; ++i)
+   {
+      n += m_prefetchUnread.erase(i);
+   }
+   if (m_prefetchUnread.empty()) update_fast_read();
+   return n;
+}
+
+//------------------------------------------------------------------------------
+
+void File::update_fast_read()
+{
+   // Method always called under lock.
+   //
+   // Reads can bypass the lock once all blocks are on disk and there are no
+   // prefetched blocks left whose first read is to be counted as a hit.
+
+   bool fast = ! m_in_shutdown && m_cfi.IsComplete() && m_prefetchUnread.empty();
+
+   AtomicCAS(m_fast_read, fast ? 0 : 1, fast ? 1 : 0);
+}
+
+//------------------------------------------------------------------------------
+
+int File::select_prefetch_block(const IODetails &iod, bool &complete)
+{
+   // Method always called under lock.
+   //
+   // Returns the next block to prefetch for an IO or -1 if there is none.
+   // - Random access: no prefetching.
+   // - Strided access: the blocks of the next m_prefetch_max_blocks reads,
+   //   assuming each spans as many blocks as the last one.
+   // - Sequential access: the first missing block after the last read,
+   //   wrapping around to the start of the file. If there is none, complete
+   //   is set as all blocks are on disk or on their way.
+   // - Access not yet known: as sequential but at most m_prefetch_max_blocks
+   //   past the last read and without wrapping.
+
+   if (iod.is_random()) return -1;
+
+   const int n_blks  = m_cfi.GetSizeInBits();
+   const int blk_min = m_offset / m_cfi.GetBufferSize();
+   const int blk_max = blk_min + n_blks - 1;
+   const int n_ahead = Cache::GetInstance().RefConfiguration().m_prefetch_max_blocks;
+
+   if (iod.is_strided())
+   {
+      const int period  = iod.m_stride + iod.m_width - 1;
+
+      int first = iod.m_last_block + iod.m_stride;
+      for (int k = 0; k < n_ahead; ++k, first += period)
+      {
+         if (first + iod.m_width - 1 < blk_min || first > blk_max) break;
+
+         for (int blk = first; blk < first + iod.m_width; ++blk)
+         {
+            if (blk < blk_min || blk > blk_max) continue;
+
+            if ( ! m_cfi.TestBitWritten(offsetIdx(blk)) && ! m_block_map.Find(blk))
+            {
+               return blk;
+            }
+         }
+      }
+      return -1;
+   }
+
+   const bool seq   = iod.is_sequential();
+   const int  start = (iod.m_last_block >= blk_min && iod.m_last_block < blk_max) ? iod.m_last_block + 1 : blk_min;
+   for (int i = 0; i < n_blks; ++i)
+   {
+      int blk = start + i;
+      if ( ! seq && (i >= n_ahead || blk > blk_max)) return -1;
+      if (blk > blk_max) blk -= n_blks;
+
+      if ( ! m_cfi.TestBitWritten(offsetIdx(blk)) && ! m_block_map.Find(blk))
+      {
+         return blk;
+      }
+   }
+   complete = true;
+   return -1;
+}
+
+//------------------------------------------------------------------------------
+
+void File::update_prefetch_score()
+{
+   // Method always called under lock.
+
+   // Blocks prefetched for a newly opened file are only read some time later.
+   // Until enough of them have been prefetched for the reads to catch up, the
+   // file keeps the full score so it is not passed over under RAM pressure.
+   if (m_prefetchReadCnt > s_prefetchWarmUp)
+      m_prefetchScore = float(m_prefetchHitCnt) / m_prefetchReadCnt;
+}
+
+//------------------------------------------------------------------------------
+
+void File::update_prefetch_priority()
+{
+   // Method always called under lock.
+
+   int n_streams = 0;
+   for (IoMap_i mi = m_io_map.begin(); mi != m_io_map.end(); ++mi)
+   {
+      if (mi->second.m_allow_prefetching && ! mi->second.is_random()) ++n_streams;
+   }
+   m_prefetchPriority = m_prefetchScore * n_streams;
+}
+
 XrdSysError* File::GetLog()
 {
    return Cache::GetInstance().GetLog();
@@ -1253,7 +1840,22 @@ XrdSysTrace* File::GetTrace()
 
 void BlockResponseHandler::Done(int res)
 {
-   m_block->m_file->ProcessBlockResponse(this, res);
+   m_block->m_file->ProcessBlockResponse(m_block, m_for_prefetch, res);
+
+   delete this;
+}
+
+//------------------------------------------------------------------------------
+
+void MultiBlockResponseHandler::Done(int res)
+{
+   // A vector read either reads everything or fails as a whole. The File
+   // may go away once its last block has been processed.
+
+   for (std::vector<Block*>::iterator i = m_blocks.begin(); i != m_blocks.end(); ++i)
+   {
+      (*i)->m_file->ProcessBlockResponse(*i, m_for_prefetch, res < 0 ? res : (*i)->get_size());
+   }
 
    delete this;
 }
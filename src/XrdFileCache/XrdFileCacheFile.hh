@@ -23,12 +23,17 @@
 
 #include "XrdOuc/XrdOucCache2.hh"
 #include "XrdOuc/XrdOucIOVec.hh"
+#include "XrdSys/XrdSysAtomics.hh"
 
 #include "XrdFileCacheInfo.hh"
 #include "XrdFileCacheStats.hh"
+#include "XrdFileCacheHotTier.hh"
+#include "XrdFileCacheBlockIndex.hh"
 
 #include <string>
 #include <map>
+#include <set>
+#include <vector>
 
 class XrdJob;
 class XrdOucIOVec;
@@ -41,6 +46,7 @@ class Log;
 namespace XrdFileCache
 {
 class BlockResponseHandler;
+class MultiBlockResponseHandler;
 class DirectResponseHandler;
 class IO;
 
@@ -59,40 +65,43 @@ class File;
 class Block
 {
 public:
-   std::vector<char>   m_buff;
+   char               *m_buff;          // from Cache's RAM block pool or the user's buffer, not owned
+   int                 m_size;
    long long           m_offset;
    File               *m_file;
    IO                 *m_io;            // IO that handled current request, used for == / != comparisons only
 
    int                 m_refcnt;
    int                 m_errno;         // stores negative errno
-   bool                m_downloaded;
+   int                 m_downloaded;
    bool                m_prefetch;
+   bool                m_user_buff;     // m_buff is part of the buffer of the File::Read() that created the block,
+                                        // until that Read() moves the data into a pool block for writing
 
-   Block(File *f, IO *io, long long off, int size, bool m_prefetch) :
-      m_offset(off), m_file(f), m_io(io), m_refcnt(0),
-      m_errno(0), m_downloaded(false), m_prefetch(m_prefetch)
-   {
-      m_buff.resize(size);
-   }
+   Block(File *f, IO *io, char *buf, long long off, int size, bool m_prefetch, bool user_buff = false) :
+      m_buff(buf), m_size(size), m_offset(off), m_file(f), m_io(io), m_refcnt(0),
+      m_errno(0), m_downloaded(0), m_prefetch(m_prefetch), m_user_buff(user_buff)
+   {}
 
-   char*     get_buff(long long pos = 0) { return &m_buff[pos];        }
-   int       get_size()                  { return (int) m_buff.size(); }
-   long long get_offset()                { return m_offset;            }
+   char*     get_buff(long long pos = 0) { return m_buff + pos; }
+   int       get_size()                  { return m_size;       }
+   long long get_offset()                { return m_offset;     }
 
    IO*  get_io() const { return m_io; }
 
-   bool is_finished() { return m_downloaded || m_errno != 0; }
-   bool is_ok()       { return m_downloaded; }
-   bool is_failed()   { return m_errno != 0; }
+   // The download state is changed under the file's lock but can be
+   // queried without it.
+   bool is_finished() { return AtomicGet(m_downloaded) || AtomicGet(m_errno) != 0; }
+   bool is_ok()       { return AtomicGet(m_downloaded); }
+   bool is_failed()   { return AtomicGet(m_errno) != 0; }
 
-   void set_downloaded()    { m_downloaded = true; }
-   void set_error(int err)  { m_errno      = err;  }
+   void set_downloaded()    { AtomicCAS(m_downloaded, 0, 1);  }
+   void set_error(int err)  { AtomicCAS(m_errno, 0, err); }
 
    void reset_error_and_set_io(IO *io)
    {
-      m_errno = 0;
       m_io    = io;
+      AtomicZAP(m_errno);
    }
 };
 
@@ -112,6 +121,21 @@ public:
 
 // ================================================================
 
+class MultiBlockResponseHandler : public XrdOucCacheIOCB
+{
+public:
+   std::vector<Block*>      m_blocks;
+   std::vector<XrdOucIOVec> m_iovec;   // one or more chunks per block
+   bool                     m_for_prefetch;
+
+   MultiBlockResponseHandler(bool prefetch) :
+      m_for_prefetch(prefetch) {}
+
+   virtual void Done(int result);
+};
+
+// ================================================================
+
 class DirectResponseHandler : public XrdOucCacheIOCB
 {
 public:
@@ -196,13 +220,24 @@ public:
    //----------------------------------------------------------------------
    Stats& GetStats() { return m_stats; }
 
-   void ProcessBlockResponse(BlockResponseHandler* brh, int res);
+   void ProcessBlockResponse(Block* b, bool for_prefetch, int res);
    void WriteBlockToDisk(Block* b);
 
+   //----------------------------------------------------------------------
+   //! Write n blocks that follow each other in the file with one call.
+   //----------------------------------------------------------------------
+   void WriteBlocksToDisk(Block** blks, int n);
+
    void Prefetch();
 
    float GetPrefetchScore() const;
 
+   //----------------------------------------------------------------------
+   //! Expected benefit of prefetching for this file: prefetch score times
+   //! the number of IOs reading sequentially or with a stride. Cached.
+   //----------------------------------------------------------------------
+   float GetPrefetchPriority() const { return m_prefetchPriority; }
+
    //! Log path
    const char* lPath() const;
 
@@ -213,6 +248,13 @@ public:
 
    long long GetFileSize() { return m_fileSize; }
 
+   //! Index of Cache's write queue for the device holding the data file.
+   int GetWriteQueueIdx() const { return m_writeQ_idx; }
+
+   //! Bytes downloaded and number of recorded accesses, from the cinfo.
+   long long GetNDownloadedBytes() const { return m_cfi.GetNDownloadedBytes(); }
+   int       GetAccessCnt()              { return (int) m_cfi.GetAccessCnt(); }
+
    void AddIO(IO *io);
    int  GetPrefetchCountOnIO(IO *io);
    void StopPrefetchingOnIO(IO *io);
@@ -230,18 +272,20 @@ public:
    bool is_in_emergency_shutdown() { return m_in_shutdown; }
 
 private:
-   enum PrefetchState_e { kOff=-1, kOn, kHold, kStopped, kComplete };
+   enum PrefetchState_e { kOff=-1, kOn, kHold, kStopped, kComplete, kPaused };
 
    int            m_ref_cnt;            //!< number of references from IO or sync
    
    bool           m_is_open;            //!< open state (presumably not needed anymore)
    bool           m_in_shutdown;        //!< file is in emergency shutdown due to irrecoverable error or unlink request
+   int            m_fast_read;          //!< all blocks on disk and no prefetch stats to collect, reads need no lock
 
    XrdOssDF      *m_output;             //!< file handle for data file on disk
    XrdOssDF      *m_infoFile;           //!< file handle for data-info file on disk
    Info           m_cfi;                //!< download status of file blocks and access statistics
 
    std::string    m_filename;           //!< filename of data file on disk
+   int            m_writeQ_idx;         //!< write queue for the device of the data file
    long long      m_offset;             //!< offset of cached file for block-based / hdfs operation
    long long      m_fileSize;           //!< size of cached disk file for block-based operation
 
@@ -253,7 +297,19 @@ private:
       bool   m_allow_prefetching;
       bool   m_ioactive_false_reported;
 
-      IODetails() : m_active_prefetches(0), m_allow_prefetching(true), m_ioactive_false_reported(false) {}
+      // Access pattern of reads through this IO, used to steer prefetching.
+      int    m_last_block;      //!< last block of the previous read, -1 if none
+      int    m_width;           //!< number of blocks spanned by the previous read
+      int    m_stride;          //!< distance from previous to current read, in blocks
+      int    m_stride_cnt;      //!< number of consecutive reads at m_stride
+      int    m_random_cnt;      //!< number of consecutive reads matching no pattern
+
+      IODetails() : m_active_prefetches(0), m_allow_prefetching(true), m_ioactive_false_reported(false),
+                    m_last_block(-1), m_width(1), m_stride(1), m_stride_cnt(0), m_random_cnt(0) {}
+
+      bool is_random()     const { return m_random_cnt >= 3; }
+      bool is_sequential() const { return m_stride == 1 && m_stride_cnt >= 2; }
+      bool is_strided()    const { return m_stride != 1 && m_stride_cnt >= 2; }
    };
 
    typedef std::map<IO*, IODetails> IoMap_t;
@@ -274,11 +330,7 @@ private:
    typedef std::list<Block*>     BlockList_t;
    typedef BlockList_t::iterator BlockList_i;
 
-   typedef std::map<int, Block*> BlockMap_t;
-   typedef BlockMap_t::iterator  BlockMap_i;
-
-
-   BlockMap_t m_block_map;
+   BlockIndex m_block_map;              //!< blocks in RAM or incoming, by block index
 
    XrdSysCondVar m_downloadCond;
 
@@ -288,11 +340,15 @@ private:
 
    int   m_prefetchReadCnt;
    int   m_prefetchHitCnt;
-   float m_prefetchScore;              // cached
+   float m_prefetchScore;              // cached, 1 during warm-up
+   float m_prefetchPriority;           // cached
+
+   std::set<int> m_prefetchUnread;     //!< blocks prefetched since open and not yet read
    
    bool  m_detachTimeIsLogged;
 
    static const char *m_traceID;
+   static const int   s_prefetchWarmUp = 32; //!< prefetched blocks before score counts
    bool overlap(int blk,               // block to query
                 long long blk_size,    //
                 long long req_off,     // offset of user request
@@ -303,7 +359,7 @@ private:
                 long long &size);
 
    // Read
-   Block* PrepareBlockRequest(int i, IO *io, bool prefetch);
+   Block* PrepareBlockRequest(int i, IO *io, bool prefetch, char *user_buf = 0, bool force_ram = true);
    
    void   ProcessBlockRequest (Block       *b,    bool prefetch);
    void   ProcessBlockRequests(BlockList_t& blks, bool prefetch);
@@ -312,7 +368,14 @@ private:
                               char* buff, long long req_off, long long req_size);
 
    int    ReadBlocksFromDisk(IntList_t& blocks,
-                             char* req_buf, long long req_off, long long req_size);
+                             char* req_buf, long long req_off, long long req_size,
+                             Stats &stats);
+
+   // Hot tier of recently read disk blocks
+   HotTier::Entry* hot_tier_get(int idx);
+   void            hot_tier_release(HotTier::Entry *e);
+   char*           hot_tier_load(int idx, int &size);
+   void            hot_tier_insert(int idx, char *buf, int size);
 
    // VRead
    bool VReadValidate     (const XrdOucIOVec *readV, int n);
@@ -322,7 +385,8 @@ private:
                            ReadVBlockListDisk& blks_on_disk,
                            std::vector<XrdOucIOVec>& chunkVec);
    int  VReadFromDisk     (const XrdOucIOVec *readV, int n,
-                           ReadVBlockListDisk& blks_on_disk);
+                           ReadVBlockListDisk& blks_on_disk,
+                           Stats &stats);
    int  VReadProcessBlocks(IO *io, const XrdOucIOVec *readV, int n,
                            std::vector<ReadVChunkListRAM>& blks_to_process,
                            std::vector<ReadVChunkListRAM>& blks_rocessed);
@@ -333,8 +397,18 @@ private:
    void dec_ref_count(Block*);
    void free_block(Block*);
 
+   void block_written(Block*, bool ok);
+
    bool select_current_io_or_disable_prefetching(bool skip_current);
 
+   // Access pattern tracking and prefetch block selection
+   void record_access(IO *io, int blk_first, int blk_last, bool sparse);
+   int  count_prefetch_hits(int blk_first, int blk_last);
+   void update_fast_read();
+   int  select_prefetch_block(const IODetails &iod, bool &complete);
+   void update_prefetch_score();
+   void update_prefetch_priority();
+
    int  offsetIdx(int idx);
 };
 
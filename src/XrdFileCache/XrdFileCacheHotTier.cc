@@ -0,0 +1,281 @@
+//----------------------------------------------------------------------------------
+// Copyright (c) 2019 by Board of Trustees of the Leland Stanford, Jr., University
+// Author: Alja Mrak-Tadel, Matevz Tadel, Brian Bockelman
+//----------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//----------------------------------------------------------------------------------
+
+#include <limits.h>
+#include <stdio.h>
+
+#include <functional>
+
+#include "XrdSys/XrdSysTrace.hh"
+#include "XrdFileCacheHotTier.hh"
+#include "XrdFileCacheTrace.hh"
+
+using namespace XrdFileCache;
+
+namespace
+{
+unsigned long long Mix(unsigned long long x)
+{
+   // splitmix64 finalizer
+   x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+   x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+   x ^= x >> 31;
+   return x;
+}
+
+const int           MaxCount      = 15;   // counters are 4 bits wide
+const int           MinAdmitCount = 2;    // a block must be seen twice to be admitted
+const int           VictimScan    = 8;    // unpinned eviction candidates looked at
+}
+
+const char *HotTier::m_traceID = "HotTier";
+
+//------------------------------------------------------------------------------
+
+HotTier::HotTier() :
+   m_trace(0),
+   m_max_blocks(0),
+   m_sketch_mask(0),
+   m_samples(0),
+   m_sample_max(0),
+   m_n_hits(0), m_n_misses(0), m_n_admitted(0), m_n_rejected(0), m_n_evicted(0)
+{}
+
+void HotTier::Init(int max_blocks, XrdSysTrace *trace)
+{
+   XrdSysMutexHelper lock(&m_mutex);
+
+   m_trace      = trace;
+   m_max_blocks = max_blocks;
+
+   if (m_max_blocks <= 0) return;
+
+   // About eight counters per block in each row, as suggested for TinyLFU.
+   unsigned long long width = 64;
+   while (width < 8ULL * m_max_blocks) width <<= 1;
+
+   m_sketch.assign(s_sketchRows * width, 0);
+   m_sketch_mask = width - 1;
+   m_sample_max  = 10LL * m_max_blocks;
+}
+
+//------------------------------------------------------------------------------
+
+HotTier::Entry* HotTier::Get(const std::string &path, int idx)
+{
+   XrdSysMutexHelper lock(&m_mutex);
+
+   Map_i mi = m_map.find(Key_t(path, idx));
+   if (mi == m_map.end())
+   {
+      ++m_n_misses;
+      return 0;
+   }
+
+   Entry *e = mi->second;
+   increment(hash(path, idx));
+   m_lru.splice(m_lru.begin(), m_lru, e->lru);
+   ++e->pins;
+   ++m_n_hits;
+   return e;
+}
+
+char* HotTier::Release(Entry *e)
+{
+   XrdSysMutexHelper lock(&m_mutex);
+
+   if (--e->pins == 0 && e->dropped)
+   {
+      char *buf = e->buf;
+      delete e;
+      return buf;
+   }
+   return 0;
+}
+
+//------------------------------------------------------------------------------
+
+bool HotTier::Admit(const std::string &path, int idx)
+{
+   XrdSysMutexHelper lock(&m_mutex);
+
+   unsigned long long h = hash(path, idx);
+   increment(h);
+
+   int  freq  = estimate(h);
+   bool admit = false;
+
+   if (freq >= MinAdmitCount)
+   {
+      if ((int) m_map.size() < m_max_blocks)
+      {
+         admit = true;
+      }
+      else
+      {
+         Entry *v = victim();
+         admit = v && freq > estimate(hash(v->path, v->idx));
+      }
+   }
+
+   if (admit) ++m_n_admitted; else ++m_n_rejected;
+   return admit;
+}
+
+char* HotTier::Insert(const std::string &path, int idx, char *buf, int size)
+{
+   XrdSysMutexHelper lock(&m_mutex);
+
+   Key_t key(path, idx);
+   if (m_map.find(key) != m_map.end()) return buf;
+
+   char *ret = 0;
+   if ((int) m_map.size() >= m_max_blocks)
+   {
+      Entry *v = victim();
+      if ( ! v) return buf;
+
+      std::vector<char*> bufs;
+      remove(v, bufs);
+      ret = bufs.front();
+      ++m_n_evicted;
+   }
+
+   Entry *e   = new Entry;
+   e->path    = path;
+   e->idx     = idx;
+   e->buf     = buf;
+   e->size    = size;
+   e->pins    = 0;
+   e->dropped = false;
+   m_lru.push_front(e);
+   e->lru     = m_lru.begin();
+   m_map[key] = e;
+
+   return ret;
+}
+
+char* HotTier::Reclaim()
+{
+   XrdSysMutexHelper lock(&m_mutex);
+
+   Entry *v = victim();
+   if ( ! v) return 0;
+
+   std::vector<char*> bufs;
+   remove(v, bufs);
+   ++m_n_evicted;
+   return bufs.front();
+}
+
+void HotTier::Invalidate(const std::string &path, std::vector<char*> &bufs)
+{
+   XrdSysMutexHelper lock(&m_mutex);
+
+   Map_i mi = m_map.lower_bound(Key_t(path, INT_MIN));
+   while (mi != m_map.end() && mi->first.first == path)
+   {
+      Entry *e = (mi++)->second;
+      remove(e, bufs);
+   }
+}
+
+int HotTier::GetNBlocks()
+{
+   XrdSysMutexHelper lock(&m_mutex);
+   return m_map.size();
+}
+
+void HotTier::Report()
+{
+   XrdSysMutexHelper lock(&m_mutex);
+
+   if ( ! IsEnabled()) return;
+
+   char buf[256];
+   snprintf(buf, sizeof(buf), "blocks %d / %d, hits %lld, misses %lld, admitted %lld, rejected %lld, evicted %lld",
+            (int) m_map.size(), m_max_blocks, m_n_hits, m_n_misses, m_n_admitted, m_n_rejected, m_n_evicted);
+   TRACE(Info, "Report() " << buf);
+
+   m_n_hits = m_n_misses = m_n_admitted = m_n_rejected = m_n_evicted = 0;
+}
+
+//------------------------------------------------------------------------------
+// Private methods, called with m_mutex held.
+//------------------------------------------------------------------------------
+
+unsigned long long HotTier::hash(const std::string &path, int idx) const
+{
+   return Mix(std::hash<std::string>()(path) ^ Mix((unsigned long long) idx));
+}
+
+void HotTier::increment(unsigned long long h)
+{
+   for (int r = 0; r < s_sketchRows; ++r)
+   {
+      unsigned char &c = m_sketch[r * (m_sketch_mask + 1) + (Mix(h + r + 1) & m_sketch_mask)];
+      if (c < MaxCount) ++c;
+   }
+
+   // Aging: halve all counters so that old popularity fades out.
+   if (++m_samples >= m_sample_max)
+   {
+      for (std::vector<unsigned char>::iterator i = m_sketch.begin(); i != m_sketch.end(); ++i)
+      {
+         *i >>= 1;
+      }
+      m_samples /= 2;
+   }
+}
+
+int HotTier::estimate(unsigned long long h) const
+{
+   int min = MaxCount;
+   for (int r = 0; r < s_sketchRows; ++r)
+   {
+      int c = m_sketch[r * (m_sketch_mask + 1) + (Mix(h + r + 1) & m_sketch_mask)];
+      if (c < min) min = c;
+   }
+   return min;
+}
+
+void HotTier::remove(Entry *e, std::vector<char*> &bufs)
+{
+   m_map.erase(Key_t(e->path, e->idx));
+   m_lru.erase(e->lru);
+
+   if (e->pins > 0)
+   {
+      e->dropped = true;
+   }
+   else
+   {
+      bufs.push_back(e->buf);
+      delete e;
+   }
+}
+
+HotTier::Entry* HotTier::victim()
+{
+   int n = 0;
+   for (std::list<Entry*>::reverse_iterator i = m_lru.rbegin(); i != m_lru.rend() && n < VictimScan; ++i, ++n)
+   {
+      if ((*i)->pins == 0) return *i;
+   }
+   return 0;
+}
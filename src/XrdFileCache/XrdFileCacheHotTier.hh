@@ -0,0 +1,150 @@
+#ifndef __XRDFILECACHE_HOT_TIER_HH__
+#define __XRDFILECACHE_HOT_TIER_HH__
+//----------------------------------------------------------------------------------
+// Copyright (c) 2019 by Board of Trustees of the Leland Stanford, Jr., University
+// Author: Alja Mrak-Tadel, Matevz Tadel, Brian Bockelman
+//----------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//----------------------------------------------------------------------------------
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "XrdSys/XrdSysPthread.hh"
+
+class XrdSysTrace;
+
+namespace XrdFileCache
+{
+//----------------------------------------------------------------------------
+//! In-memory tier holding recently read disk blocks, shared by all files.
+//!
+//! Blocks are keyed by the local path of the data file and the block index,
+//! so they survive the File object being closed and reopened. A block read
+//! from disk is only admitted if it has been requested before and, when the
+//! tier is full, if it is estimated to be more popular than the least
+//! recently used block it would replace (TinyLFU). Popularity is tracked in a
+//! count-min sketch that is halved periodically so that it follows changes
+//! in the access pattern.
+//!
+//! Buffers come from the RAM block pool of the Cache and count against
+//! pfc.ram. The Cache reclaims them when it runs out of RAM blocks.
+//----------------------------------------------------------------------------
+class HotTier
+{
+public:
+   //! A block in the tier. It is pinned while returned from Get() and can
+   //! not be evicted until Release() is called.
+   struct Entry
+   {
+      std::string path;
+      int         idx;
+      char       *buf;
+      int         size;
+      int         pins;
+      bool        dropped;    //!< removed from the tier while pinned
+      std::list<Entry*>::iterator lru;
+   };
+
+   HotTier();
+
+   //---------------------------------------------------------------------
+   //! Set maximum number of blocks, 0 disables the tier.
+   //---------------------------------------------------------------------
+   void Init(int max_blocks, XrdSysTrace *trace);
+
+   bool IsEnabled() const { return m_max_blocks > 0; }
+
+   //---------------------------------------------------------------------
+   //! Look up a block. On hit the entry is pinned and must be released.
+   //---------------------------------------------------------------------
+   Entry* Get(const std::string &path, int idx);
+
+   //---------------------------------------------------------------------
+   //! Unpin an entry returned by Get(). Returns the buffer to be given back
+   //! to the RAM pool if the entry was dropped meanwhile, 0 otherwise.
+   //---------------------------------------------------------------------
+   char* Release(Entry *e);
+
+   //---------------------------------------------------------------------
+   //! Record a disk read of a block missing in the tier and decide if it
+   //! should be admitted.
+   //---------------------------------------------------------------------
+   bool Admit(const std::string &path, int idx);
+
+   //---------------------------------------------------------------------
+   //! Insert a block read from disk, taking ownership of buf. Returns a
+   //! buffer to be given back to the RAM pool (an evicted one or buf itself
+   //! if the block is already present) or 0.
+   //---------------------------------------------------------------------
+   char* Insert(const std::string &path, int idx, char *buf, int size);
+
+   //---------------------------------------------------------------------
+   //! Evict the least recently used unpinned block and pass its buffer to
+   //! the caller. Returns 0 if there is none.
+   //---------------------------------------------------------------------
+   char* Reclaim();
+
+   //---------------------------------------------------------------------
+   //! Drop all blocks of a data file, e.g. when it is removed or reset.
+   //! Buffers to be given back to the RAM pool are appended to bufs.
+   //---------------------------------------------------------------------
+   void Invalidate(const std::string &path, std::vector<char*> &bufs);
+
+   //---------------------------------------------------------------------
+   //! Number of blocks currently held.
+   //---------------------------------------------------------------------
+   int  GetNBlocks();
+
+   //---------------------------------------------------------------------
+   //! Log and reset the hit / admission counters.
+   //---------------------------------------------------------------------
+   void Report();
+
+private:
+   typedef std::pair<std::string, int>  Key_t;
+   typedef std::map<Key_t, Entry*>      Map_t;
+   typedef Map_t::iterator              Map_i;
+
+   static const int s_sketchRows = 4;
+
+   unsigned long long hash(const std::string &path, int idx) const;
+   void increment(unsigned long long h);
+   int  estimate(unsigned long long h) const;
+   void remove(Entry *e, std::vector<char*> &bufs);
+   Entry* victim();
+
+   XrdSysTrace* GetTrace() const { return m_trace; }
+
+   const static char *m_traceID;
+
+   XrdSysMutex        m_mutex;
+   XrdSysTrace       *m_trace;
+   int                m_max_blocks;
+
+   Map_t              m_map;
+   std::list<Entry*>  m_lru;           //!< most recently used first
+
+   std::vector<unsigned char> m_sketch;      //!< s_sketchRows rows of 4-bit saturating counters
+   unsigned long long         m_sketch_mask; //!< row width - 1
+   long long                  m_samples;     //!< increments since last halving
+   long long                  m_sample_max;  //!< halve counters after this many increments
+
+   long long m_n_hits, m_n_misses, m_n_admitted, m_n_rejected, m_n_evicted;
+};
+}
+
+#endif
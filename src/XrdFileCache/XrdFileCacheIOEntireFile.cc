@@ -134,6 +134,14 @@ bool IOEntireFile::ioActive()
    return m_file->ioActive(this);
 }
 
+//______________________________________________________________________________
+void IOEntireFile::StopPrefetching()
+{
+   XrdSysMutexHelper lock(&m_mutex);
+
+   m_file->StopPrefetchingOnIO(this);
+}
+
 //______________________________________________________________________________
 XrdOucCacheIO *IOEntireFile::Detach()
 {
@@ -95,6 +95,11 @@ public:
 
    virtual long long FSize();
 
+   //---------------------------------------------------------------------
+   //! Do not prefetch on behalf of this IO, used by the prestager.
+   //---------------------------------------------------------------------
+   void StopPrefetching();
+
 private:
    XrdSysMutex  m_mutex;
    File        *m_file;
@@ -93,13 +93,67 @@ struct FpHelper
       return WriteRaw(&loc, sizeof(T));
    }
 };
+
+// Layout of version 3 cinfo files: fixed size header, a ring of AStat
+// records, and the synced bit-vector, either raw or run-length encoded.
+// Offsets of all parts are fixed for a given file so the header, the ring
+// and byte ranges of a raw bit-vector can be rewritten in place.
+
+struct HeaderV3
+{
+   int       m_version;
+   int       m_flags;
+   long long m_bufferSize;
+   long long m_fileSize;
+   long long m_creationTime;
+   long long m_accessCnt;
+   int       m_vectorBytes;    // size of bit-vector as stored
+   int       m_ringSize;       // number of AStat slots
+   char      m_cksum[16];      // md5 of raw bit-vector
+};
+
+const int kFlagRLE = 1;        // bit-vector is run-length encoded
+
+struct RunV3
+{
+   unsigned int  m_count;
+   unsigned char m_value;
+   unsigned char m_pad[3];
+};
+
+void EncodeRuns(const unsigned char *buf, int n, std::vector<RunV3> &runs)
+{
+   int i = 0;
+   while (i < n)
+   {
+      RunV3 r;
+      memset(&r, 0, sizeof(r));
+      r.m_value = buf[i];
+      r.m_count = 1;
+      while (i + (int) r.m_count < n && buf[i + r.m_count] == r.m_value) ++r.m_count;
+      i += r.m_count;
+      runs.push_back(r);
+   }
+}
+
+bool DecodeRuns(const RunV3 *runs, int n_runs, unsigned char *buf, int n)
+{
+   int pos = 0;
+   for (int i = 0; i < n_runs; ++i)
+   {
+      if (runs[i].m_count > (unsigned int) (n - pos)) return false;
+      memset(buf + pos, runs[i].m_value, runs[i].m_count);
+      pos += runs[i].m_count;
+   }
+   return pos == n;
+}
 }
 
 using namespace XrdFileCache;
 
 const char*  Info::m_infoExtension  = ".cinfo";
 const char*  Info::m_traceID        = "Cinfo";
-const int    Info::m_defaultVersion = 2;
+const int    Info::m_defaultVersion = 3;
 const size_t Info::m_maxNumAccess   = 20;
 
 //------------------------------------------------------------------------------
@@ -110,6 +164,8 @@ Info::Info(XrdSysTrace* trace, bool prefetchBuffer) :
    m_buff_written(0),  m_buff_prefetch(0),
    m_sizeInBits(0),
    m_complete(false),
+   m_dirtyFirst(0), m_dirtyEnd(0),
+   m_inPlace(false),
    m_cksCalc(0)
 {}
 
@@ -135,7 +191,9 @@ void Info::SetAllBitsSynced()
    for (int i = 0; i < nb; ++i)
       m_store.m_buff_synced[i] = 255;
 
-   m_complete = true;
+   m_dirtyFirst = 0;
+   m_dirtyEnd   = nb;
+   m_complete   = true;
 }
 
 //------------------------------------------------------------------------------
@@ -166,6 +224,8 @@ void Info::ResizeBits(int s)
    if (m_buff_prefetch)       free(m_buff_prefetch);
 
    m_sizeInBits = s;
+   m_dirtyFirst = m_dirtyEnd = 0;
+   m_inPlace    = false;
    m_buff_written        = (unsigned char*) malloc(GetSizeInBytes());
    m_store.m_buff_synced = (unsigned char*) malloc(GetSizeInBytes());
    memset(m_buff_written,        0, GetSizeInBytes());
@@ -203,7 +263,90 @@ bool Info::Read(XrdOssDF* fp, const std::string &fname)
    }
    else if (abs(m_store.m_version) == 1)
       return ReadV1(fp, fname);
+   else if (abs(m_store.m_version) == 2)
+      return ReadV2(fp, fname);
+   else if (abs(m_store.m_version) != 3)
+   {
+      TRACE(Error, trace_pfx << " File version " << m_store.m_version << " not supported");
+      return false;
+   }
+
+   HeaderV3 h;
+   r.f_off = 0;
+   if (r.ReadRaw(&h, sizeof(h))) return false;
+
+   if (h.m_bufferSize <= 0 || h.m_fileSize < 0 || h.m_ringSize < 0 || h.m_vectorBytes < 0)
+   {
+      TRACE(Error, trace_pfx << " invalid header");
+      return false;
+   }
+
+   m_store.m_bufferSize = h.m_bufferSize;
+   SetFileSize(h.m_fileSize);
+   m_store.m_creationTime = h.m_creationTime;
+   m_store.m_accessCnt    = h.m_accessCnt;
+
+   // read access statistics from the ring, oldest first
+   std::vector<AStat> ring(h.m_ringSize);
+   if (h.m_ringSize > 0 && r.ReadRaw(&ring[0], h.m_ringSize * sizeof(AStat))) return false;
+
+   size_t vs = std::min(m_store.m_accessCnt, std::min(m_maxNumAccess, (size_t) h.m_ringSize));
+   m_store.m_astats.clear();
+   for (size_t i = m_store.m_accessCnt - vs; i < m_store.m_accessCnt; ++i)
+   {
+      m_store.m_astats.push_back(ring[i % h.m_ringSize]);
+   }
+
+   if (h.m_flags & kFlagRLE)
+   {
+      if (h.m_vectorBytes % sizeof(RunV3)) return false;
+      std::vector<RunV3> runs(h.m_vectorBytes / sizeof(RunV3));
+      if ( ! runs.empty() && r.ReadRaw(&runs[0], h.m_vectorBytes)) return false;
+      if ( ! DecodeRuns(runs.empty() ? 0 : &runs[0], runs.size(), m_store.m_buff_synced, GetSizeInBytes()))
+      {
+         TRACE(Error, trace_pfx << " run-length encoded vector does not match file size");
+         return false;
+      }
+   }
+   else
+   {
+      if (h.m_vectorBytes != GetSizeInBytes())
+      {
+         TRACE(Error, trace_pfx << " vector size does not match file size");
+         return false;
+      }
+      if (r.ReadRaw(m_store.m_buff_synced, GetSizeInBytes())) return false;
+   }
+   memcpy(m_buff_written, m_store.m_buff_synced, GetSizeInBytes());
+
+   memcpy(m_store.m_cksum, h.m_cksum, 16);
+   char tmpCksum[16];
+   GetCksum(&m_store.m_buff_synced[0], &tmpCksum[0]);
+   if (memcmp(m_store.m_cksum, &tmpCksum[0], 16))
+   {
+      TRACE(Error, trace_pfx << " buffer cksum and saved cksum don't match \n");
+      return false;
+   }
+
+   // cache complete status
+   m_complete = ! IsAnythingEmptyInRng(0, m_sizeInBits);
+
+   // Raw layout with the same ring size can be updated in place.
+   m_inPlace = ! (h.m_flags & kFlagRLE) && h.m_ringSize == (int) m_maxNumAccess;
 
+   TRACE(Dump, trace_pfx << " complete "<< m_complete << " access_cnt " << m_store.m_accessCnt);
+
+   return true;
+}
+
+bool Info::ReadV2(XrdOssDF* fp, const std::string &fname)
+{
+   std::string trace_pfx("Info:::ReadV2() ");
+   trace_pfx += fname + " ";
+
+   FpHelper r(fp, 0, m_trace, m_traceID, trace_pfx + "oss read failed");
+
+   if (r.Read(m_store.m_version)) return false;
    if (r.Read(m_store.m_bufferSize)) return false;
 
    long long fs;
@@ -341,25 +484,82 @@ bool Info::Write(XrdOssDF* fp, const std::string &fname)
       return false;
    }
 
-   FpHelper w(fp, 0, m_trace, m_traceID, trace_pfx + "oss write failed");
+   const int nb = GetSizeInBytes();
 
-   m_store.m_version = m_defaultVersion;
-   if (w.Write(m_store.m_version))    return false;
-   if (w.Write(m_store.m_bufferSize)) return false;
-   if (w.Write(m_store.m_fileSize))   return false;
+   // A vector with all blocks synced never changes again, store it compactly.
+   std::vector<RunV3> runs;
+   bool all_synced = true;
+   for (int i = 0; i < nb - 1 && all_synced; ++i)
+      if (m_store.m_buff_synced[i] != 255) all_synced = false;
+   if (all_synced && nb > 0)
+   {
+      // Padding bits past the last block may be set by SetAllBitsSynced().
+      const int           last_bits = m_sizeInBits - (nb - 1) * 8;
+      const unsigned char last_mask = (unsigned char) ((1 << last_bits) - 1);
+      all_synced = ((m_store.m_buff_synced[nb - 1] & last_mask) == last_mask);
+   }
+   if (all_synced && nb > 0)
+   {
+      EncodeRuns(m_store.m_buff_synced, nb, runs);
+   }
+   const bool rle = ! runs.empty();
+
+   // Header and ring of access records.
+   std::vector<char> buf(sizeof(HeaderV3) + m_maxNumAccess * sizeof(AStat), 0);
 
-   if (w.WriteRaw(m_store.m_buff_synced, GetSizeInBytes())) return false;
+   HeaderV3 &h = * (HeaderV3*) &buf[0];
+   m_store.m_version = m_defaultVersion;
+   h.m_version       = m_defaultVersion;
+   h.m_flags         = rle ? kFlagRLE : 0;
+   h.m_bufferSize    = m_store.m_bufferSize;
+   h.m_fileSize      = m_store.m_fileSize;
+   h.m_creationTime  = m_store.m_creationTime;
+   h.m_accessCnt     = m_store.m_accessCnt;
+   h.m_vectorBytes   = rle ? runs.size() * sizeof(RunV3) : nb;
+   h.m_ringSize      = m_maxNumAccess;
 
    GetCksum(&m_store.m_buff_synced[0], &m_store.m_cksum[0]);
-   if (w.Write(m_store.m_cksum)) return false;
+   memcpy(h.m_cksum, m_store.m_cksum, 16);
 
-   if (w.Write(m_store.m_creationTime)) return false;
+   AStat *ring = (AStat*) &buf[sizeof(HeaderV3)];
+   size_t idx  = m_store.m_accessCnt - m_store.m_astats.size();
+   for (std::vector<AStat>::iterator it = m_store.m_astats.begin(); it != m_store.m_astats.end(); ++it, ++idx)
+   {
+      ring[idx % m_maxNumAccess] = *it;
+   }
 
-   if (w.Write(m_store.m_accessCnt)) return false;
-   for (std::vector<AStat>::iterator it = m_store.m_astats.begin(); it != m_store.m_astats.end(); ++it)
+   FpHelper w(fp, 0, m_trace, m_traceID, trace_pfx + "oss write failed");
+
+   if (m_inPlace && ! rle)
    {
-      if (w.WriteRaw(&(*it), sizeof(AStat))) return false;
+      // Only the changed part of the vector follows the header.
+      if (w.WriteRaw(&buf[0], buf.size())) return false;
+
+      if (m_dirtyFirst < m_dirtyEnd)
+      {
+         w.f_off += m_dirtyFirst;
+         if (w.WriteRaw(&m_store.m_buff_synced[m_dirtyFirst], m_dirtyEnd - m_dirtyFirst)) return false;
+      }
+   }
+   else
+   {
+      if (rle)
+         buf.insert(buf.end(), (char*) &runs[0], (char*) &runs[0] + runs.size() * sizeof(RunV3));
+      else
+         buf.insert(buf.end(), (char*) &m_store.m_buff_synced[0], (char*) &m_store.m_buff_synced[0] + nb);
+
+      if (w.WriteRaw(&buf[0], buf.size())) return false;
+
+      // Drop the tail of a longer, earlier layout.
+      if ((rc = fp->Ftruncate(buf.size())))
+      {
+         TRACE(Error, trace_pfx << " truncate failed " << strerror(-rc));
+         return false;
+      }
+
+      m_inPlace = ! rle;
    }
+   m_dirtyFirst = m_dirtyEnd = 0;
 
    // Can this really fail?
    if (XrdOucSxeq::Release(fp->getFD()))
@@ -136,7 +136,13 @@ public:
    bool Read(XrdOssDF* fp, const std::string &fname = "<unknown>");
 
    //---------------------------------------------------------------------
-   //! Write number of blocks and read buffer size
+   //! \brief Write content of this object into cinfo file
+   //!
+   //! If the file was read or written by this object before, only the
+   //! header, access records and the changed range of the download-state
+   //! bit-vector are written. The bit-vector of a file with all blocks
+   //! synced is stored run-length encoded.
+   //!
    //! @return true on success
    //---------------------------------------------------------------------
    bool Write(XrdOssDF* fp, const std::string &fname = "<unknown>");
@@ -275,11 +281,23 @@ protected:
    int  m_sizeInBits;                        //!< cached
    bool m_complete;                          //!< cached
 
+   int  m_dirtyFirst;                        //!< first byte of synced vector changed since last write
+   int  m_dirtyEnd;                          //!< one past last byte changed since last write
+   bool m_inPlace;                           //!< file has raw v3 layout matching this object
+
 private:
    inline unsigned char cfiBIT(int n) const { return 1 << n; }
 
-   // split reading for V1
+   inline void mark_dirty(int cn)
+   {
+      if (m_dirtyFirst >= m_dirtyEnd) { m_dirtyFirst = cn; m_dirtyEnd = cn + 1; }
+      else if (cn <  m_dirtyFirst)      m_dirtyFirst = cn;
+      else if (cn >= m_dirtyEnd)        m_dirtyEnd   = cn + 1;
+   }
+
+   // split reading for older versions
    bool ReadV1(XrdOssDF* fp, const std::string &fname);
+   bool ReadV2(XrdOssDF* fp, const std::string &fname);
    XrdCksCalc*   m_cksCalc;
 };
 
@@ -331,7 +349,11 @@ inline void Info::SetBitSynced(int i)
    assert(cn < GetSizeInBytes());
 
    const int off = i - cn*8;
-   m_store.m_buff_synced[cn] |= cfiBIT(off);
+   if ( ! (m_store.m_buff_synced[cn] & cfiBIT(off)))
+   {
+      m_store.m_buff_synced[cn] |= cfiBIT(off);
+      mark_dirty(cn);
+   }
 }
 
 //------------------------------------------------------------------------------
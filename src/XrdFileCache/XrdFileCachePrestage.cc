@@ -0,0 +1,446 @@
+//----------------------------------------------------------------------------------
+// Copyright (c) 2019 by Board of Trustees of the Leland Stanford, Jr., University
+// Author: Alja Mrak-Tadel, Matevz Tadel, Brian Bockelman
+//----------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//----------------------------------------------------------------------------------
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include <algorithm>
+
+#include "XProtocol/XProtocol.hh"
+#include "XrdOss/XrdOss.hh"
+#include "XrdOuc/XrdOucEnv.hh"
+#include "XrdSys/XrdSysTimer.hh"
+#include "XrdSys/XrdSysTrace.hh"
+
+#include "XrdFileCachePrestage.hh"
+#include "XrdFileCache.hh"
+#include "XrdFileCacheInfo.hh"
+#include "XrdFileCacheIOEntireFile.hh"
+#include "XrdFileCacheTrace.hh"
+
+using namespace XrdFileCache;
+
+namespace
+{
+int StatusToErrno(const XrdCl::XRootDStatus &st)
+{
+   if (st.IsOK()) return 0;
+   if (st.code == XrdCl::errErrorResponse) return -XProtocol::toErrno(st.errNo);
+   return -EIO;
+}
+
+double Now()
+{
+   struct timeval tv;
+   gettimeofday(&tv, 0);
+   return tv.tv_sec + 1e-6 * tv.tv_usec;
+}
+
+class ReadHandler : public XrdCl::ResponseHandler
+{
+public:
+   ReadHandler(XrdOucCacheIOCB &iocb) : m_iocb(iocb) {}
+
+   virtual void HandleResponse(XrdCl::XRootDStatus *status, XrdCl::AnyObject *response)
+   {
+      int res = StatusToErrno(*status);
+      if (res == 0 && response)
+      {
+         XrdCl::ChunkInfo *ci = 0;
+         response->Get(ci);
+         res = ci ? ci->length : 0;
+      }
+      delete status;
+      delete response;
+
+      m_iocb.Done(res);
+      delete this;
+   }
+
+private:
+   XrdOucCacheIOCB &m_iocb;
+};
+
+class ReadVHandler : public XrdCl::ResponseHandler
+{
+public:
+   ReadVHandler(XrdOucCacheIOCB &iocb) : m_iocb(iocb) {}
+
+   virtual void HandleResponse(XrdCl::XRootDStatus *status, XrdCl::AnyObject *response)
+   {
+      int res = StatusToErrno(*status);
+      if (res == 0 && response)
+      {
+         XrdCl::VectorReadInfo *vri = 0;
+         response->Get(vri);
+         res = vri ? vri->GetSize() : 0;
+      }
+      delete status;
+      delete response;
+
+      m_iocb.Done(res);
+      delete this;
+   }
+
+private:
+   XrdOucCacheIOCB &m_iocb;
+};
+
+void FillChunkList(XrdCl::ChunkList &chunks, const XrdOucIOVec *readV, int n)
+{
+   chunks.reserve(n);
+   for (int i = 0; i < n; ++i)
+   {
+      chunks.push_back(XrdCl::ChunkInfo(readV[i].offset, readV[i].size, readV[i].data));
+   }
+}
+
+void *PrestageThread(void *ptr)
+{
+   static_cast<Prestager*>(ptr)->Run();
+   return 0;
+}
+}
+
+//==============================================================================
+// PrestageIO
+//==============================================================================
+
+PrestageIO::PrestageIO(const std::string &url) :
+   m_url(url),
+   m_size(-1),
+   m_mtime(0)
+{}
+
+PrestageIO::~PrestageIO()
+{
+   if (m_file.IsOpen())
+   {
+      XrdCl::XRootDStatus st = m_file.Close();
+   }
+}
+
+int PrestageIO::Open()
+{
+   XrdCl::XRootDStatus st = m_file.Open(m_url, XrdCl::OpenFlags::Read);
+   if ( ! st.IsOK()) return StatusToErrno(st);
+
+   XrdCl::StatInfo *si = 0;
+   st = m_file.Stat(false, si);
+   if ( ! st.IsOK()) return StatusToErrno(st);
+
+   m_size  = si->GetSize();
+   m_mtime = si->GetModTime();
+   delete si;
+   return 0;
+}
+
+int PrestageIO::Fstat(struct stat &sbuff)
+{
+   if (m_size < 0) return -EBADF;
+
+   memset(&sbuff, 0, sizeof(sbuff));
+   sbuff.st_size    = m_size;
+   sbuff.st_blocks  = (m_size + 511) / 512;
+   sbuff.st_mode    = S_IFREG | 0444;
+   sbuff.st_mtime   = sbuff.st_atime = sbuff.st_ctime = m_mtime;
+   return 0;
+}
+
+int PrestageIO::Read(char *buff, long long offs, int rlen)
+{
+   uint32_t bytes = 0;
+   XrdCl::XRootDStatus st = m_file.Read(offs, rlen, buff, bytes);
+   return st.IsOK() ? (int) bytes : StatusToErrno(st);
+}
+
+void PrestageIO::Read(XrdOucCacheIOCB &iocb, char *buff, long long offs, int rlen)
+{
+   ReadHandler *h = new ReadHandler(iocb);
+   XrdCl::XRootDStatus st = m_file.Read(offs, rlen, buff, h);
+   if ( ! st.IsOK())
+   {
+      delete h;
+      iocb.Done(StatusToErrno(st));
+   }
+}
+
+int PrestageIO::ReadV(const XrdOucIOVec *readV, int n)
+{
+   XrdCl::ChunkList chunks;
+   FillChunkList(chunks, readV, n);
+
+   XrdCl::VectorReadInfo *vri = 0;
+   XrdCl::XRootDStatus st = m_file.VectorRead(chunks, 0, vri);
+   if ( ! st.IsOK()) return StatusToErrno(st);
+
+   int res = vri->GetSize();
+   delete vri;
+   return res;
+}
+
+void PrestageIO::ReadV(XrdOucCacheIOCB &iocb, const XrdOucIOVec *readV, int n)
+{
+   XrdCl::ChunkList chunks;
+   FillChunkList(chunks, readV, n);
+
+   ReadVHandler *h = new ReadVHandler(iocb);
+   XrdCl::XRootDStatus st = m_file.VectorRead(chunks, 0, h);
+   if ( ! st.IsOK())
+   {
+      delete h;
+      iocb.Done(StatusToErrno(st));
+   }
+}
+
+//==============================================================================
+// Prestager
+//==============================================================================
+
+const char *Prestager::m_traceID = "Prestager";
+
+Prestager::Prestager() :
+   m_trace(0),
+   m_max_files(0),
+   m_max_rate(0),
+   m_n_workers(0),
+   m_rate_next(0),
+   m_n_queued(0), m_n_skipped(0), m_n_done(0), m_n_failed(0), m_n_bytes(0)
+{}
+
+void Prestager::Init(int max_files, long long max_rate, XrdSysTrace *trace)
+{
+   XrdSysMutexHelper lock(&m_mutex);
+
+   m_max_files = max_files;
+   m_max_rate  = max_rate;
+   m_trace     = trace;
+}
+
+//------------------------------------------------------------------------------
+
+void Prestager::Add(const std::string &origin, const std::vector<std::string> &paths)
+{
+   XrdSysMutexHelper lock(&m_mutex);
+
+   for (std::vector<std::string>::const_iterator i = paths.begin(); i != paths.end(); ++i)
+   {
+      m_queue.push_back(Request(origin, *i));
+   }
+   m_n_queued += paths.size();
+
+   TRACE(Info, "Add() queued " << paths.size() << " files from " << origin << ", " << m_queue.size() << " waiting.");
+
+   while (m_n_workers < m_max_files && m_n_workers < (int) m_queue.size())
+   {
+      pthread_t tid;
+      if (XrdSysThread::Run(&tid, PrestageThread, this, 0, "XrdFileCache Prestage") != 0)
+      {
+         TRACE(Error, "Add() can not start prestage thread.");
+         break;
+      }
+      ++m_n_workers;
+   }
+}
+
+void Prestager::Report()
+{
+   XrdSysMutexHelper lock(&m_mutex);
+
+   char buf[256];
+   snprintf(buf, sizeof(buf), "queued %lld, waiting %d, active %d, skipped %lld, done %lld, failed %lld, bytes %lld",
+            m_n_queued, (int) m_queue.size(), m_n_workers, m_n_skipped, m_n_done, m_n_failed, m_n_bytes);
+   TRACE(Info, "Report() " << buf);
+}
+
+//------------------------------------------------------------------------------
+
+void Prestager::Run()
+{
+   while (true)
+   {
+      Request req("", "");
+      bool    got  = false;
+      bool    last = false;
+      {
+         XrdSysMutexHelper lock(&m_mutex);
+
+         if (m_queue.empty())
+         {
+            last = (--m_n_workers == 0);
+         }
+         else
+         {
+            req = m_queue.front();
+            m_queue.pop_front();
+            got = true;
+         }
+      }
+
+      // A worker only leaves once the queue is empty; it has then already
+      // been taken off the worker count.
+      if ( ! got)
+      {
+         if (last) Report();
+         return;
+      }
+
+      if (req.path.empty())
+      {
+         XrdSysMutexHelper lock(&m_mutex);
+         ++m_n_failed;
+         continue;
+      }
+
+      if (is_complete(req.path))
+      {
+         TRACE(Debug, "Run() " << req.path << " is complete, skipping.");
+         XrdSysMutexHelper lock(&m_mutex);
+         ++m_n_skipped;
+         continue;
+      }
+
+      bool ok = download(req);
+
+      XrdSysMutexHelper lock(&m_mutex);
+      if (ok) ++m_n_done; else ++m_n_failed;
+   }
+}
+
+//------------------------------------------------------------------------------
+
+bool Prestager::is_complete(const std::string &path)
+{
+   Cache             &cache = Cache::GetInstance();
+   const std::string  i_name = path + Info::m_infoExtension;
+
+   XrdOssDF *infoFile = cache.GetOss()->newFile(cache.RefConfiguration().m_username.c_str());
+   XrdOucEnv myEnv;
+   bool      complete = false;
+   if (infoFile->Open(i_name.c_str(), O_RDONLY, 0600, myEnv) == XrdOssOK)
+   {
+      Info info(m_trace, 0);
+      complete = info.Read(infoFile, i_name) && info.IsComplete();
+      infoFile->Close();
+   }
+   delete infoFile;
+
+   return complete;
+}
+
+bool Prestager::download(const Request &req)
+{
+   Cache      &cache = Cache::GetInstance();
+   std::string url   = req.origin + req.path;
+
+   PrestageIO *input = new PrestageIO(url);
+
+   int res = input->Open();
+   if (res < 0)
+   {
+      TRACE(Warning, "download() can not open " << url << ", " << ERRNO_AND_ERRSTR(-res));
+      delete input;
+      return false;
+   }
+
+   XrdOucCacheIO2 *io = cache.Attach(input);
+   if (io == input)
+   {
+      TRACE(Warning, "download() " << req.path << " is not cached, skipping.");
+      delete input;
+      return false;
+   }
+
+   // Reads below are paced, prefetching would not be.
+   if (m_max_rate > 0)
+   {
+      IOEntireFile *ioef = dynamic_cast<IOEntireFile*>(io);
+      if (ioef) ioef->StopPrefetching();
+   }
+
+   const long long BS    = cache.RefConfiguration().m_bufferSize;
+   const long long chunk = BS * std::max(1LL, cache.RefConfiguration().m_mergeReadMax / BS);
+   const long long size  = io->FSize();
+
+   char *buf = 0;
+   if (posix_memalign((void**) &buf, 4096, chunk) != 0)
+   {
+      buf = 0;
+      res = -ENOMEM;
+   }
+
+   long long off = 0;
+   while (buf && off < size)
+   {
+      int len = (int) std::min(chunk, size - off);
+      throttle(len);
+      res = io->Read(buf, off, len);
+      if (res != len)
+      {
+         if (res >= 0) res = -EIO;
+         break;
+      }
+      off += len;
+      res  = 0;
+   }
+   free(buf);
+
+   if (res == 0)
+   {
+      XrdSysMutexHelper lock(&m_mutex);
+      m_n_bytes += size;
+   }
+   TRACE(Debug, "download() " << req.path << " finished, " << off << " of " << size << " bytes read, res " << res);
+   if (res < 0)
+   {
+      TRACE(Warning, "download() " << req.path << " failed, " << ERRNO_AND_ERRSTR(-res));
+   }
+
+   // As XrdPosixFile does, wait for outstanding prefetches before detaching.
+   while (io->ioActive())
+   {
+      XrdSysTimer::Wait(100);
+   }
+   io->Detach();
+   delete input;
+
+   return res == 0;
+}
+
+void Prestager::throttle(long long bytes)
+{
+   if (m_max_rate <= 0) return;
+
+   double now = Now(), start;
+   {
+      XrdSysMutexHelper lock(&m_mutex);
+
+      start       = std::max(now, m_rate_next);
+      m_rate_next = start + double(bytes) / m_max_rate;
+   }
+
+   if (start > now)
+   {
+      XrdSysTimer::Wait((int) (1000 * (start - now)));
+   }
+}
@@ -0,0 +1,148 @@
+#ifndef __XRDFILECACHE_PRESTAGE_HH__
+#define __XRDFILECACHE_PRESTAGE_HH__
+//----------------------------------------------------------------------------------
+// Copyright (c) 2019 by Board of Trustees of the Leland Stanford, Jr., University
+// Author: Alja Mrak-Tadel, Matevz Tadel, Brian Bockelman
+//----------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//----------------------------------------------------------------------------------
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "XrdCl/XrdClFile.hh"
+#include "XrdOuc/XrdOucCache2.hh"
+#include "XrdSys/XrdSysPthread.hh"
+
+class XrdSysTrace;
+
+namespace XrdFileCache
+{
+//----------------------------------------------------------------------------
+//! Remote file read with XrdCl, the data source of a prestage download.
+//! It takes the place of the XrdPosixFile a client open would provide.
+//----------------------------------------------------------------------------
+class PrestageIO : public XrdOucCacheIO2
+{
+public:
+   PrestageIO(const std::string &url);
+
+   //---------------------------------------------------------------------
+   //! Open the remote file and get its size. Returns 0 or -errno.
+   //---------------------------------------------------------------------
+   int Open();
+
+   virtual long long   FSize() { return m_size; }
+   virtual const char *Path()  { return m_url.c_str(); }
+
+   virtual int  Fstat(struct stat &sbuff);
+
+   using XrdOucCacheIO2::Read;
+
+   virtual int  Read(char *buff, long long offs, int rlen);
+   virtual void Read(XrdOucCacheIOCB &iocb, char *buff, long long offs, int rlen);
+
+   using XrdOucCacheIO2::ReadV;
+
+   virtual int  ReadV(const XrdOucIOVec *readV, int n);
+   virtual void ReadV(XrdOucCacheIOCB &iocb, const XrdOucIOVec *readV, int n);
+
+   using XrdOucCacheIO2::Sync;
+
+   virtual int  Sync() { return 0; }
+
+   virtual int  Trunc(long long) { return -ENOTSUP; }
+
+   using XrdOucCacheIO2::Write;
+
+   virtual int  Write(char *, long long, int) { return -ENOTSUP; }
+
+   virtual ~PrestageIO();
+
+private:
+   std::string  m_url;
+   XrdCl::File  m_file;
+   long long    m_size;
+   long         m_mtime;
+};
+
+//----------------------------------------------------------------------------
+//! Bulk download of whole files into the cache.
+//!
+//! Files are queued by the prestage command and fetched by up to a
+//! configured number of worker threads. Each file is opened through the
+//! cache, just like a client open, and read from start to end. Files whose
+//! cinfo says they are complete are skipped. The total rate of reads can be
+//! capped, prefetching is then disabled for prestage reads.
+//----------------------------------------------------------------------------
+class Prestager
+{
+public:
+   Prestager();
+
+   //---------------------------------------------------------------------
+   //! Set number of concurrent downloads and rate limit in bytes / s,
+   //! 0 for no limit.
+   //---------------------------------------------------------------------
+   void Init(int max_files, long long max_rate, XrdSysTrace *trace);
+
+   //---------------------------------------------------------------------
+   //! Queue files for download. Origin is the URL prefix of the origin
+   //! server, e.g. root://host:port/, paths are logical file names.
+   //---------------------------------------------------------------------
+   void Add(const std::string &origin, const std::vector<std::string> &paths);
+
+   //---------------------------------------------------------------------
+   //! Log progress counters.
+   //---------------------------------------------------------------------
+   void Report();
+
+   //---------------------------------------------------------------------
+   //! Worker thread function, runs until the queue is empty.
+   //---------------------------------------------------------------------
+   void Run();
+
+private:
+   struct Request
+   {
+      std::string origin;
+      std::string path;
+
+      Request(const std::string &o, const std::string &p) : origin(o), path(p) {}
+   };
+
+   bool is_complete(const std::string &path);
+   bool download(const Request &req);
+   void throttle(long long bytes);
+
+   XrdSysTrace* GetTrace() const { return m_trace; }
+
+   const static char *m_traceID;
+
+   XrdSysMutex         m_mutex;
+   XrdSysTrace        *m_trace;
+   int                 m_max_files;
+   long long           m_max_rate;
+
+   std::list<Request>  m_queue;
+   int                 m_n_workers;
+
+   double              m_rate_next;     //!< time from which the next read may start
+
+   long long m_n_queued, m_n_skipped, m_n_done, m_n_failed, m_n_bytes;
+};
+}
+
+#endif
@@ -38,6 +38,7 @@ public:
    time_t    getMinTime()          const { return tMinTimeStamp; }
 
    long long getNBytesTotal()      const { return nBytesTotal; }
+   void      setNBytesTotal(long long n)   { nBytesTotal = n; }
 
    void checkFile(const std::string& iPath, long long iNBytes, time_t iTime)
    {
@@ -84,7 +85,7 @@ XrdSysTrace* GetTrace()
    return Cache::GetInstance().GetTrace();
 }
 
-void FillFileMapRecurse(XrdOssDF* iOssDF, const std::string& path, FPurgeState& purgeState)
+void FillFileMapRecurse(XrdOssDF* iOssDF, const std::string& path, FPurgeState& purgeState, PurgeIndex& purgeIndex)
 {
    char buff[256];
    XrdOucEnv env;
@@ -122,6 +123,7 @@ void FillFileMapRecurse(XrdOssDF* iOssDF, const std::string& path, FPurgeState&
                {
                   // TRACE(Dump, "FillFileMapRecurse() checking " << buff << " accessTime  " << accessTime);
                   purgeState.checkFile(np, cinfo.GetNDownloadedBytes(), accessTime);
+                  purgeIndex.Update(np, cinfo.GetNDownloadedBytes(), accessTime, cinfo.GetAccessCnt());
                }
                else
                {
@@ -137,6 +139,7 @@ void FillFileMapRecurse(XrdOssDF* iOssDF, const std::string& path, FPurgeState&
                      accessTime = fstat.st_mtime;
                      TRACE(Dump, "FillFileMapRecurse() have access time for " << np << " via stat: " << accessTime);
                      purgeState.checkFile(np, cinfo.GetNDownloadedBytes(), accessTime);
+                     purgeIndex.Update(np, cinfo.GetNDownloadedBytes(), accessTime, cinfo.GetAccessCnt());
                   }
                   else
                   {
@@ -162,7 +165,7 @@ void FillFileMapRecurse(XrdOssDF* iOssDF, const std::string& path, FPurgeState&
          }
          else if (dh->Opendir(np.c_str(), env) == XrdOssOK)
          {
-            FillFileMapRecurse(dh, np, purgeState);
+            FillFileMapRecurse(dh, np, purgeState, purgeIndex);
          }
 
          delete dh; dh = 0;
@@ -201,6 +204,9 @@ void Cache::Purge()
 
       TRACE(Info, trc_pfx << "Started.");
 
+      report_write_queues();
+      m_hot_tier.Report();
+
       long long bytesToRemove_d = 0, bytesToRemove_f = 0;
 
       // get amount of space to potentially erase based on total disk usage
@@ -225,10 +231,10 @@ void Cache::Purge()
       {
          long long estimated_writes_since_last_purge;
          {
-            XrdSysCondVarHelper lock(&m_writeQ.condVar);
+            XrdSysMutexHelper lock(&m_writeQ_mutex);
 
-            estimated_writes_since_last_purge = m_writeQ.writes_between_purges;
-            m_writeQ.writes_between_purges = 0;
+            estimated_writes_since_last_purge = m_writes_between_purges;
+            m_writes_between_purges = 0;
          }
          estimated_file_usage += estimated_writes_since_last_purge;
 
@@ -268,7 +274,8 @@ void Cache::Purge()
       long long bytesToRemove_at_start = 0; // set after file scan
       int       deleted_file_count     = 0;
 
-      if (bytesToRemove > 0 || enforce_age_based_purge)
+      // A full scan is also needed when the purge index has not been built yet.
+      if (bytesToRemove > 0 || enforce_age_based_purge || ! m_purge_index.IsValid())
       {
          // Make a sorted map of file paths sorted by access time.
          FPurgeState purgeState(2 * bytesToRemove); // prepare twice more volume than required
@@ -278,13 +285,36 @@ void Cache::Purge()
             purgeState.setMinTime(time(0) - m_configuration.m_purgeColdFilesAge);
          }
 
-         XrdOssDF* dh = oss->newDir(m_configuration.m_username.c_str());
-         if (dh->Opendir("", env) == XrdOssOK)
+         if (m_purge_index.IsValid())
          {
-            FillFileMapRecurse(dh, "", purgeState);
-            dh->Close();
+            // Only the least recently accessed files are visited.
+            std::vector<PurgeIndex::FileInfo> candidates;
+            long long n_total = m_purge_index.Oldest(2 * bytesToRemove, purgeState.getMinTime(), candidates);
+
+            for (std::vector<PurgeIndex::FileInfo>::iterator i = candidates.begin(); i != candidates.end(); ++i)
+            {
+               purgeState.checkFile(i->path, i->nBytes, i->atime);
+            }
+            purgeState.setNBytesTotal(n_total);
+
+            TRACE(Debug, trc_pfx << "purge index returned " << candidates.size() << " candidates.");
+         }
+         else
+         {
+            TRACE(Info, trc_pfx << "rebuilding purge index with a full scan.");
+
+            m_purge_index.BeginScan();
+
+            XrdOssDF* dh = oss->newDir(m_configuration.m_username.c_str());
+            if (dh->Opendir("", env) == XrdOssOK)
+            {
+               FillFileMapRecurse(dh, "", purgeState, m_purge_index);
+               dh->Close();
+            }
+            delete dh; dh = 0;
+
+            m_purge_index.EndScan();
          }
-         delete dh; dh = 0;
 
          estimated_file_usage = purgeState.getNBytesTotal();
 
@@ -362,6 +392,7 @@ void Cache::Purge()
                oss->Unlink(infoPath.c_str());
                TRACE(Dump, trc_pfx << "Removed file: '" << infoPath << "' size: " << fstat.st_size);
             }
+            m_purge_index.Remove(infoPath);
 
             // remove data file
             if (oss->Stat(dataPath.c_str(), &fstat) == XrdOssOK)
@@ -373,6 +404,7 @@ void Cache::Purge()
                oss->Unlink(dataPath.c_str());
                TRACE(Dump, trc_pfx << "Removed file: '" << dataPath << "' size: " << it->second.nBytes << ", time: " << it->first);
             }
+            InvalidateHotTier(dataPath);
          }
          if (protected_cnt > 0)
          {
@@ -387,6 +419,8 @@ void Cache::Purge()
          m_in_purge = false;
       }
 
+      m_purge_index.Compact();
+
       TRACE(Info, trc_pfx << "Finished, removed " << deleted_file_count << " data files, total size " <<
             bytesToRemove_at_start - bytesToRemove << ", bytes to remove at end: " << bytesToRemove);
 
@@ -0,0 +1,385 @@
+//----------------------------------------------------------------------------------
+// Copyright (c) 2019 by Board of Trustees of the Leland Stanford, Jr., University
+// Author: Alja Mrak-Tadel, Matevz Tadel, Brian Bockelman
+//----------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//----------------------------------------------------------------------------------
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "XrdSys/XrdSysTrace.hh"
+#include "XrdFileCachePurgeIndex.hh"
+#include "XrdFileCacheTrace.hh"
+
+using namespace XrdFileCache;
+
+// The log is a text file that starts with a header line followed by one
+// record per line:
+//   U <atime> <nBytes> <nAccess> <path>   -- add or update a file
+//   R <path>                              -- remove a file
+// A partially written last line (e.g. after a crash) is ignored.
+
+namespace
+{
+const char *LogHeader = "# pfc-purge-index v1\n";
+
+bool WriteAll(int fd, const char *buf, size_t len)
+{
+   while (len > 0)
+   {
+      ssize_t n = write(fd, buf, len);
+      if (n < 0)
+      {
+         if (errno == EINTR) continue;
+         return false;
+      }
+      buf += n;
+      len -= n;
+   }
+   return true;
+}
+
+void MakeUpdateRecord(std::string &rec, const std::string &path, long long nBytes, time_t atime, int nAccess)
+{
+   char buf[96];
+   snprintf(buf, sizeof(buf), "U %lld %lld %d ", (long long) atime, nBytes, nAccess);
+   rec += buf;
+   rec += path;
+   rec += '\n';
+}
+}
+
+const char *PurgeIndex::m_traceID = "PurgeIndex";
+
+//------------------------------------------------------------------------------
+
+PurgeIndex::PurgeIndex() :
+   m_trace(0),
+   m_nBytesTotal(0),
+   m_valid(false),
+   m_log_fd(-1),
+   m_log_records(0)
+{}
+
+PurgeIndex::~PurgeIndex()
+{
+   if (m_log_fd >= 0) close(m_log_fd);
+}
+
+//------------------------------------------------------------------------------
+
+bool PurgeIndex::Init(const char *log_path, XrdSysTrace *trace)
+{
+   XrdSysMutexHelper lock(&m_mutex);
+
+   m_trace = trace;
+
+   if ( ! log_path || ! *log_path) return false;
+
+   m_log_path = log_path;
+
+   m_valid = load_log();
+
+   m_log_fd = open(m_log_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+   if (m_log_fd < 0)
+   {
+      TRACE(Error, "Init() can not open log " << m_log_path << ", " << strerror(errno) <<
+            "; index will be kept in memory only.");
+      m_log_path.clear();
+      m_files.clear();
+      m_lru.clear();
+      m_nBytesTotal = 0;
+      m_valid = false;
+   }
+   else if (m_valid)
+   {
+      // Start from a clean log, this also drops a record cut short by a crash.
+      write_snapshot();
+   }
+
+   return m_valid;
+}
+
+bool PurgeIndex::IsValid()
+{
+   XrdSysMutexHelper lock(&m_mutex);
+   return m_valid;
+}
+
+void PurgeIndex::Invalidate()
+{
+   XrdSysMutexHelper lock(&m_mutex);
+   m_valid = false;
+}
+
+//------------------------------------------------------------------------------
+
+void PurgeIndex::BeginScan()
+{
+   XrdSysMutexHelper lock(&m_mutex);
+
+   m_files.clear();
+   m_lru.clear();
+   m_nBytesTotal = 0;
+   m_valid = false;
+}
+
+void PurgeIndex::EndScan()
+{
+   XrdSysMutexHelper lock(&m_mutex);
+
+   m_valid = true;
+   if (m_log_fd >= 0) write_snapshot();
+
+   TRACE(Info, "EndScan() index has " << m_files.size() << " files, " << m_nBytesTotal << " bytes.");
+}
+
+//------------------------------------------------------------------------------
+
+void PurgeIndex::Update(const std::string &path, long long nBytes, time_t atime, int nAccess)
+{
+   XrdSysMutexHelper lock(&m_mutex);
+
+   update_entry(path, nBytes, atime, nAccess);
+
+   // While the index is being rebuilt the snapshot written at the end of the
+   // scan includes this change.
+   if (m_valid && m_log_fd >= 0)
+   {
+      std::string rec;
+      MakeUpdateRecord(rec, path, nBytes, atime, nAccess);
+      append_log(rec.c_str(), rec.size());
+   }
+}
+
+void PurgeIndex::Remove(const std::string &path)
+{
+   XrdSysMutexHelper lock(&m_mutex);
+
+   if (m_files.find(path) == m_files.end()) return;
+
+   remove_entry(path);
+
+   if (m_valid && m_log_fd >= 0)
+   {
+      std::string rec("R ");
+      rec += path;
+      rec += '\n';
+      append_log(rec.c_str(), rec.size());
+   }
+}
+
+//------------------------------------------------------------------------------
+
+long long PurgeIndex::Oldest(long long n_bytes, time_t min_time, std::vector<FileInfo> &out)
+{
+   XrdSysMutexHelper lock(&m_mutex);
+
+   long long accum = 0;
+   for (Lru_i i = m_lru.begin(); i != m_lru.end(); ++i)
+   {
+      if ( ! (min_time > 0 && i->first < min_time) && accum >= n_bytes) break;
+
+      const Entry &e = m_files[*i->second];
+      out.push_back(FileInfo(*i->second, e.nBytes, i->first, e.nAccess));
+      accum += e.nBytes;
+   }
+
+   return m_nBytesTotal;
+}
+
+void PurgeIndex::Compact()
+{
+   XrdSysMutexHelper lock(&m_mutex);
+
+   if (m_valid && m_log_fd >= 0 && m_log_records > 2 * (long long) m_files.size() + 1024)
+   {
+      TRACE(Debug, "Compact() rewriting log with " << m_log_records << " records for " << m_files.size() << " files.");
+      write_snapshot();
+   }
+}
+
+//------------------------------------------------------------------------------
+// Private methods, called with m_mutex held.
+//------------------------------------------------------------------------------
+
+void PurgeIndex::update_entry(const std::string &path, long long nBytes, time_t atime, int nAccess)
+{
+   Files_i fi = m_files.find(path);
+
+   if (fi == m_files.end())
+   {
+      fi = m_files.insert(std::make_pair(path, Entry())).first;
+   }
+   else
+   {
+      m_nBytesTotal -= fi->second.nBytes;
+      m_lru.erase(fi->second.lru);
+   }
+
+   fi->second.nBytes  = nBytes;
+   fi->second.nAccess = nAccess;
+   fi->second.lru     = m_lru.insert(std::make_pair(atime, &fi->first));
+   m_nBytesTotal     += nBytes;
+}
+
+void PurgeIndex::remove_entry(const std::string &path)
+{
+   Files_i fi = m_files.find(path);
+
+   if (fi == m_files.end()) return;
+
+   m_nBytesTotal -= fi->second.nBytes;
+   m_lru.erase(fi->second.lru);
+   m_files.erase(fi);
+}
+
+//------------------------------------------------------------------------------
+
+bool PurgeIndex::load_log()
+{
+   FILE *fp = fopen(m_log_path.c_str(), "r");
+   if ( ! fp)
+   {
+      if (errno != ENOENT)
+      {
+         TRACE(Warning, "load_log() can not open " << m_log_path << ", " << strerror(errno));
+      }
+      return false;
+   }
+
+   char      *line = 0;
+   size_t     line_size = 0;
+   ssize_t    len;
+   bool       ok = false;
+   long long  n_rec = 0;
+
+   if ((len = getline(&line, &line_size, fp)) > 0 && strcmp(line, LogHeader) == 0)
+   {
+      ok = true;
+      while ((len = getline(&line, &line_size, fp)) > 0)
+      {
+         // A line without a newline was cut short by a crash, skip it.
+         if (line[len - 1] != '\n') break;
+         line[len - 1] = 0;
+
+         if (line[0] == 'U' && line[1] == ' ')
+         {
+            long long atime, nBytes;
+            int       nAccess, pos = 0;
+            if (sscanf(line + 2, "%lld %lld %d %n", &atime, &nBytes, &nAccess, &pos) == 3 && pos > 0 && line[2 + pos])
+            {
+               update_entry(line + 2 + pos, nBytes, (time_t) atime, nAccess);
+               ++n_rec;
+               continue;
+            }
+         }
+         else if (line[0] == 'R' && line[1] == ' ' && line[2])
+         {
+            remove_entry(line + 2);
+            ++n_rec;
+            continue;
+         }
+
+         TRACE(Warning, "load_log() malformed record in " << m_log_path << ": " << line);
+         ok = false;
+         break;
+      }
+   }
+   else
+   {
+      TRACE(Warning, "load_log() " << m_log_path << " does not start with a valid header.");
+   }
+
+   free(line);
+   fclose(fp);
+
+   if (ok)
+   {
+      m_log_records = n_rec;
+      TRACE(Info, "load_log() loaded " << m_files.size() << " files, " << m_nBytesTotal << " bytes from " << m_log_path);
+   }
+   else
+   {
+      m_files.clear();
+      m_lru.clear();
+      m_nBytesTotal = 0;
+   }
+
+   return ok;
+}
+
+void PurgeIndex::write_snapshot()
+{
+   std::string tmp_path = m_log_path + ".tmp";
+
+   int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if (fd < 0)
+   {
+      TRACE(Error, "write_snapshot() can not open " << tmp_path << ", " << strerror(errno));
+      return;
+   }
+
+   std::string buf(LogHeader);
+   bool        ok = true;
+   for (Lru_i i = m_lru.begin(); i != m_lru.end() && ok; ++i)
+   {
+      const Entry &e = m_files[*i->second];
+      MakeUpdateRecord(buf, *i->second, e.nBytes, i->first, e.nAccess);
+      if (buf.size() >= 64 * 1024)
+      {
+         ok = WriteAll(fd, buf.data(), buf.size());
+         buf.clear();
+      }
+   }
+   if (ok) ok = WriteAll(fd, buf.data(), buf.size());
+   if (ok) ok = (fsync(fd) == 0);
+   close(fd);
+
+   if ( ! ok || rename(tmp_path.c_str(), m_log_path.c_str()) != 0)
+   {
+      TRACE(Error, "write_snapshot() failed writing " << m_log_path << ", " << strerror(errno));
+      unlink(tmp_path.c_str());
+      return;
+   }
+
+   // The old descriptor refers to the replaced file.
+   int new_fd = open(m_log_path.c_str(), O_WRONLY | O_APPEND);
+   if (new_fd < 0)
+   {
+      TRACE(Error, "write_snapshot() can not reopen " << m_log_path << ", " << strerror(errno));
+      m_valid = false;
+      return;
+   }
+   close(m_log_fd);
+   m_log_fd = new_fd;
+   m_log_records = m_files.size();
+}
+
+void PurgeIndex::append_log(const char *rec, int len)
+{
+   if ( ! WriteAll(m_log_fd, rec, len))
+   {
+      TRACE(Error, "append_log() write to " << m_log_path << " failed, " << strerror(errno) <<
+            "; a rescan will be done on next purge.");
+      m_valid = false;
+      return;
+   }
+   ++m_log_records;
+}
@@ -0,0 +1,148 @@
+#ifndef __XRDFILECACHE_PURGE_INDEX_HH__
+#define __XRDFILECACHE_PURGE_INDEX_HH__
+//----------------------------------------------------------------------------------
+// Copyright (c) 2019 by Board of Trustees of the Leland Stanford, Jr., University
+// Author: Alja Mrak-Tadel, Matevz Tadel, Brian Bockelman
+//----------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//----------------------------------------------------------------------------------
+
+#include <time.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "XrdSys/XrdSysPthread.hh"
+
+class XrdSysTrace;
+
+namespace XrdFileCache
+{
+//----------------------------------------------------------------------------
+//! Index of cached files ordered by last access time, used by the purge
+//! instead of walking the cache namespace and reading every cinfo file.
+//!
+//! The index is kept up to date as files are detached, removed or created.
+//! It is built by a full scan of the cache at startup or on request. When a
+//! log path is given, every change is appended to the log and the index is
+//! reloaded from it at startup so that no scan is needed. The log is
+//! rewritten as a snapshot after a scan and when it has grown too long.
+//----------------------------------------------------------------------------
+class PurgeIndex
+{
+public:
+   struct FileInfo
+   {
+      std::string path;       //!< path of the cinfo file
+      long long   nBytes;     //!< bytes of data on disk
+      time_t      atime;      //!< time of last access
+      int         nAccess;    //!< number of recorded accesses
+
+      FileInfo(const std::string &p, long long n, time_t t, int a) :
+         path(p), nBytes(n), atime(t), nAccess(a) {}
+   };
+
+   PurgeIndex();
+   ~PurgeIndex();
+
+   //---------------------------------------------------------------------
+   //! Set up the index, loading it from the log when one is given.
+   //!
+   //! @param log_path   path of the log in the local file system or 0
+   //! @param trace      trace object for messages
+   //!
+   //! @return true if the index was loaded and is valid.
+   //---------------------------------------------------------------------
+   bool Init(const char *log_path, XrdSysTrace *trace);
+
+   //---------------------------------------------------------------------
+   //! True if the index reflects the cache, i.e. no scan is needed.
+   //---------------------------------------------------------------------
+   bool IsValid();
+
+   //---------------------------------------------------------------------
+   //! Request a full scan of the cache on the next purge cycle.
+   //---------------------------------------------------------------------
+   void Invalidate();
+
+   //---------------------------------------------------------------------
+   //! Clear the index before a full scan; mark it valid after the scan.
+   //---------------------------------------------------------------------
+   void BeginScan();
+   void EndScan();
+
+   //---------------------------------------------------------------------
+   //! Add or update a file.
+   //---------------------------------------------------------------------
+   void Update(const std::string &path, long long nBytes, time_t atime, int nAccess);
+
+   //---------------------------------------------------------------------
+   //! Remove a file.
+   //---------------------------------------------------------------------
+   void Remove(const std::string &path);
+
+   //---------------------------------------------------------------------
+   //! Collect purge candidates, least recently accessed first: all files
+   //! accessed before min_time (if not 0) and then as many more as are
+   //! needed to reach n_bytes.
+   //!
+   //! @return total number of bytes of all files in the index.
+   //---------------------------------------------------------------------
+   long long Oldest(long long n_bytes, time_t min_time, std::vector<FileInfo> &out);
+
+   //---------------------------------------------------------------------
+   //! Rewrite the log if it contains many stale records.
+   //---------------------------------------------------------------------
+   void Compact();
+
+private:
+   typedef std::multimap<time_t, const std::string*> Lru_t;
+   typedef Lru_t::iterator                           Lru_i;
+
+   struct Entry
+   {
+      long long nBytes;
+      int       nAccess;
+      Lru_i     lru;
+   };
+
+   typedef std::map<std::string, Entry> Files_t;
+   typedef Files_t::iterator            Files_i;
+
+   void update_entry(const std::string &path, long long nBytes, time_t atime, int nAccess);
+   void remove_entry(const std::string &path);
+   bool load_log();
+   void write_snapshot();
+   void append_log(const char *rec, int len);
+
+   XrdSysTrace* GetTrace() const { return m_trace; }
+
+   const static char *m_traceID;
+
+   XrdSysMutex  m_mutex;
+   XrdSysTrace *m_trace;
+
+   Files_t      m_files;
+   Lru_t        m_lru;
+   long long    m_nBytesTotal;
+   bool         m_valid;
+
+   std::string  m_log_path;
+   int          m_log_fd;
+   long long    m_log_records;
+};
+}
+
+#endif
@@ -35,11 +35,14 @@ public:
    //----------------------------------------------------------------------
    Stats() {
       m_BytesDisk = m_BytesRam = m_BytesMissed = 0;
+      m_PrefetchHit = m_PrefetchWaste = 0;
    }
 
    long long m_BytesDisk;         //!< number of bytes served from disk cache
    long long m_BytesRam;          //!< number of bytes served from RAM cache
    long long m_BytesMissed;       //!< number of bytes served directly from XrdCl
+   long long m_PrefetchHit;       //!< number of prefetched blocks that were later read
+   long long m_PrefetchWaste;     //!< number of prefetched blocks never read while file was open
 
    inline void AddStats(Stats &Src)
    {
@@ -48,6 +51,8 @@ public:
       m_BytesDisk   += Src.m_BytesDisk;
       m_BytesRam    += Src.m_BytesRam;
       m_BytesMissed += Src.m_BytesMissed;
+      m_PrefetchHit   += Src.m_PrefetchHit;
+      m_PrefetchWaste += Src.m_PrefetchWaste;
 
       m_MutexXfc.UnLock();
    }
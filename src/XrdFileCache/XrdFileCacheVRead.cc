@@ -1,3 +1,6 @@
+#include <climits>
+#include <algorithm>
+
 #include "XrdFileCacheFile.hh"
 #include "XrdFileCache.hh"
 #include "XrdFileCacheTrace.hh"
@@ -38,6 +41,12 @@ struct ReadVBlockListRAM
 
    bool AddEntry(Block* block, int chunkIdx)
    {
+      // Chunks usually come in order, check the last block first.
+      if ( ! bv.empty() && bv.back().block == block)
+      {
+         bv.back().arr->push_back(chunkIdx);
+         return false;
+      }
       for (std::vector<ReadVChunkListRAM>::iterator i = bv.begin(); i != bv.end(); ++i)
       {
          if (i->block == block)
@@ -59,6 +68,12 @@ struct ReadVBlockListDisk
 
    void AddEntry(int blockIdx, int chunkIdx)
    {
+      // Chunks usually come in order, check the last block first.
+      if ( ! bv.empty() && bv.back().block_idx == blockIdx)
+      {
+         bv.back().arr.push_back(chunkIdx);
+         return;
+      }
       for (std::vector<ReadVChunkListDisk>::iterator i = bv.begin(); i != bv.end(); ++i)
       {
          if (i->block_idx == blockIdx)
@@ -97,6 +112,23 @@ int File::ReadV(IO *io, const XrdOucIOVec *readV, int n)
    std::vector<XrdOucIOVec>       chunkVec;
    DirectResponseHandler         *direct_handler = 0;
 
+   // A file complete on disk is read without taking the file lock.
+   if (AtomicGet(m_fast_read))
+   {
+      const long long BS = m_cfi.GetBufferSize();
+      for (int i = 0; i < n; ++i)
+      {
+         const int last = (readV[i].offset + readV[i].size - 1) / BS;
+         for (int block_idx = readV[i].offset / BS; block_idx <= last; ++block_idx)
+         {
+            blocks_on_disk.AddEntry(block_idx, i);
+         }
+      }
+      bytesRead = VReadFromDisk(readV, n, blocks_on_disk, loc_stats);
+      m_stats.AddStats(loc_stats);
+      return bytesRead;
+   }
+
    m_downloadCond.Lock();
 
    if ( ! m_is_open)
@@ -114,6 +146,26 @@ int File::ReadV(IO *io, const XrdOucIOVec *readV, int n)
 
    VReadPreProcess(io, readV, n, blks_to_request, blocks_to_process, blocks_on_disk, chunkVec);
 
+   // Record the footprint of the vector read for prefetching. One that covers
+   // less than half of the blocks it spans is treated as a random access.
+   {
+      const long long BS = m_cfi.GetBufferSize();
+      int blk_min = INT_MAX, blk_max = -1, blk_cnt = 0;
+      for (int i = 0; i < n; ++i)
+      {
+         const int first = readV[i].offset / BS;
+         const int last  = (readV[i].offset + readV[i].size - 1) / BS;
+         blk_min  = std::min(blk_min, first);
+         blk_max  = std::max(blk_max, last);
+         blk_cnt += last - first + 1;
+         loc_stats.m_PrefetchHit += count_prefetch_hits(first, last);
+      }
+      if (blk_max >= 0)
+      {
+         record_access(io, blk_min, blk_max, 2 * blk_cnt < blk_max - blk_min + 1);
+      }
+   }
+
    m_downloadCond.UnLock();
 
    // ----------------------------------------------------------------
@@ -137,7 +189,7 @@ int File::ReadV(IO *io, const XrdOucIOVec *readV, int n)
    // disk read
    if (bytesRead >= 0)
    {
-      int dr = VReadFromDisk(readV, n, blocks_on_disk);
+      int dr = VReadFromDisk(readV, n, blocks_on_disk, loc_stats);
       if (dr < 0)
       {
          bytesRead = dr;
@@ -145,7 +197,6 @@ int File::ReadV(IO *io, const XrdOucIOVec *readV, int n)
       else
       {
          bytesRead += dr;
-         loc_stats.m_BytesDisk += dr;
       }
    }
 
@@ -252,11 +303,11 @@ void File::VReadPreProcess(IO *io, const XrdOucIOVec *readV, int n,
       {
          TRACEF(Dump, "VReadPreProcess chunk "<<  readV[iov_idx].size << "@"<< readV[iov_idx].offset);
 
-         BlockMap_i bi = m_block_map.find(block_idx);
-         if (bi != m_block_map.end())
+         Block *bi = m_block_map.Find(block_idx);
+         if (bi)
          {
-            if (blocks_to_process.AddEntry(bi->second, iov_idx))
-               inc_ref_count(bi->second);
+            if (blocks_to_process.AddEntry(bi, iov_idx))
+               inc_ref_count(bi);
 
             TRACEF(Dump, "VReadPreProcess block "<< block_idx <<" in map");
          }
@@ -269,7 +320,7 @@ void File::VReadPreProcess(IO *io, const XrdOucIOVec *readV, int n,
          else
          {
             Block *b;
-            if (Cache::GetInstance().RequestRAMBlock() && (b = PrepareBlockRequest(block_idx, io, false)) != 0)
+            if ((b = PrepareBlockRequest(block_idx, io, false)) != 0)
             {
                inc_ref_count(b);
                blocks_to_process.AddEntry(b, iov_idx);
@@ -295,12 +346,40 @@ void File::VReadPreProcess(IO *io, const XrdOucIOVec *readV, int n,
 
 //------------------------------------------------------------------------------
 
-int File::VReadFromDisk(const XrdOucIOVec *readV, int n, ReadVBlockListDisk& blocks_on_disk)
+int File::VReadFromDisk(const XrdOucIOVec *readV, int n, ReadVBlockListDisk& blocks_on_disk, Stats &stats)
 {
    int bytes_read = 0;
    for (std::vector<ReadVChunkListDisk>::iterator bit = blocks_on_disk.bv.begin(); bit != blocks_on_disk.bv.end(); ++bit )
    {
       int blockIdx = bit->block_idx;
+
+      // Copy all chunks of the block from the hot tier if it is there or
+      // gets admitted to it.
+      HotTier::Entry *e       = hot_tier_get(blockIdx);
+      int             hot_size = 0;
+      char           *hot_buf = e ? e->buf : hot_tier_load(blockIdx, hot_size);
+      if (hot_buf)
+      {
+         for (std::vector<int>::iterator chunkIt = bit->arr.begin(); chunkIt != bit->arr.end(); ++chunkIt)
+         {
+            long long off;     // offset in user buffer
+            long long blk_off; // offset in block
+            long long size;    // size to copy
+
+            overlap(blockIdx, m_cfi.GetBufferSize(), readV[*chunkIt].offset, readV[*chunkIt].size, off, blk_off, size);
+            memcpy(readV[*chunkIt].data + off, hot_buf + blk_off, size);
+
+            if (e) stats.m_BytesRam  += size;
+            else   stats.m_BytesDisk += size;
+            bytes_read += size;
+         }
+         TRACEF(Dump, "VReadFromDisk block= " << blockIdx << (e ? " from hot tier" : " loaded into hot tier"));
+
+         if (e) hot_tier_release(e);
+         else   hot_tier_insert(blockIdx, hot_buf, hot_size);
+         continue;
+      }
+
       for (std::vector<int>::iterator chunkIt = bit->arr.begin(); chunkIt != bit->arr.end(); ++chunkIt)
       {
          int chunkIdx = *chunkIt;
@@ -330,6 +409,7 @@ int File::VReadFromDisk(const XrdOucIOVec *readV, int n, ReadVBlockListDisk& blo
          }
 
          bytes_read += rs;
+         stats.m_BytesDisk += rs;
       }
    }
 
@@ -347,6 +427,24 @@ int File::VReadProcessBlocks(IO *io, const XrdOucIOVec *readV, int n,
    {
       std::vector<ReadVChunkListRAM> finished;
       BlockList_t                    to_reissue;
+
+      // Downloaded blocks are picked up without the file lock. It is only
+      // needed to handle failed blocks or to wait for more to arrive.
+      std::vector<ReadVChunkListRAM>::iterator bi = blocks_to_process.begin();
+      while (bi != blocks_to_process.end())
+      {
+         if (bi->block->is_ok())
+         {
+            finished.push_back(ReadVChunkListRAM(bi->block, bi->arr));
+            bi = blocks_to_process.erase(bi);
+         }
+         else
+         {
+            ++bi;
+         }
+      }
+
+      if (finished.empty())
       {
          XrdSysCondVarHelper _lck(m_downloadCond);
 
@@ -384,7 +482,7 @@ int File::VReadProcessBlocks(IO *io, const XrdOucIOVec *readV, int n,
       ProcessBlockRequests(to_reissue, false);
       to_reissue.clear();
 
-      std::vector<ReadVChunkListRAM>::iterator bi = finished.begin();
+      bi = finished.begin();
       while (bi != finished.end())
       {
          if (bi->block->is_ok())
@@ -45,6 +45,7 @@
 
 #include "XrdOss/XrdOssApi.hh"
 #include "XrdOss/XrdOssTrace.hh"
+#include "XrdOss/XrdOssUring.hh"
 #include "XrdSys/XrdSysError.hh"
 #include "XrdSys/XrdSysPlatform.hh"
 #include "XrdSys/XrdSysPthread.hh"
@@ -148,6 +149,14 @@ int XrdOssFile::Fsync(XrdSfsAio *aiop)
 int XrdOssFile::Read(XrdSfsAio *aiop)
 {
 
+// If the io_uring engine is active, use it. Should the ring be full we fall
+// back to whatever other method we would have otherwise used.
+//
+   if (XrdOssSys::ioUring)
+      {aiop->TIdent = tident;
+       if (XrdOssSys::ioUring->Read(fd, aiop)) return 0;
+      }
+
 #ifdef _POSIX_ASYNCHRONOUS_IO
    EPNAME("AioRead");
    int rc;
@@ -205,6 +214,14 @@ int XrdOssFile::Read(XrdSfsAio *aiop)
   
 int XrdOssFile::Write(XrdSfsAio *aiop)
 {
+
+// If the io_uring engine is active, use it. Should the ring be full we fall
+// back to whatever other method we would have otherwise used.
+//
+   if (XrdOssSys::ioUring)
+      {aiop->TIdent = tident;
+       if (XrdOssSys::ioUring->Write(fd, aiop)) return 0;
+      }
 #ifdef _POSIX_ASYNCHRONOUS_IO
    EPNAME("AioWrite");
    int rc;
@@ -274,6 +291,16 @@ extern "C" {extern void XrdOssAioWSH(int, siginfo_t *, void *);}
 
 int XrdOssSys::AioInit()
 {
+// If the io_uring engine was requested, start it. Failure is not fatal as we
+// simply fall back to the standard I/O methods.
+//
+   if (ioUrDepth > 0)
+      {const char *eText;
+       if (!(ioUring = XrdOssUring::Create(ioUrDepth, ioUrThreads, eText)))
+          OssEroute.Emsg("AioInit", errno, eText, "; using standard I/O.");
+          else OssEroute.Say("++++++ Using io_uring I/O engine.");
+      }
+
 #if defined(_POSIX_ASYNCHRONOUS_IO)
    EPNAME("AioInit");
    extern void *XrdOssAioWait(void *carg);
@@ -54,6 +54,7 @@
 #include "XrdOss/XrdOssError.hh"
 #include "XrdOss/XrdOssMio.hh"
 #include "XrdOss/XrdOssTrace.hh"
+#include "XrdOss/XrdOssUring.hh"
 #include "XrdOuc/XrdOucEnv.hh"
 #include "XrdOuc/XrdOucName2Name.hh"
 #include "XrdOuc/XrdOucPinLoader.hh"
@@ -86,6 +87,10 @@ XrdOucTrace OssTrace(&OssEroute);
 
 int       XrdOssSys::runOld  = 0;
 char      XrdOssSys::tryMmap = 0;
+
+XrdOssUring *XrdOssSys::ioUring     = 0;
+int          XrdOssSys::ioUrDepth   = 0;
+int          XrdOssSys::ioUrThreads = 2;
 char      XrdOssSys::chkMmap = 0;
 
 /******************************************************************************/
@@ -380,7 +385,9 @@ int XrdOssSys::Stats(char *buff, int blen)
 
 // If only size wanted, return what size we need
 //
-   if (!buff) return statflen + getStats(0,0);
+   if (!buff) return statflen + getStats(0,0)
+                              + (ioUring ? ioUring->Stats(0,0) : 0)
+                              + (tryMmap ? XrdOssMio::Stats(0,0) : 0);
 
 // Make sure we have enough space
 //
@@ -393,6 +400,20 @@ int XrdOssSys::Stats(char *buff, int blen)
    n = getStats(bp, blen);
    bp += n; blen -= n;
 
+// Generate io_uring statistics if we are using that engine
+//
+   if (ioUring)
+      {n = ioUring->Stats(bp, blen);
+       bp += n; blen -= n;
+      }
+
+// Generate memory mapped file statistics if we are mapping files
+//
+   if (tryMmap)
+      {n = XrdOssMio::Stats(bp, blen);
+       bp += n; blen -= n;
+      }
+
 // Add trailer
 //
    if (blen >= (int)sizeof(statfmt2))
@@ -756,6 +777,9 @@ int XrdOssFile::Open(const char *path, int Oflag, mode_t Mode, XrdOucEnv &Env)
           mopts |= OSSMIO_MLOK;
        if (popts & XRDEXP_MMAP  || Info.Attr.Flags & XrdFrcXAttrMem::memMap)
           mopts |= OSSMIO_MMAP;
+       if (!mopts && XrdOssMio::isHot() && popts & XRDEXP_NOTRW
+       &&  !(popts & XRDEXP_MMAP_X) && !(Oflag & (O_WRONLY | O_RDWR)))
+          mopts  = OSSMIO_HOT;
        if (mopts) mmFile = XrdOssMio::Map(local_path, fd, mopts);
       } else mmFile = 0;
 
@@ -843,6 +867,18 @@ ssize_t XrdOssFile::Read(void *buff, off_t offset, size_t blen)
 
      if (fd < 0) return (ssize_t)-XRDOSS_E8004;
 
+// If the file is memory mapped, copy whatever the mapping covers
+//
+     if (mmFile && offset >= 0)
+        {void *mBase;
+         off_t mSize = mmFile->Export(&mBase);
+         if (offset + (off_t)blen <= mSize)
+            {memcpy(buff, (char *)mBase + offset, blen);
+             XrdOssMio::Served((int)blen);
+             return (ssize_t)blen;
+            }
+        }
+
 #ifdef XRDOSSCX
      if (cxobj)  
         if (XrdOssSS->DirFlags & XrdOssNOSSDEC) return (ssize_t)-XRDOSS_E8021;
@@ -875,7 +911,14 @@ ssize_t XrdOssFile::Read(void *buff, off_t offset, size_t blen)
 ssize_t XrdOssFile::ReadV(XrdOucIOVec *readV, int n)
 {
    ssize_t rdsz, totBytes = 0;
-   int i;
+   int i = 0;
+
+// If we have an io_uring engine, submit the whole vector as a single batch.
+// Whatever the ring could not handle is read below.
+//
+   if (XrdOssSys::ioUring && n > 1
+   &&  ((i = XrdOssSys::ioUring->ReadV(fd, readV, n, totBytes)) >= n
+        || totBytes < 0)) return totBytes;
 
 // For platforms that support fadvise, pre-advise what we will be reading
 //
@@ -907,7 +950,7 @@ ssize_t XrdOssFile::ReadV(XrdOucIOVec *readV, int n)
 
 // Read in the vector and do a pre-advise if we support that
 //
-   for (i = 0; i < n; i++)
+   for (; i < n; i++)
        {do {rdsz = pread(fd, readV[i].data, readV[i].size, readV[i].offset);}
            while(rdsz < 0 && errno == EINTR);
         if (rdsz < 0 || rdsz != readV[i].size)
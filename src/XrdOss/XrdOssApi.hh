@@ -80,6 +80,7 @@ class oocx_CXFile;
 class XrdSfsAio;
 class XrdOssCache_FS;
 class XrdOssMioFile;
+class XrdOssUring;
   
 class XrdOssFile : public XrdOssDF
 {
@@ -194,6 +195,10 @@ int       Stats(char *bp, int bl);
 static int   AioInit();
 static int   AioAllOk;
 
+static XrdOssUring *ioUring;    // io_uring engine, if one is being used
+static int   ioUrDepth;         // io_uring ring depth (0 -> engine not wanted)
+static int   ioUrThreads;       // io_uring completion threads
+
 static int   runOld;            // Run in backward compatability mode
 
 static char  tryMmap;           // Memory mapped files enabled
@@ -344,6 +349,7 @@ int    xcache(XrdOucStream &Config, XrdSysError &Eroute);
 int    xcachescan(XrdOucStream &Config, XrdSysError &Eroute);
 int    xdefault(XrdOucStream &Config, XrdSysError &Eroute);
 int    xfdlimit(XrdOucStream &Config, XrdSysError &Eroute);
+int    xioeng(XrdOucStream &Config, XrdSysError &Eroute);
 int    xmaxsz(XrdOucStream &Config, XrdSysError &Eroute);
 int    xmemf(XrdOucStream &Config, XrdSysError &Eroute);
 int    xnml(XrdOucStream &Config, XrdSysError &Eroute);
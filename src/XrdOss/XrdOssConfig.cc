@@ -471,7 +471,7 @@ void XrdOssSys::ConfigMio(XrdSysError &Eroute)
 // Produce warnings if unsupported features have been selected
 //
 #if !defined(_POSIX_MAPPED_FILES)
-   if (flags & XRDEXP_MEMAP)
+   if (flags & XRDEXP_MEMAP || XrdOssMio::isHot())
       {Eroute.Say("Config warning: memory mapped files not supported; "
                              "feature disabled.");
        setoff = 1;
@@ -495,12 +495,13 @@ void XrdOssSys::ConfigMio(XrdSysError &Eroute)
       }
 #endif
 
-// If no memory flags are set, turn off memory mapped files
+// If no memory flags are set, turn off memory mapped files unless files are
+// to be mapped automatically. Otherwise, start expiring idle mappings.
 //
-   if (!(flags & XRDEXP_MEMAP) || setoff)
+   if ((!(flags & XRDEXP_MEMAP) && !XrdOssMio::isHot()) || setoff)
      {XrdOssMio::Set(0, 0, 0);
       tryMmap = 0; chkMmap = 0;
-     }
+     } else XrdOssMio::Start(Eroute);
 }
   
 /******************************************************************************/
@@ -976,6 +977,7 @@ int XrdOssSys::ConfigXeq(char *var, XrdOucStream &Config, XrdSysError &Eroute)
    TS_Xeq("cachescan",     xcachescan);
    TS_Xeq("defaults",      xdefault);
    TS_Xeq("fdlimit",       xfdlimit);
+   TS_Xeq("ioengine",      xioeng);
    TS_Xeq("maxsize",       xmaxsz);
    TS_Xeq("memfile",       xmemf);
    TS_Xeq("namelib",       xnml);
@@ -1196,6 +1198,71 @@ int XrdOssSys::xfdlimit(XrdOucStream &Config, XrdSysError &Eroute)
     return 0;
 }
   
+/******************************************************************************/
+/*                                x i o e n g                                 */
+/******************************************************************************/
+
+/* Function: xioeng
+
+   Purpose:  To parse the directive: ioengine {posix | uring [<opts>]}
+
+             posix    uses the standard I/O interfaces (the default).
+             uring    uses the Linux io_uring interface, when available, for
+                      vector and asynchronous reads and writes.
+
+             <opts>:  [depth <n>] [threads <n>]
+
+             depth    the minimum number of entries in the submission ring.
+                      The default is 256. The maximum is 4096.
+             threads  the number of threads servicing the completion ring.
+                      The default is 2. The maximum is 64.
+
+   Output: 0 upon success or !0 upon failure.
+*/
+
+int XrdOssSys::xioeng(XrdOucStream &Config, XrdSysError &Eroute)
+{
+    char *val;
+    int depth = 256, thrds = 2;
+
+      if (!(val = Config.GetWord()))
+         {Eroute.Emsg("Config", "ioengine type not specified"); return 1;}
+
+      if (!strcmp(val, "posix")) {ioUrDepth = 0; return 0;}
+
+      if (strcmp(val, "uring"))
+         {Eroute.Emsg("Config", "invalid ioengine type -", val); return 1;}
+
+      while((val = Config.GetWord()))
+           {     if (!strcmp(val, "depth"))
+                    {if (!(val = Config.GetWord()))
+                        {Eroute.Emsg("Config","ioengine depth not specified");
+                         return 1;
+                        }
+                     if (XrdOuca2x::a2i(Eroute,"ioengine depth",val,&depth,
+                                        8, 4096)) return 1;
+                    }
+            else if (!strcmp(val, "threads"))
+                    {if (!(val = Config.GetWord()))
+                        {Eroute.Emsg("Config","ioengine threads not specified");
+                         return 1;
+                        }
+                     if (XrdOuca2x::a2i(Eroute,"ioengine threads",val,&thrds,
+                                        1, 64)) return 1;
+                    }
+            else {Eroute.Emsg("Config","invalid ioengine option -",val); return 1;}
+           }
+
+#ifndef HAVE_IO_URING
+      Eroute.Say("Config warning: io_uring not supported; ioengine ignored.");
+      depth = 0;
+#endif
+
+      ioUrDepth   = depth;
+      ioUrThreads = thrds;
+      return 0;
+}
+  
 /******************************************************************************/
 /*                                x m a x s z                                 */
 /******************************************************************************/
@@ -1228,6 +1295,7 @@ int XrdOssSys::xmaxsz(XrdOucStream &Config, XrdSysError &Eroute)
 
    Purpose:  Parse the directive: memfile [off] [max <msz>]
                                           [check xattr] [preload]
+                                          [ttl <t>] [hot <n>[,<w>]]
 
              check      Applies memory mapping options based on file's xattrs.
                         For backward compatibility, we also accept:
@@ -1236,6 +1304,15 @@ int XrdOssSys::xmaxsz(XrdOucStream &Config, XrdSysError &Eroute)
              off        Disables memory mapping regardless of other options.
              on         Enables memory mapping
              preload    Preloads the file after every opn reference.
+             ttl        Unmaps a file <t> seconds after its last close instead
+                        of waiting until the memory is needed.
+             hot        Maps any file opened read-only <n> times within <w>
+                        seconds (default 60). Together, such files may use at
+                        most 1/4 of the memory available for mapping and
+                        they only displace each other. This is off by
+                        default and only applies to paths exported r/o that
+                        do not specify mmap or nommap, as with mmap, files
+                        must not be truncated while they are mapped.
              <msz>      Maximum amount of memory to use (can be n% or real mem).
 
    Output: 0 upon success or !0 upon failure.
@@ -1244,7 +1321,9 @@ int XrdOssSys::xmaxsz(XrdOucStream &Config, XrdSysError &Eroute)
 int XrdOssSys::xmemf(XrdOucStream &Config, XrdSysError &Eroute)
 {
     char *val;
+    char *comma;
     int i, j, V_check=-1, V_preld = -1, V_on=-1;
+    int V_ttl = -1, V_hotn = -1, V_hott = 0;
     long long V_max = 0;
 
     static struct mmapopts {const char *opname; int otyp;
@@ -1253,7 +1332,9 @@ int XrdOssSys::xmemf(XrdOucStream &Config, XrdSysError &Eroute)
         {"off",        0, ""},
         {"preload",    1, "memfile preload"},
         {"check",      2, "memfile check"},
-        {"max",        3, "memfile max"}};
+        {"max",        3, "memfile max"},
+        {"ttl",        4, "memfile ttl"},
+        {"hot",        5, "memfile hot"}};
     int numopts = sizeof(mmopts)/sizeof(struct mmapopts);
 
     if (!(val = Config.GetWord()))
@@ -1291,6 +1372,18 @@ int XrdOssSys::xmemf(XrdOucStream &Config, XrdSysError &Eroute)
                                                 mmopts[i].opmsg, val, &V_max,
                                                 10*1024*1024)) return 1;
                                   break;
+                          case 4: if (XrdOuca2x::a2tm(Eroute,mmopts[i].opmsg,
+                                                      val, &V_ttl, 0)) return 1;
+                                  break;
+                          case 5: if ((comma = index(val, ',')))
+                                     {*comma++ = '\0';
+                                      if (XrdOuca2x::a2tm(Eroute,
+                                          "memfile hot window", comma,
+                                          &V_hott, 1)) return 1;
+                                     }
+                                  if (XrdOuca2x::a2i(Eroute,mmopts[i].opmsg,
+                                                     val, &V_hotn, 0)) return 1;
+                                  break;
                           default: V_on = 0; break;
                          }
                   val = Config.GetWord();
@@ -1301,6 +1394,7 @@ int XrdOssSys::xmemf(XrdOucStream &Config, XrdSysError &Eroute)
 //
    XrdOssMio::Set(V_on, V_preld, V_check);
    XrdOssMio::Set(V_max);
+   XrdOssMio::SetCache(V_ttl, V_hotn, V_hott);
    return 0;
 }
 
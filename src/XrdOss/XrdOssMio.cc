@@ -39,6 +39,7 @@
 #endif
 
 #include "XrdSys/XrdSysPthread.hh"
+#include "XrdSys/XrdSysTimer.hh"
 #include "XrdOss/XrdOssMio.hh"
 #include "XrdOss/XrdOssMioFile.hh"
 #include "XrdOss/XrdOssTrace.hh"
@@ -48,8 +49,10 @@
 /******************************************************************************/
 
 XrdOucHash<XrdOssMioFile> XrdOssMio::MM_Hash;
+XrdOucHash<XrdOssMio::HotCount> XrdOssMio::MM_Hot;
 
 XrdSysMutex    XrdOssMio::MM_Mutex;
+XrdSysMutex    XrdOssMio::MM_SMutex;
 
 XrdOssMioFile *XrdOssMio::MM_Perm     = 0;
 XrdOssMioFile *XrdOssMio::MM_Idle     = 0;
@@ -67,25 +70,113 @@ long long      XrdOssMio::MM_pages    = (long long)sysconf(_SC_PHYS_PAGES);
 #endif
 long long      XrdOssMio::MM_max      = MM_pagsz*MM_pages/2;
 long long      XrdOssMio::MM_inuse    = 0;
+long long      XrdOssMio::MM_hotuse   = 0;
+int            XrdOssMio::MM_ttl      = 0;
+int            XrdOssMio::MM_hotn     = 0;
+int            XrdOssMio::MM_hott     = 60;
+
+long long      XrdOssMio::MM_hits     = 0;
+long long      XrdOssMio::MM_miss     = 0;
+long long      XrdOssMio::MM_evict    = 0;
+long long      XrdOssMio::MM_expire   = 0;
+long long      XrdOssMio::MM_served   = 0;
 
 extern XrdSysError OssEroute;
 
 extern XrdOucTrace OssTrace;
+
+namespace
+{
+// Maximum number of files whose opens are counted for automatic mapping
+//
+static const int MM_hotMax = 8192;
+}
   
+/******************************************************************************/
+/*                                 A d m i t                                  */
+/******************************************************************************/
+
+// Admit() can only be called if the caller has the MM_Mutex lock!
+//
+int XrdOssMio::Admit(const char *hashname, off_t fsize)
+{
+   HotCount *hp;
+   time_t now = time(0);
+
+// Empty files and files that would occupy too much of the cache are never
+// mapped automatically.
+//
+   if (fsize <= 0 || fsize > MM_max/4) return 0;
+
+// Count this open. The count starts anew whenever the window has passed. Keep
+// the table bounded by dropping stale counts (or all of them) when it's full.
+//
+   if (!(hp = MM_Hot.Find(hashname)))
+      {if (MM_Hot.Num() >= MM_hotMax)
+          {MM_Hot.Apply(HotPurge, (void *)&now);
+           if (MM_Hot.Num() >= MM_hotMax) MM_Hot.Purge();
+          }
+       hp = new HotCount;
+       hp->Start = now; hp->Count = 0;
+       MM_Hot.Add(hashname, hp);
+      } else if (now - hp->Start >= MM_hott) {hp->Start = now; hp->Count = 0;}
+
+// Admit the file once it has been opened often enough. All popular files
+// together may only use 1/4 of the cache. Make room by dropping idle popular
+// mappings; the file is not admitted if that isn't enough.
+//
+   if (++hp->Count < MM_hotn) return 0;
+   if (MM_hotuse + fsize > MM_max/4
+   &&  !Reclaim(MM_hotuse + fsize - MM_max/4, true)) return 0;
+   MM_Hot.Del(hashname);
+   return 1;
+}
+
 /******************************************************************************/
 /*                               D i s p l a y                                */
 /******************************************************************************/
 
 void XrdOssMio::Display(XrdSysError &Eroute)
 {
-     char buff[1080];
-     snprintf(buff, sizeof(buff), "       oss.memfile %s%s%s max %lld",
+     char buff[1080], tbuff[64] = "", hbuff[64] = "";
+     if (MM_ttl)  snprintf(tbuff, sizeof(tbuff), " ttl %d", MM_ttl);
+     if (MM_hotn) snprintf(hbuff, sizeof(hbuff), " hot %d,%d", MM_hotn, MM_hott);
+     snprintf(buff, sizeof(buff), "       oss.memfile %s%s%s max %lld%s%s",
              (MM_on      ? ""            : "off "),
              (MM_preld   ? "preload"     : ""),
-             (MM_chk     ? "check xattr" : ""), MM_max);
+             (MM_chk     ? "check xattr" : ""), MM_max, tbuff, hbuff);
      Eroute.Say(buff);
 }
 
+/******************************************************************************/
+/*                                E x p i r e                                 */
+/******************************************************************************/
+
+// Expire() can only be called if the caller has the MM_Mutex lock! The idle
+// list is ordered by the time of last close so only its head need be checked.
+//
+int XrdOssMio::Expire(time_t now)
+{
+   XrdOssMioFile *mp;
+   int n = 0;
+
+   while((mp = MM_Idle) && mp->Atime + MM_ttl <= now)
+        {Reclaim(mp);
+         Unmap(mp);
+         MM_expire++; n++;
+        }
+   return n;
+}
+
+/******************************************************************************/
+/*                              H o t P u r g e                               */
+/******************************************************************************/
+
+int XrdOssMio::HotPurge(const char *key, HotCount *hp, void *arg)
+{
+   return (*(time_t *)arg - hp->Start >= MM_hott ? -1 : 0);
+}
+
 /******************************************************************************/
 /*                                   M a p                                    */
 /******************************************************************************/
@@ -118,24 +209,49 @@ XrdOssMioFile *XrdOssMio::Map(char *path, int fd, int opts)
 //
    mapMutex.Lock(&MM_Mutex);
 
-// Check if we already have this mapping
+// Drop any idle mappings that have outlived their time to live
+//
+   if (MM_ttl && MM_Idle) Expire(time(0));
+
+// Check if we already have this mapping. The file's current size and mtime
+// must match the mapping's. An idle mapping of a file that has changed is
+// discarded and the file mapped anew. A mapping that is still in use cannot
+// be discarded, so the caller does without one.
 //
    if ((mp = MM_Hash.Find(hashname)))
-      {DEBUG("Reusing mmap; usecnt=" <<mp->inUse <<" path=" <<path);
-       if (!(mp->Status & OSSMIO_MPRM) && !mp->inUse) Reclaim(mp);
-       mp->inUse++;
-       return mp;
+      {if (mp->Mtime != statb.st_mtime || mp->Size != statb.st_size)
+          {if (mp->inUse || (mp->Status & OSSMIO_MPRM))
+              {DEBUG("Not reusing stale mmap for " <<path);
+               MM_miss++;
+               return 0;
+              }
+           DEBUG("Discarding stale mmap for " <<path);
+           Reclaim(mp);
+           Unmap(mp);
+          } else {
+           DEBUG("Reusing mmap; usecnt=" <<mp->inUse <<" path=" <<path);
+           if (!(mp->Status & OSSMIO_MPRM) && !mp->inUse) Reclaim(mp);
+           mp->inUse++;
+           MM_hits++;
+           return mp;
+          }
       }
+   MM_miss++;
 
-// Check if memory will be over committed
+// Files that are mapped only because they are popular must have been opened
+// often enough to be admitted.
+//
+   if (opts == OSSMIO_HOT && !Admit(hashname, statb.st_size)) return 0;
+
+// Check if memory will be over committed. Popular files never displace other
+// mappings, Admit() has already made room for them among their own kind.
 //
    if (MM_inuse + statb.st_size > MM_max)
-      {if (!Reclaim(statb.st_size))
+      {if (opts == OSSMIO_HOT || !Reclaim(statb.st_size))
           {OssEroute.Emsg("Mio", "Unable to reclaim enough storage to mmap",path);
            return 0;
           }
       }
-   MM_inuse += statb.st_size;
 
 // Memory map the file
 //
@@ -174,6 +290,7 @@ XrdOssMioFile *XrdOssMio::Map(char *path, int fd, int opts)
    mp->Size   = statb.st_size;
    mp->Dev    = statb.st_dev;
    mp->Ino    = statb.st_ino;
+   mp->Mtime  = statb.st_mtime;
    mp->Status = opts;
 
 // Add the mapping to our hash table
@@ -184,6 +301,8 @@ XrdOssMioFile *XrdOssMio::Map(char *path, int fd, int opts)
        delete mp;
        return 0;
       }
+   MM_inuse += statb.st_size;
+   if (opts == OSSMIO_HOT) MM_hotuse += statb.st_size;
 
 // If this is a permanent file, place it on the permanent queue
 //
@@ -235,25 +354,51 @@ void *XrdOssMio::preLoad(void *arg)
    return (void *)0;
 }
 
+/******************************************************************************/
+/*                                R e a p e r                                 */
+/******************************************************************************/
+
+void *XrdOssMio::Reaper(void *arg)
+{
+   EPNAME("MioReaper");
+   int n, naptime = (MM_ttl > 1 ? MM_ttl/2 : 1);
+
+// Periodically drop idle mappings whose time to live has passed. Map() also
+// does this but it may not be called for a long time.
+//
+   while(1)
+        {XrdSysTimer::Snooze(naptime);
+         MM_Mutex.Lock();
+         n = (MM_Idle ? Expire(time(0)) : 0);
+         MM_Mutex.UnLock();
+         if (n) {DEBUG("Expired " <<n <<" idle mappings.");}
+        }
+   return (void *)0;
+}
+
 /******************************************************************************/
 /*                               R e c l a i m                                */
 /******************************************************************************/
   
-// Reclaim() can only be called if the caller has the MM_Mutex lock!
+// Reclaim() can only be called if the caller has the MM_Mutex lock! The least
+// recently used idle mappings are at the head of the idle list. When hotOnly
+// is true, only mappings of popular files are reclaimed.
 //
-int XrdOssMio::Reclaim(off_t amount)
+int XrdOssMio::Reclaim(off_t amount, bool hotOnly)
 {
    EPNAME("MioReclaim");
-   XrdOssMioFile *mp;
+   XrdOssMioFile *mp, *np = MM_Idle;
    DEBUG("Trying to reclaim " <<amount <<" bytes.");
 
 // Try to reclaim memory
 //
-   while((mp = MM_Idle) && amount > 0)
-        {MM_Idle = mp->Next;
-         MM_inuse -= mp->Size;
-         amount   -= mp->Size;
-         MM_Hash.Del(mp->HashName);  // This will delete the object
+   while((mp = np) && amount > 0)
+        {np = mp->Next;
+         if (hotOnly && mp->Status != OSSMIO_HOT) continue;
+         amount -= mp->Size;
+         Reclaim(mp);
+         Unmap(mp);
+         MM_evict++;
         }
 
 // Indicate whether we cleared enough
@@ -263,25 +408,16 @@ int XrdOssMio::Reclaim(off_t amount)
 
 /******************************************************************************/
 
-int XrdOssMio::Reclaim(XrdOssMioFile *mp)
+void XrdOssMio::Reclaim(XrdOssMioFile *mp)
 {
-   EPNAME("MioReclaim");
-   XrdOssMioFile *pmp = 0, *cmp = MM_Idle;
-
-// Try to find the mapping
-//
-   while(cmp && mp != cmp) {pmp = cmp; cmp = cmp->Next;}
 
 // Remove mapping from the idle list
 //
-   if (cmp)
-      {if (pmp) pmp->Next = mp->Next;
-          else  MM_Idle   = mp->Next;
-       if (MM_IdleLast == cmp) MM_IdleLast = pmp;
-      }
-      else {DEBUG("Cannot find mapping for " <<mp->Dev <<':' <<mp->Ino);}
-
-   return (cmp != 0);
+   if (mp->Prev) mp->Prev->Next = mp->Next;
+      else       MM_Idle         = mp->Next;
+   if (mp->Next) mp->Next->Prev = mp->Prev;
+      else       MM_IdleLast     = mp->Prev;
+   mp->Next = mp->Prev = 0;
 }
  
 /******************************************************************************/
@@ -305,8 +441,10 @@ void XrdOssMio::Recycle(XrdOssMioFile *mp)
    if (!(mp->Status & OSSMIO_MPRM))
       {if (MM_IdleLast) MM_IdleLast->Next = mp;
           else MM_Idle = mp;
+       mp->Prev = MM_IdleLast;
        MM_IdleLast = mp;
        mp->Next = 0;
+       mp->Atime = time(0);
       }
 }
   
@@ -326,7 +464,76 @@ void XrdOssMio::Set(long long V_max)
    if (V_max > 0) MM_max = V_max;
       else if (V_max < 0) MM_max = MM_pagsz*MM_pages*(-V_max)/100;
 }
+
+void XrdOssMio::SetCache(int V_ttl, int V_hotn, int V_hott)
+{
+   if (V_ttl     >= 0) MM_ttl     = V_ttl;
+   if (V_hotn    >= 0) MM_hotn    = V_hotn;
+   if (V_hott    >  0) MM_hott    = V_hott;
+}
+
+/******************************************************************************/
+/*                                 S t a r t                                  */
+/******************************************************************************/
+
+void XrdOssMio::Start(XrdSysError &Eroute)
+{
+   pthread_t tid;
+   int retc;
+
+// Start the thread that expires idle mappings if they have a time to live
+//
+   if (MM_ttl > 0
+   && (retc = XrdSysThread::Run(&tid, Reaper, (void *)0, 0, "mmap reaper")))
+      Eroute.Emsg("Mio", retc, "create mmap reaper thread");
+}
+
+/******************************************************************************/
+/*                                 S t a t s                                  */
+/******************************************************************************/
+
+int XrdOssMio::Stats(char *buff, int blen)
+{
+   static const char statfmt[] = "<mio><hit>%lld</hit><miss>%lld</miss>"
+          "<evict>%lld</evict><expire>%lld</expire><files>%d</files>"
+          "<bytes>%lld</bytes><served>%lld</served></mio>";
+   long long hits, miss, evict, expire, inuse, served;
+   int n, files;
+
+// If only the size is wanted, return the size
+//
+   if (!buff) return sizeof(statfmt) + 16*7;
+
+// Get a consistent view of the counters
+//
+   MM_Mutex.Lock();
+   hits = MM_hits; miss = MM_miss; evict = MM_evict; expire = MM_expire;
+   inuse = MM_inuse; files = MM_Hash.Num();
+   MM_Mutex.UnLock();
+   AtomicBeg(MM_SMutex);
+   served = AtomicGet(MM_served);
+   AtomicEnd(MM_SMutex);
+
+// Format the statistics
+//
+   n = snprintf(buff, blen, statfmt, hits, miss, evict, expire, files,
+                inuse, served);
+   return (n < 0 ? 0 : (n < blen ? n : blen-1));
+}
  
+/******************************************************************************/
+/*                                 U n m a p                                  */
+/******************************************************************************/
+
+// Unmap() can only be called if the caller has the MM_Mutex lock!
+//
+void XrdOssMio::Unmap(XrdOssMioFile *mp)
+{
+   MM_inuse -= mp->Size;
+   if (mp->Status == OSSMIO_HOT) MM_hotuse -= mp->Size;
+   MM_Hash.Del(mp->HashName);  // This will delete the object
+}
+
 /******************************************************************************/
 /*             X r d O s s d M i o F i l e   D e s t r u c t o r              */
 /******************************************************************************/
@@ -32,6 +32,7 @@
 
 #include "XrdSys/XrdSysError.hh"
 #include "XrdOuc/XrdOucHash.hh"
+#include "XrdSys/XrdSysAtomics.hh"
 #include "XrdSys/XrdSysPthread.hh"
 #include "XrdOss/XrdOssMioFile.hh"
 
@@ -40,6 +41,7 @@
 #define OSSMIO_MLOK 0x0001
 #define OSSMIO_MMAP 0x0002
 #define OSSMIO_MPRM 0x0004
+#define OSSMIO_HOT  0x0008
   
 class XrdOssMio
 {
@@ -48,25 +50,49 @@ static void           Display(XrdSysError &Eroute);
 
 static char           isAuto() {return MM_chk;}
 
+static char           isHot()  {return MM_hotn > 0;}
+
 static char           isOn()   {return MM_on;}
 
 static XrdOssMioFile *Map(char *path, int fd, int opts);
 
 static void          *preLoad(void *arg);
 
+static void          *Reaper(void *arg);
+
 static void           Recycle(XrdOssMioFile *mp);
 
 static void           Set(int V_off, int V_preld, int V_check);
 
 static void           Set(long long V_max);
 
+static void           SetCache(int V_ttl, int V_hotn, int V_hott);
+
+static void           Start(XrdSysError &Eroute);
+
+static int            Stats(char *buff, int blen);
+
+static void           Served(int bytes)
+                            {AtomicBeg(MM_SMutex);
+                             AtomicAdd(MM_served, bytes);
+                             AtomicEnd(MM_SMutex);
+                            }
+
 private:
-static int  Reclaim(off_t amount);
-static int  Reclaim(XrdOssMioFile *mp);
+struct HotCount {time_t Start; int Count;};
+
+static int  Admit(const char *hashname, off_t fsize);
+static int  Expire(time_t now);
+static int  HotPurge(const char *key, HotCount *hp, void *arg);
+static int  Reclaim(off_t amount, bool hotOnly=false);
+static void Reclaim(XrdOssMioFile *mp);
+static void Unmap(XrdOssMioFile *mp);
 
 static XrdOucHash<XrdOssMioFile> MM_Hash;
+static XrdOucHash<HotCount>      MM_Hot;
 
 static XrdSysMutex    MM_Mutex;
+static XrdSysMutex    MM_SMutex;
 static XrdOssMioFile *MM_Perm;
 static XrdOssMioFile *MM_Idle;
 static XrdOssMioFile *MM_IdleLast;
@@ -79,5 +105,15 @@ static long long  MM_max;
 static long long  MM_pagsz;
 static long long  MM_pages;
 static long long  MM_inuse;
+static long long  MM_hotuse;
+static int        MM_ttl;
+static int        MM_hotn;
+static int        MM_hott;
+
+static long long  MM_hits;
+static long long  MM_miss;
+static long long  MM_evict;
+static long long  MM_expire;
+static long long  MM_served;
 };
 #endif
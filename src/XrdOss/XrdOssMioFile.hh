@@ -42,15 +42,18 @@ off_t Export(void **Addr) {*Addr = Base; return Size;}
 
        XrdOssMioFile(char *hname)
                     {strcpy(HashName, hname); 
-                     inUse = 1; Next = 0; Size = 0;
+                     inUse = 1; Next = 0; Prev = 0; Size = 0; Atime = 0;
                     }
       ~XrdOssMioFile();
 
 private:
 
 XrdOssMioFile *Next;
+XrdOssMioFile *Prev;
 dev_t          Dev;
 ino_t          Ino;
+time_t         Mtime;
+time_t         Atime;
 int            Status;
 int            inUse;
 void          *Base;
@@ -0,0 +1,529 @@
+/******************************************************************************/
+/*                                                                            */
+/*                        X r d O s s U r i n g . c c                         */
+/*                                                                            */
+/* (c) 2019 by the Board of Trustees of the Leland Stanford, Jr., University  */
+/*                            All Rights Reserved                             */
+/*   Produced by Andrew Hanushevsky for Stanford University under contract    */
+/*              DE-AC02-76-SFO0515 with the Department of Energy              */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#ifdef HAVE_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#include "XrdOss/XrdOssTrace.hh"
+#include "XrdOss/XrdOssUring.hh"
+#include "XrdOuc/XrdOucIOVec.hh"
+#include "XrdSfs/XrdSfsAio.hh"
+#include "XrdSys/XrdSysError.hh"
+#include "XrdSys/XrdSysTimer.hh"
+
+/******************************************************************************/
+/*                               G l o b a l s                                */
+/******************************************************************************/
+
+extern XrdOucTrace OssTrace;
+
+extern XrdSysError OssEroute;
+
+namespace
+{
+// The user data of each submission entry is either a pointer to an aio request
+// tagged in the low order bits or a pointer to an XrdOssUring::Req object.
+//
+static const unsigned long long udAioRead  = 1;
+static const unsigned long long udAioWrite = 2;
+static const unsigned long long udAioMask  = 3;
+
+// Each vector element is represented by one of these. They all point to the
+// batch that is waiting for the vector to complete.
+//
+class VecBatch
+{
+public:
+
+XrdSysMutex     vbMutex;
+XrdSysSemaphore vbDone;
+ssize_t         vbRC;
+int             vbPend;
+
+void            Done(ssize_t rc, int n=1)
+                    {vbMutex.Lock();
+                     if (rc < 0 && !vbRC) vbRC = rc;
+                     if (!(vbPend -= n)) vbDone.Post();
+                     vbMutex.UnLock();
+                    }
+
+                VecBatch(int n) : vbDone(0), vbRC(0), vbPend(n) {}
+               ~VecBatch() {}
+};
+
+class VecReq : public XrdOssUring::Req
+{
+public:
+
+VecBatch *batch;
+int       size;
+
+void      Done(int res)
+              {batch->Done(res == size ? 0 : (res < 0 ? res : -ESPIPE));}
+
+          VecReq() : batch(0), size(0) {}
+         ~VecReq() {}
+};
+
+void *Reaper(void *carg)
+{
+   XrdOssUring *urP = (XrdOssUring *)carg;
+
+   urP->Reap();
+   return (void *)0;
+}
+}
+
+#ifdef HAVE_IO_URING
+/******************************************************************************/
+/*                        S y s t e m   W r a p p e r s                       */
+/******************************************************************************/
+
+namespace
+{
+int ur_setup(unsigned int entries, struct io_uring_params *p)
+   {return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));}
+
+int ur_enter(int fd, unsigned int toSub, unsigned int minComp, unsigned int fl)
+   {return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSub, minComp,
+                                    fl, (void *)0, 0));}
+
+int ur_register(int fd, unsigned int opc, void *arg, unsigned int nargs)
+   {return static_cast<int>(syscall(__NR_io_uring_register,fd,opc,arg,nargs));}
+}
+#endif
+
+/******************************************************************************/
+/*                                C r e a t e                                 */
+/******************************************************************************/
+  
+XrdOssUring *XrdOssUring::Create(int depth, int thrds, const char *&eText)
+{
+#ifdef HAVE_IO_URING
+   XrdOssUring *urP = new XrdOssUring;
+   pthread_t tid;
+   int rc;
+
+// Initialize the rings
+//
+   if (!urP->Init(depth, eText)) {delete urP; return 0;}
+
+// Start the completion threads
+//
+   for (int i = 0; i < thrds; i++)
+       {if ((rc = XrdSysThread::Run(&tid, Reaper, (void *)urP, 0,
+                                    "io_uring completion")))
+           {errno = rc; eText = "start io_uring completion thread";
+            if (!i) return 0;   // The rings are simply never used
+            break;
+           }
+       }
+   return urP;
+#else
+   errno = ENOTSUP; eText = "use io_uring";
+   return 0;
+#endif
+}
+
+/******************************************************************************/
+/*                                  R e a d                                   */
+/******************************************************************************/
+  
+bool XrdOssUring::Read(int fd, XrdSfsAio *aiop)
+{
+   EPNAME("UringRead");
+   const char *tident = aiop->TIdent;
+
+   TRACE(Debug, "Read " <<aiop->sfsAio.aio_nbytes <<'@'
+                        <<aiop->sfsAio.aio_offset <<" started; aiocb="
+                        <<std::hex <<aiop <<std::dec);
+
+#ifdef HAVE_IO_URING
+   unsigned long long udata = reinterpret_cast<unsigned long long>(aiop);
+
+   return Submit(IORING_OP_READ, fd, (void *)aiop->sfsAio.aio_buf,
+                 aiop->sfsAio.aio_nbytes, aiop->sfsAio.aio_offset,
+                 udata | udAioRead);
+#else
+   return false;
+#endif
+}
+
+/******************************************************************************/
+/*                                  R e a p                                   */
+/******************************************************************************/
+  
+void XrdOssUring::Reap()
+{
+#ifdef HAVE_IO_URING
+   EPNAME("UringReap");
+   static const int maxReap = 64;
+   struct io_uring_cqe *cqeV = (struct io_uring_cqe *)cqes, cqe[maxReap];
+   unsigned int head, tail;
+   int i, n, rc;
+
+// Wait for completions and process them in batches. More than one thread may
+// be doing this so the completion ring is serialized.
+//
+   while(1)
+        {if ((rc = ur_enter(ringFD, 0, 1, IORING_ENTER_GETEVENTS)) < 0
+         &&  errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            {OssEroute.Emsg("Uring", errno, "wait for io_uring completions");
+             XrdSysTimer::Wait(1000);
+             continue;
+            }
+
+         do {cqMutex.Lock();
+             head = *cqHead;
+             tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+             for (n = 0; head != tail && n < maxReap; head++, n++)
+                 cqe[n] = cqeV[head & cqMask];
+             __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+             cqMutex.UnLock();
+
+             for (i = 0; i < n; i++)
+                 {unsigned long long udata = cqe[i].user_data;
+                  if (udata & udAioMask)
+                     {XrdSfsAio *aiop = reinterpret_cast<XrdSfsAio *>
+                                        (udata & ~udAioMask);
+                      DEBUG("aio completed for " <<aiop->TIdent <<"; result="
+                            <<cqe[i].res <<" aiocb=" <<std::hex <<aiop
+                            <<std::dec);
+                      aiop->Result = cqe[i].res;
+                      if (udata & udAioRead) aiop->doneRead();
+                         else                aiop->doneWrite();
+                     } else reinterpret_cast<Req *>(udata)->Done(cqe[i].res);
+                  Slots->Post();
+                 }
+            } while(n == maxReap);
+        }
+#endif
+}
+
+/******************************************************************************/
+/*                                 R e a d V                                  */
+/******************************************************************************/
+  
+int XrdOssUring::ReadV(int fd, XrdOucIOVec *readV, int n, ssize_t &rdRC)
+{
+#ifdef HAVE_IO_URING
+   VecBatch  batch(n);
+   VecReq   *vReq = new VecReq[n];
+   unsigned int tail;
+   int i, k, chunk, sent, nDone = 0;
+
+// Place the elements in the ring, as many at a time as the ring can hold, and
+// hand each group to the kernel with a single system call. Only one thread at
+// a time may wait for more than one slot or threads could starve each other.
+//
+   numVec++;
+   while(nDone < n)
+        {if ((chunk = n - nDone) > sqNum) chunk = sqNum;
+         slMutex.Lock();
+         for (k = 0; k < chunk; k++)
+             if (!Slots->CondWait()) {numWait++; Slots->Wait();}
+         slMutex.UnLock();
+
+         sqMutex.Lock();
+         tail = *sqTail;
+         for (k = 0; k < chunk; k++)
+             {i = nDone + k;
+              vReq[i].batch = &batch;
+              vReq[i].size  = readV[i].size;
+              Prep(tail+k, IORING_OP_READ, fd, readV[i].data, readV[i].size,
+                   readV[i].offset, reinterpret_cast<unsigned long long>
+                                    (static_cast<Req *>(&vReq[i])));
+             }
+         sent = Push(tail, chunk);
+         sqMutex.UnLock();
+
+         for (k = sent; k < chunk; k++) Slots->Post();
+         nDone += sent;
+         if (sent < chunk) break;
+        }
+
+// Elements that never made it into the ring will not complete. Then wait for
+// the rest as they refer to our stack.
+//
+   if (nDone < n) batch.Done(0, n - nDone);
+   batch.vbDone.Wait();
+   delete [] vReq;
+
+// Compute the result. A short read is the file's fault; any other error may
+// be the ring's so we let the caller redo the whole vector.
+//
+   rdRC = 0;
+   if (batch.vbRC)
+      {if (batch.vbRC != -ESPIPE) return 0;
+       rdRC = batch.vbRC;
+      } else for (i = 0; i < nDone; i++) rdRC += readV[i].size;
+   return nDone;
+#else
+   rdRC = 0;
+   return 0;
+#endif
+}
+
+/******************************************************************************/
+/*                                 S t a t s                                  */
+/******************************************************************************/
+  
+int XrdOssUring::Stats(char *buff, int blen)
+{
+   static const char statfmt[] = "<uring><vec>%lld</vec><aio>%lld</aio>"
+                                 "<sqe>%lld</sqe><wait>%lld</wait></uring>";
+
+// If only the size is wanted, return the size
+//
+   if (!buff) return sizeof(statfmt) + 16*4;
+
+// Format the statistics
+//
+   int n = snprintf(buff, blen, statfmt, numVec, numAio, numSQE, numWait);
+   return (n < 0 ? 0 : (n < blen ? n : blen-1));
+}
+
+/******************************************************************************/
+/*                                 W r i t e                                  */
+/******************************************************************************/
+  
+bool XrdOssUring::Write(int fd, XrdSfsAio *aiop)
+{
+   EPNAME("UringWrite");
+   const char *tident = aiop->TIdent;
+
+   TRACE(Debug, "Write " <<aiop->sfsAio.aio_nbytes <<'@'
+                         <<aiop->sfsAio.aio_offset <<" started; aiocb="
+                         <<std::hex <<aiop <<std::dec);
+
+#ifdef HAVE_IO_URING
+   unsigned long long udata = reinterpret_cast<unsigned long long>(aiop);
+
+   return Submit(IORING_OP_WRITE, fd, (void *)aiop->sfsAio.aio_buf,
+                 aiop->sfsAio.aio_nbytes, aiop->sfsAio.aio_offset,
+                 udata | udAioWrite);
+#else
+   return false;
+#endif
+}
+
+/******************************************************************************/
+/*                       P r i v a t e   M e t h o d s                        */
+/******************************************************************************/
+/******************************************************************************/
+/*                                  I n i t                                   */
+/******************************************************************************/
+  
+bool XrdOssUring::Init(int depth, const char *&eText)
+{
+#ifdef HAVE_IO_URING
+   static const int probeOps = 256;
+   struct io_uring_params uParms;
+   struct io_uring_probe *probe;
+   char *sqRing, *cqRing;
+   size_t sqSize, cqSize, probeSize;
+   bool isOK;
+
+// Setup the ring
+//
+   memset(&uParms, 0, sizeof(uParms));
+   if ((ringFD = ur_setup(depth, &uParms)) < 0)
+      {eText = "setup io_uring"; return false;}
+
+// Make sure the kernel supports the operations we need
+//
+   probeSize = sizeof(struct io_uring_probe)
+             + probeOps*sizeof(struct io_uring_probe_op);
+   probe = (struct io_uring_probe *)calloc(1, probeSize);
+   isOK  = ur_register(ringFD, IORING_REGISTER_PROBE, probe, probeOps) >= 0
+        && probe->last_op >= IORING_OP_WRITE
+        && (probe->ops[IORING_OP_READ ].flags & IO_URING_OP_SUPPORTED)
+        && (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED);
+   free(probe);
+   if (!isOK)
+      {close(ringFD); errno = ENOTSUP; eText = "probe io_uring"; return false;}
+
+// Map the submission and completion rings
+//
+   sqSize = uParms.sq_off.array + uParms.sq_entries*sizeof(unsigned int);
+   cqSize = uParms.cq_off.cqes  + uParms.cq_entries*sizeof(struct io_uring_cqe);
+   if (uParms.features & IORING_FEAT_SINGLE_MMAP)
+      {if (cqSize > sqSize) sqSize = cqSize;
+       cqSize = sqSize;
+      }
+
+   sqRing = (char *)mmap(0, sqSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+                         ringFD, IORING_OFF_SQ_RING);
+   if (sqRing == MAP_FAILED)
+      {close(ringFD); eText = "map io_uring submission ring"; return false;}
+
+   if (uParms.features & IORING_FEAT_SINGLE_MMAP) cqRing = sqRing;
+      else {cqRing = (char *)mmap(0, cqSize, PROT_READ|PROT_WRITE,
+                                  MAP_SHARED|MAP_POPULATE,
+                                  ringFD, IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED)
+               {close(ringFD); eText = "map io_uring completion ring";
+                return false;
+               }
+           }
+
+   sqes = mmap(0, uParms.sq_entries*sizeof(struct io_uring_sqe),
+               PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+               ringFD, IORING_OFF_SQES);
+   if (sqes == MAP_FAILED)
+      {close(ringFD); eText = "map io_uring submission entries"; return false;}
+
+// Establish all of the ring pointers
+//
+   sqHead  = (unsigned int *)(sqRing + uParms.sq_off.head);
+   sqTail  = (unsigned int *)(sqRing + uParms.sq_off.tail);
+   sqMask  = *(unsigned int *)(sqRing + uParms.sq_off.ring_mask);
+   sqArray = (unsigned int *)(sqRing + uParms.sq_off.array);
+   cqHead  = (unsigned int *)(cqRing + uParms.cq_off.head);
+   cqTail  = (unsigned int *)(cqRing + uParms.cq_off.tail);
+   cqMask  = *(unsigned int *)(cqRing + uParms.cq_off.ring_mask);
+   cqes    = cqRing + uParms.cq_off.cqes;
+
+// The number of requests in flight is limited to the submission ring size.
+// The completion ring is twice as large so it can never overflow.
+//
+   Slots   = new XrdSysSemaphore(uParms.sq_entries);
+   sqNum   = uParms.sq_entries;
+   numVec  = numAio = numSQE = numWait = 0;
+   return true;
+#else
+   errno = ENOTSUP; eText = "use io_uring";
+   return false;
+#endif
+}
+
+/******************************************************************************/
+/*                                  P r e p                                   */
+/******************************************************************************/
+
+// Caller must hold the sqMutex and a ring slot for the entry.
+  
+void XrdOssUring::Prep(unsigned int slot, int opc, int fd, void *buff,
+                       size_t blen, off_t offs, unsigned long long udata)
+{
+#ifdef HAVE_IO_URING
+   struct io_uring_sqe *sqe = &((struct io_uring_sqe *)sqes)[slot & sqMask];
+
+   memset(sqe, 0, sizeof(struct io_uring_sqe));
+   sqe->opcode    = static_cast<__u8>(opc);
+   sqe->fd        = fd;
+   sqe->addr      = reinterpret_cast<unsigned long long>(buff);
+   sqe->len       = static_cast<unsigned int>(blen);
+   sqe->off       = static_cast<unsigned long long>(offs);
+   sqe->user_data = udata;
+   sqArray[slot & sqMask] = slot & sqMask;
+#endif
+}
+
+/******************************************************************************/
+/*                                  P u s h                                   */
+/******************************************************************************/
+
+// Caller must hold the sqMutex. The cnt entries starting at tail are handed to
+// the kernel and the number it consumed is returned. Entries not consumed are
+// removed from the ring and never complete; the caller must handle them. As we
+// are the only submitter and the kernel only consumes entries while we are in
+// io_uring_enter(), the ring head tells us exactly how many were consumed.
+  
+int XrdOssUring::Push(unsigned int tail, int cnt)
+{
+#ifdef HAVE_IO_URING
+   unsigned int head;
+   int rc, done = 0;
+
+// Publish all of the entries at once and submit them
+//
+   __atomic_store_n(sqTail, tail+cnt, __ATOMIC_RELEASE);
+   while(done < cnt)
+        {if ((rc = ur_enter(ringFD, cnt-done, 0, 0)) > 0) done += rc;
+            else if (rc < 0 && errno == EINTR) continue;
+            else {if (!rc) errno = EAGAIN; break;}
+        }
+
+// If the kernel did not take everything, drop what remains
+//
+   if (done < cnt)
+      {head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+       done = static_cast<int>(head - tail);
+       __atomic_store_n(sqTail, head, __ATOMIC_RELEASE);
+      }
+   numSQE += done;
+   return done;
+#else
+   return 0;
+#endif
+}
+
+/******************************************************************************/
+/*                                S u b m i t                                 */
+/******************************************************************************/
+  
+bool XrdOssUring::Submit(int opc, int fd, void *buff, size_t blen,
+                         off_t offs, unsigned long long udata)
+{
+#ifdef HAVE_IO_URING
+   unsigned int tail;
+   int sent;
+
+// Obtain a ring slot. Asynchronous requests never wait for one; the caller
+// will simply fall back to the alternate method.
+//
+   if (!Slots->CondWait()) {errno = EAGAIN; return false;}
+
+// Fill out the next submission entry and hand it to the kernel
+//
+   sqMutex.Lock();
+   tail = *sqTail;
+   Prep(tail, opc, fd, buff, blen, offs, udata);
+   if ((sent = Push(tail, 1))) numAio++;
+   sqMutex.UnLock();
+
+   if (!sent) {Slots->Post(); return false;}
+   return true;
+#else
+   errno = ENOTSUP;
+   return false;
+#endif
+}
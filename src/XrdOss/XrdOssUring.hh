@@ -0,0 +1,127 @@
+#ifndef __XRDOSSURING_HH__
+#define __XRDOSSURING_HH__
+/******************************************************************************/
+/*                                                                            */
+/*                        X r d O s s U r i n g . h h                         */
+/*                                                                            */
+/* (c) 2019 by the Board of Trustees of the Leland Stanford, Jr., University  */
+/*                            All Rights Reserved                             */
+/*   Produced by Andrew Hanushevsky for Stanford University under contract    */
+/*              DE-AC02-76-SFO0515 with the Department of Energy              */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <sys/types.h>
+
+#include "XrdSys/XrdSysPthread.hh"
+
+struct XrdOucIOVec;
+class XrdSfsAio;
+
+/******************************************************************************/
+/*                           X r d O s s U r i n g                            */
+/******************************************************************************/
+
+// The XrdOssUring class implements an optional I/O engine based on the Linux
+// io_uring interface. Vector reads are submitted as a single batch and async
+// requests complete through the completion ring which is serviced by a small
+// number of threads. It is only available when the platform supports it and
+// the oss.ioengine directive selects it; otherwise the normal code is used.
+//
+class XrdOssUring
+{
+public:
+
+// Create an engine with a submission ring of at least <depth> entries that is
+// serviced by <thrds> completion threads. Upon failure, zero is returned and
+// eText describes what went wrong (errno holds the reason).
+//
+static XrdOssUring *Create(int depth, int thrds, const char *&eText);
+
+// Start an asynchronous read or write for the aio request. True is returned if
+// the request was queued. Otherwise, the caller must use an alternate method.
+//
+bool                Read (int fd, XrdSfsAio *aiop);
+
+bool                Write(int fd, XrdSfsAio *aiop);
+
+// Read a vector of elements as a batch. The number of leading elements that
+// were handled is returned; the caller must read the remaining ones some other
+// way. For those handled, rdRC is set as XrdOssFile::ReadV() would return it:
+// the total bytes read or -errno (-ESPIPE on short read). Should the ring fail
+// the read in a way that may not be the file's fault, zero is returned.
+//
+int                 ReadV(int fd, XrdOucIOVec *readV, int n, ssize_t &rdRC);
+
+// Process completions (only called by the completion threads).
+//
+void                Reap();
+
+// Return statistics in XML format
+//
+int                 Stats(char *buff, int blen);
+
+                    XrdOssUring() {}  // Use Create()
+                   ~XrdOssUring() {}  // Engine is never deleted
+
+// Requests placed on the ring refer to this object when not an aio request
+//
+class Req
+{
+public:
+virtual void Done(int res) = 0;
+             Req() {}
+virtual     ~Req() {}
+};
+
+private:
+
+bool                Init(int depth, const char *&eText);
+void                Prep(unsigned int slot, int opc, int fd, void *buff,
+                         size_t blen, off_t offs, unsigned long long udata);
+int                 Push(unsigned int tail, int cnt);
+bool                Submit(int opc, int fd, void *buff, size_t blen,
+                           off_t offs, unsigned long long udata);
+
+XrdSysMutex         sqMutex;
+XrdSysMutex         cqMutex;
+XrdSysMutex         slMutex;    // Serializes waiting for more than one slot
+XrdSysSemaphore    *Slots;      // Requests in flight limited to ring size
+
+int                 ringFD;
+int                 sqNum;      // Number of submission entries
+unsigned int        sqMask;
+unsigned int        cqMask;
+unsigned int       *sqHead;
+unsigned int       *sqTail;
+unsigned int       *sqArray;
+unsigned int       *cqHead;
+unsigned int       *cqTail;
+void               *sqes;
+void               *cqes;
+
+long long           numVec;     // Number of vector reads
+long long           numAio;     // Number of aio requests
+long long           numSQE;     // Number of submission entries
+long long           numWait;    // Number of times no ring slot was available
+};
+#endif
@@ -44,6 +44,8 @@
    Status:
       Public Domain
 */
+#include <pthread.h>
+
 #include "XrdOucCRC.hh"
 
 /*****************************************************************/
@@ -66,6 +68,8 @@
 /*                                                               */
 /*****************************************************************/
 
+unsigned int XrdOucCRC::crcslice[7][256];
+
 unsigned int XrdOucCRC::crctable[256] =
 {
  0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA,
@@ -161,14 +165,34 @@ unsigned int XrdOucCRC::crctable[256] =
      Compute CRC for complete buffer
      Use unsigned int instead of long to insure 32 bit values.
      Make this a C++ class.
+     Use slice-by-8 for the bulk of the buffer.
 */
 unsigned int XrdOucCRC::CRC32(const unsigned char *p, int reclen)
 {
+   static pthread_once_t onceInit = PTHREAD_ONCE_INIT;
    const unsigned int CRC32_XINIT = 0xffffffff;
    const unsigned int CRC32_XOROT = 0xffffffff;
-   unsigned int crc = CRC32_XINIT;
+   unsigned int one, two, crc = CRC32_XINIT;
+
+// Make sure the slice tables have been generated
+//
+   pthread_once(&onceInit, SliceInit);
 
-// Process each byte
+// Process eight bytes at a time (slice-by-8)
+//
+   while(reclen >= 8)
+        {one = crc ^ ((unsigned int)p[0]       | (unsigned int)p[1] <<  8
+                    | (unsigned int)p[2] << 16 | (unsigned int)p[3] << 24);
+         two =       ((unsigned int)p[4]       | (unsigned int)p[5] <<  8
+                    | (unsigned int)p[6] << 16 | (unsigned int)p[7] << 24);
+         crc = crcslice[6][ one        & 0xff] ^ crcslice[5][(one >>  8) & 0xff]
+             ^ crcslice[4][(one >> 16) & 0xff] ^ crcslice[3][ one >> 24        ]
+             ^ crcslice[2][ two        & 0xff] ^ crcslice[1][(two >>  8) & 0xff]
+             ^ crcslice[0][(two >> 16) & 0xff] ^ crctable   [ two >> 24        ];
+         p += 8; reclen -= 8;
+        }
+
+// Process each remaining byte
 //
    while(reclen-- > 0) crc = crctable[(crc ^ *p++) & 0xff] ^ (crc >> 8);
 
@@ -176,3 +200,24 @@ unsigned int XrdOucCRC::CRC32(const unsigned char *p, int reclen)
 //
    return crc ^ CRC32_XOROT;
 }
+
+/******************************************************************************/
+/*                             S l i c e I n i t                              */
+/******************************************************************************/
+
+// Generate the tables for slice-by-8 where crcslice[k-1] gives the crc of a
+// byte followed by k zero bytes.
+//
+void XrdOucCRC::SliceInit()
+{
+   unsigned int c;
+   int i, k;
+
+   for (i = 0; i < 256; i++)
+       {c = crctable[i];
+        for (k = 0; k < 7; k++)
+            {c = (c >> 8) ^ crctable[c & 0xff];
+             crcslice[k][i] = c;
+            }
+       }
+}
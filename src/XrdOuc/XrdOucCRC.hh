@@ -41,6 +41,9 @@ static unsigned int CRC32(const unsigned char *rec, int reclen);
 
 private:
 
+static void         SliceInit();
+
 static unsigned int crctable[256];
+static unsigned int crcslice[7][256];
 };
 #endif
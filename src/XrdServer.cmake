@@ -38,6 +38,7 @@ add_library(
   XrdXrootd/XrdXrootdPrepare.cc         XrdXrootd/XrdXrootdPrepare.hh
   XrdXrootd/XrdXrootdProtocol.cc        XrdXrootd/XrdXrootdProtocol.hh
   XrdXrootd/XrdXrootdResponse.cc        XrdXrootd/XrdXrootdResponse.hh
+  XrdXrootd/XrdXrootdRVPipe.cc          XrdXrootd/XrdXrootdRVPipe.hh
                                         XrdXrootd/XrdXrootdStat.icc
   XrdXrootd/XrdXrootdStats.cc           XrdXrootd/XrdXrootdStats.hh
   XrdXrootd/XrdXrootdTransit.cc         XrdXrootd/XrdXrootdTransit.hh
@@ -113,6 +114,7 @@ add_library(
   XrdOss/XrdOssSpace.cc        XrdOss/XrdOssSpace.hh
   XrdOss/XrdOssStage.cc        XrdOss/XrdOssStage.hh
   XrdOss/XrdOssStat.cc         XrdOss/XrdOssStatInfo.hh
+  XrdOss/XrdOssUring.cc        XrdOss/XrdOssUring.hh
                                XrdOss/XrdOssUnlink.cc
                                XrdOss/XrdOssError.hh
                                XrdOss/XrdOss.hh
@@ -148,6 +150,7 @@ add_library(
   XrdCms/XrdCmsReq.cc             XrdCms/XrdCmsReq.hh
   XrdCms/XrdCmsRTable.cc          XrdCms/XrdCmsRTable.hh
                                   XrdCms/XrdCmsTypes.hh
+                                  XrdCms/XrdCmsBitSet.hh
   XrdCms/XrdCmsUtils.cc           XrdCms/XrdCmsUtils.hh
                                   XrdCms/XrdCmsVnId.hh
 
@@ -176,6 +176,7 @@ add_library(
   #-----------------------------------------------------------------------------
   # XrdCks
   #-----------------------------------------------------------------------------
+  XrdCks/XrdCksAccel.cc            XrdCks/XrdCksAccel.hh
   XrdCks/XrdCksAssist.cc           XrdCks/XrdCksAssist.hh
   XrdCks/XrdCksCalccrc32.cc        XrdCks/XrdCksCalccrc32.hh
   XrdCks/XrdCksCalcmd5.cc          XrdCks/XrdCksCalcmd5.hh
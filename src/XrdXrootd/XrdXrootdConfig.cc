@@ -71,6 +71,7 @@
 #include "XrdXrootd/XrdXrootdMonitor.hh"
 #include "XrdXrootd/XrdXrootdPrepare.hh"
 #include "XrdXrootd/XrdXrootdProtocol.hh"
+#include "XrdXrootd/XrdXrootdRVPipe.hh"
 #include "XrdXrootd/XrdXrootdStats.hh"
 #include "XrdXrootd/XrdXrootdTrace.hh"
 #include "XrdXrootd/XrdXrootdTransit.hh"
@@ -224,6 +225,14 @@ int XrdXrootdProtocol::Configure(char *parms, XrdProtocol_Config *pi)
 //
    rdf = (parms && *parms ? parms : pi->ConfigFN);
    if (rdf && Config(rdf)) return 0;
+
+// If so configured, double buffer readv responses that span more than one
+// buffer. This needs the readv pipe threads.
+//
+   if (rv_pipemem && (n = XrdXrootdRVPipe::Start(rv_pipethr, rv_pipemem)))
+      {eDest.Emsg("Config", n, "start readv pipe threads; pipelining disabled");
+       rv_pipemem = 0;
+      }
    if (pi->DebugON) XrdXrootdTrace->What = TRACE_ALL;
 
 // Check if we are exporting a generic object name
@@ -487,6 +496,7 @@ int XrdXrootdProtocol::Config(const char *ConfigFN)
          if (ismine)
             {     if TS_Xeq("async",         xasync);
              else if TS_Xeq("chksum",        xcksum);
+             else if TS_Xeq("coalesce",      xcoal);
              else if TS_Xeq("diglib",        xdig);
              else if TS_Xeq("export",        xexp);
              else if TS_Xeq("fslib",         xfsl);
@@ -495,6 +505,7 @@ int XrdXrootdProtocol::Config(const char *ConfigFN)
              else if TS_Xeq("monitor",       xmon);
              else if TS_Xeq("pidpath",       xpidf);
              else if TS_Xeq("prep",          xprep);
+             else if TS_Xeq("readv",         xreadv);
              else if TS_Xeq("redirect",      xred);
              else if TS_Xeq("seclib",        xsecl);
              else if TS_Xeq("trace",         xtrace);
@@ -782,6 +793,49 @@ int XrdXrootdProtocol::xcksum(XrdOucStream &Config)
    return 0;
 }
   
+/******************************************************************************/
+/*                                 x c o a l                                  */
+/******************************************************************************/
+
+/* Function: xcoal
+
+   Purpose:  To parse the directive: coalesce {off | <bsz> [max <msz>]}
+
+             <bsz>     the size of the per-connection buffer in which small
+                       responses are held back while requests are being
+                       processed. They are sent together when the connection
+                       waits for new requests. Specify off (the default) to
+                       send each response as soon as it is produced.
+             max <msz> responses longer than <msz> bytes are never held back.
+                       The default is a quarter of <bsz>.
+
+   Output: 0 upon success or !0 upon failure.
+*/
+int XrdXrootdProtocol::xcoal(XrdOucStream &Config)
+{   long long bsz, msz;
+    char *val;
+
+    if (!(val = Config.GetWord()))
+       {eDest.Emsg("Config", "coalesce buffer size not specified"); return 1;}
+
+    if (!strcmp("off", val)) {co_buffsz = co_maxmsg = 0; return 0;}
+    if (XrdOuca2x::a2sz(eDest, "coalesce buffer size", val,
+                                &bsz, 512, 1024*1024)) return 1;
+    co_buffsz = static_cast<int>(bsz);
+    co_maxmsg = co_buffsz/4;
+
+    if ((val = Config.GetWord()))
+       {if (strcmp("max", val))
+           {eDest.Emsg("Config", "invalid coalesce option -", val); return 1;}
+        if (!(val = Config.GetWord()))
+           {eDest.Emsg("Config", "coalesce max value not specified"); return 1;}
+        if (XrdOuca2x::a2sz(eDest, "coalesce max", val,
+                                    &msz, 1, co_buffsz)) return 1;
+        co_maxmsg = static_cast<int>(msz);
+       }
+    return 0;
+}
+
 /******************************************************************************/
 /*                                  x d i g                                   */
 /******************************************************************************/
@@ -1387,6 +1441,58 @@ int XrdXrootdProtocol::xprep(XrdOucStream &Config)
    return 0;
 }
 
+/******************************************************************************/
+/*                                x r e a d v                                 */
+/******************************************************************************/
+
+/* Function: xreadv
+
+   Purpose:  To parse the directive: readv [pipeline {off | <maxmem>}]
+                                               [threads <n>]
+
+         pipeline <maxmem> enables pipelining of readv responses that span
+                           more than one buffer; one buffer is read while the
+                           previous one is sent. Each such response needs one
+                           extra buffer and <maxmem> is the maximum amount of
+                           memory these may use across all links; a response
+                           that does not fit is read and sent serially. The
+                           default is off (always read and send serially).
+         threads  <n>      the number of threads that read pipelined readv
+                           data. The default is 8.
+
+   Output: 0 upon success or !0 upon failure.
+*/
+int XrdXrootdProtocol::xreadv(XrdOucStream &Config)
+{   long long pmem;
+    char *val;
+
+    if (!(val = Config.GetWord()))
+       {eDest.Emsg("Config", "readv options not specified"); return 1;}
+
+        do { if (!strcmp("pipeline", val))
+                {if (!(val = Config.GetWord()))
+                    {eDest.Emsg("Config", "readv pipeline value not specified");
+                     return 1;
+                    }
+                 if (!strcmp("off", val)) rv_pipemem = 0;
+                    else {if (XrdOuca2x::a2sz(eDest, "readv pipeline", val,
+                                              &pmem, 0, 0x7fffffff)) return 1;
+                          rv_pipemem = static_cast<int>(pmem);
+                         }
+                }
+        else if (!strcmp("threads", val))
+                {if (!(val = Config.GetWord()))
+                    {eDest.Emsg("Config", "readv threads value not specified");
+                     return 1;
+                    }
+                 if (XrdOuca2x::a2i(eDest,"readv threads",val,&rv_pipethr,1,256))
+                    return 1;
+                }
+        else eDest.Emsg("Config", "Warning, invalid readv option", val);
+       } while((val = Config.GetWord()));
+   return 0;
+}
+
 /******************************************************************************/
 /*                                  x r e d                                   */
 /******************************************************************************/
@@ -109,6 +109,10 @@ int                   XrdXrootdProtocol::as_force     = 0;
 int                   XrdXrootdProtocol::as_noaio     = 0;
 int                   XrdXrootdProtocol::as_nosf      = 0;
 int                   XrdXrootdProtocol::as_syncw     = 0;
+int                   XrdXrootdProtocol::rv_pipemem   = 0;
+int                   XrdXrootdProtocol::rv_pipethr   = 8;
+int                   XrdXrootdProtocol::co_buffsz    = 0;
+int                   XrdXrootdProtocol::co_maxmsg    = 0;
 
 const char           *XrdXrootdProtocol::myInst  = 0;
 const char           *XrdXrootdProtocol::TraceID = "Protocol";
@@ -328,6 +332,8 @@ int dlen, rc;
    SI->Bump(SI->Count);
    xp->Link = lp;
    xp->Response.Set(lp);
+   if (co_buffsz && !lp->setCoalesce(co_buffsz, co_maxmsg))
+      eDest.Emsg("Protocol", ENOMEM, "allocate coalescing buffer for", lp->ID);
    strcpy(xp->Entity.prot, "host");
    xp->Entity.host = (char *)lp->Host();
    xp->Entity.addrInfo = lp->AddrInfo();
@@ -66,6 +66,7 @@
 
 class XrdNetSocket;
 class XrdOucEnv;
+struct XrdOucIOVec;
 class XrdOucErrInfo;
 class XrdOucReqID;
 class XrdOucStream;
@@ -83,6 +84,7 @@ class XrdXrootdAioReq;
 class XrdXrootdFile;
 class XrdXrootdFileLock;
 class XrdXrootdFileTable;
+class XrdXrootdRVPipe;
 class XrdXrootdJob;
 class XrdXrootdMonitor;
 class XrdXrootdPio;
@@ -166,6 +168,10 @@ enum RD_func {RD_chmod = 0, RD_chksum,  RD_dirlist, RD_locate, RD_mkdir,
        int   do_Qxattr();
        int   do_Read();
        int   do_ReadV();
+       int   do_ReadVPipe(XrdOucIOVec *rdVec, XrdXrootdFile **fileV,
+                          int rdVecNum, int Quantum);
+       int   do_ReadVSF(XrdOucIOVec *rdVec, XrdXrootdFile **fileV,
+                        int rdVecNum, int Quantum);
        int   do_ReadAll(int asyncOK=1);
        int   do_ReadNone(int &retc, int &pathID);
        int   do_Rm();
@@ -206,11 +212,15 @@ static void  PidFile();
        void  Reset();
 static int   rpCheck(char *fn, char **opaque);
        int   rpEmsg(const char *op, char *fn);
+       void  rvMonitor(XrdOucIOVec *rdVec, XrdXrootdFile **fileV, int rdVecNum);
+       void  rvStage(XrdXrootdRVPipe &rvP, XrdOucIOVec *rdVec,
+                     XrdXrootdFile **fileV, int rdBeg, int rdVecNum, int Quantum);
        int   vpEmsg(const char *op, char *fn);
 static int   Squash(char *);
 static int   xapath(XrdOucStream &Config);
 static int   xasync(XrdOucStream &Config);
 static int   xcksum(XrdOucStream &Config);
+static int   xcoal(XrdOucStream &Config);
 static int   xdig(XrdOucStream &Config);
 static int   xexp(XrdOucStream &Config);
 static int   xexpdo(char *path, int popt=0);
@@ -219,6 +229,7 @@ static int   xfsL(XrdOucStream &Config, char *val, int lix);
 static int   xfso(XrdOucStream &Config);
 static int   xpidf(XrdOucStream &Config);
 static int   xprep(XrdOucStream &Config);
+static int   xreadv(XrdOucStream &Config);
 static int   xlog(XrdOucStream &Config);
 static int   xmon(XrdOucStream &Config);
 static int   xred(XrdOucStream &Config);
@@ -310,6 +321,10 @@ static int                 maxBuffsz;    // Maximum buffer size we can have
 static int                 maxTransz;    // Maximum transfer size we can have
 static const int           maxRvecsz = 1024;   // Maximum read vector size
 static const int           maxWvecsz = 1024;   // Maximum writ vector size
+static int                 rv_pipemem;   // Max readv pipe memory in flight
+static int                 rv_pipethr;   // Number of readv pipe threads
+static int                 co_buffsz;    // Output coalescing buffer size
+static int                 co_maxmsg;    // Largest message that is coalesced
 
 // Statistical area
 //
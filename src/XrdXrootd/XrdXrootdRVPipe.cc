@@ -0,0 +1,159 @@
+/******************************************************************************/
+/*                                                                            */
+/*                    X r d X r o o t d R V P i p e . c c                     */
+/*                                                                            */
+/* (c) 2019 by the Board of Trustees of the Leland Stanford, Jr., University  */
+/*                            All Rights Reserved                             */
+/*   Produced by Andrew Hanushevsky for Stanford University under contract    */
+/*              DE-AC02-76-SFO0515 with the Department of Energy              */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <errno.h>
+
+#include "XrdOuc/XrdOucIOVec.hh"
+#include "XrdXrootd/XrdXrootdFile.hh"
+#include "XrdXrootd/XrdXrootdRVPipe.hh"
+
+/******************************************************************************/
+/*                        S t a t i c   M e m b e r s                         */
+/******************************************************************************/
+
+XrdSysCondVar    XrdXrootdRVPipe::rvCV(0, "readv pipe");
+XrdXrootdRVPipe *XrdXrootdRVPipe::rvFirst = 0;
+XrdXrootdRVPipe *XrdXrootdRVPipe::rvLast  = 0;
+int              XrdXrootdRVPipe::rvMemMax = 0;
+int              XrdXrootdRVPipe::rvMemUse = 0;
+
+/******************************************************************************/
+/*                                  F i l l                                   */
+/******************************************************************************/
+  
+bool XrdXrootdRVPipe::Fill()
+{
+   XrdXrootdFile *fP;
+   XrdSfsXferSize rdAmt, xfrSZ;
+   int i = rdBeg, j;
+
+// Issue one readv for each run of elements that refer to the same file. Any
+// short read is an error as we have already promised the data to the client.
+//
+   while(i < rdEnd)
+        {fP = fileV[i]; rdAmt = 0;
+         for (j = i; j < rdEnd && fileV[j] == fP; j++) rdAmt += rdVec[j].size;
+         xfrSZ = fP->XrdSfsp->readv(&rdVec[i], j-i);
+         if (xfrSZ != rdAmt)
+            {if (xfrSZ >= 0)
+                {xfrSZ = SFS_ERROR;
+                 fP->XrdSfsp->error.setErrInfo(-ENODATA,"readv past EOF");
+                }
+             errFile = fP; rdRC = xfrSZ;
+             return false;
+            }
+         i = j;
+        }
+   return true;
+}
+
+/******************************************************************************/
+/*                               R e s e r v e                                */
+/******************************************************************************/
+
+bool XrdXrootdRVPipe::Reserve(int amt)
+{
+   bool isOK;
+
+// Account for another buffer in flight if it fits in the budget
+//
+   rvCV.Lock();
+   if ((isOK = (rvMemMax - rvMemUse >= amt))) rvMemUse += amt;
+   rvCV.UnLock();
+   return isOK;
+}
+
+/******************************************************************************/
+/*                                   R u n                                    */
+/******************************************************************************/
+
+void XrdXrootdRVPipe::Run()
+{
+   rvCV.Lock();
+   Next = 0;
+   if (rvLast) rvLast->Next = this;
+      else rvFirst = this;
+   rvLast = this;
+   rvCV.Signal();
+   rvCV.UnLock();
+}
+
+/******************************************************************************/
+/*                                 S t a r t                                  */
+/******************************************************************************/
+
+int XrdXrootdRVPipe::Start(int numThreads, int memMax)
+{
+   pthread_t tid;
+   int i;
+
+// Set the memory budget for buffers in flight
+//
+   rvMemMax = memMax;
+
+// Start the pipe threads. We only fail if we could not start any of them.
+//
+   for (i = 0; i < numThreads; i++)
+       if (XrdSysThread::Run(&tid, Worker, 0, 0, "readv pipe"))
+          return (i ? 0 : errno);
+   return 0;
+}
+
+/******************************************************************************/
+/*                             U n r e s e r v e                              */
+/******************************************************************************/
+
+void XrdXrootdRVPipe::Unreserve(int amt)
+{
+   rvCV.Lock();
+   rvMemUse -= amt;
+   rvCV.UnLock();
+}
+
+/******************************************************************************/
+/*                                W o r k e r                                 */
+/******************************************************************************/
+
+void *XrdXrootdRVPipe::Worker(void *)
+{
+   XrdXrootdRVPipe *sP;
+
+// Fill stages in the order they were queued
+//
+   while(1)
+        {rvCV.Lock();
+         while(!(sP = rvFirst)) rvCV.Wait();
+         if (!(rvFirst = sP->Next)) rvLast = 0;
+         rvCV.UnLock();
+         sP->Fill();
+         sP->Done.Post();
+        }
+   return (void *)0;
+}
@@ -0,0 +1,101 @@
+#ifndef __XRDXROOTDRVPIPE_HH__
+#define __XRDXROOTDRVPIPE_HH__
+/******************************************************************************/
+/*                                                                            */
+/*                    X r d X r o o t d R V P i p e . h h                     */
+/*                                                                            */
+/* (c) 2019 by the Board of Trustees of the Leland Stanford, Jr., University  */
+/*                            All Rights Reserved                             */
+/*   Produced by Andrew Hanushevsky for Stanford University under contract    */
+/*              DE-AC02-76-SFO0515 with the Department of Energy              */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include "XrdSfs/XrdSfsInterface.hh"
+#include "XrdSys/XrdSysPthread.hh"
+
+class XrdBuffer;
+class XrdXrootdFile;
+struct XrdOucIOVec;
+
+/******************************************************************************/
+/*                       X r d X r o o t d R V P i p e                        */
+/******************************************************************************/
+
+// A readv pipe stage fills one response buffer with the data for a range of
+// readv elements. Stages are run by a small dedicated set of threads, never by
+// the scheduler, as the link thread waits for them while it holds a scheduler
+// slot. A link has at most one stage in progress so that a file is never read
+// by more than one thread at a time; the stage fills the next buffer while the
+// link thread sends the previous one. The extra buffers used by all links must
+// fit in the memory budget given to Start(); a link that cannot Reserve() one
+// reads and sends its readv response serially.
+//
+class XrdXrootdRVPipe
+{
+public:
+
+XrdBuffer        *Buff;      // -> Response buffer for this stage
+XrdXrootdFile    *errFile;   // -> File that failed, if any
+int               rdBeg;     // First readv element in this stage
+int               rdEnd;     // One past the last element in this stage
+int               rdLen;     // Response length (headers included)
+XrdSfsXferSize    rdRC;      // Result of the failing read
+
+bool              Fill();
+
+static bool       Reserve(int amt);
+static void       Unreserve(int amt);
+
+void              Run();     // Queue this stage for a pipe thread
+
+void              Set(XrdXrootdFile **fV, XrdOucIOVec *rV, int beg, int end,
+                      int len)
+                     {fileV = fV; rdVec = rV; rdBeg = beg; rdEnd = end;
+                      rdLen = len; errFile = 0; rdRC = 0;
+                     }
+
+static int        Start(int numThreads, int memMax);  // Returns 0 or errno
+
+void              Wait() {Done.Wait();}
+
+static void      *Worker(void *);
+
+                  XrdXrootdRVPipe() : Buff(0), errFile(0), rdBeg(0), rdEnd(0),
+                                      rdLen(0), rdRC(0), Done(0), Next(0),
+                                      fileV(0), rdVec(0) {}
+                 ~XrdXrootdRVPipe() {}
+
+private:
+
+static XrdSysCondVar    rvCV;
+static XrdXrootdRVPipe *rvFirst;
+static XrdXrootdRVPipe *rvLast;
+static int              rvMemMax;
+static int              rvMemUse;
+
+XrdSysSemaphore   Done;
+XrdXrootdRVPipe  *Next;
+XrdXrootdFile   **fileV;
+XrdOucIOVec      *rdVec;
+};
+#endif
@@ -57,6 +57,7 @@
 #include "XrdXrootd/XrdXrootdPio.hh"
 #include "XrdXrootd/XrdXrootdPrepare.hh"
 #include "XrdXrootd/XrdXrootdProtocol.hh"
+#include "XrdXrootd/XrdXrootdRVPipe.hh"
 #include "XrdXrootd/XrdXrootdStats.hh"
 #include "XrdXrootd/XrdXrootdTrace.hh"
 #include "XrdXrootd/XrdXrootdXPath.hh"
@@ -2309,6 +2310,7 @@ int XrdXrootdProtocol::do_ReadV()
    XrdSfsXferSize rdVAmt, rdVXfr, xfrSZ = 0;
    int rdVBeg, rdVBreak, rdVNow, rdVNum, rdVecNum;
    int currFH, i, k, Quantum, Qleft, rdVecLen = Request.header.dlen;
+   bool doPipe, doSF;
    int rvMon = Monitor.InOut();
    int ioMon = (rvMon > 1);
    char *buffp, vType = (ioMon ? XROOTD_MON_READU : XROOTD_MON_READV);
@@ -2377,6 +2379,37 @@ int XrdXrootdProtocol::do_ReadV()
    if (!FTab) return Response.Send(kXR_FileNotOpen,
                               "readv does not refer to an open file");
 
+// If the response spans more than one buffer and we are allowed to have more
+// than one buffer in flight, overlap reading the data with sending it. If all
+// of the files have a descriptor and the segments are large enough, we rather
+// send the data straight from the file. Both require that all file handles be
+// resolved up front as neither can stop midway on an invalid handle.
+//
+   doPipe = (totSZ > Quantum && rv_pipemem >= Quantum);
+   doSF   = (XrdLink::sfOK && Response.isOurs()
+         &&  totSZ-rdVecLen >= static_cast<long long>(rdVBreak)*as_minsfsz);
+   if (doPipe || doSF)
+      {XrdXrootdFile *fileV[maxRvecsz];
+       for (i = 0; i < rdVBreak; i++)
+           {if (i && rdVec[i].info == rdVec[i-1].info)
+               {fileV[i] = fileV[i-1]; continue;}
+            if (!(fileV[i] = FTab->Get(rdVec[i].info)))
+               return Response.Send(kXR_FileNotOpen,
+                                    "readv does not refer to an open file");
+           }
+       if (doSF)
+          {for (i = 0; i < rdVBreak; i++)
+               {if (!fileV[i]->sfEnabled || fileV[i]->fdNum < 0
+                ||   fileV[i]->isMMapped
+                ||   rdVec[i].offset+rdVec[i].size > fileV[i]->Stats.fSize)
+                   break;
+               }
+           if (i >= rdVBreak) return do_ReadVSF(rdVec, fileV, rdVBreak, Quantum);
+          }
+       if (doPipe && XrdXrootdRVPipe::Reserve(Quantum))
+          return do_ReadVPipe(rdVec, fileV, rdVBreak, Quantum);
+      }
+
 // Preset the previous and current file handle to be the handle of the first
 // element and make sure the file is actually open.
 //
@@ -2450,6 +2483,128 @@ int XrdXrootdProtocol::do_ReadV()
    return (Quantum != Qleft ? Response.Send(argp->buff, Quantum-Qleft) : 0);
 }
 
+/******************************************************************************/
+/*                          d o _ R e a d V P i p e                           */
+/******************************************************************************/
+
+int XrdXrootdProtocol::do_ReadVPipe(XrdOucIOVec *rdVec, XrdXrootdFile **fileV,
+                                    int rdVecNum, int Quantum)
+{
+// This is the pipelined version of do_ReadV(). A pipe thread fills one buffer
+// while we send the other one. We never have more than one stage in progress
+// so the files are read by one thread at a time, as in do_ReadV().
+//
+   XrdXrootdRVPipe rvPipe[2];
+   int cur = 0, nxt, rc = 0;
+
+// Obtain the second buffer we need. The first stage uses the link buffer. The
+// caller has reserved memory for it in the pipe budget which we must return.
+//
+   rvPipe[0].Buff = argp;
+   if (!(rvPipe[1].Buff = BPool->Obtain(Quantum)))
+      {XrdXrootdRVPipe::Unreserve(Quantum);
+       return Response.Send(kXR_NoMemory, "insufficient memory for readv");
+      }
+   rvSeq++;
+
+// Run the pipeline. Each time a stage completes we start the next one in the
+// other buffer before sending the one that just completed. Should the send
+// fail, we must wait for the next stage as its buffer is in use.
+//
+   rvStage(rvPipe[0], rdVec, fileV, 0, rdVecNum, Quantum);
+   while(1)
+        {rvPipe[cur].Wait();
+         if (rvPipe[cur].errFile) {rc = 1; break;}
+         if (rvPipe[cur].rdEnd >= rdVecNum)
+            {if (Response.Send(rvPipe[cur].Buff->buff, rvPipe[cur].rdLen) < 0)
+                rc = -1;
+             break;
+            }
+         nxt = cur ^ 1;
+         rvStage(rvPipe[nxt], rdVec, fileV, rvPipe[cur].rdEnd, rdVecNum, Quantum);
+         if (Response.Send(kXR_oksofar, rvPipe[cur].Buff->buff,
+                           rvPipe[cur].rdLen) < 0)
+            {rvPipe[nxt].Wait(); rc = -1; break;}
+         cur = nxt;
+        }
+
+// Return the additional buffer, all stages have completed by now
+//
+   BPool->Release(rvPipe[1].Buff);
+   XrdXrootdRVPipe::Unreserve(Quantum);
+
+// Handle any errors. A read error is reported against the file that failed.
+//
+   if (rc < 0) return -1;
+   if (rc > 0) return fsError(rvPipe[cur].rdRC, 0,
+                              rvPipe[cur].errFile->XrdSfsp->error, 0, 0);
+
+// Now account for the transfer on a per-file basis
+//
+   rvMonitor(rdVec, fileV, rdVecNum);
+   return 0;
+}
+
+/******************************************************************************/
+/*                            d o _ R e a d V S F                             */
+/******************************************************************************/
+
+int XrdXrootdProtocol::do_ReadVSF(XrdOucIOVec *rdVec, XrdXrootdFile **fileV,
+                                  int rdVecNum, int Quantum)
+{
+// This is the sendfile version of do_ReadV(). The readahead_list headers come
+// from memory and the data segments straight from the file descriptors so the
+// data never gets copied into a buffer. The caller has verified that every
+// segment lies within its file and that every file has a usable descriptor.
+//
+#ifdef __solaris__
+   const int sfvMax = XrdOucSFVec::sfMax;
+#else
+   const int sfvMax = XrdOucSFVec::sfMaxRV;
+#endif
+   const int hdrSZ = sizeof(readahead_list);
+   struct readahead_list respHdr[maxRvecsz];
+   XrdOucSFVec sfVec[2*maxRvecsz+1];
+   int currFH, i, sfNum, xfrSZ, rdBeg = 0;
+
+// Each response carries at most a Quantum worth of data just as it would
+// have had we used a buffer. Element zero is reserved for the response header.
+//
+   rvSeq++;
+   while(rdBeg < rdVecNum)
+        {sfNum = 1; xfrSZ = 0;
+         for (i = rdBeg; i < rdVecNum; i++)
+             {if (xfrSZ + rdVec[i].size + hdrSZ > Quantum
+              ||  sfNum + 2 > sfvMax) break;
+              currFH = rdVec[i].info;
+              memcpy(respHdr[i].fhandle, &currFH, sizeof(respHdr[i].fhandle));
+              respHdr[i].rlen   = htonl(rdVec[i].size);
+              respHdr[i].offset = htonll(rdVec[i].offset);
+              sfVec[sfNum].buffer = (char *)&respHdr[i];
+              sfVec[sfNum].sendsz = hdrSZ;
+              sfVec[sfNum].fdnum  = -1;
+              sfNum++;
+              if (rdVec[i].size)
+                 {sfVec[sfNum].offset = rdVec[i].offset;
+                  sfVec[sfNum].sendsz = rdVec[i].size;
+                  sfVec[sfNum].fdnum  = fileV[i]->fdNum;
+                  sfNum++;
+                 }
+              xfrSZ += rdVec[i].size + hdrSZ;
+              TRACEP(FS,"fh=" <<currFH <<" readV " <<rdVec[i].size
+                        <<'@' <<rdVec[i].offset <<" sendfile");
+             }
+         if (Response.Send((i < rdVecNum ? kXR_oksofar : kXR_ok),
+                           sfVec, sfNum, xfrSZ) < 0) return -1;
+         rdBeg = i;
+        }
+
+// Now account for the transfer on a per-file basis
+//
+   rvMonitor(rdVec, fileV, rdVecNum);
+   return 0;
+}
+
 /******************************************************************************/
 /*                                 d o _ R m                                  */
 /******************************************************************************/
@@ -3699,6 +3854,71 @@ int XrdXrootdProtocol::rpEmsg(const char *op, char *fn)
    return Response.Send(kXR_NotAuthorized, buff);
 }
  
+/******************************************************************************/
+/*                             r v M o n i t o r                              */
+/******************************************************************************/
+  
+void XrdXrootdProtocol::rvMonitor(XrdOucIOVec *rdVec, XrdXrootdFile **fileV,
+                                  int rdVecNum)
+{
+   XrdSfsXferSize rdVXfr;
+   int i, k, rdVBeg, rdVNum, rvMon = Monitor.InOut(), ioMon = (rvMon > 1);
+   char vType = (ioMon ? XROOTD_MON_READU : XROOTD_MON_READV);
+
+// Record statistics and monitoring information for each run of readv elements
+// that refer to the same file, just as do_ReadV() does as it goes along.
+//
+   for (rdVBeg = 0; rdVBeg < rdVecNum; rdVBeg = i)
+       {rdVXfr = 0;
+        for (i = rdVBeg; i < rdVecNum && fileV[i] == fileV[rdVBeg]; i++)
+            rdVXfr += rdVec[i].size;
+        rdVNum = i - rdVBeg; myFile = fileV[rdVBeg];
+        myFile->Stats.rvOps(rdVXfr, rdVNum);
+        if (rvMon)
+           {Monitor.Agent->Add_rv(myFile->Stats.FileID, htonl(rdVXfr),
+                                          htons(rdVNum), rvSeq, vType);
+            if (ioMon) for (k = rdVBeg; k < i; k++)
+                Monitor.Agent->Add_rd(myFile->Stats.FileID,
+                        htonl(rdVec[k].size), htonll(rdVec[k].offset));
+           }
+       }
+}
+ 
+/******************************************************************************/
+/*                               r v S t a g e                                */
+/******************************************************************************/
+
+void XrdXrootdProtocol::rvStage(XrdXrootdRVPipe &rvP, XrdOucIOVec *rdVec,
+                                XrdXrootdFile **fileV, int rdBeg, int rdVecNum,
+                                int Quantum)
+{
+   const int hdrSZ = sizeof(readahead_list);
+   struct readahead_list respHdr;
+   char *buffp = rvP.Buff->buff;
+   int currFH, i, Qleft = Quantum;
+
+// Lay out as many elements as will fit into the stage's buffer
+//
+   for (i = rdBeg; i < rdVecNum; i++)
+       {if (Qleft < rdVec[i].size + hdrSZ) break;
+        currFH = rdVec[i].info;
+        memcpy(respHdr.fhandle, &currFH, sizeof(respHdr.fhandle));
+        respHdr.rlen   = htonl(rdVec[i].size);
+        respHdr.offset = htonll(rdVec[i].offset);
+        memcpy(buffp, &respHdr, hdrSZ);
+        rdVec[i].data = buffp + hdrSZ;
+        buffp += (rdVec[i].size+hdrSZ);
+        Qleft -= (rdVec[i].size+hdrSZ);
+        TRACEP(FS,"fh=" <<currFH <<" readV " <<rdVec[i].size
+                  <<'@' <<rdVec[i].offset);
+       }
+
+// Hand the stage to a pipe thread
+//
+   rvP.Set(fileV, rdVec, rdBeg, i, Quantum-Qleft);
+   rvP.Run();
+}
+
 /******************************************************************************/
 /*                                 S e t S F                                  */
 /******************************************************************************/
@@ -0,0 +1,250 @@
+/******************************************************************************/
+/*                                                                            */
+/*                   X r d C m s B i t S e t T e s t . c c                    */
+/*                                                                            */
+/* (c) 2019 by the Board of Trustees of the Leland Stanford, Jr., University  */
+/*   Produced by Andrew Hanushevsky for Stanford University under contract    */
+/*              DE-AC02-76-SFO0515 with the Department of Energy              */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+// These tests check XrdCmsBitSet at the default width of 64 bits, at wider
+// widths, and at the width SMask_t has in this build (CMS_MAX_NODES). Most
+// checks sit at the 64-bit word boundaries where the multi-word code differs
+// from a plain unsigned long long.
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <stdlib.h>
+#include <sstream>
+#include <string>
+
+#include "XrdCms/XrdCmsBitSet.hh"
+#include "XrdCms/XrdCmsTypes.hh"
+
+/******************************************************************************/
+/*                           D e c l a r a t i o n                            */
+/******************************************************************************/
+
+class CmsBitSetTest: public CppUnit::TestCase
+{
+  public:
+    CPPUNIT_TEST_SUITE( CmsBitSetTest );
+      CPPUNIT_TEST( Bits64Test );
+      CPPUNIT_TEST( Bits128Test );
+      CPPUNIT_TEST( Bits1024Test );
+      CPPUNIT_TEST( SMaskTest );
+      CPPUNIT_TEST( DisplayTest );
+    CPPUNIT_TEST_SUITE_END();
+    void Bits64Test()   {Check<64>();}
+    void Bits128Test()  {Check<128>();}
+    void Bits1024Test() {Check<1024>();}
+    void SMaskTest()    {Check<STMax>();}
+    void DisplayTest();
+
+  private:
+    template<int N> void Check();
+    template<int N> void SetTest();
+    template<int N> void ShiftTest();
+    template<int N> void NotTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CmsBitSetTest );
+
+/******************************************************************************/
+/*                                 C h e c k                                  */
+/******************************************************************************/
+
+template<int N> void CmsBitSetTest::Check()
+{
+   SetTest<N>();
+   ShiftTest<N>();
+   NotTest<N>();
+}
+
+/******************************************************************************/
+/*                               S e t T e s t                                */
+/******************************************************************************/
+
+template<int N> void CmsBitSetTest::SetTest()
+{
+   typedef XrdCmsBitSet<N> Mask;
+
+// An empty mask has no bits
+//
+   Mask m(0);
+   CPPUNIT_ASSERT( !m );
+   CPPUNIT_ASSERT_EQUAL( 0, m.Count() );
+   CPPUNIT_ASSERT_EQUAL( -1, m.First() );
+
+// Set the bits on either side of each word boundary and the last one
+//
+   int n = 0;
+   for (int w = 64; w < N; w += 64)
+       {m.Set(w-1); m.Set(w); n += 2;
+        CPPUNIT_ASSERT( m.Test(w-1) && m.Test(w) );
+        CPPUNIT_ASSERT( !m.Test(w-2) && !m.Test(w+1) );
+       }
+   m.Set(N-1); n++;
+   CPPUNIT_ASSERT( static_cast<bool>(m) );
+   CPPUNIT_ASSERT_EQUAL( n, m.Count() );
+   CPPUNIT_ASSERT_EQUAL( 63, m.First() );
+
+// First() finds the lowest bit in any word
+//
+   Mask f(0);
+   f.Set(N-1);
+   CPPUNIT_ASSERT_EQUAL( N-1, f.First() );
+   f.Set(0);
+   CPPUNIT_ASSERT_EQUAL( 0, f.First() );
+   CPPUNIT_ASSERT_EQUAL( 2, f.Count() );
+
+// Construction from integers
+//
+   CPPUNIT_ASSERT( Mask(1) == Mask(1ULL) );
+   CPPUNIT_ASSERT_EQUAL( 1, Mask(1).Count() );
+   CPPUNIT_ASSERT_EQUAL( N, Mask(-1).Count() );
+   CPPUNIT_ASSERT_EQUAL( N, Mask(-1LL).Count() );
+
+// An unsigned value fills only the low order word
+//
+   Mask u(~0ULL);
+   CPPUNIT_ASSERT_EQUAL( 64, u.Count() );
+   CPPUNIT_ASSERT( u.Test(63) );
+   if (N > 64) CPPUNIT_ASSERT( !u.Test(64) );
+}
+
+/******************************************************************************/
+/*                             S h i f t T e s t                              */
+/******************************************************************************/
+
+template<int N> void CmsBitSetTest::ShiftTest()
+{
+   typedef XrdCmsBitSet<N> Mask;
+
+// A single bit walks across every word boundary and back
+//
+   Mask one(1);
+   for (int i = 0; i < N; i++)
+       {Mask m = one << i;
+        CPPUNIT_ASSERT_EQUAL( 1, m.Count() );
+        CPPUNIT_ASSERT_EQUAL( i, m.First() );
+        CPPUNIT_ASSERT( (m >> i) == one );
+       }
+
+// Bits shifted past either end are lost
+//
+   Mask top(0);
+   top.Set(N-1);
+   CPPUNIT_ASSERT( !(top << 1) );
+   CPPUNIT_ASSERT( !(one >> 1) );
+   CPPUNIT_ASSERT( (top << 0) == top );
+   CPPUNIT_ASSERT( (top >> 0) == top );
+
+// Shifting one bit at a time equals shifting by the sum
+//
+   Mask edge(0);
+   edge.Set(62); edge.Set(63);
+   CPPUNIT_ASSERT( ((edge << 1) << 1) == (edge << 2) );
+   CPPUNIT_ASSERT( ((edge >> 1) >> 1) == (edge >> 2) );
+
+// Compare random patterns against a plain array of bits
+//
+   bool ref[N];
+   Mask m(0);
+   srand(N);
+   for (int i = 0; i < N; i++)
+       if ((ref[i] = (rand() & 1))) m.Set(i);
+
+   const int amt[] = {1, 31, 63, 64, 65, 127, 128, 129, N/2, N-1};
+   for (unsigned int k = 0; k < sizeof(amt)/sizeof(int); k++)
+       {int s = amt[k];
+        if (s >= N) continue;
+        Mask l = m << s, r = m >> s;
+        for (int i = 0; i < N; i++)
+            {CPPUNIT_ASSERT_EQUAL( (i >= s && ref[i-s]), l.Test(i) );
+             CPPUNIT_ASSERT_EQUAL( (i+s < N && ref[i+s]), r.Test(i) );
+            }
+       }
+}
+
+/******************************************************************************/
+/*                               N o t T e s t                                */
+/******************************************************************************/
+
+template<int N> void CmsBitSetTest::NotTest()
+{
+   typedef XrdCmsBitSet<N> Mask;
+
+// The complement covers all words
+//
+   CPPUNIT_ASSERT_EQUAL( N, (~Mask(0)).Count() );
+   CPPUNIT_ASSERT( ~Mask(0) == Mask(-1) );
+   CPPUNIT_ASSERT( !~Mask(-1) );
+
+// Complement bits on either side of each word boundary
+//
+   for (int w = 64; w <= N; w += 64)
+       {Mask m(0);
+        m.Set(w-1);
+        if (w < N) m.Set(w);
+        Mask c = ~m;
+        CPPUNIT_ASSERT( !c.Test(w-1) && c.Test(w-2) );
+        if (w < N) CPPUNIT_ASSERT( !c.Test(w) );
+        if (w+1 < N) CPPUNIT_ASSERT( c.Test(w+1) );
+        CPPUNIT_ASSERT_EQUAL( N - m.Count(), c.Count() );
+        CPPUNIT_ASSERT( !(c & m) );
+        CPPUNIT_ASSERT( (c | m) == Mask(-1) );
+        CPPUNIT_ASSERT( (c ^ m) == Mask(-1) );
+        CPPUNIT_ASSERT( ~c == m );
+       }
+
+// Clearing a bit the way the cmsd does it
+//
+   Mask all(-1), bit(0);
+   bit.Set(N-1);
+   all &= ~bit;
+   CPPUNIT_ASSERT_EQUAL( N-1, all.Count() );
+   CPPUNIT_ASSERT( !all.Test(N-1) );
+}
+
+/******************************************************************************/
+/*                           D i s p l a y T e s t                            */
+/******************************************************************************/
+
+void CmsBitSetTest::DisplayTest()
+{
+   std::ostringstream s1, s2, s3;
+
+// Masks are shown in hex, high order word first without leading zeroes
+//
+   s1 <<XrdCmsBitSet<64>(0x2a);
+   CPPUNIT_ASSERT_EQUAL( std::string("2a"), s1.str() );
+
+   s2 <<XrdCmsBitSet<128>(0x2a);
+   CPPUNIT_ASSERT_EQUAL( std::string("2a"), s2.str() );
+
+   XrdCmsBitSet<128> m(1);
+   m = m << 64;
+   s3 <<m;
+   CPPUNIT_ASSERT_EQUAL( std::string("10000000000000000"), s3.str() );
+}
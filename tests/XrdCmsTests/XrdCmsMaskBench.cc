@@ -0,0 +1,254 @@
+/******************************************************************************/
+/*                                                                            */
+/*                    X r d C m s M a s k B e n c h . c c                     */
+/*                                                                            */
+/* (c) 2019 by the Board of Trustees of the Leland Stanford, Jr., University  */
+/*   Produced by Andrew Hanushevsky for Stanford University under contract    */
+/*              DE-AC02-76-SFO0515 with the Department of Energy              */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+// This program checks XrdCmsBitSet against a plain bool array and measures
+// the cost of the mask operations the cmsd does most often at 64, 256, and
+// 1024 nodes: the node table scan done by each server selection, the vector
+// arithmetic done by each location cache lookup, and the bounce vector
+// recalculation done by getBVec(). Run it with an optional iteration count.
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "XrdCms/XrdCmsBitSet.hh"
+
+using namespace std;
+
+/******************************************************************************/
+/*                          U n i t   G l o b a l s                           */
+/******************************************************************************/
+
+namespace
+{
+   unsigned long long rSeed = 0x2545f4914f6cdd1dULL;
+   long long          Sink  = 0;
+   int                xRC   = 0;
+   int                Iters = 20000;
+   const char        *MeMe  = "cmsmaskbench: ";
+}
+
+/******************************************************************************/
+/*                               D e f i n e s                                */
+/******************************************************************************/
+
+#define EMSG(x) xRC=1,cerr <<MeMe <<x <<endl
+
+/******************************************************************************/
+/*                             U t i l i t i e s                              */
+/******************************************************************************/
+
+namespace
+{
+double Now()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+unsigned long long Rand()
+{
+   rSeed ^= rSeed >> 12; rSeed ^= rSeed << 25; rSeed ^= rSeed >> 27;
+   return rSeed * 0x2545f4914f6cdd1dULL;
+}
+
+template<int N>
+XrdCmsBitSet<N> RandMask(bool *ref, int nBits)
+{
+   XrdCmsBitSet<N> m(0);
+   for (int i = 0; i < N; i++)
+       {ref[i] = (i < nBits && (Rand() & 1));
+        if (ref[i]) m.Set(i);
+       }
+   return m;
+}
+
+template<int N>
+bool Same(const XrdCmsBitSet<N> &m, const bool *ref)
+{
+   for (int i = 0; i < N; i++) if (m.Test(i) != ref[i]) return false;
+   return true;
+}
+}
+
+/******************************************************************************/
+/*                                 C h e c k                                  */
+/******************************************************************************/
+
+template<int N>
+void Check()
+{
+   typedef XrdCmsBitSet<N> Mask_t;
+   bool a[N], b[N], r[N];
+   int  cnt, first;
+
+// Run through a number of random masks and compare each operator result with
+// what we get by doing the same thing one bit at a time.
+//
+   for (int k = 0; k < 200; k++)
+       {Mask_t ma = RandMask<N>(a, N), mb = RandMask<N>(b, N);
+        int sh = Rand() % N;
+
+        for (int i = 0; i < N; i++) r[i] = a[i] & b[i];
+        if (!Same<N>(ma & mb, r)) EMSG(N <<" bits: & failed");
+        for (int i = 0; i < N; i++) r[i] = a[i] | b[i];
+        if (!Same<N>(ma | mb, r)) EMSG(N <<" bits: | failed");
+        for (int i = 0; i < N; i++) r[i] = a[i] ^ b[i];
+        if (!Same<N>(ma ^ mb, r)) EMSG(N <<" bits: ^ failed");
+        for (int i = 0; i < N; i++) r[i] = !a[i];
+        if (!Same<N>(~ma, r)) EMSG(N <<" bits: ~ failed");
+        for (int i = 0; i < N; i++) r[i] = (i >= sh && a[i-sh]);
+        if (!Same<N>(ma << sh, r)) EMSG(N <<" bits: << " <<sh <<" failed");
+        for (int i = 0; i < N; i++) r[i] = (i+sh < N && a[i+sh]);
+        if (!Same<N>(ma >> sh, r)) EMSG(N <<" bits: >> " <<sh <<" failed");
+
+        cnt = 0; first = -1;
+        for (int i = 0; i < N; i++) if (a[i]) {if (first < 0) first = i; cnt++;}
+        if (ma.Count() != cnt)     EMSG(N <<" bits: Count() failed");
+        if (ma.First() != first)   EMSG(N <<" bits: First() failed");
+        if (static_cast<bool>(ma) != (cnt != 0) || !ma != (cnt == 0))
+           EMSG(N <<" bits: bool conversion failed");
+        if ((ma == mb) != (memcmp(a, b, sizeof(a)) == 0))
+           EMSG(N <<" bits: == failed");
+       }
+
+// Check the conversions the cmsd relies on
+//
+   Mask_t one(1);
+   if (Mask_t(~0).Count() != N || Mask_t(~0LL).Count() != N)
+      EMSG(N <<" bits: signed conversion is not sign extended");
+   if (Mask_t(~0ULL).Count() != 64)
+      EMSG(N <<" bits: unsigned conversion is not zero extended");
+   if ((one << (N-1)).First() != N-1 || (one << (N-1)).Count() != 1)
+      EMSG(N <<" bits: shift to the top bit failed");
+}
+
+/******************************************************************************/
+/*                                 B e n c h                                  */
+/******************************************************************************/
+
+template<int N>
+void Bench(int nNodes)
+{
+   typedef XrdCmsBitSet<N> Mask_t;
+   static const int numLoc = 4096;
+   static Mask_t    nodeMask[N], hfvec[numLoc], pfvec[numLoc], qfvec[numLoc];
+   static long long bounced[N];
+   bool   ref[N];
+   Mask_t okVec, pmask, bVec;
+   double tBeg, tAnd, tTest, tLoc, tBVec;
+   int    hits;
+
+// Set up a node table and a location cache with random contents
+//
+   for (int i = 0; i < N; i++)
+       {nodeMask[i] = Mask_t(1) << i; bounced[i] = Rand() % 1000;}
+   for (int i = 0; i < numLoc; i++)
+       {hfvec[i] = RandMask<N>(ref, nNodes);
+        pfvec[i] = RandMask<N>(ref, nNodes);
+        qfvec[i] = 0;
+       }
+   okVec = RandMask<N>(ref, nNodes) | hfvec[0];
+
+// A selection scans the node table and checks each node against the mask of
+// eligible nodes. This is done the old way, by and'ing the node's mask, and
+// the new way, by testing the node's bit.
+//
+   hits = 0; tBeg = Now();
+   for (int k = 0; k < Iters; k++)
+       {pmask = hfvec[k % numLoc];
+        for (int i = 0; i < nNodes; i++) if (nodeMask[i] & pmask) hits += i;
+       }
+   tAnd = (Now() - tBeg) / Iters; Sink += hits;
+
+   hits = 0; tBeg = Now();
+   for (int k = 0; k < Iters; k++)
+       {pmask = hfvec[k % numLoc];
+        for (int i = 0; i < nNodes; i++) if (pmask.Test(i)) hits += i;
+       }
+   tTest = (Now() - tBeg) / Iters; Sink += hits;
+
+// A location cache lookup removes bounced nodes and computes the have,
+// pending, and bounce vectors relative to the nodes that are still around.
+//
+   bVec = RandMask<N>(ref, nNodes);
+   hits = 0; tBeg = Now();
+   for (int k = 0; k < Iters*10; k++)
+       {int j = k % numLoc;
+        Mask_t hf, pf, bf;
+        hfvec[j] &= ~bVec; pfvec[j] &= ~bVec;
+        hf = okVec & hfvec[j];
+        pf = okVec & pfvec[j];
+        bf = okVec & (bVec | qfvec[j]);
+        if (hf) hits += hf.First();
+        if (pf || bf) hits++;
+       }
+   tLoc = (Now() - tBeg) / (Iters*10); Sink += hits;
+
+// getBVec() builds the vector of nodes that bounced after a given time
+//
+   tBeg = Now();
+   for (int k = 0; k < Iters; k++)
+       {Mask_t bv(0);
+        long long tod = k % 1000;
+        for (int i = 0; i < nNodes; i++) if (bounced[i] > tod) bv.Set(i);
+        Sink += bv.Count();
+       }
+   tBVec = (Now() - tBeg) / Iters;
+
+   printf("%5d nodes %5d bits: select scan %8.1f ns (and) %8.1f ns (test)"
+          "  lookup %6.1f ns  getBVec %8.1f ns\n",
+          nNodes, N, tAnd, tTest, tLoc, tBVec);
+}
+
+/******************************************************************************/
+/*                                  m a i n                                   */
+/******************************************************************************/
+
+int main(int argc, char **argv)
+{
+   if (argc > 1 && (Iters = atoi(argv[1])) <= 0)
+      {cerr <<"Usage: " <<argv[0] <<" [iterations]" <<endl; return 1;}
+
+// First make sure the masks actually work
+//
+   Check<64>(); Check<256>(); Check<1024>();
+   if (xRC) return xRC;
+
+// Now see what they cost at various cluster sizes
+//
+   Bench<64>(64);
+   Bench<256>(64);   Bench<256>(256);
+   Bench<1024>(64);  Bench<1024>(256); Bench<1024>(1024);
+   if (!Sink) cerr <<MeMe <<"nothing selected" <<endl;
+   return 0;
+}
@@ -0,0 +1,351 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2014 by Board of Trustees of the Leland Stanford, Jr., University
+// Author: Alja Mrak-Tadel, Matevz Tadel, Brian Bockelman
+//------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//------------------------------------------------------------------------------
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+
+#include "XrdCks/XrdCksCalcmd5.hh"
+#include "XrdOss/XrdOss.hh"
+#include "XrdSys/XrdSysTrace.hh"
+#include "XrdFileCache/XrdFileCacheInfo.hh"
+
+using XrdFileCache::Info;
+
+//------------------------------------------------------------------------------
+// Declaration
+//------------------------------------------------------------------------------
+class FileCacheInfoTest: public CppUnit::TestCase
+{
+  public:
+    CPPUNIT_TEST_SUITE( FileCacheInfoTest );
+      CPPUNIT_TEST( ReadV2Test );
+      CPPUNIT_TEST( RawRoundTripTest );
+      CPPUNIT_TEST( InPlaceUpdateTest );
+      CPPUNIT_TEST( RLETest );
+      CPPUNIT_TEST( BadVersionTest );
+    CPPUNIT_TEST_SUITE_END();
+    void setUp();
+    void tearDown();
+    void ReadV2Test();
+    void RawRoundTripTest();
+    void InPlaceUpdateTest();
+    void RLETest();
+    void BadVersionTest();
+  private:
+    std::string pPath;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( FileCacheInfoTest );
+
+namespace
+{
+//------------------------------------------------------------------------------
+// A cinfo file backed by a local file descriptor
+//------------------------------------------------------------------------------
+class LocalFile : public XrdOssDF
+{
+  public:
+    LocalFile( const std::string &path, bool trunc = false )
+    {
+      fd = open( path.c_str(), O_RDWR | O_CREAT | (trunc ? O_TRUNC : 0), 0644 );
+    }
+
+    ~LocalFile() { Close(); }
+
+    ssize_t Read( void *buff, off_t offs, size_t blen )
+    {
+      ssize_t rc = pread( fd, buff, blen, offs );
+      return ( rc < 0 ? -errno : rc );
+    }
+
+    ssize_t Write( const void *buff, off_t offs, size_t blen )
+    {
+      ssize_t rc = pwrite( fd, buff, blen, offs );
+      return ( rc < 0 ? -errno : rc );
+    }
+
+    int Ftruncate( unsigned long long flen )
+    {
+      return ( ftruncate( fd, flen ) ? -errno : 0 );
+    }
+
+    int Fstat( struct stat *buf )
+    {
+      return ( fstat( fd, buf ) ? -errno : 0 );
+    }
+
+    int getFD() { return fd; }
+
+    int Close( long long *retsz = 0 )
+    {
+      (void)retsz;
+      if( fd >= 0 ) close( fd );
+      fd = -1;
+      return 0;
+    }
+
+    off_t Size()
+    {
+      struct stat buf;
+      return ( Fstat( &buf ) ? -1 : buf.st_size );
+    }
+};
+
+XrdSysTrace trace( "InfoTest" );
+
+const long long bSize  = 1024*1024;
+const long long fSize  = 100*bSize + 17;   // 101 blocks, 13 bytes of vector
+const int       nBlks  = 101;
+
+//------------------------------------------------------------------------------
+// Set up a new Info object for the test file
+//------------------------------------------------------------------------------
+void Setup( Info &cfi )
+{
+  cfi.SetBufferSize( bSize );
+  cfi.SetFileSize( fSize );
+}
+}
+
+//------------------------------------------------------------------------------
+// Set up and tear down the cinfo file
+//------------------------------------------------------------------------------
+void FileCacheInfoTest::setUp()
+{
+  char tmpl[] = "/tmp/xrdpfcInfoTest.XXXXXX";
+  int  fd     = mkstemp( tmpl );
+  CPPUNIT_ASSERT( fd >= 0 );
+  close( fd );
+  pPath = tmpl;
+}
+
+void FileCacheInfoTest::tearDown()
+{
+  unlink( pPath.c_str() );
+}
+
+//------------------------------------------------------------------------------
+// A version 2 file is read and rewritten as version 3
+//------------------------------------------------------------------------------
+void FileCacheInfoTest::ReadV2Test()
+{
+  //----------------------------------------------------------------------------
+  // Write the version 2 layout by hand
+  //----------------------------------------------------------------------------
+  std::vector<unsigned char> vec( ( nBlks - 1 ) / 8 + 1, 0 );
+  vec[0] = 0x05; vec[12] = 0x10;
+
+  XrdCksCalcmd5 md5;
+  md5.Update( (const char*) &vec[0], vec.size() );
+  char cksum[16];
+  memcpy( cksum, md5.Final(), 16 );
+
+  int       version = 2;
+  long long bufSz   = bSize, fileSz = fSize;
+  time_t    ctime   = 1234567;
+  size_t    nAcc    = 2;
+  Info::AStat as[2];
+  as[0].AttachTime = 10; as[0].DetachTime = 20; as[0].BytesDisk = 30;
+  as[1].AttachTime = 40; as[1].DetachTime = 50; as[1].BytesMissed = 60;
+
+  std::string v2;
+  v2.append( (char*) &version, sizeof(version) );
+  v2.append( (char*) &bufSz,   sizeof(bufSz) );
+  v2.append( (char*) &fileSz,  sizeof(fileSz) );
+  v2.append( (char*) &vec[0],  vec.size() );
+  v2.append( cksum,            16 );
+  v2.append( (char*) &ctime,   sizeof(ctime) );
+  v2.append( (char*) &nAcc,    sizeof(nAcc) );
+  v2.append( (char*) as,       sizeof(as) );
+
+  {
+    LocalFile f( pPath, true );
+    CPPUNIT_ASSERT( f.Write( v2.data(), 0, v2.size() ) == (ssize_t) v2.size() );
+  }
+
+  //----------------------------------------------------------------------------
+  // Read it and check what we got
+  //----------------------------------------------------------------------------
+  {
+    LocalFile f( pPath );
+    Info cfi( &trace );
+    CPPUNIT_ASSERT( cfi.Read( &f ) );
+    CPPUNIT_ASSERT_EQUAL( 2, cfi.GetVersion() );
+    CPPUNIT_ASSERT_EQUAL( fSize, cfi.GetFileSize() );
+    CPPUNIT_ASSERT_EQUAL( bSize, cfi.GetBufferSize() );
+    CPPUNIT_ASSERT_EQUAL( nBlks, cfi.GetSizeInBits() );
+    CPPUNIT_ASSERT_EQUAL( 3, cfi.GetNDownloadedBlocks() );
+    CPPUNIT_ASSERT( cfi.TestBitWritten( 0 ) && cfi.TestBitWritten( 2 ) );
+    CPPUNIT_ASSERT( cfi.TestBitWritten( 100 ) && ! cfi.TestBitWritten( 1 ) );
+    CPPUNIT_ASSERT_EQUAL( (size_t) 2, cfi.GetAccessCnt() );
+    CPPUNIT_ASSERT_EQUAL( 30LL, cfi.RefStoredData().m_astats[0].BytesDisk );
+    CPPUNIT_ASSERT_EQUAL( 60LL, cfi.RefStoredData().m_astats[1].BytesMissed );
+
+    //--------------------------------------------------------------------------
+    // Upgrade it to version 3
+    //--------------------------------------------------------------------------
+    CPPUNIT_ASSERT( cfi.Write( &f ) );
+  }
+
+  {
+    LocalFile f( pPath );
+    Info cfi( &trace );
+    CPPUNIT_ASSERT( cfi.Read( &f ) );
+    CPPUNIT_ASSERT_EQUAL( 3, cfi.GetVersion() );
+    CPPUNIT_ASSERT_EQUAL( fSize, cfi.GetFileSize() );
+    CPPUNIT_ASSERT_EQUAL( 3, cfi.GetNDownloadedBlocks() );
+    CPPUNIT_ASSERT( cfi.TestBitWritten( 100 ) );
+    CPPUNIT_ASSERT_EQUAL( (size_t) 2, cfi.GetAccessCnt() );
+    CPPUNIT_ASSERT_EQUAL( (time_t) 40, cfi.RefStoredData().m_astats[1].AttachTime );
+  }
+}
+
+//------------------------------------------------------------------------------
+// A partially downloaded file is written raw and read back
+//------------------------------------------------------------------------------
+void FileCacheInfoTest::RawRoundTripTest()
+{
+  {
+    LocalFile f( pPath, true );
+    Info cfi( &trace );
+    Setup( cfi );
+    cfi.SetBitSynced( 3 );
+    cfi.SetBitSynced( 64 );
+    for( int i = 0; i < 25; ++i ) cfi.WriteIOStatSingle( i, i, i + 1 );
+    CPPUNIT_ASSERT( cfi.Write( &f ) );
+  }
+
+  LocalFile f( pPath );
+  Info cfi( &trace );
+  CPPUNIT_ASSERT( cfi.Read( &f ) );
+  CPPUNIT_ASSERT_EQUAL( 3, cfi.GetVersion() );
+  CPPUNIT_ASSERT_EQUAL( 2, cfi.GetNDownloadedBlocks() );
+  CPPUNIT_ASSERT( cfi.TestBitWritten( 3 ) && cfi.TestBitWritten( 64 ) );
+  CPPUNIT_ASSERT( ! cfi.IsComplete() );
+
+  //----------------------------------------------------------------------------
+  // Only the last records are kept, oldest first
+  //----------------------------------------------------------------------------
+  const Info::Store &st = cfi.RefStoredData();
+  CPPUNIT_ASSERT_EQUAL( (size_t) 25, st.m_accessCnt );
+  CPPUNIT_ASSERT_EQUAL( Info::GetMaxNumAccess(), st.m_astats.size() );
+  CPPUNIT_ASSERT_EQUAL( 5LL,  st.m_astats.front().BytesDisk );
+  CPPUNIT_ASSERT_EQUAL( 24LL, st.m_astats.back().BytesDisk );
+}
+
+//------------------------------------------------------------------------------
+// Blocks synced after a file was read are written in place
+//------------------------------------------------------------------------------
+void FileCacheInfoTest::InPlaceUpdateTest()
+{
+  off_t size;
+  {
+    LocalFile f( pPath, true );
+    Info cfi( &trace );
+    Setup( cfi );
+    cfi.SetBitSynced( 0 );
+    CPPUNIT_ASSERT( cfi.Write( &f ) );
+    size = f.Size();
+
+    //--------------------------------------------------------------------------
+    // The second write only updates the changed range
+    //--------------------------------------------------------------------------
+    cfi.SetBitSynced( 50 );
+    cfi.SetBitSynced( 99 );
+    cfi.WriteIOStatSingle( 7 );
+    CPPUNIT_ASSERT( cfi.Write( &f ) );
+    CPPUNIT_ASSERT_EQUAL( size, f.Size() );
+  }
+
+  {
+    LocalFile f( pPath );
+    Info cfi( &trace );
+    CPPUNIT_ASSERT( cfi.Read( &f ) );
+    CPPUNIT_ASSERT_EQUAL( 3, cfi.GetNDownloadedBlocks() );
+    CPPUNIT_ASSERT( cfi.TestBitWritten( 50 ) && cfi.TestBitWritten( 99 ) );
+    CPPUNIT_ASSERT_EQUAL( (size_t) 1, cfi.GetAccessCnt() );
+
+    //--------------------------------------------------------------------------
+    // A file that was read is also updated in place
+    //--------------------------------------------------------------------------
+    cfi.SetBitSynced( 7 );
+    CPPUNIT_ASSERT( cfi.Write( &f ) );
+    CPPUNIT_ASSERT_EQUAL( size, f.Size() );
+  }
+
+  LocalFile f( pPath );
+  Info cfi( &trace );
+  CPPUNIT_ASSERT( cfi.Read( &f ) );
+  CPPUNIT_ASSERT_EQUAL( 4, cfi.GetNDownloadedBlocks() );
+  CPPUNIT_ASSERT( cfi.TestBitWritten( 7 ) );
+}
+
+//------------------------------------------------------------------------------
+// A complete file is stored run-length encoded and the raw tail is dropped
+//------------------------------------------------------------------------------
+void FileCacheInfoTest::RLETest()
+{
+  off_t size;
+  {
+    LocalFile f( pPath, true );
+    Info cfi( &trace );
+    Setup( cfi );
+    cfi.SetBitSynced( 1 );
+    CPPUNIT_ASSERT( cfi.Write( &f ) );
+    size = f.Size();
+
+    cfi.SetAllBitsSynced();
+    CPPUNIT_ASSERT( cfi.Write( &f ) );
+    CPPUNIT_ASSERT( f.Size() < size );
+  }
+
+  LocalFile f( pPath );
+  Info cfi( &trace );
+  CPPUNIT_ASSERT( cfi.Read( &f ) );
+  CPPUNIT_ASSERT( cfi.IsComplete() );
+  CPPUNIT_ASSERT_EQUAL( nBlks, cfi.GetNDownloadedBlocks() );
+  CPPUNIT_ASSERT( cfi.TestBitWritten( nBlks - 1 ) );
+}
+
+//------------------------------------------------------------------------------
+// Versions we do not know are rejected
+//------------------------------------------------------------------------------
+void FileCacheInfoTest::BadVersionTest()
+{
+  {
+    LocalFile f( pPath, true );
+    Info cfi( &trace );
+    Setup( cfi );
+    CPPUNIT_ASSERT( cfi.Write( &f ) );
+    int version = 4;
+    CPPUNIT_ASSERT( f.Write( &version, 0, sizeof(version) ) == sizeof(version) );
+  }
+
+  LocalFile f( pPath );
+  Info cfi( &trace );
+  CPPUNIT_ASSERT( ! cfi.Read( &f ) );
+}